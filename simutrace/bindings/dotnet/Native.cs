@@ -218,6 +218,13 @@ namespace SimuTrace
             public StreamStatistics stats;
         }
 
+        [StructLayout(LayoutKind.Sequential, Pack = 1)]
+        public struct StreamPartition
+        {
+            public uint first;
+            public uint last;
+        }
+
         public enum QueryIndexType
         {
             QIndex = 0x00,
@@ -340,6 +347,11 @@ namespace SimuTrace
         public delegate int DynamicStreamGetNextEntry(IntPtr userData,
             out IntPtr entryOut);
 
+        public delegate int ParallelScanPartition(IntPtr userData,
+            uint partition, ref IntPtr handle);
+        public delegate int ParallelScanReduce(IntPtr userData,
+            uint partition);
+
         [StructLayout(LayoutKind.Sequential, Pack = 1)]
         public struct DynamicStreamOperations
         {
@@ -1000,6 +1012,96 @@ namespace SimuTrace
         }
 
 
+        /// <summary>
+        /// This method divides the segments of a stream into ranges of
+        /// consecutive sequence numbers, which contain about the same number
+        /// of segments. Each partition can be read with its own handle (see
+        /// StStreamOpenPartition()).
+        /// </summary>
+        /// <param name="session">The id of the session that holds the
+        ///     stream of interest.</param>
+        /// <param name="stream">The id of the stream to partition.</param>
+        /// <param name="count">The maximum number of partitions.</param>
+        /// <param name="partitionsOut">The array will hold the
+        ///     partitions in the order of the stream.</param>
+        /// <returns>The number of partitions. The method will return -1 on
+        ///     error. For a more detailed error description call
+        ///     StGetLastError().</returns>
+        public static int StStreamPartition(uint session, uint stream,
+            uint count, out StreamPartition[] partitionsOut)
+        {
+            StreamPartition[] partitions = new StreamPartition[count];
+
+            int num = NativeMethods.StStreamPartition(session, stream, count,
+                partitions);
+            if (num < 0) {
+                partitionsOut = null;
+                return num;
+            }
+
+            Array.Resize(ref partitions, num);
+            partitionsOut = partitions;
+
+            return num;
+        }
+
+
+        /// <summary>
+        /// This method opens a new read handle, which points to the first
+        /// entry of the supplied partition. StGetNextEntry() returns 0 after
+        /// the last entry of the partition.
+        /// </summary>
+        /// <param name="session">The id of the session that holds the
+        ///     stream of interest.</param>
+        /// <param name="stream">The id of the stream to open a
+        ///     handle for.</param>
+        /// <param name="partition">The partition to read as returned by
+        ///     StStreamPartition().</param>
+        /// <param name="flags">Supplies information on how the caller intends
+        ///     to access the stream with the requested handle. For more
+        ///     information see StreamAccessFlags.</param>
+        /// <returns>A read handle to the partition if successful, 0
+        ///     otherwise. For a more detailed error description call
+        ///     StGetLastError().</returns>
+        public static IntPtr StStreamOpenPartition(uint session, uint stream,
+            ref StreamPartition partition, StreamAccessFlags flags)
+        {
+            return NativeMethods.StStreamOpenPartition(session, stream,
+                ref partition, flags);
+        }
+
+
+        /// <summary>
+        /// This method splits the stream into at most threadCount partitions
+        /// and calls the scan handler for each partition in a separate
+        /// thread. When all partitions have been scanned, the method calls
+        /// the reduce handler for each partition in the calling thread.
+        /// </summary>
+        /// <param name="session">The id of the session that holds the
+        ///     stream of interest.</param>
+        /// <param name="stream">The id of the stream to scan.</param>
+        /// <param name="threadCount">The maximum number of threads and
+        ///     partitions.</param>
+        /// <param name="flags">Supplies information on how the scan handler
+        ///     accesses the partitions. For more information see
+        ///     StreamAccessFlags.</param>
+        /// <param name="scan">Handler, which reads a partition.</param>
+        /// <param name="reduce">Handler, which merges the result of a
+        ///     partition. May be null.</param>
+        /// <param name="userData">User-defined data passed to the
+        ///     handlers.</param>
+        /// <returns>true if successful, false otherwise. For a more
+        ///     detailed error description call StGetLastError().</returns>
+        public static bool StStreamParallelScan(uint session, uint stream,
+            uint threadCount, StreamAccessFlags flags,
+            ParallelScanPartition scan, ParallelScanReduce reduce,
+            IntPtr userData)
+        {
+            return NativeMethods.StStreamParallelScan(session, stream,
+                threadCount, flags, scan, reduce, userData);
+        }
+
+
         /* Tracing API */
 
         /// <summary>
@@ -1054,6 +1156,58 @@ namespace SimuTrace
         }
 
 
+        /// <summary>
+        /// This method returns a pointer to the next entry in the stream and
+        /// the number of entries that directly follow in the current
+        /// segment. The read pointer of the handle moves behind the last of
+        /// these entries.
+        /// </summary>
+        /// <param name="handle">A stream read handle. The method may allocate
+        ///     a new handle and update the supplied one.</param>
+        /// <param name="countOut">Receives the number of entries in the
+        ///     returned span.</param>
+        /// <returns>A pointer to the first entry of the span if successful, 0
+        ///     otherwise. For a more detailed error description call
+        ///     StGetLastError().</returns>
+        public static IntPtr StGetNextEntries(ref IntPtr handle,
+            out IntPtr countOut)
+        {
+            return NativeMethods.StGetNextEntries(ref handle, out countOut);
+        }
+
+
+        /// <summary>
+        /// This method returns a pointer to the space for the next entry in
+        /// the stream and the number of entries that fit into the current
+        /// segment. Complete the written entries with StSubmitEntries().
+        /// </summary>
+        /// <param name="handle">A stream write handle. The method may
+        ///     allocate a new handle and update the supplied one.</param>
+        /// <param name="countOut">Receives the number of entries that fit
+        ///     into the returned span.</param>
+        /// <returns>A pointer to the first entry of the span if successful, 0
+        ///     otherwise. For a more detailed error description call
+        ///     StGetLastError().</returns>
+        public static IntPtr StReserveEntries(ref IntPtr handle,
+            out IntPtr countOut)
+        {
+            return NativeMethods.StReserveEntries(ref handle, out countOut);
+        }
+
+
+        /// <summary>
+        /// This method completes the first entries of the span returned by
+        /// the last call to StReserveEntries().
+        /// </summary>
+        /// <param name="handle">The write handle of the stream, which has been
+        ///     used in the matching call to StReserveEntries().</param>
+        /// <param name="count">The number of entries to complete.</param>
+        public static void StSubmitEntries(IntPtr handle, IntPtr count)
+        {
+            NativeMethods.StSubmitEntries(handle, count);
+        }
+
+
         /// <summary>
         /// In Simutrace, entries are required to be of fixed size. This
         /// method enables tracing of variable-sized data such as strings. To
@@ -197,6 +197,26 @@ namespace SimuTrace
             [return: MarshalAs(UnmanagedType.I1)]
             public static extern bool StStreamClose(IntPtr handle);
 
+            [DllImport(libsimutrace,
+                CallingConvention = CallingConvention.Cdecl)]
+            public static extern int StStreamPartition(uint session,
+                uint stream, uint count,
+                [Out] StreamPartition[] partitionsOut);
+
+            [DllImport(libsimutrace,
+                CallingConvention = CallingConvention.Cdecl)]
+            public static extern IntPtr StStreamOpenPartition(uint session,
+                uint stream, ref StreamPartition partition,
+                StreamAccessFlags flags);
+
+            [DllImport(libsimutrace,
+                CallingConvention = CallingConvention.Cdecl)]
+            [return: MarshalAs(UnmanagedType.I1)]
+            public static extern bool StStreamParallelScan(uint session,
+                uint stream, uint threadCount, StreamAccessFlags flags,
+                ParallelScanPartition scan, ParallelScanReduce reduce,
+                IntPtr userData);
+
 
             /* Tracing API */
 
@@ -212,6 +232,21 @@ namespace SimuTrace
                 CallingConvention = CallingConvention.Cdecl)]
             public static extern void StSubmitEntry(IntPtr handle);
 
+            [DllImport(libsimutrace,
+                CallingConvention = CallingConvention.Cdecl)]
+            public static extern IntPtr StGetNextEntries(ref IntPtr handle,
+                out IntPtr countOut);
+
+            [DllImport(libsimutrace,
+                CallingConvention = CallingConvention.Cdecl)]
+            public static extern IntPtr StReserveEntries(ref IntPtr handle,
+                out IntPtr countOut);
+
+            [DllImport(libsimutrace,
+                CallingConvention = CallingConvention.Cdecl)]
+            public static extern void StSubmitEntries(IntPtr handle,
+                IntPtr count);
+
             [DllImport(libsimutrace,
                 CallingConvention = CallingConvention.Cdecl)]
             public static extern IntPtr StWriteVariableData(ref IntPtr handle,
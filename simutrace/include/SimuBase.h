@@ -82,6 +82,7 @@
 // Communication
 //
 
+#include "CommandRing.h"
 #include "Port.h"
 #include "ServerPort.h"
 #include "ClientPort.h"
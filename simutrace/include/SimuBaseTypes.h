@@ -236,7 +236,8 @@ extern "C"
     /*! \internal \brief Communication channel capabilities. */
     typedef enum _ChannelCapabilities {
         CCapNone           = 0x0000,
-        CCapHandleTransfer = 0x0001
+        CCapHandleTransfer = 0x0001,
+        CCapCommandRing    = 0x0002
     } ChannelCapabilities;
 #endif
 
@@ -61,8 +61,10 @@
 
 #include <netdb.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
 
+#include <poll.h>
 #include <signal.h>
 #include <pthread.h>
 #include <semaphore.h>
@@ -74,6 +76,11 @@
 
 #include <time.h>
 
+#if defined(__linux__)
+#include <linux/errqueue.h>
+#include <linux/futex.h>
+#endif
+
 #if (defined(__MACH__) && defined(__APPLE__))
 #include <mach/mach.h>
 #include <mach/clock.h>
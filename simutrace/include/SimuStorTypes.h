@@ -328,35 +328,85 @@ extern "C"
         return _false;
     }
 
+    /*! \internal \brief Finds offset of the first entry starting in a
+     *            buffer of variable-sized data.
+     *
+     *  An entry reaching over into the next segment is counted to the first
+     *  segment only. A segment may thus start with the remaining blocks of
+     *  an entry from the previous segment, which we need to skip. Returns
+     *  \p size if no entry starts in the buffer.
+     */
+    static inline size_t findFirstVariableEntry(const byte* buffer,
+                                                size_t size,
+                                                uint32_t sizeHint,
+                                                uint64_t entryCount)
+    {
+        assert(buffer != NULL);
+        assert((sizeHint > sizeof(VDataBlockHeader)) &&
+               (sizeHint <= VARIABLE_ENTRY_MAX_SIZE));
+
+        uint64_t endCount = 0;
+        size_t firstEnd = size;
+        _bool continued = _false;
+        size_t offset;
+
+        if (entryCount == 0) {
+            return size;
+        }
+
+        for (offset = 0; offset + sizeHint <= size; offset += sizeHint) {
+            const VDataBlockHeader* header =
+                (const VDataBlockHeader*)(buffer + offset);
+
+            continued = header->continuation;
+            if (!continued) {
+                if (endCount++ == 0) {
+                    firstEnd = offset;
+                }
+            }
+        }
+
+        /* Each entry starting in the buffer ends in the buffer, except for
+           a last entry, which is continued in the next segment. Any extra
+           end belongs to an entry of the previous segment.                */
+        if (endCount + (continued ? 1 : 0) > entryCount) {
+            assert(endCount + (continued ? 1 : 0) == entryCount + 1);
+            return firstEnd + sizeHint;
+        }
+
+        return 0;
+    }
+
     /*! \internal \brief Finds offset of the first block of the n-th entry */
     static inline size_t findVariableEntry(const byte* buffer, size_t size,
+                                           uint32_t sizeHint,
                                            uint64_t localSearchIndex)
     {
         assert(buffer != NULL);
-        assert(size > sizeof(VDataBlockHeader));
+        assert((sizeHint > sizeof(VDataBlockHeader)) &&
+               (sizeHint <= VARIABLE_ENTRY_MAX_SIZE));
 
+        /* Each block occupies sizeHint bytes, regardless of the amount of
+           data it holds. An entry starts with the block following the last
+           block of the previous entry.                                    */
         uint64_t localIndex = 0;
-        const byte* buf = buffer;
-        do {
-            VDataBlockHeader* header = (VDataBlockHeader*)(buffer);
+        size_t offset = 0;
+        while (offset + sizeHint <= size) {
+            const VDataBlockHeader* header =
+                (const VDataBlockHeader*)(buffer + offset);
+
+            if (localIndex == localSearchIndex) {
+                return offset;
+            }
 
             if (!header->continuation) {
                 localIndex++;
-
-                if (localIndex == localSearchIndex) {
-                    return buffer - buf;
-                }
             }
 
-            /* Move the buffer to the next block. */
-            size_t sizeHint = sizeof(VDataBlockHeader) + header->size;
-            assert(size >= sizeHint);
-
-            buffer += sizeHint;
-            size -= sizeHint;
-        } while (size > sizeof(VDataBlockHeader));
+            offset += sizeHint;
+        }
 
-        return -1;
+        return (size_t)-1;
     }
 #endif /* SIMUTRACE */
 
@@ -601,6 +651,25 @@ extern "C"
     } StreamQueryInformation;
 
 
+    /*! \brief Range of segments in a stream.
+     *
+     *  Describes a part of a stream by the sequence numbers of its first and
+     *  last segment. Both segments are part of the stream. Segments between
+     *  them may be missing.
+     *
+     *  \since 3.2.2
+     *
+     *  \see StStreamPartition()
+     *  \see StStreamOpenPartition()
+     */
+    typedef struct _StreamPartition {
+        StreamSegmentId first;  /*!< \brief Sequence number of the first
+                                     segment in the partition */
+        StreamSegmentId last;   /*!< \brief Sequence number of the last
+                                     segment in the partition */
+    } StreamPartition;
+
+
     /*! \internal \brief Segment control element. */
     typedef struct _SegmentControlElement {
         /* Modified by the server - do not touch! */
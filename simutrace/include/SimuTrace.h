@@ -998,6 +998,137 @@ extern "C"
     _bool StStreamClose(StreamHandle handle);
 
 
+    /*! \brief Splits a stream into partitions for parallel reading.
+     *
+     *  This method divides the segments of a stream into ranges of
+     *  consecutive sequence numbers, which contain about the same number of
+     *  segments. Each partition can be read with its own handle (see
+     *  StStreamOpenPartition()), for example, by a dedicated thread.
+     *
+     *  \param session The id of the session that holds the stream of interest.
+     *
+     *  \param stream The id of the stream to partition. Dynamic streams
+     *                cannot be partitioned.
+     *
+     *  \param count The maximum number of partitions.
+     *
+     *  \param partitionsOut Pointer to an array with at least \p count
+     *                       elements, which receives the partitions in the
+     *                       order of the stream.
+     *
+     *  \returns The number of partitions written to \p partitionsOut. This
+     *           may be less than \p count, if the stream does not contain
+     *           enough segments, and is 0 for an empty stream. On error the
+     *           method returns -1. For a more detailed error description
+     *           call StGetLastError().
+     *
+     *  \remarks Only segments which have been completely processed by the
+     *           server are included in the partitions.
+     *
+     *  \since 3.2.2
+     *
+     *  \see StStreamOpenPartition()
+     *  \see StStreamParallelScan()
+     */
+    SIMUTRACE_API
+    int StStreamPartition(SessionId session, StreamId stream, uint32_t count,
+                          StreamPartition* partitionsOut);
+
+
+    /*! \brief Opens a read handle to a partition of a stream.
+     *
+     *  This method opens a new read handle, which points to the first entry
+     *  of the supplied partition. StGetNextEntryFast() returns \c NULL after
+     *  the last entry of the partition, as it does at the end of a stream.
+     *
+     *  \param session The id of the session that holds the stream of interest.
+     *
+     *  \param stream The id of the stream to open a handle for.
+     *
+     *  \param partition The partition to read as returned by
+     *                   StStreamPartition().
+     *
+     *  \param flags Supplies information on how the caller intends to access
+     *               the stream with the requested handle. For more information
+     *               see #StreamAccessFlags.
+     *
+     *  \returns A read handle to the partition if successful, \c NULL
+     *           otherwise. For a more detailed error description call
+     *           StGetLastError().
+     *
+     *  \remarks The server keeps the read ahead of each partition handle
+     *           apart and within the partition. The handles of a session
+     *           share the read ahead budget of the session, so parallel
+     *           readers do not evict each other's segments.
+     *
+     *  \remarks Only reading forward is bounded by the partition. The bound
+     *           remains, if the handle is reused with StStreamOpen().
+     *
+     *  \remarks Close the handle with StStreamClose().
+     *
+     *  \since 3.2.2
+     *
+     *  \see StStreamPartition()
+     *  \see StStreamParallelScan()
+     */
+    SIMUTRACE_API
+    StreamHandle StStreamOpenPartition(SessionId session, StreamId stream,
+                                       const StreamPartition* partition,
+                                       StreamAccessFlags flags);
+
+
+    /*! \brief Reads a stream with multiple threads.
+     *
+     *  This method splits the stream into at most \p threadCount partitions
+     *  (see StStreamPartition()) and starts a thread for each partition. The
+     *  threads join the session, open a handle to their partition and call
+     *  the \p scan handler with it. When all partitions have been scanned,
+     *  the method calls the \p reduce handler for each partition in the
+     *  calling thread, so the results of the partitions can be merged in
+     *  the order of the stream.
+     *
+     *  \param session The id of the session that holds the stream of interest.
+     *
+     *  \param stream The id of the stream to scan. Dynamic streams cannot be
+     *                scanned in parallel.
+     *
+     *  \param threadCount The maximum number of threads and partitions.
+     *
+     *  \param flags Supplies information on how the \p scan handler accesses
+     *               the partitions. For more information see
+     *               #StreamAccessFlags. Usually \c SafSequentialScan.
+     *
+     *  \param scan Handler, which reads a partition. Must not be \c NULL.
+     *
+     *  \param reduce Handler, which merges the result of a partition. May be
+     *                \c NULL.
+     *
+     *  \param userData User-defined data passed to the handlers.
+     *
+     *  \returns \c _true if successful, \c _false otherwise. For a more
+     *           detailed error description call StGetLastError(). If a
+     *           handler failed, the error has the #EcUser class and the
+     *           value returned by the handler as code.
+     *
+     *  \remarks The partition indices passed to the handlers are less than
+     *           \p threadCount. There may be fewer partitions than threads.
+     *
+     *  \remarks If any partition fails, the method does not call the
+     *           \p reduce handler. If several partitions fail, the method
+     *           returns the error of the first failed partition.
+     *
+     *  \since 3.2.2
+     *
+     *  \see StStreamPartition()
+     *  \see StStreamOpenPartition()
+     */
+    SIMUTRACE_API
+    _bool StStreamParallelScan(SessionId session, StreamId stream,
+                               uint32_t threadCount, StreamAccessFlags flags,
+                               ParallelScanPartition scan,
+                               ParallelScanReduce reduce, void* userData);
+
+
     /* Tracing API */
 
     /*! \brief Returns a pointer to the next entry in a stream.
@@ -1280,6 +1411,227 @@ extern "C"
     void StSubmitEntry(StreamHandle handle);
 
 
+    /*! \brief Returns all remaining entries of the current segment.
+     *
+     *  This method performs the same operation as StGetNextEntryFast() for
+     *  a whole run of entries. It returns a pointer to the next entry and
+     *  the number of entries that directly follow in the handle's current
+     *  segment, and moves the read pointer of the supplied handle behind
+     *  the last of these entries. If the handle already reached the end of
+     *  the segment, the method proceeds to the next segment first.
+     *
+     *  \param handlePtr A pointer to the stream read handle. The method may
+     *                   allocate a new handle and update the supplied pointer.
+     *
+     *  \param countOut Pointer to a variable receiving the number of entries
+     *                  in the returned span. Must not be \c NULL.
+     *
+     *  \returns A pointer to the first entry of the span if successful,
+     *           \c NULL otherwise. For a more detailed error description call
+     *           StGetLastError(). On error, the supplied handle will be
+     *           invalidated. If successful, the caller may access the entries
+     *           as an array of the data type supplied at stream registration.
+     *
+     *  \remarks This method is not thread-safe when operating on the same
+     *           handle.
+     *
+     *  \remarks The span stays valid until the next call on the handle.
+     *           Spans of dynamic streams always contain a single entry.
+     *
+     *  \remarks Use StReserveEntriesFast() to write entries in bulk.
+     *           Reading variable-sized data with spans is not supported.
+     *
+     *  \since 3.2.2
+     *
+     *  \see StGetNextEntries()
+     *  \see StGetNextEntryFast()
+     *  \see StReserveEntriesFast()
+     */
+    static inline void* StGetNextEntriesFast(StreamHandle* handlePtr,
+                                             size_t* countOut)
+    {
+        STASSERT(handlePtr != NULL);
+        STASSERT(countOut != NULL);
+        StreamHandle handle = *handlePtr;
+        STASSERT(handle != NULL);
+        STASSERT(!isVariableEntrySize(handle->entrySize));
+        STASSERT((handle->flags & SsfRead) != 0);
+
+        byte* entry = handle->entry;
+
+        /* If there is no entry left in the segment, StGetNextEntryFast()
+           proceeds the handle to the next segment and returns its first
+           entry. We extend the span from there.                             */
+        if (entry + handle->entrySize > handle->segmentEnd) {
+            entry = (byte*)StGetNextEntryFast(handlePtr);
+            if (entry == NULL) {
+                *countOut = 0;
+                return NULL;
+            }
+
+            handle = *handlePtr;
+
+            /* Dynamic streams deliver one entry at a time */
+            if ((handle->flags & SsfDynamic) != 0) {
+                *countOut = 1;
+                return entry;
+            }
+        }
+
+        size_t count = (size_t)(handle->segmentEnd - entry) /
+                       handle->entrySize;
+
+        STASSERT((entry >= handle->segmentStart) && (count > 0));
+
+        handle->entry = entry + count * handle->entrySize;
+
+        *countOut = count;
+        return entry;
+    }
+
+
+    /*! \brief Returns all remaining entries of the current segment.
+     *
+     *  This method performs the same operation as StGetNextEntriesFast() as
+     *  part of the client library exported interface.
+     *
+     *  \since 3.2.2
+     *
+     *  \see StGetNextEntriesFast()
+     */
+    SIMUTRACE_API
+    void* StGetNextEntries(StreamHandle* handlePtr, size_t* countOut);
+
+
+    /*! \brief Reserves the remaining space of the current segment.
+     *
+     *  This method returns a pointer to the space for the next entry and the
+     *  number of entries that fit into the handle's current segment. The
+     *  caller writes the entries to the span and completes them with a single
+     *  call to StSubmitEntriesFast(). If the current segment is full, the
+     *  method submits it and proceeds to a new segment first.
+     *
+     *  \param handlePtr A pointer to the stream write handle. The method may
+     *                   allocate a new handle and update the supplied pointer.
+     *
+     *  \param countOut Pointer to a variable receiving the number of entries
+     *                  that fit into the returned span. Must not be \c NULL.
+     *
+     *  \returns A pointer to the first entry of the span if successful,
+     *           \c NULL otherwise. For a more detailed error description call
+     *           StGetLastError(). On error, the supplied handle will be
+     *           invalidated.
+     *
+     *  \remarks This method is not thread-safe when operating on the same
+     *           handle.
+     *
+     *  \remarks The reservation does not move the write pointer. Only the
+     *           entries passed to StSubmitEntriesFast() become part of the
+     *           stream. Calling StReserveEntriesFast() again without
+     *           submitting entries returns the same span.
+     *
+     *  \remarks The buffer space returned by this method is not zeroed and
+     *           may contain arbitrary data.
+     *
+     *  \remarks Writing variable-sized data with spans is not supported.
+     *
+     *  \since 3.2.2
+     *
+     *  \see StReserveEntries()
+     *  \see StSubmitEntriesFast()
+     *  \see StGetNextEntriesFast()
+     */
+    static inline void* StReserveEntriesFast(StreamHandle* handlePtr,
+                                             size_t* countOut)
+    {
+        STASSERT(handlePtr != NULL);
+        STASSERT(countOut != NULL);
+        StreamHandle handle = *handlePtr;
+        STASSERT(handle != NULL);
+        STASSERT(!isVariableEntrySize(handle->entrySize));
+        STASSERT((handle->flags & SsfRead) == 0);
+        STASSERT((handle->flags & SsfDynamic) == 0);
+
+        byte* entry = handle->entry;
+
+        /* Submit the full segment and request a new one from the server    */
+        if (entry + handle->entrySize > handle->segmentEnd) {
+            handle = StStreamAppend(INVALID_SESSION_ID, INVALID_STREAM_ID,
+                                    handle);
+
+            *handlePtr = handle;
+            if ((handle == NULL) || (handle->stat.control == NULL)) {
+                *countOut = 0;
+                return NULL;
+            }
+            entry = handle->entry;
+        }
+
+        size_t count = (size_t)(handle->segmentEnd - entry) /
+                       handle->entrySize;
+
+        STASSERT((entry >= handle->segmentStart) && (count > 0));
+
+        *countOut = count;
+        return entry;
+    }
+
+
+    /*! \brief Reserves the remaining space of the current segment.
+     *
+     *  This method performs the same operation as StReserveEntriesFast() as
+     *  part of the client library exported interface.
+     *
+     *  \since 3.2.2
+     *
+     *  \see StReserveEntriesFast()
+     */
+    SIMUTRACE_API
+    void* StReserveEntries(StreamHandle* handlePtr, size_t* countOut);
+
+
+    /*! \brief Completes a run of entries.
+     *
+     *  This method completes the first \p count entries of the span returned
+     *  by the last call to StReserveEntriesFast() and moves the write pointer
+     *  of the handle behind them.
+     *
+     *  \param handle The write handle of the stream, which has been used in
+     *                the matching call to StReserveEntriesFast().
+     *
+     *  \param count The number of entries to complete. Must not exceed the
+     *               size of the reserved span.
+     *
+     *  \since 3.2.2
+     *
+     *  \see StSubmitEntries()
+     *  \see StReserveEntriesFast()
+     */
+    static inline void StSubmitEntriesFast(StreamHandle handle, size_t count)
+    {
+        STASSERT((handle->flags & SsfRead) == 0);
+        STASSERT((handle->flags & SsfDynamic) == 0);
+        STASSERT(handle->entry + count * handle->entrySize <=
+                 handle->segmentEnd);
+
+        handle->entry += count * handle->entrySize;
+        handle->stat.control->rawEntryCount += (uint32_t)count;
+    }
+
+
+    /*! \brief Completes a run of entries.
+     *
+     *  This method performs the same operation as StSubmitEntriesFast() as
+     *  part of the client library exported interface.
+     *
+     *  \since 3.2.2
+     *
+     *  \see StSubmitEntriesFast()
+     */
+    SIMUTRACE_API
+    void StSubmitEntries(StreamHandle handle, size_t count);
+
+
     /*! \brief Writes variable-sized data to a stream.
      *
      *  In Simutrace, entries are required to be of fixed size. This method
@@ -0,0 +1,444 @@
+/*
+ * Copyright 2015 (C) Karlsruhe Institute of Technology (KIT)
+ * Marc Rittinghaus
+ *
+ *             _____ _                 __
+ *            / ___/(_)___ ___  __  __/ /__________ _________
+ *            \__ \/ / __ `__ \/ / / / __/ ___/ __ `/ ___/ _ \
+ *           ___/ / / / / / / / /_/ / /_/ /  / /_/ / /__/  __/
+ *          /____/_/_/ /_/ /_/\__,_/\__/_/   \__,_/\___/\___/
+ *                         http://simutrace.org
+ *
+ * Simutrace Client Library (libsimutrace) is part of Simutrace.
+ *
+ * libsimutrace is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libsimutrace is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libsimutrace. If not, see <http://www.gnu.org/licenses/>.
+ */
+/*! \file */
+#pragma once
+#ifndef SIMUTRACE_STREAM_H
+#define SIMUTRACE_STREAM_H
+
+#ifndef __cplusplus
+#error "SimuTraceStream.h requires C++. Use SimuTrace.h from C."
+#endif
+
+#include <iterator>
+#include <type_traits>
+
+#include "SimuTrace.h"
+
+namespace SimuTrace {
+
+    /*! \brief Compile-time properties of an entry type.
+     *
+     *  Specializations exist for the memory entry types in
+     *  SimuTraceEntryTypes.h. Specialize the template for custom entry types
+     *  to use them with TypedStream::registerStream().
+     *
+     *  \since 3.2.2
+     */
+    template<typename T>
+    struct EntryTraits
+    {
+        static const bool isMemoryEntry = false;
+    };
+
+    template<typename T, ArchitectureSize S, bool D>
+    struct _MemoryEntryTraits
+    {
+        static const bool isMemoryEntry = true;
+        static const ArchitectureSize size = S;
+        static const bool hasData = D;
+
+        static const StreamTypeDescriptor* findType(
+            MemoryAccessType accessType, MemoryAddressType addressType)
+        {
+            return StStreamFindMemoryType(size, accessType, addressType,
+                                          (hasData) ? _true : _false);
+        }
+    };
+
+    template<> struct EntryTraits<MemoryAccess32> :
+        _MemoryEntryTraits<MemoryAccess32, As32Bit, false> {};
+    template<> struct EntryTraits<DataMemoryAccess32> :
+        _MemoryEntryTraits<DataMemoryAccess32, As32Bit, true> {};
+    template<> struct EntryTraits<MemoryAccess64> :
+        _MemoryEntryTraits<MemoryAccess64, As64Bit, false> {};
+    template<> struct EntryTraits<DataMemoryAccess64> :
+        _MemoryEntryTraits<DataMemoryAccess64, As64Bit, true> {};
+
+
+    /*! \brief Typed handle to a stream of fixed-size entries.
+     *
+     *  A TypedStream wraps a #StreamHandle for entries of type \p T. It keeps
+     *  the span of entries that remain in the current segment and only calls
+     *  into the client library when the span is exhausted (see
+     *  StGetNextEntries() and StReserveEntries()). Taking the next entry is
+     *  thus an inlined pointer increment.
+     *
+     *  Errors are reported as in the C API. Methods return \c false or
+     *  \c nullptr and the caller may use StGetLastError() for details.
+     *
+     *  \remarks A TypedStream is not thread-safe. It closes its handle on
+     *           destruction. Entries written with next() are submitted
+     *           when the span is exhausted, on flush() and on close().
+     *
+     *  \since 3.2.2
+     *
+     *  \see StreamRange
+     */
+    template<typename T>
+    class TypedStream
+    {
+        static_assert(std::is_pod<T>::value,
+                      "Stream entries must be plain old data.");
+        static_assert((sizeof(T) & VARIABLE_ENTRY_SIZE_FLAG) == 0,
+                      "Variable-sized entries are not supported.");
+    private:
+        TypedStream(const TypedStream&) = delete;
+        TypedStream& operator=(const TypedStream&) = delete;
+
+        StreamHandle _handle;
+
+        T* _entry;
+        T* _end;
+
+        // Start of the entries written since the last submit
+        T* _pending;
+
+        bool _attach(StreamHandle handle)
+        {
+            if (handle == nullptr) {
+                return false;
+            }
+
+            if (handle->entrySize != sizeof(T)) {
+                StStreamClose(handle);
+                StSetLastError(EcRuntime, RteArgumentException,
+                    "The entry type does not match the entry size of the "
+                    "stream.");
+
+                return false;
+            }
+
+            _handle = handle;
+            return true;
+        }
+
+        void _submit()
+        {
+            if (_pending != _entry) {
+                StSubmitEntries(_handle, static_cast<size_t>(_entry - _pending));
+                _pending = _entry;
+            }
+        }
+
+        bool _refill()
+        {
+            if (_handle == nullptr) {
+                return false;
+            }
+
+            size_t count;
+            void* span;
+
+            if ((_handle->flags & SsfRead) != 0) {
+                span = StGetNextEntries(&_handle, &count);
+            } else {
+                _submit();
+
+                span = StReserveEntries(&_handle, &count);
+            }
+
+            if (span == nullptr) {
+                _entry = _end = _pending = nullptr;
+                return false;
+            }
+
+            _entry = _pending = static_cast<T*>(span);
+            _end = _entry + count;
+
+            return true;
+        }
+
+    public:
+        typedef T EntryType;
+
+        TypedStream() :
+            _handle(nullptr),
+            _entry(nullptr),
+            _end(nullptr),
+            _pending(nullptr) { }
+
+        TypedStream(TypedStream&& other) :
+            _handle(other._handle),
+            _entry(other._entry),
+            _end(other._end),
+            _pending(other._pending)
+        {
+            other._handle = nullptr;
+            other._entry = other._end = other._pending = nullptr;
+        }
+
+        ~TypedStream()
+        {
+            close();
+        }
+
+        /*! \brief Registers a new memory stream for the entry type.
+         *
+         *  Only available for entry types with memory entry traits.
+         *
+         *  \returns The id of the new stream, or #INVALID_STREAM_ID.
+         */
+        static StreamId registerStream(SessionId session, const char* name,
+                                       MemoryAccessType accessType,
+                                       MemoryAddressType addressType)
+        {
+            static_assert(EntryTraits<T>::isMemoryEntry,
+                          "No stream type known for the entry type.");
+
+            const StreamTypeDescriptor* type =
+                EntryTraits<T>::findType(accessType, addressType);
+            if (type == nullptr) {
+                return INVALID_STREAM_ID;
+            }
+
+            StreamDescriptor desc;
+            if (!StMakeStreamDescriptorFromType(name, type, &desc)) {
+                return INVALID_STREAM_ID;
+            }
+
+            return StStreamRegister(session, &desc);
+        }
+
+        /*! \brief Opens the stream for reading. See StStreamOpen(). */
+        bool open(SessionId session, StreamId stream,
+                  QueryIndexType type = QIndex, uint64_t value = 0,
+                  StreamAccessFlags flags = SafSequentialScan)
+        {
+            close();
+
+            return _attach(StStreamOpen(session, stream, type, value, flags,
+                                        nullptr));
+        }
+
+        /*! \brief Opens the stream for writing. See StStreamAppend(). */
+        bool append(SessionId session, StreamId stream)
+        {
+            close();
+
+            return _attach(StStreamAppend(session, stream, nullptr));
+        }
+
+        /*! \brief Submits all entries written so far. */
+        void flush()
+        {
+            if ((_handle != nullptr) && ((_handle->flags & SsfRead) == 0)) {
+                _submit();
+            }
+        }
+
+        bool close()
+        {
+            if (_handle == nullptr) {
+                return true;
+            }
+
+            flush();
+
+            _bool result = StStreamClose(_handle);
+
+            _handle = nullptr;
+            _entry = _end = _pending = nullptr;
+
+            return (result != _false);
+        }
+
+        /*! \brief Returns the next entry to read or write.
+         *
+         *  \returns A pointer to the entry, or \c nullptr at the end of the
+         *           stream or on error.
+         */
+        inline T* next()
+        {
+            if ((_entry < _end) || _refill()) {
+                return _entry++;
+            }
+
+            return nullptr;
+        }
+
+        /*! \brief Returns the remaining entries of the current segment.
+         *
+         *  Takes all entries up to the end of the current span. When
+         *  writing, all entries of the span are submitted with the next
+         *  flush.
+         *
+         *  \returns A pointer to the first entry, or \c nullptr at the end
+         *           of the stream or on error.
+         */
+        inline T* nextSpan(size_t& countOut)
+        {
+            if ((_entry < _end) || _refill()) {
+                T* span = _entry;
+
+                countOut = static_cast<size_t>(_end - _entry);
+                _entry = _end;
+
+                return span;
+            }
+
+            countOut = 0;
+            return nullptr;
+        }
+
+        /*! \brief Copies an entry to the stream. */
+        inline bool write(const T& entry)
+        {
+            T* e = next();
+            if (e == nullptr) {
+                return false;
+            }
+
+            *e = entry;
+            return true;
+        }
+
+        bool isOpen() const
+        {
+            return (_handle != nullptr);
+        }
+
+        StreamHandle getHandle() const
+        {
+            return _handle;
+        }
+    };
+
+
+    /*! \brief Input range over the entries of a TypedStream.
+     *
+     *  Reads the stream from its current position to its end. Use it with
+     *  range-based for loops and the algorithms of the standard library that
+     *  work on input iterators.
+     *
+     *  \code
+     *  TypedStream<DataRead64> stream;
+     *  stream.open(session, id);
+     *
+     *  for (const DataRead64& entry : StreamRange<DataRead64>(stream)) {
+     *      ...
+     *  }
+     *  \endcode
+     *
+     *  \since 3.2.2
+     */
+    template<typename T>
+    class StreamRange
+    {
+    private:
+        TypedStream<T>* _stream;
+
+    public:
+        class iterator
+        {
+        private:
+            TypedStream<T>* _stream;
+
+            // The iterator walks the span itself and only goes back to
+            // the stream when it is exhausted.
+            T* _entry;
+            T* _end;
+
+            inline void _nextSpan()
+            {
+                size_t count;
+
+                _entry = _stream->nextSpan(count);
+                _end = _entry + count;
+            }
+
+        public:
+            typedef std::input_iterator_tag iterator_category;
+            typedef T value_type;
+            typedef ptrdiff_t difference_type;
+            typedef T* pointer;
+            typedef T& reference;
+
+            iterator() :
+                _stream(nullptr),
+                _entry(nullptr),
+                _end(nullptr) { }
+
+            explicit iterator(TypedStream<T>* stream) :
+                _stream(stream)
+            {
+                _nextSpan();
+            }
+
+            inline T& operator*() const
+            {
+                return *_entry;
+            }
+
+            inline T* operator->() const
+            {
+                return _entry;
+            }
+
+            inline iterator& operator++()
+            {
+                if (++_entry == _end) {
+                    _nextSpan();
+                }
+
+                return *this;
+            }
+
+            inline iterator operator++(int)
+            {
+                iterator tmp(*this);
+                ++(*this);
+                return tmp;
+            }
+
+            inline bool operator==(const iterator& other) const
+            {
+                return (_entry == other._entry);
+            }
+
+            inline bool operator!=(const iterator& other) const
+            {
+                return (_entry != other._entry);
+            }
+        };
+
+        explicit StreamRange(TypedStream<T>& stream) :
+            _stream(&stream) { }
+
+        iterator begin()
+        {
+            return iterator(_stream);
+        }
+
+        iterator end()
+        {
+            return iterator();
+        }
+    };
+
+}
+
+#endif
@@ -358,7 +358,10 @@ extern "C"
             /* Static streams */
             struct {
                 StreamSegmentId sequenceNumber;
-                uint32_t reserved;
+
+                /* Last segment of a partition handle or
+                   INVALID_STREAM_SEGMENT_ID. Formerly reserved. */
+                StreamSegmentId lastSequenceNumber;
 
                 SegmentControlElement* control;
             } stat;
@@ -398,6 +401,59 @@ extern "C"
      */
     typedef StreamStateDescriptor* StreamHandle;
 
+
+    /*! \brief Parallel scan partition handler
+     *
+     *  StStreamParallelScan() calls this handler once for each partition of
+     *  the scanned stream. The handler runs in a worker thread, which is
+     *  attached to the session of the scan.
+     *
+     *  \param userData The user data passed to StStreamParallelScan().
+     *
+     *  \param partition The index of the partition. Use it to store results
+     *                   per partition in \p userData.
+     *
+     *  \param handlePtr A pointer to a read handle, which points to the first
+     *                   entry of the partition. StGetNextEntryFast() returns
+     *                   \c NULL at the end of the partition. The handler must
+     *                   not close the handle.
+     *
+     *  \returns The handler should return 0 on success or any other value
+     *           otherwise. The return value is then interpreted as error code,
+     *           the scan is aborted and the error code can be retrieved
+     *           through StGetLastError().
+     *
+     *  \remarks The handler is called in parallel for different partitions.
+     *
+     *  \since 3.2.2
+     *
+     *  \see StStreamParallelScan()
+     */
+    typedef int (*ParallelScanPartition)(void* userData, uint32_t partition,
+                                         StreamHandle* handlePtr);
+
+
+    /*! \brief Parallel scan reduce handler
+     *
+     *  StStreamParallelScan() calls this handler in the calling thread after
+     *  all partitions have been scanned successfully. The handler is called
+     *  once for each partition in the order of the partitions.
+     *
+     *  \param userData The user data passed to StStreamParallelScan().
+     *
+     *  \param partition The index of the partition to merge.
+     *
+     *  \returns The handler should return 0 on success or any other value
+     *           otherwise. The return value is then interpreted as error code,
+     *           the reduction is aborted and the error code can be retrieved
+     *           through StGetLastError().
+     *
+     *  \since 3.2.2
+     *
+     *  \see StStreamParallelScan()
+     */
+    typedef int (*ParallelScanReduce)(void* userData, uint32_t partition);
+
 #ifdef __cplusplus
 }
     /* StreamStateFlags */
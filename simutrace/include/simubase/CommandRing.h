@@ -0,0 +1,114 @@
+/*
+ * Copyright 2015 (C) Karlsruhe Institute of Technology (KIT)
+ * Marc Rittinghaus
+ *
+ * Simutrace Base Library (libsimubase) is part of Simutrace.
+ *
+ * libsimubase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libsimubase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libsimubase. If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#ifndef COMMAND_RING_H
+#define COMMAND_RING_H
+
+#include "SimuPlatform.h"
+#include "SimuBaseTypes.h"
+
+namespace SimuTrace
+{
+
+// Number of polls of the ring before a reader or writer goes to sleep. On
+// systems with a single processor, we go to sleep right away.
+#define COMMAND_RING_SPIN_COUNT 500
+
+#define COMMAND_RING_MIN_CAPACITY (4 * 1024)
+#define COMMAND_RING_MAX_CAPACITY (16 * 1024 * 1024)
+
+    class SharedMemorySegment;
+
+    // A command ring connects two processes on the same machine through
+    // shared memory. It consists of two single-producer/single-consumer
+    // byte rings, one for each direction. The server creates the ring and
+    // transfers its handle to the client. A side that finds the ring empty
+    // (or full) spins briefly and then sleeps on a futex until the peer
+    // signals new data (or space). Without futexes, the side polls instead.
+    // Local channels use the ring for all message traffic once it is
+    // enabled, which saves the system calls of the domain socket for each
+    // message. They only do so on Linux (see LocalChannel.h).
+    class CommandRing
+    {
+    private:
+        struct Direction;
+        struct Header;
+
+    private:
+        DISABLE_COPY(CommandRing);
+
+        std::unique_ptr<SharedMemorySegment> _segment;
+        Header* _header;
+        byte* _data;
+
+        uint32_t _capacity;
+        uint32_t _spinCount;
+        bool _isServer;
+        bool _enabled;
+
+        void _initialize();
+
+        Direction& _getDirection(bool send) const;
+        byte* _getBuffer(bool send) const;
+
+        bool _wait(std::atomic<uint64_t>* counter, uint64_t value,
+                   std::atomic<uint32_t>* waiting,
+                   std::atomic<uint32_t>* signal, uint32_t timeout);
+        void _signal(std::atomic<uint32_t>* waiting,
+                     std::atomic<uint32_t>* signal);
+
+        static bool _isValidCapacity(uint32_t capacity);
+        static size_t _getSegmentSize(uint32_t capacity);
+    public:
+        // Creates a new ring with the given capacity per direction (server)
+        CommandRing(uint32_t capacity);
+
+        // Maps a ring created by the peer (client). The ring takes
+        // ownership of the handle and invalidates the caller's value.
+        CommandRing(Handle& handle, uint32_t capacity);
+        ~CommandRing();
+
+        // Writes as many bytes as fit into the ring. Waits up to timeout
+        // ms for free space and returns 0 if there is none. If signal is
+        // false, the peer is not woken up for this data, unless the ring
+        // runs full. Use this for a message header that is directly
+        // followed by a payload.
+        size_t write(const void* data, size_t size, uint32_t timeout,
+                     bool signal = true);
+
+        // Reads up to size bytes. Waits up to timeout ms for data and
+        // returns 0 if there is none.
+        size_t read(void* data, size_t size, uint32_t timeout);
+
+        // Marks the ring as closed and wakes up the peer. Data that is
+        // already in the ring can still be read.
+        void close();
+
+        void enable();
+        bool isEnabled() const;
+        bool isClosed() const;
+
+        Handle getHandle() const;
+        uint32_t getCapacity() const;
+    };
+
+}
+
+#endif
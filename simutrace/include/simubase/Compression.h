@@ -28,6 +28,48 @@ namespace SimuTrace
 
     namespace Compression {
 
+        // Codec identifiers are persisted in trace files. Do not change the
+        // values of existing codecs. LZMA must remain 0x00, because files
+        // written before codecs became selectable carry a zero here.
+        enum CodecId {
+            CiLzma = 0x00,
+            CiLz4  = 0x01,
+            CiNone = 0x02,
+
+            CiInvalid = 0xff
+        };
+
+        typedef size_t (*CompressFunction)(const void* source,
+                                           size_t sourceLength,
+                                           void* destination,
+                                           size_t destinationLength,
+                                           uint32_t level);
+
+        typedef size_t (*DecompressFunction)(const void* source,
+                                             size_t sourceLength,
+                                             void* destination,
+                                             size_t destinationLength);
+
+        struct Codec {
+            CodecId id;
+            const char* name;
+
+            // Levels are codec-specific. Higher levels trade speed for a
+            // better compression ratio.
+            uint32_t defaultLevel;
+            uint32_t maxLevel;
+
+            CompressFunction compress;
+            DecompressFunction decompress;
+        };
+
+        // Returns nullptr if the codec is unknown
+        const Codec* findCodec(CodecId id);
+        const Codec* findCodec(const std::string& name);
+
+        const Codec* getCodec(CodecId id);
+        const Codec* getCodec(const std::string& name);
+
         // LZMA ----
         size_t lzmaCompress(const void* source, size_t sourceLength,
                             void* destination, size_t destinationLength,
@@ -35,6 +77,22 @@ namespace SimuTrace
 
         size_t lzmaDecompress(const void* source, size_t sourceLength,
                               void* destination, size_t destinationLength);
+
+        // LZ4 ----
+        size_t lz4Compress(const void* source, size_t sourceLength,
+                           void* destination, size_t destinationLength,
+                           uint32_t level);
+
+        size_t lz4Decompress(const void* source, size_t sourceLength,
+                             void* destination, size_t destinationLength);
+
+        // None ----
+        size_t storeCompress(const void* source, size_t sourceLength,
+                             void* destination, size_t destinationLength,
+                             uint32_t level);
+
+        size_t storeDecompress(const void* source, size_t sourceLength,
+                               void* destination, size_t destinationLength);
     }
 
 }
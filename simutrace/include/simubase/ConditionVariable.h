@@ -46,6 +46,9 @@ namespace SimuTrace
 
         void wait();
 
+        // Waits at most timeout ms. Returns false, if the timeout expired.
+        bool wait(uint32_t timeout);
+
         void wakeOne();
         void wakeAll();
     };
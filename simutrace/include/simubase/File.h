@@ -54,6 +54,12 @@ namespace SimuTrace
         #endif
         };
 
+        struct IoVector
+        {
+            const void* buffer;
+            size_t size;
+        };
+
     private:
         DISABLE_COPY(File);
 
@@ -103,6 +109,12 @@ namespace SimuTrace
         size_t write(const void* buffer, size_t size, FileOffset offset);
         size_t write(const void* buffer, size_t size);
 
+        ///
+        /// Writes the buffers back-to-back to the file, starting at offset.
+        /// Uses a single gathering system call where supported.
+        ///
+        size_t write(const std::vector<IoVector>& vectors, FileOffset offset);
+
         template<typename T>
         size_t write(const T* buffer, FileOffset offset)
         {
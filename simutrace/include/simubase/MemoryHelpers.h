@@ -37,6 +37,22 @@ namespace SimuTrace
         const int getMemoryAllocationGranularity();
         const uint64_t getAvailablePhysicalMemory();
         const uint64_t getPhysicalMemory();
+
+        // NUMA topology. Systems without NUMA support or where the topology
+        // cannot be determined report a single node with all processors.
+        uint32_t getNumNumaNodes();
+        uint32_t getCurrentNumaNode();
+        const std::vector<uint32_t>& getNumaNodeProcessors(uint32_t node);
+
+        // Splits count elements into numNodes contiguous ranges of (almost)
+        // equal size and returns the node of the range containing index.
+        uint32_t getNumaNodeOfIndex(uint64_t index, uint64_t count,
+                                    uint32_t numNodes);
+
+        // Sets the preferred node for the pages in the given range. Must be
+        // called before the pages are touched for the first time. Returns
+        // false if the policy could not be applied.
+        bool bindMemoryToNumaNode(void* start, size_t size, uint32_t node);
     }
 
 }
@@ -25,11 +25,21 @@
 #include "SimuBaseTypes.h"
 
 #include "RpcInterface.h"
+#include "Compression.h"
 
 namespace SimuTrace
 {
 
+// Data payloads smaller than this are never compressed
+#define PORT_COMPRESSION_THRESHOLD (64 * 1024)
+
+// Default for the largest data payload that the port compresses. The
+// compression buffer grows to the largest payload and is kept between
+// messages, so this also bounds the memory held by each port.
+#define PORT_COMPRESSION_BUFFER_LIMIT (64 * 1024 * 1024)
+
     class Channel;
+    class CommandRing;
 
     class Port
     {
@@ -44,6 +54,19 @@ namespace SimuTrace
 
         uint8_t _lastSequenceNumber;
 
+        // Codec used to compress data payloads sent through this port. The
+        // peer must support the codec (see setCompression()).
+        Compression::CodecId _codec;
+        uint32_t _codecLevel;
+
+        std::unique_ptr<char[]> _compressionBuffer;
+        size_t _compressionBufferSize;
+        size_t _compressionBufferLimit;
+
+        char* _getCompressionBuffer(size_t size);
+
+        uint32_t _compress(const void* payload, uint32_t length);
+        void _decompress(Message& msg, uint32_t length);
     protected:
         Port(bool isServer, const std::string& specifier);
         Port(std::unique_ptr<Channel>& channel);
@@ -69,6 +92,27 @@ namespace SimuTrace
         uint8_t getLastSequenceNumber() const;
 
         ChannelCapabilities getChannelCaps() const;
+
+        // Enables the compression of data payloads with the given codec.
+        // Payloads below PORT_COMPRESSION_THRESHOLD bytes and payloads that
+        // do not compress are sent as they are. Compressed payloads are
+        // decompressed on receive, regardless of this setting. Pass
+        // Compression::CiInvalid to disable compression.
+        void setCompression(Compression::CodecId codec, uint32_t level);
+
+        // Sets the size of the largest data payload that the port
+        // compresses. Larger payloads are sent as they are.
+        void setCompressionBufferLimit(size_t limit);
+
+        Compression::CodecId getCompressionCodec() const;
+        uint32_t getCompressionLevel() const;
+
+        // Moves the message traffic of the port to a command ring in shared
+        // memory, as soon as the ring is enabled. Handles are still
+        // transferred through the channel. Requires a channel with the
+        // CCapCommandRing capability.
+        void setCommandRing(std::unique_ptr<CommandRing>& ring);
+        CommandRing* getCommandRing() const;
     };
 
 }
@@ -46,6 +46,7 @@ namespace SimuTrace
 
     enum MessageFlags {
         MfResponse             = 0x01,
+        MfCompressed           = 0x02,
 
         MfMax
     };
@@ -86,7 +87,8 @@ namespace SimuTrace
     static std::string messageFlagsToStr(uint8_t flags)
     {
         static const char* flagChars[] = {
-            "r" // LmfResponse
+            "r", // MfResponse
+            "z"  // MfCompressed
         };
 
         std::stringstream str;
@@ -72,6 +72,49 @@ namespace Options
                     "between successive connection retries if the server port "
                     "is busy. See also: network.local.retryCount.",
                     OPT_LONG_PREFIX "network.local.retrySleep");
+
+        //
+        // Socket Channel
+        //
+
+        typeMap["network.socket.nagle"] = libconfig::Setting::Type::TypeBoolean;
+        options.add("",
+                    false,
+                    0,
+                    0,
+                    "If set, socket channels keep Nagle's algorithm enabled. "
+                    "By default, small messages are sent immediately "
+                    "(TCP_NODELAY).",
+                    OPT_LONG_PREFIX "network.socket.nagle");
+
+        typeMap["network.socket.sendBufferSize"] = libconfig::Setting::Type::TypeInt;
+        options.add("0",
+                    false,
+                    1,
+                    0,
+                    "The size of the kernel send buffer of socket channels "
+                    "in KiB. A value of 0 keeps the system default.",
+                    OPT_LONG_PREFIX "network.socket.sendBufferSize");
+
+        typeMap["network.socket.receiveBufferSize"] = libconfig::Setting::Type::TypeInt;
+        options.add("0",
+                    false,
+                    1,
+                    0,
+                    "The size of the kernel receive buffer of socket channels "
+                    "in KiB. A value of 0 keeps the system default.",
+                    OPT_LONG_PREFIX "network.socket.receiveBufferSize");
+
+        typeMap["network.socket.zeroCopyThreshold"] = libconfig::Setting::Type::TypeInt;
+        options.add("0",
+                    false,
+                    1,
+                    0,
+                    "Socket channels send messages of at least this size in "
+                    "KiB without copying the data into kernel memory "
+                    "(MSG_ZEROCOPY, Linux only). A value of 0 disables "
+                    "zero-copy sends.",
+                    OPT_LONG_PREFIX "network.socket.zeroCopyThreshold");
     }
 
 }
@@ -124,12 +124,16 @@ namespace SimuTrace
         bool shouldStop() const;
 
         // Waits for the thread to finish its execution
-        void waitForThread() const;
+        void waitForThread();
 
         // Get or set the priority of the thread
         void setPriority(int priority);
         int getPriority() const;
 
+        // Restricts the thread to the processors of the given NUMA node.
+        // Returns false if the platform does not support thread placement.
+        bool setNumaNode(uint32_t node);
+
         // Checks if the thread has finished execution
         bool hasFinished() const;
         bool isRunning() const;
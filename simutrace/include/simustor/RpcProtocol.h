@@ -25,6 +25,7 @@
 #include "SimuStorTypes.h"
 
 #include "RpcInterface.h"
+#include "Compression.h"
 #include "Version.h"
 
 namespace SimuTrace
@@ -116,11 +117,21 @@ namespace SimuTrace
     ///
     /// Arguments:
     ///        Parameter0<uint16_t>: Client API version (with RPC_VER macro)
+    ///        Parameter1<uint64_t>: Transport compression offer in the
+    ///                              upper 32 bits (since 3.2.2, see below)
     ///
     /// Return Value:
     ///        SC_Success on success, SC_Failed otherwise.
     ///
     ///        Parameter0<SessionId> Server Side Session Id
+    ///        Parameter1<uint64_t>: Selected transport compression
+    ///                              (since 3.2.2, see below)
+    ///
+    ///        If the server set up a command ring (since 3.2.2, see below),
+    ///        the response is a handle message instead:
+    ///        Handles: Command ring
+    ///        Parameter0<SessionId> Server Side Session Id
+    ///        Parameter1<uint32_t>: Capacity of the command ring
     ///
     RPC_CALL_V32C(0x0010, SessionCreate, Embedded, 0)
 
@@ -133,14 +144,97 @@ namespace SimuTrace
     ///
     /// Arguments:
     ///        Parameter0<uint16_t>: Client API version (with RPC_VER macro)
-    ///        Parameter1<SessionId>: Session Id
+    ///        Parameter1<SessionId>: Session Id in the lower 32 bits,
+    ///                               transport compression offer in the
+    ///                               upper 32 bits (since 3.2.2, see below)
     ///
     /// Return Value:
     ///        SC_Success on success, SC_Failed otherwise.
     ///
+    ///        Parameter1<uint64_t>: Selected transport compression
+    ///                              (since 3.2.2, see below)
+    ///
+    ///        Handles, Parameter1<uint32_t>: Command ring as for
+    ///                                       SessionCreate.
+    ///
     RPC_CALL_V32C(0x0011, SessionOpen, Embedded, 0)
 
 
+    ///
+    ///    Transport Compression
+    /// -----------------------------------------------------------
+    /// Description:
+    ///        Connections without shared memory transfer segments as message
+    ///        payload. These payloads may be compressed on the wire. When a
+    ///        connection joins a session (SessionCreate, SessionOpen), the
+    ///        client offers the codecs it can decompress as bit mask
+    ///        (1 << Compression::CodecId). The server selects one of them
+    ///        and returns codec and level, which both sides then use to
+    ///        compress payloads they send on the connection. Compressed
+    ///        messages carry the MfCompressed flag. Servers prior to 3.2.2
+    ///        return 0, which means no compression.
+    ///
+    ///
+    ///    Command Ring
+    /// -----------------------------------------------------------
+    /// Description:
+    ///        Clients connected through a channel with the CCapCommandRing
+    ///        capability set the highest bit of the offer instead. The
+    ///        server may then create a command ring in shared memory and
+    ///        return it with the response. Both sides move all further
+    ///        message traffic of the connection to the ring. Handles are
+    ///        still transferred through the channel. Servers prior to 3.2.2
+    ///        return an embedded response, which means no command ring.
+    ///
+
+    namespace RpcApi {
+
+        inline uint64_t makeCompressionOffer(uint32_t codecMask)
+        {
+            return static_cast<uint64_t>(codecMask) << 32;
+        }
+
+        inline uint32_t getCompressionOffer(uint64_t parameter1)
+        {
+            return static_cast<uint32_t>(parameter1 >> 32) & 0xffff;
+        }
+
+        inline uint64_t makeCommandRingOffer()
+        {
+            return 1ULL << 63;
+        }
+
+        inline bool hasCommandRingOffer(uint64_t parameter1)
+        {
+            return (parameter1 & makeCommandRingOffer()) != 0;
+        }
+
+        inline uint64_t makeCompressionSelection(Compression::CodecId codec,
+                                                 uint32_t level)
+        {
+            if (codec == Compression::CiInvalid) {
+                return 0;
+            }
+
+            return ((level & 0xff) << 8) | ((codec + 1) & 0xff);
+        }
+
+        inline Compression::CodecId getSelectedCodec(uint64_t parameter1)
+        {
+            uint32_t codec = static_cast<uint32_t>(parameter1 & 0xff);
+
+            return (codec == 0) ? Compression::CiInvalid :
+                static_cast<Compression::CodecId>(codec - 1);
+        }
+
+        inline uint32_t getSelectedCodecLevel(uint64_t parameter1)
+        {
+            return static_cast<uint32_t>((parameter1 >> 8) & 0xff);
+        }
+
+    }
+
+
     ///
     ///    SessionQuery
     /// -----------------------------------------------------------
@@ -472,6 +566,104 @@ namespace SimuTrace
     ///
     RPC_CALL_V32C(0x0035, StreamClose, Data, 0)
 
+
+    ///
+    ///    StreamSubmitAndAppend
+    /// -----------------------------------------------------------
+    /// Routine Description:
+    ///        Submits the specified append segment and appends a new segment
+    ///        at the end of the stream. In contrast to StreamAppend, a
+    ///        session may hold multiple open append segments of a stream.
+    ///        These must be submitted in the order of their sequence
+    ///        numbers. The index of the first entry in a segment is
+    ///        determined on submission.
+    ///
+    /// Arguments:
+    ///        Parameter0<StreamId>: Stream to apply the operation on.
+    ///        Parameter1<StreamSegmentId>: Id of the append segment to
+    ///                              submit or INVALID_STREAM_SEGMENT_ID to
+    ///                              only append a new segment.
+    ///
+    ///      Only for remote connections:
+    ///        Payload<Segment>: Control element of the segment + the
+    ///                          segment data
+    ///
+    ///      Local connections send a data packet with zero payload size.
+    ///
+    /// Return Value:
+    ///        Same as StreamAppend.
+    ///
+    RPC_CALL_V32(0x0036, StreamSubmitAndAppend, Data, 0)
+
+
+    ///
+    ///    StreamAppendCancel
+    /// -----------------------------------------------------------
+    /// Routine Description:
+    ///        Releases an unused append segment at the end of the stream.
+    ///        The sequence number of the segment is reused by the next
+    ///        append.
+    ///
+    /// Arguments:
+    ///        Parameter0<StreamId>: Stream to apply the operation on.
+    ///        Parameter1<StreamSegmentId>: Id of the append segment
+    ///
+    /// Return Value:
+    ///        SC_Success on success, SC_Failed otherwise.
+    ///
+    RPC_CALL_V32(0x0037, StreamAppendCancel, Embedded, 0)
+
+
+    ///
+    ///    StreamCloseAndOpenRange
+    /// -----------------------------------------------------------
+    /// Routine Description:
+    ///        Same as StreamCloseAndOpen, but restricts the open to the
+    ///        segments up to the specified sequence number. The server
+    ///        fails the open with a not found error, if the query points
+    ///        behind this segment, and does not read ahead beyond it.
+    ///        Read ahead state is kept per range, so a session may scan
+    ///        multiple ranges of a stream in parallel.
+    ///
+    /// Arguments:
+    ///        Parameter0<StreamId>: Stream to apply the operation on.
+    ///        Parameter1<StreamSegmentId>: Sequence number to close.
+    ///
+    ///        Payload<StreamOpenRangeQuery>: Query value and the last
+    ///                                       sequence number of the range
+    ///
+    /// Return Value:
+    ///        Same as StreamCloseAndOpen (Version 3.1).
+    ///
+    struct StreamOpenRangeQuery {
+        StreamOpenQuery query;
+        StreamSegmentId last;
+    };
+
+    RPC_CALL_V32(0x0038, StreamCloseAndOpenRange, Data,
+                 sizeof(StreamOpenRangeQuery))
+
+
+    ///
+    ///    StreamPartition
+    /// -----------------------------------------------------------
+    /// Routine Description:
+    ///        Splits the segments of a stream into ranges of consecutive
+    ///        sequence numbers, which contain about the same number of
+    ///        segments. Only segments that can be opened are included.
+    ///
+    /// Arguments:
+    ///        Parameter0<StreamId>: Stream to partition.
+    ///        Parameter1<uint32_t>: Maximum number of partitions.
+    ///
+    /// Return Value:
+    ///        SC_Success on success, SC_Failed otherwise.
+    ///
+    ///        Parameter0<uint32_t>: Number of partitions
+    ///        Payload<data>: Array of StreamPartition
+    ///
+    RPC_CALL_V32(0x0039, StreamPartition, Embedded, 0)
+
 }
 
 #endif
\ No newline at end of file
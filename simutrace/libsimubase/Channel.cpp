@@ -43,6 +43,20 @@ namespace SimuTrace
 
     }
 
+    size_t Channel::_sendGather(const void* header, size_t headerSize,
+                                const void* data, size_t size)
+    {
+        // Channels that cannot send multiple buffers at once, send the
+        // buffers one after another.
+        size_t bytesSent = _send(header, headerSize);
+
+        if (size > 0) {
+            bytesSent += _send(data, size);
+        }
+
+        return bytesSent;
+    }
+
     bool Channel::_isServerChannel() const
     {
         return _isServer;
@@ -86,6 +100,20 @@ namespace SimuTrace
         return bytesSent;
     }
 
+    size_t Channel::send(const void* header, size_t headerSize,
+                         const void* data, size_t size)
+    {
+        ThrowOn(!isConnected(), InvalidOperationException);
+        ThrowOn(header == nullptr, ArgumentNullException, "header");
+        ThrowOn(headerSize == 0, ArgumentNullException, "headerSize");
+        ThrowOn((data == nullptr) && (size > 0), ArgumentNullException, "data");
+
+        size_t bytesSent = _sendGather(header, headerSize, data, size);
+
+        _bytesSent += bytesSent;
+        return bytesSent;
+    }
+
     size_t Channel::receive(void* data, size_t size)
     {
         ThrowOn(!isConnected(), InvalidOperationException);
@@ -109,6 +137,16 @@ namespace SimuTrace
         return bytesReceived;
     }
 
+    void Channel::attachCommandRing(std::unique_ptr<CommandRing>& ring)
+    {
+        Throw(NotSupportedException);
+    }
+
+    CommandRing* Channel::getCommandRing() const
+    {
+        return nullptr;
+    }
+
     const std::string& Channel::getAddress() const
     {
         return _address;
@@ -27,6 +27,8 @@
 namespace SimuTrace
 {
 
+    class CommandRing;
+
     class Channel
     {
     private:
@@ -46,6 +48,8 @@ namespace SimuTrace
 
         virtual size_t _send(const void* data, size_t size) = 0;
         virtual size_t _send(const std::vector<Handle>& handles) = 0;
+        virtual size_t _sendGather(const void* header, size_t headerSize,
+                                   const void* data, size_t size);
         virtual size_t _receive(void* data, size_t size) = 0;
         virtual size_t _receive(std::vector<Handle>& handles,
                                 uint32_t handleCount) = 0;
@@ -61,9 +65,17 @@ namespace SimuTrace
 
         size_t send(const void* data, size_t size);
         size_t send(const std::vector<Handle>& handles);
+        size_t send(const void* header, size_t headerSize,
+                    const void* data, size_t size);
         size_t receive(void* data, size_t size);
         size_t receive(std::vector<Handle>& handles, uint32_t handleCount);
 
+        // Moves the message traffic of the channel to the ring, as soon as
+        // the ring is enabled. Only channels with the CCapCommandRing
+        // capability support command rings.
+        virtual void attachCommandRing(std::unique_ptr<CommandRing>& ring);
+        virtual CommandRing* getCommandRing() const;
+
         virtual bool isConnected() const = 0;
         virtual ChannelCapabilities getChannelCaps() const = 0;
 
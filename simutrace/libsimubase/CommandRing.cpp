@@ -0,0 +1,414 @@
+/*
+ * Copyright 2015 (C) Karlsruhe Institute of Technology (KIT)
+ * Marc Rittinghaus
+ *
+ * Simutrace Base Library (libsimubase) is part of Simutrace.
+ *
+ * libsimubase is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libsimubase is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libsimubase. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "SimuPlatform.h"
+#include "SimuBaseTypes.h"
+
+#include "CommandRing.h"
+
+#include "Clock.h"
+#include "Exceptions.h"
+#include "SharedMemorySegment.h"
+#include "ThreadBase.h"
+#include "Utils.h"
+
+#define COMMAND_RING_MAGIC 0x474e4952 // 'RING'
+
+namespace SimuTrace
+{
+
+    // The head and the tail are running byte counters. Only the producer
+    // writes the head and only the consumer writes the tail. Each sits in
+    // its own cache line, so the sides do not invalidate each other's line
+    // with every update. The signal words are the futexes a sleeping side
+    // waits on. The waiting flags tell the peer that it has to wake us up.
+    struct CommandRing::Direction
+    {
+        std::atomic<uint64_t> head;
+        uint8_t reserved0[56];
+
+        std::atomic<uint64_t> tail;
+        uint8_t reserved1[56];
+
+        std::atomic<uint32_t> dataSignal;
+        std::atomic<uint32_t> spaceSignal;
+        std::atomic<uint32_t> consumerWaiting;
+        std::atomic<uint32_t> producerWaiting;
+        uint8_t reserved2[48];
+    };
+
+    struct CommandRing::Header
+    {
+        uint32_t magic;
+        uint32_t capacity;
+        std::atomic<uint32_t> closed;
+        uint8_t reserved[52];
+
+        // [0] client to server, [1] server to client
+        Direction directions[2];
+    };
+
+    // Both processes access the header through their own mapping. The
+    // atomics must therefore be lock-free and have the size of the plain
+    // types, so the signal words can serve as futexes.
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+                  "std::atomic<uint32_t> must have the size of uint32_t.");
+    static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t),
+                  "std::atomic<uint64_t> must have the size of uint64_t.");
+
+    namespace {
+
+        inline void _cpuRelax()
+        {
+        #if defined(_WIN32)
+            YieldProcessor();
+        #elif defined(__i386__) || defined(__x86_64__)
+            __builtin_ia32_pause();
+        #endif
+        }
+
+    #if defined(__linux__)
+        // Sleeps until the signal changes from value, the peer wakes us up
+        // or the timeout in ms expires.
+        inline void _sleepOnSignal(std::atomic<uint32_t>* signal,
+                                   uint32_t value, uint32_t timeout)
+        {
+            struct timespec ts;
+            ts.tv_sec  = timeout / 1000;
+            ts.tv_nsec = (timeout % 1000) * 1000000;
+
+            ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(signal),
+                      FUTEX_WAIT, value, &ts, nullptr, 0);
+        }
+
+        inline void _wakeOnSignal(std::atomic<uint32_t>* signal)
+        {
+            ::syscall(SYS_futex, reinterpret_cast<uint32_t*>(signal),
+                      FUTEX_WAKE, std::numeric_limits<int>::max(), nullptr,
+                      nullptr, 0);
+        }
+    #else
+        // Without futexes, we poll the signal. Local channels only use
+        // command rings on Linux (see LocalChannel::getChannelCaps()).
+        inline void _sleepOnSignal(std::atomic<uint32_t>* signal,
+                                   uint32_t value, uint32_t timeout)
+        {
+            uint64_t end = Clock::getTicks() +
+                static_cast<uint64_t>(timeout) * 1000000;
+
+            while ((signal->load(std::memory_order_acquire) == value) &&
+                   (Clock::getTicks() < end)) {
+                ThreadBase::sleep(1);
+            }
+        }
+
+        inline void _wakeOnSignal(std::atomic<uint32_t>* signal)
+        {
+            // The sleeping side sees the new signal when it polls next.
+        }
+    #endif
+
+    }
+
+    CommandRing::CommandRing(uint32_t capacity) :
+        _segment(),
+        _header(nullptr),
+        _data(nullptr),
+        _capacity(capacity),
+        _spinCount((System::getNumLogicalProcessors() > 1) ?
+                   COMMAND_RING_SPIN_COUNT : 0),
+        _isServer(true),
+        _enabled(false)
+    {
+        ThrowOn(!_isValidCapacity(capacity), ArgumentOutOfBoundsException,
+                "capacity");
+
+        Guid guid;
+        generateGuid(guid);
+
+        std::string name = stringFormat("simutrace.ring.%s",
+    #if (defined(__MACH__) && defined(__APPLE__))
+                                        guidToString(guid, true).c_str());
+    #else
+                                        guidToString(guid).c_str());
+    #endif
+
+        _segment = std::unique_ptr<SharedMemorySegment>(
+            new SharedMemorySegment(name, true, _getSegmentSize(capacity)));
+
+        _initialize();
+
+        memset(static_cast<void*>(_header), 0, sizeof(Header));
+        _header->magic    = COMMAND_RING_MAGIC;
+        _header->capacity = capacity;
+    }
+
+    CommandRing::CommandRing(Handle& handle, uint32_t capacity) :
+        _segment(),
+        _header(nullptr),
+        _data(nullptr),
+        _capacity(capacity),
+        _spinCount((System::getNumLogicalProcessors() > 1) ?
+                   COMMAND_RING_SPIN_COUNT : 0),
+        _isServer(false),
+        _enabled(false)
+    {
+        ThrowOn(handle == INVALID_HANDLE_VALUE, ArgumentException, "handle");
+        ThrowOn(!_isValidCapacity(capacity), ArgumentOutOfBoundsException,
+                "capacity");
+
+        _segment = std::unique_ptr<SharedMemorySegment>(
+            new SharedMemorySegment(handle, true, _getSegmentSize(capacity)));
+
+        // The segment takes care of closing the handle.
+        handle = INVALID_HANDLE_VALUE;
+
+        _initialize();
+
+        ThrowOn((_header->magic != COMMAND_RING_MAGIC) ||
+                (_header->capacity != capacity), Exception,
+                "The command ring does not match the expected layout.");
+    }
+
+    CommandRing::~CommandRing()
+    {
+        close();
+
+        _segment->unmap();
+    }
+
+    void CommandRing::_initialize()
+    {
+        _segment->map();
+
+        _header = reinterpret_cast<Header*>(_segment->getBuffer());
+        _data = _segment->getBuffer() + sizeof(Header);
+    }
+
+    bool CommandRing::_isValidCapacity(uint32_t capacity)
+    {
+        // The capacity must be a power of 2, so the running counters can
+        // be mapped to the buffer with a mask.
+        return (capacity >= COMMAND_RING_MIN_CAPACITY) &&
+               (capacity <= COMMAND_RING_MAX_CAPACITY) &&
+               ((capacity & (capacity - 1)) == 0);
+    }
+
+    size_t CommandRing::_getSegmentSize(uint32_t capacity)
+    {
+        return sizeof(Header) + 2 * static_cast<size_t>(capacity);
+    }
+
+    CommandRing::Direction& CommandRing::_getDirection(bool send) const
+    {
+        // The client sends on direction 0, the server on direction 1
+        return _header->directions[(send == _isServer) ? 1 : 0];
+    }
+
+    byte* CommandRing::_getBuffer(bool send) const
+    {
+        return _data + ((send == _isServer) ? _capacity : 0);
+    }
+
+    bool CommandRing::_wait(std::atomic<uint64_t>* counter, uint64_t value,
+                            std::atomic<uint32_t>* waiting,
+                            std::atomic<uint32_t>* signal, uint32_t timeout)
+    {
+        // The peer usually answers within a few microseconds. Spinning
+        // saves the two system calls for going to sleep and waking up.
+        for (uint32_t i = 0; i < _spinCount; ++i) {
+            if ((counter->load(std::memory_order_acquire) != value) ||
+                isClosed()) {
+                return true;
+            }
+
+            _cpuRelax();
+        }
+
+        uint32_t seq = signal->load(std::memory_order_acquire);
+
+        // Announce that we are going to sleep, before we check the counter
+        // for the last time. The peer updates the counter before it checks
+        // our flag. Either we see the new counter, or the peer sees the
+        // flag and changes the signal, so the futex does not block.
+        waiting->store(1, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if ((counter->load(std::memory_order_acquire) == value) &&
+            !isClosed()) {
+            _sleepOnSignal(signal, seq, timeout);
+        }
+
+        waiting->store(0, std::memory_order_release);
+
+        return (counter->load(std::memory_order_acquire) != value) ||
+               isClosed();
+    }
+
+    void CommandRing::_signal(std::atomic<uint32_t>* waiting,
+                              std::atomic<uint32_t>* signal)
+    {
+        // Pairs with the fence in _wait()
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        if (waiting->load(std::memory_order_acquire) == 0) {
+            return;
+        }
+
+        signal->fetch_add(1, std::memory_order_seq_cst);
+        _wakeOnSignal(signal);
+    }
+
+    size_t CommandRing::write(const void* data, size_t size,
+                              uint32_t timeout, bool signal)
+    {
+        assert(data != nullptr);
+        assert(_enabled);
+
+        Direction& dir = _getDirection(true);
+        byte* buffer = _getBuffer(true);
+
+        ThrowOn(isClosed(), PlatformException, ECONNRESET);
+
+        uint64_t head = dir.head.load(std::memory_order_relaxed);
+        uint64_t tail = dir.tail.load(std::memory_order_acquire);
+
+        if (head - tail == _capacity) {
+            // The peer might sleep on data that we have not signaled, yet.
+            _signal(&dir.consumerWaiting, &dir.dataSignal);
+
+            _wait(&dir.tail, tail, &dir.producerWaiting, &dir.spaceSignal,
+                  timeout);
+
+            ThrowOn(isClosed(), PlatformException, ECONNRESET);
+
+            tail = dir.tail.load(std::memory_order_acquire);
+            if (head - tail == _capacity) {
+                return 0;
+            }
+        }
+
+        size_t length = std::min(size,
+            static_cast<size_t>(_capacity - (head - tail)));
+
+        // Copy the data in up to two parts, if it wraps around the end
+        uint32_t offset = static_cast<uint32_t>(head & (_capacity - 1));
+        size_t first = std::min(length, static_cast<size_t>(_capacity - offset));
+
+        memcpy(buffer + offset, data, first);
+        if (first < length) {
+            memcpy(buffer, static_cast<const byte*>(data) + first,
+                   length - first);
+        }
+
+        dir.head.store(head + length, std::memory_order_release);
+
+        if (signal) {
+            _signal(&dir.consumerWaiting, &dir.dataSignal);
+        }
+
+        return length;
+    }
+
+    size_t CommandRing::read(void* data, size_t size, uint32_t timeout)
+    {
+        assert(data != nullptr);
+        assert(_enabled);
+
+        Direction& dir = _getDirection(false);
+        byte* buffer = _getBuffer(false);
+
+        uint64_t tail = dir.tail.load(std::memory_order_relaxed);
+        uint64_t head = dir.head.load(std::memory_order_acquire);
+
+        if (head == tail) {
+            // Data written before the ring has been closed is still
+            // delivered. This is the same as with a socket.
+            ThrowOn(isClosed(), PlatformException, ECONNRESET);
+
+            _wait(&dir.head, head, &dir.consumerWaiting, &dir.dataSignal,
+                  timeout);
+
+            head = dir.head.load(std::memory_order_acquire);
+            if (head == tail) {
+                ThrowOn(isClosed(), PlatformException, ECONNRESET);
+
+                return 0;
+            }
+        }
+
+        size_t length = std::min(size, static_cast<size_t>(head - tail));
+
+        uint32_t offset = static_cast<uint32_t>(tail & (_capacity - 1));
+        size_t first = std::min(length, static_cast<size_t>(_capacity - offset));
+
+        memcpy(data, buffer + offset, first);
+        if (first < length) {
+            memcpy(static_cast<byte*>(data) + first, buffer, length - first);
+        }
+
+        dir.tail.store(tail + length, std::memory_order_release);
+        _signal(&dir.producerWaiting, &dir.spaceSignal);
+
+        return length;
+    }
+
+    void CommandRing::close()
+    {
+        if ((_header == nullptr) || isClosed()) {
+            return;
+        }
+
+        _header->closed.store(1, std::memory_order_release);
+
+        // Wake up the peer, regardless of what it is waiting for.
+        for (int i = 0; i < 2; ++i) {
+            Direction& dir = _header->directions[i];
+
+            _signal(&dir.consumerWaiting, &dir.dataSignal);
+            _signal(&dir.producerWaiting, &dir.spaceSignal);
+        }
+    }
+
+    void CommandRing::enable()
+    {
+        _enabled = true;
+    }
+
+    bool CommandRing::isEnabled() const
+    {
+        return _enabled;
+    }
+
+    bool CommandRing::isClosed() const
+    {
+        return (_header->closed.load(std::memory_order_acquire) != 0);
+    }
+
+    Handle CommandRing::getHandle() const
+    {
+        return _segment->getHandle();
+    }
+
+    uint32_t CommandRing::getCapacity() const
+    {
+        return _capacity;
+    }
+
+}
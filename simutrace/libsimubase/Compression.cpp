@@ -25,11 +25,64 @@
 #include "Utils.h"
 
 #include "lzma/LzmaLib.h"
+#include <lz4.h>
+
+#if LZ4_VERSION_NUMBER < 10700
+#error "liblz4 1.7 or newer is required."
+#endif
 
 namespace SimuTrace {
 namespace Compression
 {
 
+    static const Codec _codecs[] = {
+        { CiLzma, "lzma", 4, 9, lzmaCompress, lzmaDecompress },
+        { CiLz4,  "lz4",  9, 9, lz4Compress,  lz4Decompress },
+        { CiNone, "none", 0, 0, storeCompress, storeDecompress }
+    };
+
+    const Codec* findCodec(CodecId id)
+    {
+        for (size_t i = 0; i < sizeof(_codecs) / sizeof(Codec); ++i) {
+            if (_codecs[i].id == id) {
+                return &_codecs[i];
+            }
+        }
+
+        return nullptr;
+    }
+
+    const Codec* findCodec(const std::string& name)
+    {
+        for (size_t i = 0; i < sizeof(_codecs) / sizeof(Codec); ++i) {
+            if (name.compare(_codecs[i].name) == 0) {
+                return &_codecs[i];
+            }
+        }
+
+        return nullptr;
+    }
+
+    const Codec* getCodec(CodecId id)
+    {
+        const Codec* codec = findCodec(id);
+
+        ThrowOnNull(codec, NotFoundException, "compression codec",
+                    stringFormat("Unknown codec id %d.", id));
+
+        return codec;
+    }
+
+    const Codec* getCodec(const std::string& name)
+    {
+        const Codec* codec = findCodec(name);
+
+        ThrowOnNull(codec, NotFoundException, "compression codec",
+                    stringFormat("Unknown codec '%s'.", name.c_str()));
+
+        return codec;
+    }
+
     // LZMA ----
     size_t lzmaCompress(const void* source, size_t sourceLength,
                         void* destination, size_t destinationLength,
@@ -108,5 +161,131 @@ namespace Compression
         return uncompressedSize;
     }
 
+    // LZ4 ----
+    size_t lz4Compress(const void* source, size_t sourceLength,
+                       void* destination, size_t destinationLength,
+                       uint32_t level)
+    {
+        const size_t totalHeaderSize = sizeof(uint64_t);
+
+        ThrowOn(sourceLength == 0, ArgumentException, "sourceLength");
+        ThrowOn(destinationLength <= totalHeaderSize, ArgumentException,
+                "destinationLength");
+
+        // liblz4 works with int sizes
+        ThrowOn(sourceLength > LZ4_MAX_INPUT_SIZE, ArgumentOutOfBoundsException,
+                "sourceLength");
+
+        // Like for LZMA, we prepend the uncompressed size so that the
+        // decompressor can verify the destination buffer up front.
+        uint64_t* destinationOfSize = static_cast<uint64_t*>(destination);
+        *destinationOfSize = sourceLength;
+
+        unsigned char* destinationAfterHeader = reinterpret_cast<unsigned char*>(
+            reinterpret_cast<size_t>(destination) + totalHeaderSize);
+
+        const size_t compressedLength = std::min<size_t>(
+            destinationLength - totalHeaderSize,
+            std::numeric_limits<int>::max());
+
+        // The level is mapped to the acceleration of the match finder. The
+        // highest level searches every position (acceleration 1).
+        const Codec* codec = getCodec(CiLz4);
+        int acceleration = (level >= codec->maxLevel) ? 1 :
+            static_cast<int>(codec->maxLevel + 1 - level);
+
+        int compressedSize = LZ4_compress_fast(
+            static_cast<const char*>(source),
+            reinterpret_cast<char*>(destinationAfterHeader),
+            static_cast<int>(sourceLength),
+            static_cast<int>(compressedLength), acceleration);
+
+        ThrowOn(compressedSize <= 0, Exception, "LZ4 compression failed. "
+                "The destination buffer is too small.");
+
+        return static_cast<size_t>(compressedSize) + totalHeaderSize;
+    }
+
+    size_t lz4Decompress(const void* source, size_t sourceLength,
+                         void* destination, size_t destinationLength)
+    {
+        const size_t totalHeaderSize = sizeof(uint64_t);
+
+        ThrowOn(sourceLength <= totalHeaderSize, ArgumentException, "sourceLength");
+        ThrowOn(destinationLength == 0, ArgumentException, "destinationLength");
+
+        const uint64_t* sourceOfSize = static_cast<const uint64_t*>(source);
+        size_t uncompressedSize = static_cast<size_t>(*sourceOfSize);
+
+        ThrowOn(destinationLength < uncompressedSize, Exception, stringFormat(
+                "The destination buffer is too small to decompress the "
+                "source. Expected %s, but was given %s.",
+                sizeToString(uncompressedSize, SizeUnit::SuBytes).c_str(),
+                sizeToString(destinationLength, SizeUnit::SuBytes).c_str()));
+
+        const unsigned char* sourceAfterHeader =
+            reinterpret_cast<const unsigned char*>(
+                reinterpret_cast<size_t>(source) + totalHeaderSize);
+
+        ThrowOn((uncompressedSize > LZ4_MAX_INPUT_SIZE) ||
+                (sourceLength - totalHeaderSize >
+                 static_cast<size_t>(std::numeric_limits<int>::max())),
+                Exception, "LZ4 decompression failed. The source is "
+                "corrupted.");
+
+        // The decoder never writes beyond the given capacity and fails on
+        // malformed input.
+        int size = LZ4_decompress_safe(
+            reinterpret_cast<const char*>(sourceAfterHeader),
+            static_cast<char*>(destination),
+            static_cast<int>(sourceLength - totalHeaderSize),
+            static_cast<int>(uncompressedSize));
+
+        ThrowOn(size < 0, Exception, stringFormat(
+                "LZ4 decompression failed. The error code is: %d.", size));
+
+        // A block that is truncated at a sequence boundary is well-formed,
+        // but yields less data than announced.
+        ThrowOn(static_cast<size_t>(size) != uncompressedSize, Exception,
+                stringFormat("LZ4 decompression failed. Expected %s, but "
+                             "got %s.",
+                sizeToString(uncompressedSize, SizeUnit::SuBytes).c_str(),
+                sizeToString(static_cast<size_t>(size),
+                             SizeUnit::SuBytes).c_str()));
+
+        return uncompressedSize;
+    }
+
+    // None ----
+    size_t storeCompress(const void* source, size_t sourceLength,
+                         void* destination, size_t destinationLength,
+                         uint32_t level)
+    {
+        ThrowOn(sourceLength == 0, ArgumentException, "sourceLength");
+        ThrowOn(destinationLength < sourceLength, ArgumentException,
+                "destinationLength");
+
+        // Stored data has no levels
+        ThrowOn(level != 0, ArgumentOutOfBoundsException, "level");
+
+        memcpy(destination, source, sourceLength);
+
+        return sourceLength;
+    }
+
+    size_t storeDecompress(const void* source, size_t sourceLength,
+                           void* destination, size_t destinationLength)
+    {
+        ThrowOn(destinationLength < sourceLength, Exception, stringFormat(
+                "The destination buffer is too small to decompress the "
+                "source. Expected %s, but was given %s.",
+                sizeToString(sourceLength, SizeUnit::SuBytes).c_str(),
+                sizeToString(destinationLength, SizeUnit::SuBytes).c_str()));
+
+        memcpy(destination, source, sourceLength);
+
+        return sourceLength;
+    }
+
 }
 }
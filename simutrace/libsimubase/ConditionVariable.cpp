@@ -22,6 +22,7 @@
 
 #include "ConditionVariable.h"
 
+#include "Clock.h"
 #include "Exceptions.h"
 
 namespace SimuTrace
@@ -62,6 +63,34 @@ namespace SimuTrace
     #endif
     }
 
+    bool ConditionVariable::wait(uint32_t timeout)
+    {
+    #if defined(_WIN32)
+        if (!::SleepConditionVariableCS(&_cv, &_cs, timeout)) {
+            DWORD error = ::GetLastError();
+            ThrowOn(error != ERROR_TIMEOUT, PlatformException, error);
+
+            return false;
+        }
+    #else
+        Timestamp ts = Clock::getTimestamp() +
+            static_cast<Timestamp>(timeout) * 1000000ULL;
+
+        struct timespec deadline;
+        deadline.tv_sec  = static_cast<time_t>(ts / 1000000000ULL);
+        deadline.tv_nsec = static_cast<long>(ts % 1000000000ULL);
+
+        int result = ::pthread_cond_timedwait(&_cv, &_cs, &deadline);
+        if (result == ETIMEDOUT) {
+            return false;
+        } else if (result != 0) {
+            Throw(PlatformException, result);
+        }
+    #endif
+
+        return true;
+    }
+
     void ConditionVariable::wakeOne()
     {
     #if defined(_WIN32)
@@ -26,6 +26,12 @@
 #include "Exceptions.h"
 #include "Utils.h"
 
+#if defined(_WIN32)
+#else
+#include <sys/uio.h>
+#include <limits.h>
+#endif
+
 namespace SimuTrace
 {
 
@@ -147,6 +153,67 @@ namespace SimuTrace
         return size;
     }
 
+    size_t File::write(const std::vector<IoVector>& vectors, FileOffset offset)
+    {
+        ThrowOn(!_file.isValid(), InvalidOperationException);
+
+        size_t total = 0;
+    #if defined(_WIN32)
+        for (auto& vector : vectors) {
+            if (vector.size > 0) {
+                total += write(vector.buffer, vector.size, offset + total);
+            }
+        }
+    #else
+        std::vector<struct iovec> iov;
+        iov.reserve(vectors.size());
+
+        for (auto& vector : vectors) {
+            if (vector.size == 0) {
+                continue;
+            }
+
+            ThrowOnNull(vector.buffer, ArgumentNullException, "vectors");
+
+            struct iovec v;
+            v.iov_base = const_cast<void*>(vector.buffer);
+            v.iov_len  = vector.size;
+
+            iov.push_back(v);
+            total += vector.size;
+        }
+
+        size_t index = 0;
+        while (index < iov.size()) {
+            int count = static_cast<int>(
+                std::min<size_t>(iov.size() - index, IOV_MAX));
+
+            ssize_t result = ::pwritev(_file, &iov[index], count, offset);
+            ThrowOn(result <= -1, PlatformException);
+            ThrowOn(result == 0, Exception, "Failed to write entire buffer.");
+
+            offset += result;
+
+            // Skip the vectors that have been written entirely and continue
+            // with the remainder of a partially written one.
+            size_t written = static_cast<size_t>(result);
+            while (written > 0) {
+                if (written >= iov[index].iov_len) {
+                    written -= iov[index].iov_len;
+                    index++;
+                } else {
+                    iov[index].iov_base =
+                        static_cast<byte*>(iov[index].iov_base) + written;
+                    iov[index].iov_len -= written;
+                    written = 0;
+                }
+            }
+        }
+    #endif
+
+        return total;
+    }
+
     size_t File::write(const void* buffer, size_t size)
     {
         FileOffset offset = reserveSpace(size);
@@ -39,7 +39,8 @@ namespace SimuTrace
 
     LocalChannel::LocalChannel(bool isServer, const std::string& address) :
         Channel(isServer, address),
-        _endpoint()
+        _endpoint(),
+        _ring()
     {
         if (isServer) {
             _createServerEndpoint();
@@ -50,7 +51,8 @@ namespace SimuTrace
 
     LocalChannel::LocalChannel(SafeHandle& endpoint, const std::string& address) :
         Channel(false, address),
-        _endpoint()
+        _endpoint(),
+        _ring()
     {
         assert(endpoint.isValid());
 
@@ -296,6 +298,71 @@ namespace SimuTrace
     }
 #endif
 
+    bool LocalChannel::_isRingEnabled() const
+    {
+        return (_ring != nullptr) && _ring->isEnabled();
+    }
+
+    bool LocalChannel::_isPeerConnected() const
+    {
+    #if defined(SIMUTRACE_LOCAL_ENABLE_COMMAND_RING)
+        // The peer does not touch the ring when it terminates. However,
+        // the system closes its end of the domain socket.
+        struct pollfd fd;
+        fd.fd      = _endpoint;
+        fd.events  = POLLRDHUP;
+        fd.revents = 0;
+
+        int result = ::poll(&fd, 1, 0);
+        if (result < 0) {
+            return (System::getLastErrorCode() == EINTR);
+        }
+
+        return !IsSet(fd.revents, POLLRDHUP | POLLHUP | POLLERR | POLLNVAL);
+    #else
+        return true;
+    #endif
+    }
+
+    size_t LocalChannel::_sendToRing(const void* data, size_t size,
+                                     bool signal)
+    {
+        size_t bytesWritten = 0;
+
+        while (bytesWritten < size) {
+            size_t result = _ring->write(
+                static_cast<const byte*>(data) + bytesWritten,
+                size - bytesWritten, LOCAL_COMMAND_RING_TIMEOUT, signal);
+
+            if (result == 0) {
+                ThrowOn(!_isPeerConnected(), PlatformException, ECONNRESET);
+            }
+
+            bytesWritten += result;
+        }
+
+        return bytesWritten;
+    }
+
+    size_t LocalChannel::_receiveFromRing(void* data, size_t size)
+    {
+        size_t bytesRead = 0;
+
+        while (bytesRead < size) {
+            size_t result = _ring->read(static_cast<byte*>(data) + bytesRead,
+                                        size - bytesRead,
+                                        LOCAL_COMMAND_RING_TIMEOUT);
+
+            if (result == 0) {
+                ThrowOn(!_isPeerConnected(), PlatformException, ECONNRESET);
+            }
+
+            bytesRead += result;
+        }
+
+        return bytesRead;
+    }
+
     void LocalChannel::_createServerEndpoint()
     {
     #if defined(_WIN32)
@@ -380,12 +447,22 @@ namespace SimuTrace
 
             _endpoint.close();
         }
+
+        // Only mark the ring as closed. Another thread may still wait on
+        // it. The ring is released with the channel.
+        if (_ring != nullptr) {
+            _ring->close();
+        }
     }
 
     size_t LocalChannel::_send(const void* data, size_t size)
     {
         assert(data != nullptr && size > 0);
 
+        if (_isRingEnabled()) {
+            return _sendToRing(data, size, true);
+        }
+
     #if defined(_WIN32)
         DWORD bytesWritten;
         if (!::WriteFile(_endpoint, data, (DWORD) size, &bytesWritten, nullptr)) {
@@ -433,6 +510,23 @@ namespace SimuTrace
         return bytesWritten;
     }
 
+    size_t LocalChannel::_sendGather(const void* header, size_t headerSize,
+                                     const void* data, size_t size)
+    {
+        if (!_isRingEnabled()) {
+            return Channel::_sendGather(header, headerSize, data, size);
+        }
+
+        // Wake up the peer only once for the whole message
+        size_t bytesSent = _sendToRing(header, headerSize, (size == 0));
+
+        if (size > 0) {
+            bytesSent += _sendToRing(data, size, true);
+        }
+
+        return bytesSent;
+    }
+
     size_t LocalChannel::_send(const std::vector<Handle>& handles)
     {
         if (handles.size() == 0) {
@@ -493,6 +587,10 @@ namespace SimuTrace
     {
         assert(data != nullptr && size > 0);
 
+        if (_isRingEnabled()) {
+            return _receiveFromRing(data, size);
+        }
+
     #if defined(_WIN32)
         DWORD bytesRead;
         if (!::ReadFile(_endpoint, data, (DWORD) size, &bytesRead, nullptr)) {
@@ -613,6 +711,24 @@ namespace SimuTrace
         return std::unique_ptr<Channel>(new LocalChannel(isServer, address));
     }
 
+    void LocalChannel::attachCommandRing(std::unique_ptr<CommandRing>& ring)
+    {
+    #if defined(SIMUTRACE_LOCAL_ENABLE_COMMAND_RING)
+        ThrowOnNull(ring, ArgumentNullException, "ring");
+        ThrowOn(!isConnected() || (_ring != nullptr),
+                InvalidOperationException);
+
+        _ring = std::move(ring);
+    #else
+        Throw(NotSupportedException);
+    #endif
+    }
+
+    CommandRing* LocalChannel::getCommandRing() const
+    {
+        return _ring.get();
+    }
+
     bool LocalChannel::isConnected() const
     {
         return (_endpoint.isValid());
@@ -620,7 +736,12 @@ namespace SimuTrace
 
     ChannelCapabilities LocalChannel::getChannelCaps() const
     {
+    #if defined(SIMUTRACE_LOCAL_ENABLE_COMMAND_RING)
+        return static_cast<ChannelCapabilities>(
+            CCapHandleTransfer | CCapCommandRing);
+    #else
         return CCapHandleTransfer;
+    #endif
     }
 
 }
@@ -27,6 +27,16 @@
 #include "Channel.h"
 
 #include "SafeHandle.h"
+#include "CommandRing.h"
+
+// Command rings sleep on futexes, which only Linux offers
+#if defined(__linux__)
+#define SIMUTRACE_LOCAL_ENABLE_COMMAND_RING
+#endif
+
+// Time in ms after which a side waiting on the command ring checks whether
+// the peer is still connected
+#define LOCAL_COMMAND_RING_TIMEOUT 200
 
 namespace SimuTrace
 {
@@ -39,8 +49,19 @@ namespace SimuTrace
 
         SafeHandle _endpoint;
 
+        // If enabled, all data except handles is transferred through the
+        // command ring. The endpoint then only carries handles and tells
+        // us when the peer disconnects.
+        std::unique_ptr<CommandRing> _ring;
+
         LocalChannel(SafeHandle& endpoint, const std::string& address);
 
+        bool _isRingEnabled() const;
+        bool _isPeerConnected() const;
+
+        size_t _sendToRing(const void* data, size_t size, bool signal);
+        size_t _receiveFromRing(void* data, size_t size);
+
     #if defined(_WIN32)
         void _createServerNamedPipe();
         void _connectServerNamedPipe();
@@ -71,6 +92,8 @@ namespace SimuTrace
 
         virtual size_t _send(const void* data, size_t size) override;
         virtual size_t _send(const std::vector<Handle>& handles) override;
+        virtual size_t _sendGather(const void* header, size_t headerSize,
+                                   const void* data, size_t size) override;
         virtual size_t _receive(void* data, size_t size) override;
         virtual size_t _receive(std::vector<Handle>& handles,
                                 uint32_t handleCount) override;
@@ -83,6 +106,10 @@ namespace SimuTrace
         LocalChannel(bool isServer, const std::string& address);
         virtual ~LocalChannel();
 
+        virtual void attachCommandRing(
+            std::unique_ptr<CommandRing>& ring) override;
+        virtual CommandRing* getCommandRing() const override;
+
         virtual bool isConnected() const override;
         virtual ChannelCapabilities getChannelCaps() const override;
     };
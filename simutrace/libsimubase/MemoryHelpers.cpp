@@ -158,5 +158,194 @@ namespace System
         return ret;
     }
 
+    struct _NumaTopology
+    {
+        std::vector<std::vector<uint32_t>> processors;
+        std::vector<uint32_t> nodeOfProcessor;
+    };
+
+#if defined(_WIN32) || (defined(__MACH__) && defined(__APPLE__))
+#else
+    // Parses a list in the sysfs format (e.g., "0-3,8,10-11")
+    bool _parseSysfsList(const std::string& path, std::vector<uint32_t>& out)
+    {
+        std::ifstream file(path, std::ifstream::in);
+        std::string list;
+
+        if (!file || !std::getline(file, list)) {
+            return false;
+        }
+
+        std::istringstream stream(list);
+        std::string range;
+        while (std::getline(stream, range, ',')) {
+            if (range.empty()) {
+                continue;
+            }
+
+            uint32_t first, last;
+            auto pos = range.find('-');
+            if (pos == std::string::npos) {
+                first = last = static_cast<uint32_t>(std::stoul(range));
+            } else {
+                first = static_cast<uint32_t>(std::stoul(range.substr(0, pos)));
+                last = static_cast<uint32_t>(std::stoul(range.substr(pos + 1)));
+            }
+
+            for (uint32_t i = first; i <= last; ++i) {
+                out.push_back(i);
+            }
+        }
+
+        return !out.empty();
+    }
+#endif
+
+    _NumaTopology _readNumaTopology()
+    {
+        _NumaTopology topology;
+
+    #if defined(_WIN32) || (defined(__MACH__) && defined(__APPLE__))
+    #else
+        std::vector<uint32_t> nodes;
+
+        try {
+            if (_parseSysfsList("/sys/devices/system/node/online", nodes)) {
+                topology.processors.resize(nodes.back() + 1);
+
+                for (auto node : nodes) {
+                    std::vector<uint32_t>& cpus = topology.processors[node];
+
+                    // Memory-only nodes do not have any processors
+                    _parseSysfsList(stringFormat(
+                        "/sys/devices/system/node/node%d/cpulist", node), cpus);
+
+                    for (auto cpu : cpus) {
+                        if (cpu >= topology.nodeOfProcessor.size()) {
+                            topology.nodeOfProcessor.resize(cpu + 1, 0);
+                        }
+
+                        topology.nodeOfProcessor[cpu] = node;
+                    }
+                }
+            }
+        } catch (const std::exception&) {
+            topology.processors.clear();
+            topology.nodeOfProcessor.clear();
+        }
+    #endif
+
+        if (topology.nodeOfProcessor.empty()) {
+            long count = 1;
+        #if defined(_WIN32)
+            SYSTEM_INFO sysinfo;
+            ::GetSystemInfo(&sysinfo);
+            count = sysinfo.dwNumberOfProcessors;
+        #else
+            count = std::max(1L, ::sysconf(_SC_NPROCESSORS_ONLN));
+        #endif
+
+            topology.processors.assign(1, std::vector<uint32_t>());
+            for (uint32_t i = 0; i < count; ++i) {
+                topology.processors[0].push_back(i);
+            }
+
+            topology.nodeOfProcessor.assign(count, 0);
+        }
+
+        return topology;
+    }
+
+    const _NumaTopology& _getNumaTopology()
+    {
+        static const _NumaTopology topology = _readNumaTopology();
+
+        return topology;
+    }
+
+    uint32_t getNumNumaNodes()
+    {
+        return static_cast<uint32_t>(_getNumaTopology().processors.size());
+    }
+
+    uint32_t getCurrentNumaNode()
+    {
+    #if defined(_WIN32) || (defined(__MACH__) && defined(__APPLE__))
+        return 0;
+    #else
+        const _NumaTopology& topology = _getNumaTopology();
+        if (topology.processors.size() == 1) {
+            return 0;
+        }
+
+        int cpu = ::sched_getcpu();
+        if ((cpu < 0) ||
+            (static_cast<size_t>(cpu) >= topology.nodeOfProcessor.size())) {
+            return 0;
+        }
+
+        return topology.nodeOfProcessor[cpu];
+    #endif
+    }
+
+    const std::vector<uint32_t>& getNumaNodeProcessors(uint32_t node)
+    {
+        const _NumaTopology& topology = _getNumaTopology();
+        ThrowOn(node >= topology.processors.size(),
+                ArgumentOutOfBoundsException, "node");
+
+        return topology.processors[node];
+    }
+
+    uint32_t getNumaNodeOfIndex(uint64_t index, uint64_t count,
+                                uint32_t numNodes)
+    {
+        ThrowOn(index >= count, ArgumentOutOfBoundsException, "index");
+        ThrowOn((numNodes == 0) || (numNodes > count),
+                ArgumentOutOfBoundsException, "numNodes");
+
+        // Element i belongs to node n, if
+        // floor(n * count / numNodes) <= i < floor((n + 1) * count / numNodes)
+        return static_cast<uint32_t>(((index + 1) * numNodes - 1) / count);
+    }
+
+    bool bindMemoryToNumaNode(void* start, size_t size, uint32_t node)
+    {
+        ThrowOn(node >= getNumNumaNodes(), ArgumentOutOfBoundsException,
+                "node");
+
+    #if defined(_WIN32) || (defined(__MACH__) && defined(__APPLE__))
+        return false;
+    #else
+        // We call mbind() directly so we do not depend on libnuma.
+        const int mpolPreferred = 1;
+        unsigned long mask[4] = { 0 };
+        const unsigned long bits = sizeof(unsigned long) * 8;
+
+        // The kernel only evaluates maxnode - 1 bits of the mask
+        if (node >= sizeof(mask) * 8 - 1) {
+            return false;
+        }
+
+        // The range must be page aligned. We shrink it to the pages that
+        // are entirely covered.
+        uintptr_t pageSize = getPageSize();
+        uintptr_t first = (reinterpret_cast<uintptr_t>(start) + pageSize - 1) &
+                          ~(pageSize - 1);
+        uintptr_t last = (reinterpret_cast<uintptr_t>(start) + size) &
+                         ~(pageSize - 1);
+        if (last <= first) {
+            return false;
+        }
+
+        mask[node / bits] = 1UL << (node % bits);
+
+        long result = ::syscall(SYS_mbind, first, last - first, mpolPreferred,
+                                mask, sizeof(mask) * 8, 0);
+
+        return (result == 0);
+    #endif
+    }
+
+}
 }
-}
\ No newline at end of file
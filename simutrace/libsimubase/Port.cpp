@@ -27,6 +27,7 @@
 
 #include "Channel.h"
 #include "ChannelProvider.h"
+#include "CommandRing.h"
 #include "RpcInterface.h"
 
 #include "Logging.h"
@@ -34,12 +35,25 @@
 namespace SimuTrace
 {
 
+    // Compressed data payloads start with this header, followed by the
+    // output of the codec.
+    struct CompressedPayloadHeader {
+        uint32_t length; // Uncompressed length of the payload
+        uint8_t codec;   // Compression::CodecId
+        uint8_t reserved[3];
+    };
+
     Port::Port(bool isServer, const std::string& specifier) :
         _channel(nullptr),
         _specifier(specifier),
         _messagesSent(0),
         _messagesReceived(0),
-        _lastSequenceNumber(0)
+        _lastSequenceNumber(0),
+        _codec(Compression::CiInvalid),
+        _codecLevel(0),
+        _compressionBuffer(),
+        _compressionBufferSize(0),
+        _compressionBufferLimit(PORT_COMPRESSION_BUFFER_LIMIT)
     {
         _channel = ChannelProvider::createChannelFromSpecifier(isServer,
                                                                specifier);
@@ -50,7 +64,12 @@ namespace SimuTrace
         _specifier(),
         _messagesSent(0),
         _messagesReceived(0),
-        _lastSequenceNumber(0)
+        _lastSequenceNumber(0),
+        _codec(Compression::CiInvalid),
+        _codecLevel(0),
+        _compressionBuffer(),
+        _compressionBufferSize(0),
+        _compressionBufferLimit(PORT_COMPRESSION_BUFFER_LIMIT)
     {
         assert(channel != nullptr);
         _channel = std::move(channel);
@@ -61,6 +80,68 @@ namespace SimuTrace
 
     }
 
+    char* Port::_getCompressionBuffer(size_t size)
+    {
+        // The buffer only grows. Connections transferring segments thus
+        // allocate it once and reuse it for every segment.
+        if (_compressionBufferSize < size) {
+            // We do not need the old content, so we do not copy it.
+            _compressionBuffer.reset();
+            _compressionBuffer = std::unique_ptr<char[]>(new char[size]);
+            _compressionBufferSize = size;
+        }
+
+        return _compressionBuffer.get();
+    }
+
+    uint32_t Port::_compress(const void* payload, uint32_t length)
+    {
+        const Compression::Codec* codec = Compression::getCodec(_codec);
+        const size_t headerSize = sizeof(CompressedPayloadHeader);
+
+        // Compression only pays off, if the result is smaller than the
+        // original payload. We thus limit the output to the payload size.
+        char* buffer = _getCompressionBuffer(length);
+
+        CompressedPayloadHeader* header =
+            reinterpret_cast<CompressedPayloadHeader*>(buffer);
+
+        header->length = length;
+        header->codec  = static_cast<uint8_t>(_codec);
+        memset(header->reserved, 0, sizeof(header->reserved));
+
+        size_t size;
+        try {
+            size = codec->compress(payload, length, buffer + headerSize,
+                                   length - headerSize, _codecLevel);
+        } catch (const Exception&) {
+            // The payload does not compress. Send it as it is.
+            return 0;
+        }
+
+        assert(size + headerSize <= length);
+        return static_cast<uint32_t>(size + headerSize);
+    }
+
+    void Port::_decompress(Message& msg, uint32_t length)
+    {
+        const CompressedPayloadHeader* header =
+            reinterpret_cast<const CompressedPayloadHeader*>(
+                _compressionBuffer.get());
+        const size_t headerSize = sizeof(CompressedPayloadHeader);
+
+        const Compression::Codec* codec = Compression::getCodec(
+            static_cast<Compression::CodecId>(header->codec));
+
+        size_t size = codec->decompress(_compressionBuffer.get() + headerSize,
+                                        length - headerSize,
+                                        msg.data.payload,
+                                        msg.data.payloadLength);
+
+        ThrowOn(size != msg.data.payloadLength,
+                RpcMessageMalformedException);
+    }
+
     void Port::_send(const Message& msg)
     {
         LogRpc("Sending message to %s: <seq: %d, code: 0x%x, type: %d (%s),"
@@ -80,30 +161,58 @@ namespace SimuTrace
                msg.data.payloadLength);
 
         _lastSequenceNumber = msg.sequenceNumber;
-        _channel->send(&msg, MESSAGE_SIZE);
 
         switch (msg.payloadType)
         {
             case MessagePayloadType::MptEmbedded: {
+                _channel->send(&msg, MESSAGE_SIZE);
+
                 break;
             }
 
             case MessagePayloadType::MptData: {
-                if (msg.data.payloadLength == 0) {
-                    break;
+                assert((msg.data.payload != nullptr) ||
+                       (msg.data.payloadLength == 0));
+
+                // Compress large payloads (i.e., segments) if enabled. We
+                // send a modified copy of the header, because the message
+                // belongs to the caller.
+                if ((_codec != Compression::CiInvalid) &&
+                    (msg.data.payloadLength >= PORT_COMPRESSION_THRESHOLD) &&
+                    (msg.data.payloadLength <= _compressionBufferLimit)) {
+
+                    uint32_t length = _compress(msg.data.payload,
+                                                msg.data.payloadLength);
+                    if (length > 0) {
+                        Message header = msg;
+                        header.flags |= MessageFlags::MfCompressed;
+                        header.data.payloadLength = length;
+
+                        size_t bytesSend = _channel->send(&header, MESSAGE_SIZE,
+                            _compressionBuffer.get(), length);
+
+                        ThrowOn(bytesSend != MESSAGE_SIZE + length,
+                                RpcMessageMalformedException);
+
+                        break;
+                    }
                 }
 
-                assert(msg.data.payload != nullptr);
-                size_t bytesSend = _channel->send(msg.data.payload,
+                // Send the header and the payload in one go. This way, small
+                // messages leave the channel in a single packet.
+                size_t bytesSend = _channel->send(&msg, MESSAGE_SIZE,
+                                                  msg.data.payload,
                                                   msg.data.payloadLength);
 
-                ThrowOn(bytesSend != msg.data.payloadLength,
+                ThrowOn(bytesSend != MESSAGE_SIZE + msg.data.payloadLength,
                         RpcMessageMalformedException);
 
                 break;
             }
 
             case MessagePayloadType::MptHandles: {
+                _channel->send(&msg, MESSAGE_SIZE);
+
                 if (msg.handles.handleCount == 0) {
                     break;
                 }
@@ -144,6 +253,36 @@ namespace SimuTrace
                         break;
                     }
 
+                    // A compressed payload is received into the port's
+                    // buffer first. We then decompress it into the memory
+                    // given by the allocator (e.g., a stream segment).
+                    uint32_t compressedLength = 0;
+                    if (IsSet(msg.flags, MessageFlags::MfCompressed)) {
+                        compressedLength = msg.data.payloadLength;
+
+                        ThrowOn(compressedLength <=
+                                    sizeof(CompressedPayloadHeader),
+                                RpcMessageMalformedException);
+
+                        char* buffer = _getCompressionBuffer(compressedLength);
+
+                        size_t bytesRead = _channel->receive(buffer,
+                                                             compressedLength);
+
+                        ThrowOn(bytesRead != compressedLength,
+                                RpcMessageMalformedException);
+
+                        const CompressedPayloadHeader* header =
+                            reinterpret_cast<const CompressedPayloadHeader*>(
+                                buffer);
+
+                        ThrowOn(header->length == 0,
+                                RpcMessageMalformedException);
+
+                        msg.flags &= ~MessageFlags::MfCompressed;
+                        msg.data.payloadLength = header->length;
+                    }
+
                     msg.localFlags |= LocalMessageFlags::LmfAllocationOwner;
 
                     // Use custom memory allocator if possible. However, do not
@@ -166,6 +305,12 @@ namespace SimuTrace
                         msg.localFlags |= LocalMessageFlags::LmfCustomAllocation;
                     }
 
+                    if (compressedLength > 0) {
+                        _decompress(msg, compressedLength);
+
+                        break;
+                    }
+
                     size_t bytesRead = _channel->receive(msg.data.payload,
                                                          msg.data.payloadLength);
 
@@ -280,4 +425,55 @@ namespace SimuTrace
         return _channel->getChannelCaps();
     }
 
+    void Port::setCompression(Compression::CodecId codec, uint32_t level)
+    {
+        if (codec == Compression::CiInvalid) {
+            _codec = codec;
+            _codecLevel = 0;
+
+            _compressionBuffer.reset();
+            _compressionBufferSize = 0;
+            return;
+        }
+
+        const Compression::Codec* c = Compression::getCodec(codec);
+        ThrowOn(level > c->maxLevel, ArgumentOutOfBoundsException, "level");
+
+        _codec = codec;
+        _codecLevel = level;
+    }
+
+    void Port::setCompressionBufferLimit(size_t limit)
+    {
+        _compressionBufferLimit = limit;
+
+        if (_compressionBufferSize > limit) {
+            _compressionBuffer.reset();
+            _compressionBufferSize = 0;
+        }
+    }
+
+    void Port::setCommandRing(std::unique_ptr<CommandRing>& ring)
+    {
+        ThrowOn(!IsSet(getChannelCaps(), CCapCommandRing),
+                NotSupportedException);
+
+        _channel->attachCommandRing(ring);
+    }
+
+    CommandRing* Port::getCommandRing() const
+    {
+        return _channel->getCommandRing();
+    }
+
+    Compression::CodecId Port::getCompressionCodec() const
+    {
+        return _codec;
+    }
+
+    uint32_t Port::getCompressionLevel() const
+    {
+        return _codecLevel;
+    }
+
 }
\ No newline at end of file
@@ -26,9 +26,22 @@
 #include "Interlocked.h"
 #include "Utils.h"
 #include "Logging.h"
+#include "Configuration.h"
 
 namespace SimuTrace {
 
+#if defined(_WIN32)
+#else
+#if defined(MSG_NOSIGNAL)
+    // Report a closed connection as EPIPE instead of raising SIGPIPE
+    #define SOCKET_SEND_FLAGS MSG_NOSIGNAL
+#else
+    // Systems without MSG_NOSIGNAL (e.g., Mac OS X) use the SO_NOSIGPIPE
+    // socket option instead. See _configureSocket().
+    #define SOCKET_SEND_FLAGS 0
+#endif
+#endif
+
 #if defined(_WIN32)
 namespace System
 {
@@ -62,7 +75,15 @@ namespace System
     SocketChannel::SocketChannel(bool isServer, const std::string& address) :
         Channel(isServer, address),
         _endpoint(INVALID_SOCKET),
-        _info(nullptr)
+        _info(nullptr),
+        _ipaddress(),
+        _port(),
+        _receiveBuffer(),
+        _receiveOffset(0),
+        _receiveLength(0),
+        _zeroCopyThreshold(0),
+        _zeroCopyEnabled(false),
+        _zeroCopyPending(0)
     {
         _initChannel(isServer, address, INVALID_SOCKET);
     }
@@ -70,7 +91,15 @@ namespace System
     SocketChannel::SocketChannel(SOCKET endpoint, const std::string& address) :
         Channel(false, address),
         _endpoint(INVALID_SOCKET),
-        _info(nullptr)
+        _info(nullptr),
+        _ipaddress(),
+        _port(),
+        _receiveBuffer(),
+        _receiveOffset(0),
+        _receiveLength(0),
+        _zeroCopyThreshold(0),
+        _zeroCopyEnabled(false),
+        _zeroCopyPending(0)
     {
         _initChannel(false, address, endpoint);
     }
@@ -105,6 +134,15 @@ namespace System
     #else
     #endif
 
+    #ifdef SIMUTRACE_SOCKET_ENABLE_ZEROCOPY
+        int zeroCopyThreshold = 0;
+        Configuration::tryGet("network.socket.zeroCopyThreshold",
+                              zeroCopyThreshold);
+
+        _zeroCopyThreshold = (zeroCopyThreshold > 0) ?
+            static_cast<size_t>(zeroCopyThreshold) * 1024 : 0;
+    #endif
+
         try {
             _updateSocketAddress(address);
 
@@ -305,6 +343,14 @@ namespace System
             }
         }
 
+        try {
+            _configureSocket(endpoint);
+        } catch (...) {
+            _closeSocket(endpoint);
+
+            throw;
+        }
+
         _endpoint = endpoint;
     }
 
@@ -402,6 +448,14 @@ namespace System
             }
         }
 
+        try {
+            _configureSocket(endpoint);
+        } catch (...) {
+            _closeSocket(endpoint);
+
+            throw;
+        }
+
         _endpoint = endpoint;
     }
 
@@ -460,6 +514,55 @@ namespace System
         ThrowOn(result == SOCKET_ERROR, SocketException);
     }
 
+    void SocketChannel::_configureSocket(SOCKET socket)
+    {
+        int result;
+
+        // Small messages (e.g., embedded RPCs) should leave the host right
+        // away. With Nagle's algorithm, the second half of a request waits
+        // for the acknowledgment of the first half, which in turn is delayed
+        // by the peer. We always send complete messages, so Nagle does not
+        // save us any packets.
+        bool nagle = false;
+        Configuration::tryGet("network.socket.nagle", nagle);
+
+        int noDelay = (nagle) ? 0 : 1;
+        result = ::setsockopt(socket, IPPROTO_TCP, TCP_NODELAY,
+                              (const char*)&noDelay, sizeof(noDelay));
+        ThrowOn(result == SOCKET_ERROR, SocketException);
+
+        // The kernel buffer sizes are given in KiB. A value of 0 keeps the
+        // system's default (and its auto-tuning).
+        int sendBufferSize = 0;
+        Configuration::tryGet("network.socket.sendBufferSize", sendBufferSize);
+        if (sendBufferSize > 0) {
+            sendBufferSize *= 1024;
+            result = ::setsockopt(socket, SOL_SOCKET, SO_SNDBUF,
+                                  (const char*)&sendBufferSize,
+                                  sizeof(sendBufferSize));
+            ThrowOn(result == SOCKET_ERROR, SocketException);
+        }
+
+        int receiveBufferSize = 0;
+        Configuration::tryGet("network.socket.receiveBufferSize",
+                              receiveBufferSize);
+        if (receiveBufferSize > 0) {
+            receiveBufferSize *= 1024;
+            result = ::setsockopt(socket, SOL_SOCKET, SO_RCVBUF,
+                                  (const char*)&receiveBufferSize,
+                                  sizeof(receiveBufferSize));
+            ThrowOn(result == SOCKET_ERROR, SocketException);
+        }
+
+    #if defined(_WIN32)
+    #elif defined(SO_NOSIGPIPE)
+        int noSigPipe = 1;
+        result = ::setsockopt(socket, SOL_SOCKET, SO_NOSIGPIPE,
+                              &noSigPipe, sizeof(noSigPipe));
+        ThrowOn(result == SOCKET_ERROR, SocketException);
+    #endif
+    }
+
     std::unique_ptr<Channel> SocketChannel::_accept()
     {
         SOCKET endpoint;
@@ -511,6 +614,16 @@ namespace System
             }
         }
 
+        // Socket options are not necessarily inherited from the listening
+        // socket. We therefore configure each connection explicitly.
+        try {
+            _configureSocket(endpoint);
+        } catch (...) {
+            _closeSocket(endpoint);
+
+            throw;
+        }
+
         return std::unique_ptr<SocketChannel>(
             new SocketChannel(endpoint, address));
     }
@@ -522,131 +635,365 @@ namespace System
         }
 
         _endpoint = INVALID_SOCKET;
+
+        _receiveOffset = 0;
+        _receiveLength = 0;
+
+        // Closing the socket drops outstanding completions
+        _zeroCopyPending = 0;
     }
 
     size_t SocketChannel::_send(const void* data, size_t size)
     {
         assert(data != nullptr && size > 0);
 
-    #if defined(_WIN32)
-        int bytesWritten = 0;
-        int result;
-    #else
-        ssize_t bytesWritten = 0;
-        ssize_t result;
+        return _sendGather(data, size, nullptr, 0);
+    }
+
+    size_t SocketChannel::_send(const std::vector<Handle>& handles)
+    {
+        Throw(NotSupportedException);
+    }
+
+    bool SocketChannel::_enableZeroCopy()
+    {
+    #ifdef SIMUTRACE_SOCKET_ENABLE_ZEROCOPY
+        assert(_zeroCopyThreshold > 0);
+
+        // We enable zero-copy on the first large send only. Most connections
+        // never transfer segments (e.g., when using shared memory).
+        if (!_zeroCopyEnabled) {
+            int enable = 1;
+            int result = ::setsockopt(_endpoint, SOL_SOCKET, SO_ZEROCOPY,
+                                      &enable, sizeof(enable));
+            if (result == SOCKET_ERROR) {
+                LogDebug("Zero-copy is not supported for connection '%s' "
+                         "<error: %d>. Falling back to regular sends.",
+                         getAddress().c_str(), System::getLastErrorCode());
+
+                _zeroCopyThreshold = 0;
+                return false;
+            }
 
-        System::ignoreSignal(SIGPIPE); {
+            _zeroCopyEnabled = true;
+        }
+
+        return true;
+    #else
+        return false;
     #endif
+    }
 
-            do {
-                void* buf = reinterpret_cast<void*>(
-                    reinterpret_cast<size_t>(data) + bytesWritten);
+    void SocketChannel::_reapZeroCopyCompletions(bool wait)
+    {
+    #ifdef SIMUTRACE_SOCKET_ENABLE_ZEROCOPY
+        bool copied = false;
+
+        // With zero-copy, the kernel sends the data directly from the user
+        // buffer and signals completion for each send call via the socket's
+        // error queue as soon as the peer has acknowledged the data. We do
+        // not need to wait for the completions to let the caller reuse the
+        // buffer: large payloads are only sent in RPC calls and returns. The
+        // peer answers a call only after it received the payload and the
+        // answer acknowledges the data. A returned segment stays in use
+        // until the peer's next request. We therefore only collect the
+        // completions to free the error queue and the pinned pages.
+        while (_zeroCopyPending > 0) {
+            char control[CMSG_SPACE(sizeof(struct sock_extended_err) +
+                                    sizeof(struct sockaddr_in6))];
+
+            struct msghdr msg = {0};
+            msg.msg_control    = control;
+            msg.msg_controllen = sizeof(control);
+
+            ssize_t result = ::recvmsg(_endpoint, &msg, MSG_ERRQUEUE);
+            if (result < 0) {
+                int error = System::getLastErrorCode();
+
+                if ((error == EAGAIN) || (error == EWOULDBLOCK)) {
+                    if (!wait) {
+                        break;
+                    }
 
-            #if defined(_WIN32)
-                result = ::send(_endpoint, (const char*)buf,
-                                (int)(size - bytesWritten), 0);
-                if (result == SOCKET_ERROR) {
-                    Throw(SocketException);
-            #else
-                result = ::send(_endpoint, buf, size - bytesWritten, 0);
-                if (result < 0) {
-                    int error = System::getLastErrorCode();
+                    // Reading the error queue never blocks. Wait until the
+                    // next completion arrives. The error condition is always
+                    // reported by poll, we do not need to request it.
+                    struct pollfd pfd = {0};
+                    pfd.fd = _endpoint;
 
-                    // If error is interrupted system-call we just continue
-                    if (error != EINTR) {
-                        System::restoreSignal(SIGPIPE);
+                    if ((::poll(&pfd, 1, -1) < 0) &&
+                        (System::getLastErrorCode() != EINTR)) {
+                        _zeroCopyPending = 0;
 
-                        Throw(PlatformException, error);
+                        Throw(PlatformException);
                     }
-            #endif
-                } else if (result > 0) {
-                    bytesWritten += result;
-                } else {
-                    assert(result == 0);
 
-                #if defined(_WIN32)
-                    Throw(PlatformException, ERROR_NO_DATA);
-                #else
-                    System::restoreSignal(SIGPIPE);
-                    Throw(PlatformException, ECONNRESET);
-                #endif
+                    // The connection broke down without completions
+                    if ((pfd.revents & (POLLHUP | POLLNVAL)) != 0) {
+                        _zeroCopyPending = 0;
+
+                        Throw(PlatformException, ECONNRESET);
+                    }
+                } else if (error != EINTR) {
+                    _zeroCopyPending = 0;
+
+                    Throw(PlatformException, error);
+                }
+
+                continue;
+            }
+
+            for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+                 cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+
+                if (!(((cmsg->cmsg_level == SOL_IP) &&
+                       (cmsg->cmsg_type == IP_RECVERR)) ||
+                      ((cmsg->cmsg_level == SOL_IPV6) &&
+                       (cmsg->cmsg_type == IPV6_RECVERR)))) {
+                    continue;
+                }
+
+                struct sock_extended_err* err =
+                    reinterpret_cast<struct sock_extended_err*>(
+                        CMSG_DATA(cmsg));
+
+                if (err->ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+                    ThrowOn(err->ee_errno != 0, PlatformException,
+                            err->ee_errno);
+
+                    continue;
+                }
+
+                // Each notification covers a range of send calls
+                uint32_t count = err->ee_data - err->ee_info + 1;
+                assert(count <= _zeroCopyPending);
+
+                _zeroCopyPending -= count;
+
+                if ((err->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0) {
+                    copied = true;
                 }
+            }
+        }
+
+        // If the kernel had to copy the data anyway (e.g., on loopback or
+        // with network devices that do not support scatter/gather), the
+        // completion tracking is pure overhead. Use regular sends then.
+        if (copied) {
+            LogDebug("Kernel copied zero-copy send on connection '%s'. "
+                     "Falling back to regular sends.",
+                     getAddress().c_str());
 
-            } while((result < 0) || (bytesWritten < size));
+            _zeroCopyThreshold = 0;
+        }
+    #endif
+    }
+
+    size_t SocketChannel::_sendGather(const void* header, size_t headerSize,
+                                      const void* data, size_t size)
+    {
+        assert(header != nullptr && headerSize > 0);
+        assert(data != nullptr || size == 0);
+
+        size_t totalSize = headerSize + size;
+        size_t bytesWritten = 0;
 
     #if defined(_WIN32)
+        WSABUF buffers[2];
+        DWORD bufferCount = (size > 0) ? 2 : 1;
+        DWORD result;
+
+        buffers[0].buf = (CHAR*)header;
+        buffers[0].len = (ULONG)headerSize;
+        buffers[1].buf = (CHAR*)data;
+        buffers[1].len = (ULONG)size;
+
+        // For blocking sockets WSASend only returns when all buffers
+        // have been sent or an error occurred.
+        if (::WSASend(_endpoint, buffers, bufferCount, &result, 0,
+                      nullptr, nullptr) == SOCKET_ERROR) {
+            Throw(SocketException);
+        }
+
+        ThrowOn(result == 0, PlatformException, ERROR_NO_DATA);
+
+        bytesWritten = result;
     #else
+        struct iovec iov[2];
+        iov[0].iov_base = const_cast<void*>(header);
+        iov[0].iov_len  = headerSize;
+        iov[1].iov_base = const_cast<void*>(data);
+        iov[1].iov_len  = size;
+
+        struct msghdr msg = {0};
+        msg.msg_iov    = iov;
+        msg.msg_iovlen = (size > 0) ? 2 : 1;
+
+        int flags = SOCKET_SEND_FLAGS;
+
+    #ifdef SIMUTRACE_SOCKET_ENABLE_ZEROCOPY
+        // Collect the completions of previous zero-copy sends. We only wait
+        // if too many sends are still in flight.
+        if (_zeroCopyPending > 0) {
+            _reapZeroCopyCompletions(
+                _zeroCopyPending >= SIMUTRACE_SOCKET_MAX_PENDING_ZEROCOPY);
+        }
+
+        // Large payloads (i.e., segments) are sent without copying them into
+        // kernel memory. The user pages are pinned until the data has been
+        // acknowledged by the peer.
+        if ((_zeroCopyThreshold > 0) && (totalSize >= _zeroCopyThreshold) &&
+            _enableZeroCopy()) {
+            flags |= MSG_ZEROCOPY;
         }
-        System::restoreSignal(SIGPIPE);
     #endif
 
-        ThrowOn(bytesWritten != size, Exception, "The amount of data written "
-                "to the connection endpoint does not match the supplied "
-                "buffer size.");
+        // Send header and payload with a single call. This way, the data
+        // is coalesced into as few packets as possible.
+        while (bytesWritten < totalSize) {
+            ssize_t result = ::sendmsg(_endpoint, &msg, flags);
+            if (result < 0) {
+                int error = System::getLastErrorCode();
 
-        return bytesWritten;
-    }
+            #ifdef SIMUTRACE_SOCKET_ENABLE_ZEROCOPY
+                // The kernel could not pin further pages (optmem limit).
+                // Send the rest of the data with regular sends.
+                if ((error == ENOBUFS) && ((flags & MSG_ZEROCOPY) != 0)) {
+                    flags &= ~MSG_ZEROCOPY;
 
-    size_t SocketChannel::_send(const std::vector<Handle>& handles)
-    {
-        Throw(NotSupportedException);
+                    continue;
+                }
+            #endif
+
+                // If error is interrupted system-call we just continue
+                if (error != EINTR) {
+                    _zeroCopyPending = 0;
+
+                    Throw(PlatformException, error);
+                }
+
+                continue;
+            } else if (result == 0) {
+                _zeroCopyPending = 0;
+
+                Throw(PlatformException, ECONNRESET);
+            }
+
+        #ifdef SIMUTRACE_SOCKET_ENABLE_ZEROCOPY
+            // Each successful zero-copy call gets a completion notification
+            if ((flags & MSG_ZEROCOPY) != 0) {
+                _zeroCopyPending++;
+            }
+        #endif
+
+            bytesWritten += result;
+
+            // The call may have returned early. Skip the data that has
+            // already been written and send the rest.
+            size_t skip = static_cast<size_t>(result);
+            while ((skip > 0) && (msg.msg_iovlen > 0)) {
+                if (skip >= msg.msg_iov->iov_len) {
+                    skip -= msg.msg_iov->iov_len;
+
+                    msg.msg_iov++;
+                    msg.msg_iovlen--;
+                } else {
+                    msg.msg_iov->iov_base = reinterpret_cast<void*>(
+                        reinterpret_cast<size_t>(msg.msg_iov->iov_base) + skip);
+                    msg.msg_iov->iov_len -= skip;
+
+                    skip = 0;
+                }
+            }
+        }
+    #endif
+
+        ThrowOn(bytesWritten != totalSize, Exception, "The amount of data "
+                "written to the connection endpoint does not match the "
+                "supplied buffer size.");
+
+        return bytesWritten;
     }
 
-    size_t SocketChannel::_receive(void* data, size_t size)
+    size_t SocketChannel::_receiveSome(void* data, size_t size, int flags)
     {
         assert(data != nullptr && size > 0);
 
     #if defined(_WIN32)
-        int bytesRead = 0;
         int result;
+
+        result = ::recv(_endpoint, (char*)data, (int)size, flags);
+        if (result == SOCKET_ERROR) {
+            Throw(SocketException);
+        } else if (result == 0) {
+            Throw(PlatformException, ERROR_NO_DATA);
+        }
     #else
-        ssize_t bytesRead = 0;
         ssize_t result;
 
-        System::ignoreSignal(SIGPIPE); {
+        do {
+            result = ::recv(_endpoint, data, size, flags);
+            if (result < 0) {
+                int error = System::getLastErrorCode();
+
+                // If error is interrupted system-call we just continue
+                if (error != EINTR) {
+                    Throw(PlatformException, error);
+                }
+            } else if (result == 0) {
+                Throw(PlatformException, ECONNRESET);
+            }
+        } while (result < 0);
     #endif
 
-            do {
-                void* buf = reinterpret_cast<void*>(
-                    reinterpret_cast<size_t>(data) + bytesRead);
+        return static_cast<size_t>(result);
+    }
 
-            #if defined(_WIN32)
-                result = ::recv(_endpoint, (char*)buf,
-                                (int)(size - bytesRead), 0);
-                if (result == SOCKET_ERROR) {
-                    Throw(SocketException);
-            #else
-                result = ::recv(_endpoint, buf, size - bytesRead, 0);
-                if (result < 0) {
-                    int error = System::getLastErrorCode();
+    size_t SocketChannel::_receive(void* data, size_t size)
+    {
+        assert(data != nullptr && size > 0);
 
-                    // If error is interrupted system-call we just continue
-                    if (error != EINTR) {
-                        System::restoreSignal(SIGPIPE);
+        char* buffer = static_cast<char*>(data);
+        size_t bytesRead = 0;
 
-                        Throw(PlatformException, error);
-                    }
-            #endif
-                } else if (result > 0) {
-                    bytesRead += result;
-                } else {
-                    assert(result == 0);
+        if (_receiveBuffer.empty()) {
+            _receiveBuffer.resize(SIMUTRACE_SOCKET_RECEIVE_BUFFER_SIZE);
+        }
 
-                #if defined(_WIN32)
-                    Throw(PlatformException, ERROR_NO_DATA);
-                #else
-                    System::restoreSignal(SIGPIPE);
-                    Throw(PlatformException, ECONNRESET);
-                #endif
-                }
+        // Serve the request from previously buffered data first
+        size_t buffered = _receiveLength - _receiveOffset;
+        if (buffered > 0) {
+            size_t n = std::min(buffered, size);
+            memcpy(buffer, &_receiveBuffer[_receiveOffset], n);
 
-            } while ((result < 0) || (bytesRead < size));
+            _receiveOffset += n;
+            bytesRead += n;
+        }
 
-    #if defined(_WIN32)
-    #else
+        while (bytesRead < size) {
+            size_t remaining = size - bytesRead;
+
+            if (remaining >= _receiveBuffer.size()) {
+                // Large payloads (e.g., segments) go directly to the
+                // destination. There is no point in copying them through
+                // the buffer. We further let the kernel fill the whole
+                // destination before waking us up.
+                bytesRead += _receiveSome(buffer + bytesRead, remaining,
+                                          MSG_WAITALL);
+            } else {
+                // Read as much as is available. For small messages, this
+                // usually fetches the header together with the payload and
+                // saves us the additional system call for the payload.
+                _receiveLength = _receiveSome(_receiveBuffer.data(),
+                                              _receiveBuffer.size(), 0);
+
+                size_t n = std::min(_receiveLength, remaining);
+                memcpy(buffer + bytesRead, _receiveBuffer.data(), n);
+
+                _receiveOffset = n;
+                bytesRead += n;
+            }
         }
-        System::restoreSignal(SIGPIPE);
-    #endif
 
         ThrowOn(bytesRead != size, Exception, "The amount of data read from "
                 "the connection endpoint does not match the supplied "
@@ -40,6 +40,21 @@ namespace SimuTrace
 // Enable/disable ipv6 support
 #define SIMUTRACE_SOCKET_ENABLE_IPV6
 
+// Size of the buffer used to batch reads from the socket. Reads that are at
+// least as large as the buffer bypass it.
+#define SIMUTRACE_SOCKET_RECEIVE_BUFFER_SIZE (16 * 1024)
+
+// Enable/disable zero-copy send support (MSG_ZEROCOPY). Requires Linux 4.14+.
+#if defined(__linux__) && defined(MSG_ZEROCOPY) && defined(SO_ZEROCOPY) && \
+    defined(SO_EE_ORIGIN_ZEROCOPY)
+#define SIMUTRACE_SOCKET_ENABLE_ZEROCOPY
+#endif
+
+// Maximum number of zero-copy sends without a completion notification. A
+// send waits for completions if the limit is reached. This bounds the amount
+// of pinned memory and the length of the socket's error queue.
+#define SIMUTRACE_SOCKET_MAX_PENDING_ZEROCOPY 64
+
     class SocketChannel :
         public Channel
     {
@@ -52,6 +67,16 @@ namespace SimuTrace
         std::string _ipaddress;
         std::string _port;
 
+        std::vector<char> _receiveBuffer;
+        size_t _receiveOffset;
+        size_t _receiveLength;
+
+        // Sends of at least this size (in bytes) use zero-copy. A value of
+        // 0 disables zero-copy for the channel.
+        size_t _zeroCopyThreshold;
+        bool _zeroCopyEnabled;
+        uint32_t _zeroCopyPending;
+
         SocketChannel(SOCKET endpoint, const std::string& address);
 
         void _initChannel(bool isServer, const std::string& address,
@@ -71,6 +96,12 @@ namespace SimuTrace
         void _connectServerEndpoint();
 
         static void _closeSocket(SOCKET socket);
+        static void _configureSocket(SOCKET socket);
+
+        bool _enableZeroCopy();
+        void _reapZeroCopyCompletions(bool wait);
+
+        size_t _receiveSome(void* data, size_t size, int flags);
 
     private:
         virtual std::unique_ptr<Channel> _accept() override;
@@ -79,6 +110,8 @@ namespace SimuTrace
 
         virtual size_t _send(const void* data, size_t size) override;
         virtual size_t _send(const std::vector<Handle>& handles) override;
+        virtual size_t _sendGather(const void* header, size_t headerSize,
+                                   const void* data, size_t size) override;
         virtual size_t _receive(void* data, size_t size) override;
         virtual size_t _receive(std::vector<Handle>& handles,
                                 uint32_t handleCount) override;
@@ -22,6 +22,8 @@
 
 #include "ThreadBase.h"
 
+#include "MemoryHelpers.h"
+
 #include "Exceptions.h"
 #include <signal.h>
 #include <setjmp.h>
@@ -199,20 +201,35 @@ namespace System
         return (_state == TsStopping);
     }
 
-    void ThreadBase::waitForThread() const
+    void ThreadBase::waitForThread()
     {
-        if (!isRunning() || isExecutingThread()) {
+        // We also join threads that already finished execution, so the
+        // thread's resources are released and the thread has left its
+        // start routine when we return.
+        if ((_threadId == INVALID_THREAD_ID) || isExecutingThread()) {
             return;
         }
 
+        const bool running = isRunning();
+
     #if defined(_WIN32)
         if (::WaitForSingleObject(_thread, INFINITE) == WAIT_FAILED) {
             Throw(PlatformException);
         }
     #else
         void* result;
-        ::pthread_join(_threadId, &result);
-        ThrowOn(result != 0, PlatformException, *((int*)(&result)));
+        int error = ::pthread_join(_threadId, &result);
+        ThrowOn(error != 0, PlatformException, error);
+    #endif
+
+        // The thread has been joined. The destructor must not detach it
+        // anymore.
+        _threadId = INVALID_THREAD_ID;
+
+    #if defined(_WIN32)
+    #else
+        ThrowOn(running && (result != 0), PlatformException,
+                *((int*)(&result)));
     #endif
     }
 
@@ -242,6 +259,36 @@ namespace System
         return _priority;
     }
 
+    bool ThreadBase::setNumaNode(uint32_t node)
+    {
+        ThrowOn(_threadId == INVALID_THREAD_ID, InvalidOperationException);
+
+        const std::vector<uint32_t>& processors =
+            System::getNumaNodeProcessors(node);
+        if (processors.empty()) {
+            return false;
+        }
+
+    #if defined(_WIN32) || (defined(__MACH__) && defined(__APPLE__))
+        // Not implemented. Just do nothing.
+        return false;
+    #else
+        cpu_set_t set;
+        CPU_ZERO(&set);
+
+        for (auto cpu : processors) {
+            if (cpu < CPU_SETSIZE) {
+                CPU_SET(cpu, &set);
+            }
+        }
+
+        int result = ::pthread_setaffinity_np(_threadId, sizeof(set), &set);
+        ThrowOn(result != 0, PlatformException, result);
+
+        return true;
+    #endif
+    }
+
     bool ThreadBase::hasFinished() const
     {
         return (_state == TsFinished);
@@ -0,0 +1,305 @@
+/*
+ * Copyright 2015 (C) Karlsruhe Institute of Technology (KIT)
+ * Marc Rittinghaus
+ *
+ * Simutrace Client Library (libsimutrace) is part of Simutrace.
+ *
+ * libsimutrace is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libsimutrace is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libsimutrace. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "SimuStor.h"
+
+#include "AppendPipeline.h"
+
+#include "ClientSession.h"
+
+namespace SimuTrace
+{
+
+    AppendPipeline::AppendPipeline(ClientSession& session) :
+        _session(session),
+        _port(),
+        _lock(),
+        _queue(),
+        _streams(),
+        _stats(),
+        _thread(_threadMain)
+    {
+        // The pipeline joins the session with its own connection. That way,
+        // submissions do not interfere with the calls of the producer.
+        _port = std::unique_ptr<ClientPort>(
+            new ClientPort(session.getAddress()));
+
+        Message response = {0};
+
+        _port->call(&response, RpcApi::CCV_SessionOpen, RPC_VERSION,
+                    ClientSession::makeTransportOffer(*_port) |
+                    session.getServerSideId());
+
+        ClientSession::applyTransportSelection(*_port, response);
+
+        AppendPipeline* self = this;
+        _thread.setArgument(self);
+        _thread.start();
+    }
+
+    AppendPipeline::~AppendPipeline()
+    {
+        // The thread works off all pending submissions before it exits, so
+        // we do not lose segments that have been queued already.
+        Lock(_lock); {
+            if (!_queue.empty()) {
+                LogDebug("Stopping append pipeline with %zu pending "
+                         "submissions. Waiting for them to complete.",
+                         _queue.size());
+            }
+
+            if (_thread.isRunning()) {
+                _thread.stop();
+            }
+
+            _lock.wakeAll();
+        } Unlock();
+
+        _thread.waitForThread();
+
+        for (auto& pair : _streams) {
+            if (pair.second.failed) {
+                LogError("Asynchronous submission to stream %d failed. Data "
+                         "may have been lost. The error was '%s'.",
+                         pair.first, pair.second.error.c_str());
+            }
+        }
+
+        try {
+            _port->call(nullptr, RpcApi::CCV_SessionClose);
+        } catch (const std::exception& e) {
+            LogError("Failed to close append pipeline connection. "
+                     "The exception is '%s'.", e.what());
+        }
+
+        LogDebug("Append pipeline closed. %llu segments submitted, "
+                 "producers ran out of credits %llu times (%llu ms).",
+                 static_cast<unsigned long long>(_stats.submits),
+                 static_cast<unsigned long long>(_stats.stalls),
+                 static_cast<unsigned long long>(
+                    _stats.stallTicks / 1000000));
+    }
+
+    int AppendPipeline::_threadMain(Thread<AppendPipeline*>& thread)
+    {
+        AppendPipeline* pipeline = thread.getArgument();
+        assert(pipeline != nullptr);
+
+        Environment::set(&pipeline->_session.getEnvironment());
+
+        while (true) {
+            Request request;
+
+            Lock(pipeline->_lock); {
+                while (pipeline->_queue.empty() && !thread.shouldStop()) {
+                    pipeline->_lock.wait();
+                }
+
+                // Stop only when the queue has been drained
+                if (pipeline->_queue.empty()) {
+                    assert(thread.shouldStop());
+                    break;
+                }
+
+                request = pipeline->_queue.front();
+            } Unlock();
+
+            pipeline->_process(request);
+        }
+
+        return 0;
+    }
+
+    void AppendPipeline::_process(Request& request)
+    {
+        SegmentId id = INVALID_SEGMENT_ID;
+        bool skip;
+        std::string error;
+
+        // Once a submission failed, we do not send any further segments of
+        // the stream. The server expects them in order.
+        Lock(_lock); {
+            auto it = _streams.find(request.stream);
+            assert(it != _streams.end());
+
+            skip = it->second.failed;
+        } Unlock();
+
+        if (!skip) {
+            Message response = {0};
+            response.allocator = request.allocator;
+            response.allocatorArgs = request.allocatorArgs;
+
+            try {
+                _port->call(&response, RpcApi::CCV_StreamSubmitAndAppend,
+                            request.payload, request.payloadLength,
+                            request.stream, request.sequenceNumber);
+
+                id = static_cast<SegmentId>(response.data.parameter1);
+            } catch (const std::exception& e) {
+                error = e.what();
+                skip = true;
+
+                LogError("Failed to submit segment of stream %d <sqn: %d>. "
+                         "The exception is '%s'.", request.stream,
+                         request.sequenceNumber, e.what());
+            }
+        }
+
+        Lock(_lock); {
+            _queue.pop_front();
+
+            StreamState& state = _streams[request.stream];
+            assert(state.inFlight > 0);
+            state.inFlight--;
+
+            if (skip) {
+                if (!state.failed) {
+                    state.failed = true;
+                    state.error = error;
+                }
+            } else {
+                _stats.submits++;
+
+                if (id != INVALID_SEGMENT_ID) {
+                    state.credits.push_back(id);
+                }
+            }
+
+            _lock.wakeAll();
+        } Unlock();
+    }
+
+    void AppendPipeline::_throwOnError(StreamId stream, StreamState& state)
+    {
+        // Must be called with the lock held!
+
+        if (!state.failed) {
+            return;
+        }
+
+        // Wait until the remaining submissions of the stream have been
+        // skipped, so we can forget the stream. Its remaining append
+        // segments will be cleaned up by the server, when the session closes.
+        while (state.inFlight > 0) {
+            _lock.wait();
+        }
+
+        std::string error = state.error;
+        _streams.erase(stream);
+
+        Throw(Exception, stringFormat("Asynchronous submission to stream "
+              "%d failed. The error was '%s'.", stream, error.c_str()));
+    }
+
+    void AppendPipeline::addCredit(StreamId stream, SegmentId segment)
+    {
+        assert(segment != INVALID_SEGMENT_ID);
+
+        LockScope(_lock);
+        _streams[stream].credits.push_back(segment);
+    }
+
+    void AppendPipeline::submit(StreamId stream,
+                                StreamSegmentId sequenceNumber,
+                                const void* payload, uint32_t payloadLength,
+                                PayloadAllocator allocator,
+                                void* allocatorArgs)
+    {
+        Request request;
+        request.stream         = stream;
+        request.sequenceNumber = sequenceNumber;
+        request.payload        = payload;
+        request.payloadLength  = payloadLength;
+        request.allocator      = allocator;
+        request.allocatorArgs  = allocatorArgs;
+
+        LockScope(_lock);
+        ThrowOn(!_thread.isRunning(), InvalidOperationException);
+
+        StreamState& state = _streams[stream];
+        _throwOnError(stream, state);
+
+        state.inFlight++;
+        _queue.push_back(request);
+
+        _lock.wakeAll();
+    }
+
+    SegmentId AppendPipeline::acquire(StreamId stream)
+    {
+        LockScope(_lock);
+
+        StreamState& state = _streams[stream];
+        if (state.credits.empty() && (state.inFlight > 0)) {
+            uint64_t start = Clock::getTicks();
+
+            while (state.credits.empty() && (state.inFlight > 0) &&
+                   !state.failed) {
+                _lock.wait();
+            }
+
+            _stats.stalls++;
+            _stats.stallTicks += Clock::getTicks() - start;
+        }
+
+        _throwOnError(stream, state);
+
+        // The server could not reserve any further segments for us. This
+        // is the same as a failed synchronous append.
+        if (state.credits.empty()) {
+            return INVALID_SEGMENT_ID;
+        }
+
+        SegmentId id = state.credits.front();
+        state.credits.pop_front();
+
+        return id;
+    }
+
+    void AppendPipeline::drain(StreamId stream,
+                               std::vector<SegmentId>& creditsOut)
+    {
+        LockScope(_lock);
+
+        auto it = _streams.find(stream);
+        if (it == _streams.end()) {
+            return;
+        }
+
+        StreamState& state = it->second;
+        while (state.inFlight > 0) {
+            _lock.wait();
+        }
+
+        _throwOnError(stream, state);
+
+        creditsOut.insert(creditsOut.end(), state.credits.begin(),
+                          state.credits.end());
+
+        _streams.erase(it);
+    }
+
+    void AppendPipeline::getStatistics(Statistics& statsOut) const
+    {
+        LockScope(_lock);
+        statsOut = _stats;
+    }
+
+}
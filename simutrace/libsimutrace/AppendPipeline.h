@@ -0,0 +1,125 @@
+/*
+ * Copyright 2015 (C) Karlsruhe Institute of Technology (KIT)
+ * Marc Rittinghaus
+ *
+ * Simutrace Client Library (libsimutrace) is part of Simutrace.
+ *
+ * libsimutrace is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * libsimutrace is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with libsimutrace. If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#ifndef APPEND_PIPELINE_H
+#define APPEND_PIPELINE_H
+
+#include "SimuStor.h"
+
+namespace SimuTrace
+{
+
+    class ClientSession;
+
+    // Submits written segments of a session in the background. The pipeline
+    // owns a dedicated connection to the server and a thread that works off
+    // the submissions in the order they have been queued. For every
+    // submitted segment the server appends a new segment to the stream. The
+    // response on the pipeline's connection thus acknowledges the submission
+    // and at the same time returns a new credit for the producer.
+    //
+    // A producer keeps a window of reserved segments per stream (credits).
+    // When it has filled a segment, it queues the segment for submission
+    // and continues with the next credit without waiting for the server.
+    // The producer only blocks, if it runs out of credits.
+    class AppendPipeline
+    {
+    public:
+        struct Statistics {
+            uint64_t submits;    // Number of submitted segments
+            uint64_t stalls;     // Number of times a producer ran dry
+            uint64_t stallTicks; // Time producers waited for credits
+        };
+
+    private:
+        DISABLE_COPY(AppendPipeline);
+
+        struct Request {
+            StreamId stream;
+            StreamSegmentId sequenceNumber;
+
+            const void* payload;
+            uint32_t payloadLength;
+
+            PayloadAllocator allocator;
+            void* allocatorArgs;
+        };
+
+        struct StreamState {
+            std::deque<SegmentId> credits;
+            uint32_t inFlight;
+
+            bool failed;
+            std::string error;
+
+            StreamState() :
+                credits(),
+                inFlight(0),
+                failed(false),
+                error() { }
+        };
+
+        ClientSession& _session;
+        std::unique_ptr<ClientPort> _port;
+
+        // Protects all members below
+        mutable ConditionVariable _lock;
+
+        std::deque<Request> _queue;
+        std::map<StreamId, StreamState> _streams;
+
+        Statistics _stats;
+
+        Thread<AppendPipeline*> _thread;
+
+        static int _threadMain(Thread<AppendPipeline*>& thread);
+
+        void _process(Request& request);
+        void _throwOnError(StreamId stream, StreamState& state);
+    public:
+        AppendPipeline(ClientSession& session);
+        ~AppendPipeline();
+
+        // Adds a reserved segment to the window of the given stream
+        void addCredit(StreamId stream, SegmentId segment);
+
+        // Queues the submission of a written append segment. The payload
+        // must stay valid until the submission has been acknowledged.
+        void submit(StreamId stream, StreamSegmentId sequenceNumber,
+                    const void* payload, uint32_t payloadLength,
+                    PayloadAllocator allocator, void* allocatorArgs);
+
+        // Returns the next reserved segment of the stream. If the window is
+        // empty, the method waits for outstanding submissions to complete.
+        // Returns INVALID_SEGMENT_ID if the server could not reserve further
+        // segments. Throws if a submission of the stream failed.
+        SegmentId acquire(StreamId stream);
+
+        // Waits until all submissions of the stream have been acknowledged
+        // and returns the unused reserved segments in the order of their
+        // reservation. Afterwards, the pipeline forgets the stream.
+        void drain(StreamId stream, std::vector<SegmentId>& creditsOut);
+
+        void getStatistics(Statistics& statsOut) const;
+    };
+
+}
+
+#endif
@@ -41,7 +41,9 @@ namespace SimuTrace
                                  SessionId serverSideId, const Environment& root) :
         Session(manager, serverApiVersion, localId, root),
         _address(),
-        _serverSideId(serverSideId)
+        _serverSideId(serverSideId),
+        _pipelineLock(),
+        _appendPipeline()
     {
         ThrowOnNull(port, ArgumentNullException, "port");
 
@@ -53,6 +55,8 @@ namespace SimuTrace
 
     ClientSession::~ClientSession()
     {
+        _closeAppendPipeline();
+
         for (int i = 0; i < _clients.size(); ++i) {
             LogWarn("The thread %d attached to session %d, but did not "
                     "detach. Ensure that all threads properly close their "
@@ -102,6 +106,15 @@ namespace SimuTrace
         }
     }
 
+    void ClientSession::_closeAppendPipeline()
+    {
+        LockScope(_pipelineLock);
+
+        // All write handles have been closed at this point. Destroying the
+        // pipeline closes its connection to the server.
+        _appendPipeline = nullptr;
+    }
+
     void ClientSession::_determineStreamBufferConfiguration(
         uint32_t& numSegments)
     {
@@ -205,8 +218,12 @@ namespace SimuTrace
         ThrowOnNull(cp, ArgumentException, "port");
 
         if (_clients.size() > 0) {
-            cp->call(nullptr, RpcApi::CCV_SessionOpen, RPC_VERSION,
-                     _serverSideId);
+            Message response = {0};
+
+            cp->call(&response, RpcApi::CCV_SessionOpen, RPC_VERSION,
+                     makeTransportOffer(*cp) | _serverSideId);
+
+            applyTransportSelection(*cp, response);
         }
 
         if (context == nullptr) {
@@ -245,6 +262,12 @@ namespace SimuTrace
             return true;
         }
 
+        // The append pipeline is part of the session. It has to leave
+        // before the last thread, so the server does not wait for it.
+        if (_clients.size() == 1) {
+            _closeAppendPipeline();
+        }
+
         ClientPort* port = it->second.get();
         port->call(nullptr, RpcApi::CCV_SessionClose);
 
@@ -354,6 +377,87 @@ namespace SimuTrace
         return _address;
     }
 
+    SessionId ClientSession::getServerSideId() const
+    {
+        return _serverSideId;
+    }
+
+    AppendPipeline& ClientSession::getAppendPipeline()
+    {
+        LockScope(_pipelineLock);
+
+        if (_appendPipeline == nullptr) {
+            _appendPipeline = std::unique_ptr<AppendPipeline>(
+                new AppendPipeline(*this));
+        }
+
+        return *_appendPipeline;
+    }
+
+    uint64_t ClientSession::makeTransportOffer(const ClientPort& port)
+    {
+        ChannelCapabilities caps = port.getChannelCaps();
+
+        // Segments are not transferred over connections with shared memory.
+        // However, we can move the RPCs to a command ring.
+        if (IsSet(caps, ChannelCapabilities::CCapHandleTransfer)) {
+            return IsSet(caps, ChannelCapabilities::CCapCommandRing) ?
+                RpcApi::makeCommandRingOffer() : 0;
+        }
+
+        uint32_t mask = 0;
+        for (uint32_t id = 0; id < Compression::CiNone; ++id) {
+            if (Compression::findCodec(
+                    static_cast<Compression::CodecId>(id)) != nullptr) {
+                mask |= 1 << id;
+            }
+        }
+
+        return RpcApi::makeCompressionOffer(mask);
+    }
+
+    void ClientSession::applyTransportSelection(ClientPort& port,
+                                                Message& response)
+    {
+        // The server returns the command ring as handle
+        if (response.payloadType == MessagePayloadType::MptHandles) {
+            assert(response.handles.handles != nullptr);
+            assert(response.handles.handles->size() ==
+                   response.handles.handleCount);
+
+            ThrowOn(response.handles.handleCount != 1,
+                    RpcMessageMalformedException);
+
+            Handle& ringHandle = response.handles.handles->at(0);
+
+            std::unique_ptr<CommandRing> ring(
+                new CommandRing(ringHandle, response.handles.parameter1));
+
+            // The server has already enabled the ring, after it sent the
+            // response. We must not use the ring for anything before.
+            ring->enable();
+            port.setCommandRing(ring);
+
+            LogDebug("Using command ring with %d KiB per direction.",
+                     port.getCommandRing()->getCapacity() >> 10);
+
+            return;
+        }
+
+        Compression::CodecId codec =
+            RpcApi::getSelectedCodec(response.embedded.parameter1);
+
+        if (codec == Compression::CiInvalid) {
+            return;
+        }
+
+        port.setCompression(codec,
+            RpcApi::getSelectedCodecLevel(response.embedded.parameter1));
+
+        LogDebug("Compressing transferred data with codec '%s'.",
+                 Compression::getCodec(codec)->name);
+    }
+
     ClientPort& ClientSession::getPort() const
     {
         ThrowOnNull(_context, InvalidOperationException);
@@ -24,6 +24,8 @@
 #include "SimuStor.h"
 #include "SimuTraceTypes.h"
 
+#include "AppendPipeline.h"
+
 namespace SimuTrace
 {
 
@@ -42,6 +44,13 @@ namespace SimuTrace
         static __thread ClientThreadContext* _context;
         std::vector<ClientThreadContext*> _clients;
 
+        // Background submission of segments for streams with an append
+        // window (see client.stream.appendWindow). Created on first use.
+        CriticalSection _pipelineLock;
+        std::unique_ptr<AppendPipeline> _appendPipeline;
+
+        void _closeAppendPipeline();
+
         void _detachFromContext(ClientThreadContext* context);
         void _determineStreamBufferConfiguration(uint32_t& numSegments);
         void _updateSettings();
@@ -69,7 +78,17 @@ namespace SimuTrace
         StreamId registerDynamicStream(DynamicStreamDescriptor& desc);
 
         const std::string& getAddress() const;
+        SessionId getServerSideId() const;
         ClientPort& getPort() const;
+
+        AppendPipeline& getAppendPipeline();
+
+        // Transport options of a connection (compression, command ring).
+        // The offer is passed with SessionCreate/SessionOpen, the selection
+        // is taken from the server's response (see RpcProtocol.h).
+        static uint64_t makeTransportOffer(const ClientPort& port);
+        static void applyTransportSelection(ClientPort& port,
+                                            Message& response);
     };
 
 }
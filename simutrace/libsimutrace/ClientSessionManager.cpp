@@ -31,7 +31,8 @@ namespace SimuTrace
         SessionManager(),
         _config(),
         _log(""),
-        _environment()
+        _environment(),
+        _openLock()
     {
         _environment.log = &_log;
         _environment.config = &_config;
@@ -64,6 +65,11 @@ namespace SimuTrace
         // Apply default configuration
         int recPoolSize = SIMUTRACE_CLIENT_MEMMGMT_RECOMMENDED_POOLSIZE;
         Configuration::set<int>("client.memmgmt.poolSize", recPoolSize);
+
+        // Submit segments synchronously. Larger windows let producers
+        // continue writing while previous segments are transferred.
+        int appendWindow = 1;
+        Configuration::set<int>("client.stream.appendWindow", appendWindow);
     }
 
     std::unique_ptr<Session> ClientSessionManager::_startSession(
@@ -74,12 +80,16 @@ namespace SimuTrace
         ClientPort& port = dynamic_cast<ClientPort&>(*sessionPort);
 
         // Create the server session
-        port.call(&response, RpcApi::CCV_SessionCreate, RPC_VERSION);
+        port.call(&response, RpcApi::CCV_SessionCreate, RPC_VERSION,
+                  ClientSession::makeTransportOffer(port));
 
-        ThrowOn((response.payloadType != MessagePayloadType::MptEmbedded) ||
+        ThrowOn(((response.payloadType != MessagePayloadType::MptEmbedded) &&
+                 (response.payloadType != MessagePayloadType::MptHandles)) ||
                 (response.parameter0 == INVALID_SESSION_ID),
                 RpcMessageMalformedException);
 
+        ClientSession::applyTransportSelection(port, response);
+
         // Create the local client session. If this fails, we will close the
         // port. This will also close the session on the server side.
         return std::unique_ptr<Session>(
@@ -137,6 +147,16 @@ namespace SimuTrace
                     stringFormat("session with id %d", session));
 
         uint16_t apiVersion = cs->getPeerApiVersion();
+
+        // The server processes new connections in the order it accepts
+        // them and waits for the first request on each connection. If
+        // another thread connected before us, but sent its request after
+        // ours (the session allows only one attach at a time), a server
+        // with a single request worker would wait for that thread, while
+        // it waits for our response. We therefore connect and send the
+        // request in one go.
+        LockScope(_openLock);
+
         std::unique_ptr<Port> port(new ClientPort(cs->getAddress()));
 
         _openLocalSession(session, port, apiVersion);
@@ -36,6 +36,10 @@ namespace SimuTrace
         LogCategory _log;
         Environment _environment;
 
+        // Serializes connecting and opening local sessions. See
+        // openLocalSession().
+        CriticalSection _openLock;
+
         void _initializeEnvironment();
 
         virtual std::unique_ptr<Session> _startSession(SessionId localId,
@@ -237,8 +237,10 @@ namespace SimuTrace
             std::vector<StreamId> ids;
             _enumerateStreams(ids, StreamEnumFilter::SefRegular);
 
-            StreamId max = *std::max_element(ids.cbegin(), ids.cend());
-            assert(max < sid);
+            if (!ids.empty()) {
+                StreamId max = *std::max_element(ids.cbegin(), ids.cend());
+                assert(max < sid);
+            }
         #endif
 
             return std::unique_ptr<Stream>(
@@ -309,13 +311,16 @@ namespace SimuTrace
         }
 
         // Now add the dynamic streams that this client session possesses.
-        std::vector<Stream*> dynStreams;
-        this->Store::_enumerateStreams(dynStreams, StreamEnumFilter::SefDynamic);
-        for (auto stream : dynStreams) {
-            assert(IsSet(stream->getFlags(), StreamFlags::SfDynamic));
-            assert(!IsSet(stream->getFlags(), StreamFlags::SfHidden));
-
-            ids.push_back(stream->getId());
+        if (IsSet(filter, StreamEnumFilter::SefDynamic)) {
+            std::vector<Stream*> dynStreams;
+            this->Store::_enumerateStreams(dynStreams,
+                                           StreamEnumFilter::SefDynamic);
+            for (auto stream : dynStreams) {
+                assert(IsSet(stream->getFlags(), StreamFlags::SfDynamic));
+                assert(!IsSet(stream->getFlags(), StreamFlags::SfHidden));
+
+                ids.push_back(stream->getId());
+            }
         }
 
         std::swap(ids, out);
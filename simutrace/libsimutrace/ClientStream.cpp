@@ -32,6 +32,7 @@ namespace SimuTrace
         Stream(id, desc, buffer),
         ClientObject(session),
         _lock(),
+        _handleLock(),
         _writeHandle(),
         _readHandles()
     {
@@ -53,6 +54,8 @@ namespace SimuTrace
         assert(handle != nullptr);
         assert(handle->stream == this);
 
+        LockScope(_handleLock);
+
         if (!IsSet(handle->flags, StreamStateFlags::SsfRead)) {
             assert(_writeHandle == nullptr);
 
@@ -68,6 +71,8 @@ namespace SimuTrace
         assert(handle->stream == this);
         StreamId id = reinterpret_cast<ClientStream*>(handle->stream)->getId();
 
+        LockScope(_handleLock);
+
         if (handle == _writeHandle.get()) {
             assert(!IsSet(handle->flags, StreamStateFlags::SsfRead));
             assert(!IsSet(handle->flags, StreamStateFlags::SsfDynamic));
@@ -99,6 +104,18 @@ namespace SimuTrace
         }
     }
 
+    void ClientStream::_flushHandle(StreamHandle handle)
+    {
+        // For a stream to contain new data, a corresponding stream handle has
+        // to be allocated. A write handle therefore points to a segment that
+        // needs to be submitted. However, for segments backed by a
+        // shared-memory buffer, we let the server submit it automatically.
+
+        if (getStreamBuffer().isMaster()) {
+            _closeHandle(handle);
+        }
+    }
+
     StreamHandle ClientStream::append(StreamHandle handle)
     {
         LockScope(_lock);
@@ -115,8 +132,6 @@ namespace SimuTrace
     StreamHandle ClientStream::open(QueryIndexType type, uint64_t value,
                                     StreamAccessFlags flags, StreamHandle handle)
     {
-        LockScope(_lock);
-
         // We do not check here, if the supplied handle is in our list or if
         // it is a manually crafted one by the caller. However, we do not need
         // to care.
@@ -126,6 +141,16 @@ namespace SimuTrace
                     InvalidOperationException);
         }
 
+        // Opening a read handle of a static stream does not touch any state
+        // of the stream except for the handle list. Threads reading the
+        // stream with different handles thus can wait for their segments in
+        // parallel. The handlers of dynamic streams may rely on being
+        // serialized.
+        if (!IsSet(getFlags(), StreamFlags::SfDynamic)) {
+            return _open(type, value, flags, handle);
+        }
+
+        LockScope(_lock);
         return _open(type, value, flags, handle);
     }
 
@@ -152,15 +177,7 @@ namespace SimuTrace
             return;
         }
 
-        // For a stream to contain new data, a corresponding stream handle has
-        // to be allocated. A write handle therefore points to a segment that
-        // needs to be submitted. However, for segments backed by a
-        // shared-memory buffer, we let the server submit it automatically.
-
-        if (getStreamBuffer().isMaster()) {
-            _closeHandle(_writeHandle.get());
-        }
-
+        _flushHandle(_writeHandle.get());
         _releaseHandle(_writeHandle.get());
     }
 
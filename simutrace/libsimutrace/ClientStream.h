@@ -36,6 +36,10 @@ namespace SimuTrace
 
         CriticalSection _lock;
 
+        // Protects the handle lists. Read handles of static streams are
+        // opened without the stream lock (see open()).
+        CriticalSection _handleLock;
+
         std::unique_ptr<StreamStateDescriptor> _writeHandle;
         std::list<std::unique_ptr<StreamStateDescriptor>> _readHandles;
     protected:
@@ -48,6 +52,7 @@ namespace SimuTrace
                                    StreamHandle handle) = 0;
 
         virtual void _closeHandle(StreamHandle handle) = 0;
+        virtual void _flushHandle(StreamHandle handle);
     public:
         ClientStream(StreamId id, const StreamDescriptor& desc,
                      StreamBuffer& buffer, ClientSession& session);
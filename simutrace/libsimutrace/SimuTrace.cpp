@@ -25,6 +25,7 @@
 #include "ClientSessionManager.h"
 #include "ClientSession.h"
 #include "ClientStream.h"
+#include "StaticStream.h"
 
 namespace SimuTrace
 {
@@ -589,6 +590,252 @@ namespace SimuTrace
         return result;
     }
 
+    inline StaticStream& _getStaticStream(SessionId session, StreamId stream)
+    {
+        ClientSession& cs = _getSession(session);
+
+        // Dynamic streams do not consist of segments and cannot be split
+        StaticStream* sstream =
+            dynamic_cast<StaticStream*>(&cs.getStream(stream));
+        ThrowOnNull(sstream, NotSupportedException);
+
+        return *sstream;
+    }
+
+    SIMUTRACE_API
+    int StStreamPartition(SessionId session, StreamId stream, uint32_t count,
+                          StreamPartition* partitionsOut)
+    {
+        int result = 0;
+
+        API_TRY {
+            ThrowOnNull(partitionsOut, ArgumentNullException, "partitionsOut");
+            ThrowOn((count == 0) ||
+                    (count > static_cast<uint32_t>(
+                        std::numeric_limits<int>::max())),
+                    ArgumentOutOfBoundsException, "count");
+
+            StaticStream& sstream = _getStaticStream(session, stream);
+
+            std::vector<StreamPartition> partitions;
+            sstream.partition(count, partitions);
+            assert(partitions.size() <= count);
+
+            std::copy(partitions.begin(), partitions.end(), partitionsOut);
+
+            result = static_cast<int>(partitions.size());
+        } API_CATCH(result, -1);
+
+        return result;
+    }
+
+    SIMUTRACE_API
+    StreamHandle StStreamOpenPartition(SessionId session, StreamId stream,
+                                       const StreamPartition* partition,
+                                       StreamAccessFlags flags)
+    {
+        StreamHandle result = nullptr;
+
+        API_TRY {
+            ThrowOnNull(partition, ArgumentNullException, "partition");
+
+            StaticStream& sstream = _getStaticStream(session, stream);
+
+            result = sstream.openPartition(*partition, flags);
+        } API_CATCH(result, nullptr);
+
+        return result;
+    }
+
+    struct _ParallelScanWorker {
+        SessionId session;
+        StreamId stream;
+        StreamAccessFlags flags;
+
+        uint32_t index;
+        StreamPartition partition;
+
+        ParallelScanPartition scan;
+        void* userData;
+
+        // Shared by all workers of the scan. Set by the first worker that
+        // fails, so the others stop at their next segment boundary.
+        volatile _bool* abort;
+
+        // Last error of the worker thread, if the scan failed
+        bool failed;
+        ExceptionSite errorSite;
+        ExceptionClass errorClass;
+        int error;
+        std::string errorMessage;
+    };
+
+    void _saveLastError(_ParallelScanWorker& worker)
+    {
+        *worker.abort       = _true;
+        worker.failed       = true;
+        worker.errorSite    = _lastErrorSite;
+        worker.errorClass   = _lastErrorClass;
+        worker.error        = _lastError;
+        worker.errorMessage = (_lastErrorMessage != nullptr) ?
+            *_lastErrorMessage : std::string();
+    }
+
+    StreamHandle _openScanPartition(_ParallelScanWorker& worker)
+    {
+        StreamHandle result = nullptr;
+
+        API_TRY {
+            StaticStream& sstream = _getStaticStream(worker.session,
+                                                     worker.stream);
+
+            // The stream keeps the abort flag with the handle, so that the
+            // partition ends early if another worker fails.
+            result = sstream.openPartition(worker.partition, worker.flags,
+                                           worker.abort);
+        } API_CATCH(result, nullptr);
+
+        return result;
+    }
+
+    int _parallelScanMain(Thread<_ParallelScanWorker*>& thread)
+    {
+        _ParallelScanWorker* worker = thread.getArgument();
+        assert(worker != nullptr);
+
+        // Another partition already failed. The scan result is discarded
+        // anyway, so we do not even start.
+        if (*worker->abort != _false) {
+            return 0;
+        }
+
+        // The worker joins the session with its own connection. Its requests
+        // thus do not queue up behind the requests of the other workers.
+        if (!StSessionOpen(worker->session)) {
+            _saveLastError(*worker);
+        } else {
+            StreamHandle handle = _openScanPartition(*worker);
+            if (handle == nullptr) {
+                _saveLastError(*worker);
+            } else {
+                int code = worker->scan(worker->userData, worker->index,
+                                        &handle);
+                if (code != 0) {
+                    _setLastError(ExceptionSite::EsClient,
+                                  ExceptionClass::EcUser, code, nullptr);
+                    _saveLastError(*worker);
+                }
+
+                if (handle != nullptr) {
+                    StStreamClose(handle);
+                }
+            }
+
+            StSessionClose(worker->session);
+        }
+
+        // Release the error message of the thread
+        _setLastErrorSuccess();
+
+        // The error is reported through the worker. A non-zero exit code
+        // would make the join throw.
+        return 0;
+    }
+
+    SIMUTRACE_API
+    _bool StStreamParallelScan(SessionId session, StreamId stream,
+                               uint32_t threadCount, StreamAccessFlags flags,
+                               ParallelScanPartition scan,
+                               ParallelScanReduce reduce, void* userData)
+    {
+        typedef Thread<_ParallelScanWorker*> WorkerThread;
+
+        _bool result = _true;
+        std::vector<_ParallelScanWorker> workers;
+        volatile _bool abort = _false;
+        const _ParallelScanWorker* failed = nullptr;
+        int reduceError = 0;
+
+        API_TRY {
+            ThrowOnNull(scan, ArgumentNullException, "scan");
+            ThrowOn(threadCount == 0, ArgumentOutOfBoundsException,
+                    "threadCount");
+
+            StaticStream& sstream = _getStaticStream(session, stream);
+
+            std::vector<StreamPartition> partitions;
+            sstream.partition(threadCount, partitions);
+
+            workers.resize(partitions.size());
+            for (uint32_t i = 0; i < workers.size(); ++i) {
+                _ParallelScanWorker& worker = workers[i];
+
+                worker.session   = session;
+                worker.stream    = stream;
+                worker.flags     = flags;
+                worker.index     = i;
+                worker.partition = partitions[i];
+                worker.scan      = scan;
+                worker.userData  = userData;
+                worker.abort     = &abort;
+                worker.failed    = false;
+            }
+
+            std::vector<std::unique_ptr<WorkerThread>> threads;
+            auto waitForWorkers = [&threads]() {
+                for (auto& thread : threads) {
+                    thread->waitForThread();
+                }
+            };
+
+            try {
+                for (auto& worker : workers) {
+                    _ParallelScanWorker* arg = &worker;
+
+                    threads.push_back(std::unique_ptr<WorkerThread>(
+                        new WorkerThread(_parallelScanMain, arg)));
+                    threads.back()->start();
+                }
+            } catch (...) {
+                abort = _true;
+                waitForWorkers();
+                throw;
+            }
+
+            waitForWorkers();
+
+            for (auto& worker : workers) {
+                if (worker.failed) {
+                    failed = &worker;
+                    break;
+                }
+            }
+
+            // Merge the results in the order of the stream
+            if ((failed == nullptr) && (reduce != nullptr)) {
+                for (uint32_t i = 0; i < workers.size(); ++i) {
+                    reduceError = reduce(userData, i);
+                    if (reduceError != 0) {
+                        break;
+                    }
+                }
+            }
+        } API_CATCH(result, _false);
+
+        if (failed != nullptr) {
+            _setLastError(failed->errorSite, failed->errorClass, failed->error,
+                          (failed->errorMessage.empty()) ? nullptr :
+                            failed->errorMessage.c_str());
+            result = _false;
+        } else if (reduceError != 0) {
+            _setLastError(ExceptionSite::EsClient, ExceptionClass::EcUser,
+                          reduceError, nullptr);
+            result = _false;
+        }
+
+        return result;
+    }
+
 
     /* Tracing API */
 
@@ -610,6 +857,24 @@ namespace SimuTrace
         StSubmitEntryFast(handle);
     }
 
+    SIMUTRACE_API
+    void* StGetNextEntries(StreamHandle* handlePtr, size_t* countOut)
+    {
+        return StGetNextEntriesFast(handlePtr, countOut);
+    }
+
+    SIMUTRACE_API
+    void* StReserveEntries(StreamHandle* handlePtr, size_t* countOut)
+    {
+        return StReserveEntriesFast(handlePtr, countOut);
+    }
+
+    SIMUTRACE_API
+    void StSubmitEntries(StreamHandle handle, size_t count)
+    {
+        StSubmitEntriesFast(handle, count);
+    }
+
     SIMUTRACE_API
     size_t StWriteVariableData(StreamHandle* handlePtr, byte* sourceBuffer,
                                size_t sourceLength, uint64_t* referenceOut)
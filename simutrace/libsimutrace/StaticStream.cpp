@@ -21,6 +21,7 @@
 
 #include "StaticStream.h"
 
+#include "AppendPipeline.h"
 #include "ClientStream.h"
 
 namespace SimuTrace
@@ -29,7 +30,10 @@ namespace SimuTrace
     StaticStream::StaticStream(StreamId id, const StreamDescriptor& desc,
                                StreamBuffer& buffer,
                                ClientSession& session) :
-        ClientStream(id, desc, buffer, session)
+        ClientStream(id, desc, buffer, session),
+        _appendWindow(1),
+        _scanLock(),
+        _scanAborts()
     {
 
     }
@@ -124,6 +128,24 @@ namespace SimuTrace
         handle->entry = nullptr;
         handle->segmentStart = nullptr;
         handle->segmentEnd = nullptr;
+
+        // The stream does not close invalid handles (see ClientStream::close())
+        _releaseScanAbort(handle);
+    }
+
+    bool StaticStream::_isScanAborted(StreamHandle handle)
+    {
+        LockScope(_scanLock);
+
+        auto it = _scanAborts.find(handle);
+        return (it != _scanAborts.end()) && (*it->second != _false);
+    }
+
+    void StaticStream::_releaseScanAbort(StreamHandle handle)
+    {
+        LockScope(_scanLock);
+
+        _scanAborts.erase(handle);
     }
 
     void StaticStream::_payloadAllocatorWrite(Message& msg, bool free, void* args)
@@ -183,11 +205,129 @@ namespace SimuTrace
         msg.data.payload = segment;
     }
 
+    SegmentId StaticStream::_reserveAppend()
+    {
+        Message response = {0};
+        response.allocator = _payloadAllocatorWrite;
+        response.allocatorArgs = this;
+
+        _getPort().call(&response, RpcApi::CCV_StreamSubmitAndAppend,
+                        nullptr, 0, getId(), INVALID_STREAM_SEGMENT_ID);
+
+        return static_cast<SegmentId>(response.data.parameter1);
+    }
+
+    void StaticStream::_drainAppend()
+    {
+        if (_appendWindow <= 1) {
+            return;
+        }
+
+        std::vector<SegmentId> credits;
+        AppendPipeline& pipeline = getSession().getAppendPipeline();
+
+        // Wait for all submissions to complete. Only then, the segments
+        // reserved at the end of the stream can be released in reverse
+        // order without leaving holes.
+        pipeline.drain(getId(), credits);
+
+        StreamBuffer& buffer = getStreamBuffer();
+        for (auto it = credits.rbegin(); it != credits.rend(); ++it) {
+            SegmentControlElement* ctrl = buffer.getControlElement(*it);
+            assert(ctrl != nullptr);
+
+            _getPort().call(nullptr, RpcApi::CCV_StreamAppendCancel, getId(),
+                            ctrl->link.sequenceNumber);
+        }
+    }
+
+    StreamHandle StaticStream::_appendAsync(StreamHandle handle)
+    {
+        AppendPipeline& pipeline = getSession().getAppendPipeline();
+        SegmentId id;
+
+        if (handle == nullptr) {
+            // Fill the window. We need at least one segment to start. If
+            // the server cannot give us more, we start with fewer credits.
+            id = _reserveAppend();
+
+            for (uint32_t i = 1; (i < _appendWindow) &&
+                                 (id != INVALID_SEGMENT_ID); ++i) {
+                SegmentId credit = _reserveAppend();
+                if (credit == INVALID_SEGMENT_ID) {
+                    break;
+                }
+
+                pipeline.addCredit(getId(), credit);
+            }
+        } else {
+            assert(handle->stream == this);
+            assert(!IsSet(handle->flags, StreamStateFlags::SsfRead));
+            assert(!IsSet(handle->flags, StreamStateFlags::SsfDynamic));
+            assert(handle->segment != INVALID_SEGMENT_ID);
+
+            uint32_t payloadLength;
+            void* payload = _getPayload(handle->segment, &payloadLength);
+
+            // Hand the segment to the pipeline and continue with the next
+            // credit. We do not touch the submitted segment anymore.
+            try {
+                pipeline.submit(getId(),
+                                handle->stat.control->link.sequenceNumber,
+                                payload, payloadLength,
+                                _payloadAllocatorWrite, this);
+
+                id = pipeline.acquire(getId());
+            } catch (...) {
+                _releaseHandle(handle);
+
+                throw;
+            }
+        }
+
+        if (id == INVALID_SEGMENT_ID) {
+            if (handle != nullptr) {
+                _drainAppend();
+                _releaseHandle(handle);
+            }
+
+            return nullptr;
+        }
+
+        if (handle == nullptr) {
+            std::unique_ptr<StreamStateDescriptor> desc(
+                new StreamStateDescriptor());
+
+            _initializeStaticHandle(desc.get(), id);
+
+            handle = desc.get();
+            _addHandle(desc);
+
+            LogDebug("Created new write handle for stream %d with an append "
+                     "window of %d segments.", getId(), _appendWindow);
+        } else {
+            _initializeStaticHandle(handle, id);
+        }
+
+        return handle;
+    }
+
     StreamHandle StaticStream::_append(StreamHandle handle)
     {
         uint32_t payloadLength = 0;
         void* payload = nullptr;
 
+        // The append window is a property of the write handle. It may only
+        // change when a new handle is created.
+        if (handle == nullptr) {
+            int window = Configuration::get<int>("client.stream.appendWindow");
+            _appendWindow = static_cast<uint32_t>(std::max(window, 1));
+        }
+
+        if (_appendWindow > 1) {
+            return _appendAsync(handle);
+        }
+
         if (handle != nullptr) {
             assert(handle->stream == this);
             assert(!IsSet(handle->flags, StreamStateFlags::SsfRead));
@@ -245,8 +385,10 @@ namespace SimuTrace
         return handle;
     }
 
-    StreamHandle StaticStream::_open(QueryIndexType type, uint64_t value,
-                                     StreamAccessFlags flags, StreamHandle handle)
+    StreamHandle StaticStream::_openRange(QueryIndexType type, uint64_t value,
+                                          StreamAccessFlags flags,
+                                          StreamHandle handle,
+                                          StreamSegmentId last)
     {
     #ifdef _DEBUG
         if (handle != nullptr) {
@@ -261,10 +403,13 @@ namespace SimuTrace
         response.allocator = _payloadAllocatorRead;
         response.allocatorArgs = this;
 
-        StreamOpenQuery query;
+        StreamOpenRangeQuery range;
+        StreamOpenQuery& query = range.query;
         query.type  = type;
         query.value = value;
 
+        range.last = last;
+
         // Specifying no flags and a handle will lead us to copy the
         // handle's flags. Otherwise, we use the specified flags.
         if ((handle != nullptr) && (flags == StreamAccessFlags::SafNone)) {
@@ -282,8 +427,17 @@ namespace SimuTrace
                 INVALID_STREAM_SEGMENT_ID;
 
         try {
-            _getPort().call(&response, RpcApi::CCV_StreamCloseAndOpen, &query,
-                            sizeof(StreamOpenQuery), getId(), closeSqn);
+            // Only handles of partitions need the range variant. This keeps
+            // regular handles working with servers that do not know it.
+            if (last == INVALID_STREAM_SEGMENT_ID) {
+                _getPort().call(&response, RpcApi::CCV_StreamCloseAndOpen,
+                                &query, sizeof(StreamOpenQuery), getId(),
+                                closeSqn);
+            } else {
+                _getPort().call(&response, RpcApi::CCV_StreamCloseAndOpenRange,
+                                &range, sizeof(StreamOpenRangeQuery), getId(),
+                                closeSqn);
+            }
 
         } catch (...) {
             // If the client requests a segment that is still in progress or
@@ -316,6 +470,9 @@ namespace SimuTrace
 
             _initializeStaticHandle(handle, id, SsfRead, flags, offset);
 
+            // The handle keeps the end of its range for all further opens
+            handle->stat.lastSequenceNumber = last;
+
             // Add the handle only after we could successfully initialize
             // it. Otherwise, we might throw and would need to manually
             // remove it from the handle list again.
@@ -329,6 +486,22 @@ namespace SimuTrace
         return handle;
     }
 
+    StreamHandle StaticStream::_open(QueryIndexType type, uint64_t value,
+                                     StreamAccessFlags flags, StreamHandle handle)
+    {
+        StreamSegmentId last = (handle != nullptr) ?
+            handle->stat.lastSequenceNumber : INVALID_STREAM_SEGMENT_ID;
+
+        // The partition handle of an aborted parallel scan does not proceed
+        // to the next segment. The range then ends with the current segment.
+        if ((handle != nullptr) && _isScanAborted(handle)) {
+            assert(last != INVALID_STREAM_SEGMENT_ID);
+            last = handle->stat.sequenceNumber;
+        }
+
+        return _openRange(type, value, flags, handle, last);
+    }
+
     void StaticStream::_closeHandle(StreamHandle handle)
     {
         assert(handle != nullptr);
@@ -343,15 +516,30 @@ namespace SimuTrace
         void *payload = nullptr;
 
         if (!IsSet(handle->flags, StreamStateFlags::SsfRead)) {
+            // Previous segments of the handle must reach the server first
+            _drainAppend();
+
             // This is a write handle. Add any new data to the RPC call
             payload = _getPayload(handle->segment, &payloadLength);
         }
 
+        _releaseScanAbort(handle);
+
         _getPort().call(nullptr, RpcApi::CCV_StreamClose, payload,
                         payloadLength, getId(),
                         handle->stat.control->link.sequenceNumber);
     }
 
+    void StaticStream::_flushHandle(StreamHandle handle)
+    {
+        // Even if we leave the submission of the current segment to the
+        // server, we must complete the pipelined appends and return the
+        // unused segments.
+        _drainAppend();
+
+        this->ClientStream::_flushHandle(handle);
+    }
+
     void StaticStream::queryInformation(StreamQueryInformation& informationOut) const
     {
         Message response = {0};
@@ -370,4 +558,51 @@ namespace SimuTrace
         informationOut = *desc;
     }
 
+    void StaticStream::partition(uint32_t count,
+        std::vector<StreamPartition>& partitionsOut) const
+    {
+        Message response = {0};
+
+        _getPort().call(&response, RpcApi::CCV_StreamPartition, getId(), count);
+
+        uint32_t n = response.parameter0;
+
+        ThrowOn((response.payloadType != MessagePayloadType::MptData) ||
+                (response.data.payloadLength != n * sizeof(StreamPartition)) ||
+                (n > count),
+                RpcMessageMalformedException);
+
+        partitionsOut.clear();
+
+        if (n > 0) {
+            assert(response.data.payload != nullptr);
+            StreamPartition* buffer =
+                reinterpret_cast<StreamPartition*>(response.data.payload);
+
+            partitionsOut.assign(buffer, buffer + n);
+        }
+    }
+
+    StreamHandle StaticStream::openPartition(const StreamPartition& partition,
+                                             StreamAccessFlags flags,
+                                             const volatile _bool* abort)
+    {
+        ThrowOn((partition.first > partition.last) ||
+                (partition.last == INVALID_STREAM_SEGMENT_ID),
+                ArgumentException, "partition");
+
+        StreamHandle handle = _openRange(QueryIndexType::QSequenceNumber,
+                                         partition.first, flags, nullptr,
+                                         partition.last);
+
+        if ((handle != nullptr) && (handle->stat.control != nullptr) &&
+            (abort != nullptr)) {
+            LockScope(_scanLock);
+
+            _scanAborts[handle] = abort;
+        }
+
+        return handle;
+    }
+
 }
\ No newline at end of file
@@ -33,6 +33,19 @@ namespace SimuTrace
     private:
         DISABLE_COPY(StaticStream);
 
+        // Number of segments a write handle may reserve ahead. Determined
+        // when the write handle is created (see AppendPipeline).
+        uint32_t _appendWindow;
+
+        // Abort flags of the partition handles of parallel scans. Once a
+        // flag is set, the handle ends with its current segment. We keep
+        // the flags here, because the layout of the handle is public.
+        CriticalSection _scanLock;
+        std::unordered_map<StreamHandle, const volatile _bool*> _scanAborts;
+
+        bool _isScanAborted(StreamHandle handle);
+        void _releaseScanAbort(StreamHandle handle);
+
         void _initializeStaticHandle(StreamHandle handle, SegmentId segment,
                                      StreamStateFlags flags = SsfNone,
                                      StreamAccessFlags aflags = SafNone,
@@ -44,12 +57,21 @@ namespace SimuTrace
         static void _payloadAllocatorWrite(Message& msg, bool free, void* args);
         static void _payloadAllocatorRead(Message& msg, bool free, void* args);
 
+        SegmentId _reserveAppend();
+        void _drainAppend();
+        StreamHandle _appendAsync(StreamHandle handle);
+
+        StreamHandle _openRange(QueryIndexType type, uint64_t value,
+                                StreamAccessFlags flags, StreamHandle handle,
+                                StreamSegmentId last);
+
         virtual StreamHandle _append(StreamHandle handle) override;
         virtual StreamHandle _open(QueryIndexType type, uint64_t value,
                                    StreamAccessFlags flags,
                                    StreamHandle handle) override;
 
         virtual void _closeHandle(StreamHandle handle) override;
+        virtual void _flushHandle(StreamHandle handle) override;
     public:
         StaticStream(StreamId id, const StreamDescriptor& desc,
                      StreamBuffer& buffer, ClientSession& session);
@@ -57,6 +79,12 @@ namespace SimuTrace
 
         virtual void queryInformation(
             StreamQueryInformation& informationOut) const override;
+
+        void partition(uint32_t count,
+                       std::vector<StreamPartition>& partitionsOut) const;
+        StreamHandle openPartition(const StreamPartition& partition,
+                                   StreamAccessFlags flags,
+                                   const volatile _bool* abort = nullptr);
     };
 }
 
@@ -29,6 +29,11 @@ namespace SimuTrace
     private:
         DISABLE_COPY(HandleStreamContext);
 
+        // Span of entries fetched from the input stream, but not yet
+        // returned by the multiplexer.
+        byte* _next;
+        byte* _end;
+
     public:
         StreamHandle handle;
         MultiplexerEntry entry;
@@ -36,6 +41,8 @@ namespace SimuTrace
         HandleStreamContext(const StreamMultiplexer& multiplexer,
                             uint32_t streamIndex, QueryIndexType type,
                             uint64_t value, StreamAccessFlags flags) :
+            _next(nullptr),
+            _end(nullptr),
             handle(nullptr),
             entry()
         {
@@ -55,34 +62,35 @@ namespace SimuTrace
 
         inline bool update(bool temporal)
         {
-            // Get the first entry from the stream. This might fail and return
-            // nullptr instead. We treat this as end of stream.
-            entry.entry = StGetNextEntryFast(&handle);
-            if (entry.entry == nullptr) {
-                return false;
+            // Fetch the remaining entries of the input's current segment at
+            // once, so we go through the handle only once per segment. The
+            // entries stay valid until the next fetch, which we only do when
+            // the last entry of the span has been passed on. The fetch might
+            // fail and return nullptr instead. We treat this as end of stream.
+            if (_next == _end) {
+                size_t count;
+                _next = reinterpret_cast<byte*>(
+                    StGetNextEntriesFast(&handle, &count));
+                if (_next == nullptr) {
+                    _end = nullptr;
+
+                    entry.entry = nullptr;
+                    entry.cycleCount = INVALID_CYCLE_COUNT;
+                    return false;
+                }
+
+                _end = _next + count * handle->entrySize;
             }
 
+            entry.entry = _next;
+            _next += handle->entrySize;
+
             entry.cycleCount = (temporal) ?
                 *(reinterpret_cast<CycleCount*>(entry.entry)) & TEMPORAL_ORDER_CYCLE_COUNT_MASK :
                 INVALID_CYCLE_COUNT;
 
             return true;
         }
-
-        inline static bool compareByCycleCountWithPointer(
-            const HandleStreamContext* ctx1, const HandleStreamContext* ctx2)
-        {
-            if (ctx2 == nullptr) {
-                return true;
-            } else if (ctx1 == nullptr) {
-                return false;
-            } else {
-                assert(ctx1->entry.cycleCount != INVALID_CYCLE_COUNT);
-                assert(ctx2->entry.cycleCount != INVALID_CYCLE_COUNT);
-
-                return ctx1->entry.cycleCount < ctx2->entry.cycleCount;
-            }
-        }
     };
 
     class StreamMultiplexer::HandleContext
@@ -97,11 +105,94 @@ namespace SimuTrace
         std::vector<HandleStreamContext*> list;
         int index;
 
+        // Loser tree for the cycle count rule. tree[0] holds the index of
+        // the input with the lowest cycle count (the winner), tree[1..n-1]
+        // the input that lost the match at the respective node. The leaves
+        // are implicit: input i is at node n + i. Exhausted inputs remain in
+        // the tree with INVALID_CYCLE_COUNT and thus lose every match.
+        std::vector<uint32_t> tree;
+        std::vector<CycleCount> keys;
+        uint32_t runnerUp;
+
         HandleContext(const StreamMultiplexer& multiplexer) :
             multiplexer(multiplexer),
             streams(),
             list(),
-            index(-1) { }
+            index(-1),
+            tree(),
+            keys(),
+            runnerUp(0) { }
+
+        inline bool beats(uint32_t a, uint32_t b) const
+        {
+            // On equal cycle counts the input with the lower index wins, so
+            // the order does not depend on the history of the tree.
+            return (keys[a] < keys[b]) || ((keys[a] == keys[b]) && (a < b));
+        }
+
+        inline void updateRunnerUp()
+        {
+            // The runner-up is the best of the inputs that lost directly
+            // against the winner, i.e., of the losers on the winner's path.
+            uint32_t node = (static_cast<uint32_t>(tree.size()) + tree[0]) / 2;
+            assert(node > 0);
+
+            runnerUp = tree[node];
+            for (node /= 2; node > 0; node /= 2) {
+                if (beats(tree[node], runnerUp)) {
+                    runnerUp = tree[node];
+                }
+            }
+        }
+
+        void buildTree()
+        {
+            const uint32_t n = static_cast<uint32_t>(streams.size());
+            assert(n >= 2);
+
+            keys.resize(n);
+            tree.resize(n);
+
+            std::vector<uint32_t> winners(2 * n);
+            for (uint32_t i = 0; i < n; ++i) {
+                keys[i] = streams[i]->entry.cycleCount;
+                winners[n + i] = i;
+            }
+
+            for (uint32_t node = n - 1; node > 0; --node) {
+                uint32_t a = winners[2 * node];
+                uint32_t b = winners[2 * node + 1];
+
+                if (beats(a, b)) {
+                    winners[node] = a;
+                    tree[node] = b;
+                } else {
+                    winners[node] = b;
+                    tree[node] = a;
+                }
+            }
+
+            tree[0] = winners[1];
+            updateRunnerUp();
+        }
+
+        inline void replay()
+        {
+            // The winner loaded a new entry (and updated its key). We play it
+            // against the losers on its path to the root. This takes log(n)
+            // comparisons.
+            uint32_t winner = tree[0];
+
+            for (uint32_t node = (static_cast<uint32_t>(tree.size()) + winner) / 2;
+                 node > 0; node /= 2) {
+                if (beats(tree[node], winner)) {
+                    std::swap(tree[node], winner);
+                }
+            }
+
+            tree[0] = winner;
+            updateRunnerUp();
+        }
     };
 
     template<MultiplexingRule rule, bool indirect, bool temporal>
@@ -271,7 +362,12 @@ namespace SimuTrace
         try {
             std::unique_ptr<HandleContext> ctx(new HandleContext(*multiplexer));
             ctx->streams.reserve(multiplexer->_inputStreams.size());
-            ctx->list.reserve(multiplexer->_inputStreams.size());
+
+            const bool merge =
+                (multiplexer->_rule == MultiplexingRule::MxrCycleCount);
+            if (!merge) {
+                ctx->list.reserve(multiplexer->_inputStreams.size());
+            }
 
             for (uint32_t i = 0; i < multiplexer->_inputStreams.size(); ++i) {
                 std::unique_ptr<HandleStreamContext> sctx(
@@ -279,21 +375,19 @@ namespace SimuTrace
 
                 // Load the first entry from the stream. If the entry is null,
                 // we assume the stream to be empty
-                if (sctx->update(multiplexer->_temporal)) {
+                if (sctx->update(multiplexer->_temporal) && !merge) {
                     ctx->list.push_back(sctx.get());
                 }
 
                 ctx->streams.push_back(std::move(sctx));
             }
 
-            // For the cycle count rule we use a sorted list. This way we can
-            // always take the first entry (lowest cycle count). Inserting the
-            // next entry should be cheap in most cases, too, because often we
-            // have only have to compare the first few entries to find the
-            // right position.
-            if (multiplexer->_rule == MultiplexingRule::MxrCycleCount) {
-                std::sort(ctx->list.begin(), ctx->list.end(),
-                          HandleStreamContext::compareByCycleCountWithPointer);
+            // For the cycle count rule we merge the inputs with a loser tree.
+            // A sorted list would cost O(n) per entry to keep sorted, which
+            // makes the multiplexer the bottleneck for many inputs (e.g.,
+            // one stream per vCPU). The tree needs O(log n) comparisons.
+            if (merge) {
+                ctx->buildTree();
             }
 
             *userDataOut = ctx.get();
@@ -328,6 +422,47 @@ namespace SimuTrace
 
         auto ctx = reinterpret_cast<StreamMultiplexer::HandleContext*>(userData);
 
+        // Condition should be optimized out by the compiler
+        if (rule == MultiplexingRule::MxrCycleCount) {
+            // With the cycle count rule, we always take the entry of the
+            // winner of the loser tree as this will have the lowest cycle
+            // count. The tree must be built right from the start.
+            assert(ctx->tree.size() == ctx->streams.size());
+            auto sctx = ctx->streams[ctx->tree[0]].get();
+
+            if (ctx->index == -1) {
+                // This indicates the first access. The first entries are
+                // already in the tree.
+                ctx->index = 0;
+            } else if (sctx->entry.entry != nullptr) {
+                // We give the user the guarantee that the entry returned in
+                // the last call is valid up to this call. We therefore can
+                // update the entry only now.
+                sctx->update(temporal);
+
+                // As long as the new entry beats the runner-up, the winner
+                // stays the same and we can return a whole run of entries
+                // from the same input without touching the tree.
+                ctx->keys[ctx->tree[0]] = sctx->entry.cycleCount;
+
+                if (!ctx->beats(ctx->tree[0], ctx->runnerUp)) {
+                    ctx->replay();
+
+                    sctx = ctx->streams[ctx->tree[0]].get();
+                }
+            }
+
+            // The winner is only exhausted if all input streams are
+            // exhausted. Signal the end of the dynamic stream in that case.
+            if (sctx->entry.entry == nullptr) {
+                *entryOut = nullptr;
+                return 0;
+            }
+
+            *entryOut = (indirect) ? &sctx->entry : sctx->entry.entry;
+            return 0;
+        }
+
         if (ctx->index == -1) {
             // This indicates that this is the first access or that all
             // input streams are exhausted.
@@ -373,30 +508,6 @@ namespace SimuTrace
                         break;
                     }
 
-                    case MultiplexingRule::MxrCycleCount: {
-                        // With the cycle count rule, we modify the list to
-                        // keep it sorted. We then always take the first
-                        // element from the list as this will have the lowest
-                        // cycle count. The list must be sorted right from the
-                        // start.
-                        assert(ctx->index == 0);
-
-                        int i = 0;
-                        while (true) {
-                            if ((++i >= ctx->list.size()) ||
-                                (sctx->entry.cycleCount <=
-                                ctx->list[i]->entry.cycleCount)) {
-
-                                ctx->list[i - 1] = sctx;
-                                break;
-                            }
-
-                            ctx->list[i - 1] = ctx->list[i];
-                        }
-
-                        break;
-                    }
-
                     default: {
                         assert(false); // Should never happen
                         break;
@@ -0,0 +1,138 @@
+/*
+ * Copyright 2015 (C) Karlsruhe Institute of Technology (KIT)
+ * Marc Rittinghaus
+ *
+ * Simutrace Storage Server (storageserver) is part of Simutrace.
+ *
+ * storageserver is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * storageserver is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with storageserver. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "SimuStor.h"
+
+#include "AllocationWaitQueue.h"
+
+namespace SimuTrace
+{
+
+    AllocationWaitQueue::AllocationWaitQueue() :
+        _lock(),
+        _waiters(),
+        _numWaiters(0),
+        _generation(1),
+        _stats()
+    {
+
+    }
+
+    AllocationWaitQueue::~AllocationWaitQueue()
+    {
+        assert(_waiters.empty());
+    }
+
+    void AllocationWaitQueue::enter(Waiter& waiter, Priority priority)
+    {
+        waiter.priority = priority;
+        waiter.start = Clock::getTicks();
+
+        // A new waiter gets a turn right away when it reaches the head of the
+        // queue. A resource might have been released after the waiter's last
+        // attempt to acquire one, but before it entered the queue.
+        waiter.generation = 0;
+
+        LockScope(_lock);
+
+        // Insert after all waiters of the same or a higher priority
+        auto it = _waiters.end();
+        while ((it != _waiters.begin()) &&
+               ((*std::prev(it))->priority < priority)) {
+            --it;
+        }
+
+        waiter.position = _waiters.insert(it, &waiter);
+        _numWaiters++;
+
+        _stats.waits++;
+    }
+
+    bool AllocationWaitQueue::wait(Waiter& waiter, uint64_t deadline)
+    {
+        LockScope(_lock);
+
+        while ((_waiters.front() != &waiter) ||
+               (waiter.generation == _generation)) {
+
+            uint64_t now = Clock::getTicks();
+            if (now >= deadline) {
+                return false;
+            }
+
+            // Round up, so we do not spin on the last millisecond
+            uint32_t timeout = static_cast<uint32_t>(
+                (deadline - now + 999999) / 1000000);
+
+            _lock.wait(timeout);
+        }
+
+        waiter.generation = _generation;
+
+        return true;
+    }
+
+    void AllocationWaitQueue::leave(Waiter& waiter, bool success)
+    {
+        uint64_t ticks = Clock::getTicks() - waiter.start;
+
+        LockScope(_lock);
+
+        bool head = (_waiters.front() == &waiter);
+        _waiters.erase(waiter.position);
+        _numWaiters--;
+
+        _stats.waitTicks += ticks;
+        _stats.maxWaitTicks = std::max(_stats.maxWaitTicks, ticks);
+
+        if (!success) {
+            _stats.timeouts++;
+        }
+
+        // The next waiter gets its turn. We have to wake all waiters,
+        // because we cannot wake a specific one.
+        if (head && !_waiters.empty()) {
+            _generation++;
+            _lock.wakeAll();
+        }
+    }
+
+    void AllocationWaitQueue::notify()
+    {
+        LockScope(_lock);
+
+        if (!_waiters.empty()) {
+            _generation++;
+            _lock.wakeAll();
+        }
+    }
+
+    bool AllocationWaitQueue::hasWaiters() const
+    {
+        return (_numWaiters > 0);
+    }
+
+    void AllocationWaitQueue::getStatistics(Statistics& statsOut) const
+    {
+        LockScope(_lock);
+
+        statsOut = _stats;
+    }
+
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2015 (C) Karlsruhe Institute of Technology (KIT)
+ * Marc Rittinghaus
+ *
+ * Simutrace Storage Server (storageserver) is part of Simutrace.
+ *
+ * storageserver is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * storageserver is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with storageserver. If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#ifndef ALLOCATION_WAIT_QUEUE_H
+#define ALLOCATION_WAIT_QUEUE_H
+
+#include "SimuStor.h"
+
+namespace SimuTrace
+{
+
+    //
+    // Queue of threads waiting for a resource (e.g., a segment in a stream
+    // buffer) to be released. Waiters are served in the order of their
+    // priority and in FIFO order within the same priority. Only the waiter
+    // at the head of the queue gets a turn. It gets a turn after entering
+    // the queue and whenever a resource has been released afterwards. The
+    // waiter then tries to acquire the resource on its own and either
+    // leaves the queue or waits for the next release.
+    //
+    class AllocationWaitQueue
+    {
+    public:
+        enum Priority {
+            Normal = 0x00,
+            High   = 0x01
+        };
+
+        struct Waiter
+        {
+            Priority priority;
+            uint64_t start;
+            uint64_t generation;
+
+            std::list<Waiter*>::iterator position;
+
+            Waiter() :
+                priority(Priority::Normal),
+                start(0),
+                generation(0),
+                position() { }
+        };
+
+        struct Statistics
+        {
+            uint64_t waits;
+            uint64_t timeouts;
+
+            // Time in ns spent in the queue
+            uint64_t waitTicks;
+            uint64_t maxWaitTicks;
+
+            Statistics() :
+                waits(0),
+                timeouts(0),
+                waitTicks(0),
+                maxWaitTicks(0) { }
+        };
+
+    private:
+        DISABLE_COPY(AllocationWaitQueue);
+
+        mutable ConditionVariable _lock;
+
+        std::list<Waiter*> _waiters;
+        std::atomic<uint32_t> _numWaiters;
+        uint64_t _generation;
+
+        Statistics _stats;
+
+    public:
+        AllocationWaitQueue();
+        ~AllocationWaitQueue();
+
+        void enter(Waiter& waiter, Priority priority);
+
+        // Blocks until the waiter gets its turn or the given time in ns
+        // (see Clock::getTicks()) has been reached. Returns false on timeout.
+        bool wait(Waiter& waiter, uint64_t deadline);
+
+        // Removes the waiter from the queue. success indicates if the
+        // waiter could acquire the resource.
+        void leave(Waiter& waiter, bool success);
+
+        // Signals that a resource has been released
+        void notify();
+
+        bool hasWaiters() const;
+        void getStatistics(Statistics& statsOut) const;
+    };
+
+}
+
+#endif
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2015 (C) Karlsruhe Institute of Technology (KIT)
+ * Marc Rittinghaus
+ *
+ * Simutrace Storage Server (storageserver) is part of Simutrace.
+ *
+ * storageserver is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * storageserver is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with storageserver. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "SimuStor.h"
+
+#include "ReadAheadController.h"
+
+namespace SimuTrace
+{
+
+    ReadAheadController::ReadAheadController(uint32_t window,
+                                             uint32_t maxWindow) :
+        _window(window),
+        _maxWindow(std::max(window, maxWindow)),
+        _lastSequenceNumber(INVALID_STREAM_SEGMENT_ID),
+        _stride(0),
+        _streak(0),
+        _lastOpen(0),
+        _interval(0)
+    {
+
+    }
+
+    uint32_t ReadAheadController::_getTargetWindow(uint64_t loadTicks) const
+    {
+        // Without measurements, we keep the current window
+        if ((loadTicks == 0) || (_interval == 0)) {
+            return _window;
+        }
+
+        // We need to start loading a segment as many opens in advance as
+        // the reader consumes segments while a single segment is loaded.
+        uint64_t target = (loadTicks + _interval - 1) / _interval + 1;
+
+        return static_cast<uint32_t>(std::min<uint64_t>(target, _maxWindow));
+    }
+
+    int64_t ReadAheadController::update(StreamSegmentId sequenceNumber,
+                                        StreamAccessFlags flags, uint64_t now)
+    {
+        if (_lastSequenceNumber != INVALID_STREAM_SEGMENT_ID) {
+            int64_t stride = static_cast<int64_t>(sequenceNumber) -
+                static_cast<int64_t>(_lastSequenceNumber);
+
+            if ((stride == _stride) && (stride != 0)) {
+                _streak++;
+            } else {
+                _stride = stride;
+                _streak = 1;
+            }
+
+            // Track the time between two opens as exponentially weighted
+            // moving average.
+            uint64_t interval = now - _lastOpen;
+            _interval = (_interval == 0) ? interval :
+                (_interval * 7 + interval) / 8;
+        }
+
+        _lastSequenceNumber = sequenceNumber;
+        _lastOpen = now;
+
+        // The caller told us that it scans the stream
+        if (IsSet(flags, StreamAccessFlags::SafSequentialScan)) {
+            return IsSet(flags, StreamAccessFlags::SafReverseRead) ? -1 : 1;
+        }
+
+        if ((_streak >= _minStreak) &&
+            (_stride >= -_maxStride) && (_stride <= _maxStride)) {
+            return _stride;
+        }
+
+        return 0;
+    }
+
+    void ReadAheadController::hit(bool late, uint64_t loadTicks)
+    {
+        uint32_t target = _getTargetWindow(loadTicks);
+
+        if (late) {
+            // The segment was requested in time, but the reader still had
+            // to wait. Prefetch further ahead.
+            _window = std::min(std::max(_window + 1, target), _maxWindow);
+        } else if (_window > target) {
+            _window--;
+        }
+    }
+
+    void ReadAheadController::miss(uint64_t loadTicks)
+    {
+        uint32_t target = _getTargetWindow(loadTicks);
+
+        _window = std::min(std::max(_window + 1, target), _maxWindow);
+    }
+
+    uint32_t ReadAheadController::getWindow(uint32_t budget) const
+    {
+        return std::min(_window, budget);
+    }
+
+}
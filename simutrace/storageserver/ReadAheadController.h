@@ -0,0 +1,101 @@
+/*
+ * Copyright 2015 (C) Karlsruhe Institute of Technology (KIT)
+ * Marc Rittinghaus
+ *
+ * Simutrace Storage Server (storageserver) is part of Simutrace.
+ *
+ * storageserver is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * storageserver is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with storageserver. If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#ifndef READ_AHEAD_CONTROLLER_H
+#define READ_AHEAD_CONTROLLER_H
+
+#include "SimuStor.h"
+
+namespace SimuTrace
+{
+
+    struct ReadAheadStatistics {
+        // Opens of segments, which had been prefetched and were already
+        // loaded (hits) or still loading (late hits).
+        uint64_t hits;
+        uint64_t lateHits;
+
+        // Opens of segments, which had not been prefetched while the
+        // reader followed a detected access pattern.
+        uint64_t misses;
+
+        // Number of segments for which a prefetch was issued
+        uint64_t prefetches;
+
+        ReadAheadStatistics() :
+            hits(0),
+            lateHits(0),
+            misses(0),
+            prefetches(0) { }
+    };
+
+    //
+    // The read ahead controller tracks the accesses of a single reader
+    // (i.e., session) to a stream. It detects sequential, reverse and
+    // strided patterns from the sequence numbers of consecutive opens, or
+    // takes the pattern from the SafSequentialScan and SafReverseRead
+    // flags. The number of segments to prefetch (the window) follows the
+    // ratio of the time needed to load a segment to the time the reader
+    // takes to consume one. Late hits and misses grow the window, while
+    // timely hits shrink it again towards that ratio. The window never
+    // exceeds the maximum given on construction or the budget supplied by
+    // the caller. The controller is not synchronized.
+    //
+    class ReadAheadController
+    {
+    private:
+        // Largest distance between two opens, which we accept as stride
+        static const int64_t _maxStride = 64;
+
+        // Number of consecutive opens with the same stride before we
+        // consider the stride a pattern.
+        static const uint32_t _minStreak = 2;
+
+        uint32_t _window;
+        uint32_t _maxWindow;
+
+        StreamSegmentId _lastSequenceNumber;
+        int64_t _stride;
+        uint32_t _streak;
+
+        uint64_t _lastOpen;
+        uint64_t _interval;
+
+        uint32_t _getTargetWindow(uint64_t loadTicks) const;
+    public:
+        ReadAheadController(uint32_t window, uint32_t maxWindow);
+
+        // Updates the access pattern with an open of the given segment.
+        // Returns the stride in sequence numbers with which to prefetch or
+        // 0, if the reader does not follow a pattern.
+        int64_t update(StreamSegmentId sequenceNumber, StreamAccessFlags flags,
+                       uint64_t now);
+
+        // Adapts the window to the outcome of an open, which followed the
+        // pattern. loadTicks is the average time needed to load a segment.
+        void hit(bool late, uint64_t loadTicks);
+        void miss(uint64_t loadTicks);
+
+        uint32_t getWindow(uint32_t budget) const;
+    };
+
+}
+
+#endif
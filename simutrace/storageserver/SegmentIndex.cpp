@@ -0,0 +1,159 @@
+/*
+ * Copyright 2015 (C) Karlsruhe Institute of Technology (KIT)
+ * Marc Rittinghaus
+ *
+ * Simutrace Storage Server (storageserver) is part of Simutrace.
+ *
+ * storageserver is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * storageserver is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with storageserver. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "SimuStor.h"
+
+#include "SegmentIndex.h"
+
+namespace SimuTrace
+{
+
+    SegmentIndex::SegmentIndex() :
+        _starts(),
+        _entries(),
+        _summary()
+    {
+
+    }
+
+    SegmentIndex::~SegmentIndex()
+    {
+
+    }
+
+    size_t SegmentIndex::_lowerBound(const uint64_t* keys, size_t count,
+                                     uint64_t value)
+    {
+        if (count == 0) {
+            return 0;
+        }
+
+        // Branchless lower bound. The loop runs a fixed number of
+        // iterations for a given count and the compiler turns the
+        // conditional into a conditional move.
+        const uint64_t* base = keys;
+        while (count > 1) {
+            size_t half = count / 2;
+            base = (base[half] < value) ? base + half : base;
+            count -= half;
+        }
+
+        return (base - keys) + (*base < value);
+    }
+
+    size_t SegmentIndex::_lowerBound(uint64_t value) const
+    {
+        // Find the first block whose first key is not below the value.
+        // The lower bound is either in the preceding block or it is the
+        // first key of that block.
+        size_t block = _lowerBound(_summary.data(), _summary.size(), value);
+        if (block == 0) {
+            return 0;
+        }
+
+        size_t first = (block - 1) * BlockSize;
+        size_t count = std::min<size_t>(BlockSize, _starts.size() - first);
+
+        return first + _lowerBound(&_starts[first], count, value);
+    }
+
+    void SegmentIndex::_updateSummary(size_t position)
+    {
+        size_t block = position / BlockSize;
+        size_t blockCount = (_starts.size() + BlockSize - 1) / BlockSize;
+
+        _summary.resize(blockCount);
+        for (size_t i = block; i < blockCount; ++i) {
+            _summary[i] = _starts[i * BlockSize];
+        }
+    }
+
+    bool SegmentIndex::insert(const Range& range,
+                              StreamSegmentId sequenceNumber)
+    {
+        assert(range.start <= range.end);
+
+        Entry entry;
+        entry.end            = range.end;
+        entry.sequenceNumber = sequenceNumber;
+
+        size_t position;
+        if (_starts.empty() || (_starts.back() < range.start)) {
+            // Common case: the segment is added in order
+            position = _starts.size();
+
+            _starts.push_back(range.start);
+            _entries.push_back(entry);
+        } else {
+            // Segments are completed out of order only when encoding of
+            // a segment overtakes the one of a previous segment. The
+            // insert position is thus close to the end.
+            position = _lowerBound(range.start);
+            if ((position < _starts.size()) &&
+                (_starts[position] == range.start)) {
+                return false;
+            }
+
+            _starts.insert(_starts.begin() + position, range.start);
+            _entries.insert(_entries.begin() + position, entry);
+        }
+
+        _updateSummary(position);
+
+        return true;
+    }
+
+    StreamSegmentId SegmentIndex::find(uint64_t value) const
+    {
+        size_t position = _lowerBound(value);
+
+        if ((position < _starts.size()) && (_starts[position] == value)) {
+            return _entries[position].sequenceNumber;
+        }
+
+        // The value is not the start of a segment. It can thus only be
+        // in the segment with the next lower start.
+        if ((position > 0) && (value <= _entries[position - 1].end)) {
+            assert(value > _starts[position - 1]);
+            return _entries[position - 1].sequenceNumber;
+        }
+
+        return INVALID_STREAM_SEGMENT_ID;
+    }
+
+    void SegmentIndex::clear()
+    {
+        _starts.clear();
+        _entries.clear();
+        _summary.clear();
+    }
+
+    size_t SegmentIndex::getSize() const
+    {
+        return _starts.size();
+    }
+
+    size_t SegmentIndex::getMemoryUsage() const
+    {
+        return _starts.capacity() * sizeof(uint64_t) +
+               _entries.capacity() * sizeof(Entry) +
+               _summary.capacity() * sizeof(uint64_t);
+    }
+
+}
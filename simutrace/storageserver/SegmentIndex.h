@@ -0,0 +1,88 @@
+/*
+ * Copyright 2015 (C) Karlsruhe Institute of Technology (KIT)
+ * Marc Rittinghaus
+ *
+ * Simutrace Storage Server (storageserver) is part of Simutrace.
+ *
+ * storageserver is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * storageserver is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with storageserver. If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#ifndef SEGMENT_INDEX_H
+#define SEGMENT_INDEX_H
+
+#include "SimuStor.h"
+
+namespace SimuTrace
+{
+
+    //
+    // The segment index maps a value (e.g., an entry index or cycle count)
+    // to the segment whose range contains the value. Segments are usually
+    // added in the order of their ranges, so the index is kept in sorted
+    // arrays instead of a tree. The start values are stored contiguously
+    // and split into blocks of BlockSize keys. A separate summary array
+    // holds the first key of each block. A lookup performs a branchless
+    // binary search on the summary, which is small enough to stay in the
+    // cache, followed by a search within a single block (one or two cache
+    // lines). Adding a segment in order is an append and the summary only
+    // needs to be updated from the block at which a segment is inserted.
+    //
+    // As with the previous tree-based index, ranges with a start value
+    // that is already in the index are ignored. The index is not
+    // synchronized.
+    //
+    class SegmentIndex
+    {
+    public:
+        static const uint32_t BlockSize = 16;
+
+    private:
+        DISABLE_COPY(SegmentIndex);
+
+        struct Entry {
+            uint64_t end;
+            StreamSegmentId sequenceNumber;
+        };
+
+        std::vector<uint64_t> _starts;
+        std::vector<Entry> _entries;
+        std::vector<uint64_t> _summary;
+
+        static size_t _lowerBound(const uint64_t* keys, size_t count,
+                                  uint64_t value);
+
+        size_t _lowerBound(uint64_t value) const;
+        void _updateSummary(size_t position);
+    public:
+        SegmentIndex();
+        ~SegmentIndex();
+
+        // Returns false, if the start of the range is already in the index
+        bool insert(const Range& range, StreamSegmentId sequenceNumber);
+
+        // Returns the sequence number of the segment containing the value
+        // or INVALID_STREAM_SEGMENT_ID if no segment contains the value.
+        StreamSegmentId find(uint64_t value) const;
+
+        void clear();
+
+        size_t getSize() const;
+
+        // Returns the number of bytes occupied by the index
+        size_t getMemoryUsage() const;
+    };
+
+}
+
+#endif
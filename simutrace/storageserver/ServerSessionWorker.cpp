@@ -82,9 +82,14 @@ namespace SimuTrace
         m[RpcApi::CCV32_StreamEnumerate]        = _handleStreamEnumerate;
         m[RpcApi::CCV32_StreamQuery]            = _handleStreamQuery;
         m[RpcApi::CCV32_StreamAppend]           = _handleStreamAppend;
+        m[RpcApi::CCV32_StreamSubmitAndAppend]  = _handleStreamSubmitAndAppend;
+        m[RpcApi::CCV32_StreamAppendCancel]     = _handleStreamAppendCancel;
         m[RpcApi::CCV30_StreamCloseAndOpen]     = _handleStreamCloseAndOpen;
         m[RpcApi::CCV32_StreamCloseAndOpen]     = _handleStreamCloseAndOpen;
+        m[RpcApi::CCV32_StreamCloseAndOpenRange] =
+            _handleStreamCloseAndOpenRange;
         m[RpcApi::CCV32_StreamClose]            = _handleStreamClose;
+        m[RpcApi::CCV32_StreamPartition]        = _handleStreamPartition;
     }
 
     void ServerSessionWorker::_acknowledgeSessionCreate()
@@ -96,6 +101,26 @@ namespace SimuTrace
         msg.response.status = RpcApi::SC_Success;
         msg.parameter0 = _session.getId();
 
+        // If we created a command ring for the connection, we transfer it
+        // to the client with the response and use it from now on (see
+        // StorageServer::_negotiateCommandRing()).
+        CommandRing* ring = _port->getCommandRing();
+        if (ring != nullptr) {
+            std::vector<Handle> handleList;
+            handleList.push_back(ring->getHandle());
+
+            _port->ret(msg, RpcApi::SC_Success, handleList, _session.getId(),
+                       ring->getCapacity());
+
+            ring->enable();
+            return;
+        }
+
+        // Tell the client which transport compression we have selected for
+        // the connection (see StorageServer::_negotiateCompression()).
+        msg.embedded.parameter1 = RpcApi::makeCompressionSelection(
+            _port->getCompressionCodec(), _port->getCompressionLevel());
+
         _port->ret(msg);
     }
 
@@ -292,24 +317,14 @@ namespace SimuTrace
         return false;
     }
 
-    bool ServerSessionWorker::_handleStreamAppend(MessageContext& ctx)
+    void ServerSessionWorker::_returnAppendSegment(MessageContext& ctx,
+                                                   ServerStream& stream,
+                                                   StreamSegmentId sqn,
+                                                   SegmentId seg)
     {
-        TEST_REQUEST_V32(StreamAppend, ctx.msg);
         ServerSession& session = ctx.worker._session;
         ServerPort* port = ctx.worker._port.get();
 
-        StreamId id = ctx.msg.parameter0;
-        ServerStream& stream = dynamic_cast<ServerStream&>(
-            session.getStream(id));
-
-        SegmentId seg = INVALID_SEGMENT_ID;
-        StreamSegmentId sqn;
-
-        // At this point the control element already needs to be
-        // updated via shared memory or through a payload allocator.
-
-        sqn = stream.append(session.getId(), &seg);
-
         try {
             if (ctx.worker.channelSupportsSharedMemory() ||
                 (seg == INVALID_SEGMENT_ID)) {
@@ -330,13 +345,71 @@ namespace SimuTrace
 
             throw;
         }
+    }
 
+    bool ServerSessionWorker::_handleStreamAppend(MessageContext& ctx)
+    {
+        TEST_REQUEST_V32(StreamAppend, ctx.msg);
+        ServerSession& session = ctx.worker._session;
+
+        StreamId id = ctx.msg.parameter0;
+        ServerStream& stream = dynamic_cast<ServerStream&>(
+            session.getStream(id));
+
+        SegmentId seg = INVALID_SEGMENT_ID;
+        StreamSegmentId sqn;
+
+        // At this point the control element already needs to be
+        // updated via shared memory or through a payload allocator.
+
+        sqn = stream.append(session.getId(), &seg);
+
+        _returnAppendSegment(ctx, stream, sqn, seg);
         return false;
     }
 
-    bool ServerSessionWorker::_handleStreamCloseAndOpen(MessageContext& ctx)
+    bool ServerSessionWorker::_handleStreamSubmitAndAppend(
+        MessageContext& ctx)
+    {
+        TEST_REQUEST_V32(StreamSubmitAndAppend, ctx.msg);
+        ServerSession& session = ctx.worker._session;
+
+        StreamId id = ctx.msg.parameter0;
+        StreamSegmentId sseg = ctx.msg.data.parameter1;
+        ServerStream& stream = dynamic_cast<ServerStream&>(
+            session.getStream(id));
+
+        SegmentId seg = INVALID_SEGMENT_ID;
+        StreamSegmentId sqn;
+
+        // At this point the control element already needs to be
+        // updated via shared memory or through a payload allocator.
+
+        sqn = stream.append(session.getId(), sseg, &seg);
+
+        _returnAppendSegment(ctx, stream, sqn, seg);
+        return false;
+    }
+
+    bool ServerSessionWorker::_handleStreamAppendCancel(MessageContext& ctx)
+    {
+        TEST_REQUEST_V32(StreamAppendCancel, ctx.msg);
+        ServerSession& session = ctx.worker._session;
+
+        StreamId id = ctx.msg.parameter0;
+        StreamSegmentId sseg =
+            static_cast<StreamSegmentId>(ctx.msg.embedded.parameter1);
+        ServerStream& stream = dynamic_cast<ServerStream&>(
+            session.getStream(id));
+
+        stream.cancelAppend(session.getId(), sseg);
+        return true;
+    }
+
+    void ServerSessionWorker::_closeAndOpen(MessageContext& ctx,
+                                            StreamOpenQuery& query,
+                                            StreamSegmentId last)
     {
-        TEST_REQUEST_V32(StreamCloseAndOpen, ctx.msg);
         ServerSession& session = ctx.worker._session;
         ServerPort* port = ctx.worker._port.get();
 
@@ -353,10 +426,6 @@ namespace SimuTrace
             stream.close(session.getId(), closeSqn, nullptr);
         }
 
-        // Do the open query
-        StreamOpenQuery* query = reinterpret_cast<StreamOpenQuery*>(
-            ctx.msg.data.payload);
-
         SegmentId seg = INVALID_SEGMENT_ID;
         StreamSegmentId sqn;
         size_t offset;
@@ -368,14 +437,14 @@ namespace SimuTrace
         // finish. Since we are always specifying an output offset, the open()
         // will perform the wait for us (in order to have the segment data
         // available for entry offset search).
-        query->flags = static_cast<StreamAccessFlags>(
-            query->flags | StreamAccessFlags::SafSynchronous);
+        query.flags = static_cast<StreamAccessFlags>(
+            query.flags | StreamAccessFlags::SafSynchronous);
 
         ctx.worker._wait.reset();
 
-        sqn = stream.open(session.getId(), query->type,
-                          query->value, query->flags, &seg,
-                          &offset, &ctx.worker._wait);
+        sqn = stream.open(session.getId(), query.type, query.value,
+                          query.flags, &seg, &offset, &ctx.worker._wait,
+                          last);
 
         StreamBuffer& buffer = stream.getStreamBuffer();
 
@@ -426,7 +495,29 @@ namespace SimuTrace
 
             throw;
         }
+    }
 
+    bool ServerSessionWorker::_handleStreamCloseAndOpen(MessageContext& ctx)
+    {
+        TEST_REQUEST_V32(StreamCloseAndOpen, ctx.msg);
+
+        StreamOpenQuery* query = reinterpret_cast<StreamOpenQuery*>(
+            ctx.msg.data.payload);
+
+        _closeAndOpen(ctx, *query, INVALID_STREAM_SEGMENT_ID);
+        return false;
+    }
+
+    bool ServerSessionWorker::_handleStreamCloseAndOpenRange(
+        MessageContext& ctx)
+    {
+        TEST_REQUEST_V32(StreamCloseAndOpenRange, ctx.msg);
+
+        StreamOpenRangeQuery* query = reinterpret_cast<StreamOpenRangeQuery*>(
+            ctx.msg.data.payload);
+
+        // A range without an end is a regular open
+        _closeAndOpen(ctx, query->query, query->last);
         return false;
     }
 
@@ -447,6 +538,28 @@ namespace SimuTrace
         return true;
     }
 
+    bool ServerSessionWorker::_handleStreamPartition(MessageContext& ctx)
+    {
+        TEST_REQUEST_V32(StreamPartition, ctx.msg);
+        ServerSession& session = ctx.worker._session;
+        ServerPort* port = ctx.worker._port.get();
+
+        StreamId id = ctx.msg.parameter0;
+        uint32_t count = static_cast<uint32_t>(ctx.msg.embedded.parameter1);
+        ServerStream& stream = dynamic_cast<ServerStream&>(
+            session.getStream(id));
+
+        std::vector<StreamPartition> partitions;
+        stream.partition(count, partitions);
+
+        port->ret(ctx.msg, RpcApi::SC_Success, partitions.data(),
+                  static_cast<uint32_t>(partitions.size() *
+                                        sizeof(StreamPartition)),
+                  static_cast<uint32_t>(partitions.size()));
+
+        return false;
+    }
+
     void ServerSessionWorker::_messagePayloadAllocator(Message& msg, bool free,
                                                        void* args)
     {
@@ -464,6 +577,7 @@ namespace SimuTrace
         switch (code)
         {
             case RpcApi::CCV32_StreamAppend:
+            case RpcApi::CCV32_StreamSubmitAndAppend:
             case RpcApi::CCV32_StreamClose: {
                 TEST_REQUEST_V32(StreamAppend, msg); // Same characteristics
 
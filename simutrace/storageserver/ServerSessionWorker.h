@@ -63,8 +63,18 @@ namespace SimuTrace
         static bool _handleStreamEnumerate(MessageContext& ctx);
         static bool _handleStreamQuery(MessageContext& ctx);
         static bool _handleStreamAppend(MessageContext& ctx);
+        static bool _handleStreamSubmitAndAppend(MessageContext& ctx);
+        static bool _handleStreamAppendCancel(MessageContext& ctx);
         static bool _handleStreamCloseAndOpen(MessageContext& ctx);
+        static bool _handleStreamCloseAndOpenRange(MessageContext& ctx);
         static bool _handleStreamClose(MessageContext& ctx);
+        static bool _handleStreamPartition(MessageContext& ctx);
+
+        static void _returnAppendSegment(MessageContext& ctx,
+                                         ServerStream& stream,
+                                         StreamSegmentId sqn, SegmentId seg);
+        static void _closeAndOpen(MessageContext& ctx, StreamOpenQuery& query,
+                                  StreamSegmentId last);
 
         static void _messagePayloadAllocator(Message& msg, bool free,
                                              void* args);
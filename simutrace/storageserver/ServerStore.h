@@ -78,6 +78,10 @@ namespace SimuTrace
                               StreamEnumFilter filter) const;
 
         StreamEncoder::FactoryMethod getEncoderFactory(const StreamTypeId& type);
+
+        // Adds the segments of an existing stream, whose loading has been
+        // deferred (see ServerStream::deferLoad()). Called on first access.
+        virtual void loadStream(ServerStream& stream) { }
     };
 
 }
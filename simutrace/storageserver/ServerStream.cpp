@@ -42,6 +42,9 @@ namespace SimuTrace
         bool cancel;
         bool prefetched;
 
+        // Start of the current load in ns or 0, if not loading
+        uint64_t loadStart;
+
         uint32_t referenceCount;
         std::map<SessionId, uint32_t> referenceMap;
         std::vector<StreamWait*> waitList;
@@ -54,6 +57,7 @@ namespace SimuTrace
             sideId(INVALID_SEGMENT_ID),
             cancel(false),
             prefetched(false),
+            loadStart(0),
             referenceCount(1)
         {
             // This constructor should be used to create segment locations
@@ -73,6 +77,7 @@ namespace SimuTrace
             sideId(INVALID_SEGMENT_ID),
             cancel(false),
             prefetched(false),
+            loadStart(0),
             referenceCount(0)
         {
             location = std::move(loc);
@@ -101,10 +106,13 @@ namespace SimuTrace
         Stream(id, desc, buffer),
         _store(store),
         _lastSequenceNumber(INVALID_STREAM_SEGMENT_ID),
-        _lastAppendSequenceNumber(INVALID_STREAM_SEGMENT_ID),
+        _appendList(),
         _lastAppendIndex(0),
         _encoder(nullptr),
-        _stats()
+        _stats(),
+        _readAheadStats(),
+        _loadTicks(0),
+        _loadPending(false)
     {
         StreamEncoder::FactoryMethod encoderFactory;
         encoderFactory = store.getEncoderFactory(desc.type.id);
@@ -118,9 +126,12 @@ namespace SimuTrace
 
         // Initialize read ahead
         Configuration::get("server.memmgmt.readAhead", _readAheadAmount);
+        Configuration::get("server.memmgmt.readAheadMax", _readAheadMax);
+        _readAheadMax = std::max(_readAheadAmount, _readAheadMax);
+
         if (_readAheadAmount > 0) {
             _readAheadList = std::unique_ptr<StreamSegmentId[]>(
-                new StreamSegmentId[_readAheadAmount]);
+                new StreamSegmentId[_readAheadMax]);
         }
     }
 
@@ -307,7 +318,7 @@ namespace SimuTrace
                 (range->end   != INVALID_LARGE_OBJECT_ID)) {
 
                 assert(range->start <= range->end);
-                _trees[i].insert(range);
+                _trees[i].insert(*range, sequenceNumber);
 
                 // Update stream range statistics
                 Range* statRange = &_stats.ranges.ranges[i];
@@ -392,6 +403,18 @@ namespace SimuTrace
             // already applied.
             assert((*location == nullptr) || (*location == loc->location));
 
+            // Track the time needed to load a segment for the read ahead.
+            // Synchronous completions are mostly served from the cache and
+            // would distort the average.
+            if ((loc->loadStart != 0) && (success) && (!synchronous)) {
+                uint64_t ticks = Clock::getTicks() - loc->loadStart;
+
+                _loadTicks = (_loadTicks == 0) ? ticks :
+                    (_loadTicks * 7 + ticks) / 8;
+            }
+
+            loc->loadStart = 0;
+
             if ((*location == nullptr) || (loc->cancel)) {
                 // The operation should be canceled. This may happen, if
                 // the user initiated an open, but closed the segment
@@ -552,6 +575,7 @@ namespace SimuTrace
 
         loc->prefetched = prefetch;
         loc->cancel     = prefetch;
+        loc->loadStart  = Clock::getTicks();
 
         // openSegment() guarantees that the sideId is set BEFORE the encoder
         // starts reading the segment. sideId is thus even valid, if the
@@ -662,6 +686,23 @@ namespace SimuTrace
         bool complete;
         bool success = true;
 
+        // If this is an append segment, we now know where its entries start.
+        // Append segments are submitted in order, so all preceding segments
+        // have already been accounted for. A segment that is closed out of
+        // order (e.g., by a misbehaving client) is stored without index.
+        auto ait = std::find(_appendList.begin(), _appendList.end(),
+                             loc->sequenceNumber);
+        bool appended = (ait != _appendList.end());
+        bool inOrder = (ait == _appendList.begin());
+
+        if (appended) {
+            SegmentControlElement* ctrl = buffer.getControlElement(loc->id);
+            assert(ctrl != nullptr);
+
+            ctrl->startIndex = (inOrder) ? _lastAppendIndex :
+                INVALID_ENTRY_INDEX;
+        }
+
         try {
             complete = buffer.submitSegment(loc->id, location);
         } catch (const std::exception& e) {
@@ -735,66 +776,83 @@ namespace SimuTrace
 
         // It is valid to submit a written segment by closing it. In that case,
         // we need to update our append state.
-        if (sqn == _lastAppendSequenceNumber) {
-            assert((_lastAppendIndex < INVALID_ENTRY_INDEX) ||
-                   (entryCount == 0));
+        if (appended) {
+            if (inOrder) {
+                assert((_lastAppendIndex < INVALID_ENTRY_INDEX) ||
+                       (entryCount == 0));
+
+                _lastAppendIndex += entryCount;
+            }
 
-            _lastAppendIndex += entryCount;
-            _lastAppendSequenceNumber = INVALID_STREAM_SEGMENT_ID;
+            _appendList.erase(std::find(_appendList.begin(),
+                                        _appendList.end(), sqn));
         }
     }
 
-    StreamSegmentId ServerStream::_findSequenceNumber(QueryIndexType type,
-                                                      uint64_t value) const
+    uint32_t ServerStream::_collectReadAhead(StreamSegmentId sequenceNumber,
+                                             int64_t stride, uint32_t window,
+                                             StreamSegmentId last)
     {
-        if (type <= QueryIndexType::_QMaxTree) {
-            const std::set<Range*, RangeCompare>& tree = _trees[type];
-
-            Range range;
-            range.start = range.end = value;
-
-            Range* targetRange = nullptr;
-
-            auto it = tree.lower_bound(&range);
-            if ((it != tree.end()) && (value == (*it)->start)) {
-                targetRange = *it;
+        // This method must be called with the openLock and lock held!
+
+        uint32_t count = 0;
+        StreamSegmentId raSqn = sequenceNumber;
+
+        assert(window <= _readAheadMax);
+        while (count < window) {
+            if ((stride == 1) || (stride == -1)) {
+                // Find the next/previous valid sequence number after/before
+                // the requested or last prefetched one, respectively.
+                raSqn = _findSequenceNumber((stride > 0) ?
+                    QueryIndexType::QNextValidSequenceNumber :
+                    QueryIndexType::QPreviousValidSequenceNumber, raSqn);
             } else {
-                ReverseRangeIterator rit(it);
-                if ((rit != tree.rend()) &&
-                    (value <= ((*rit)->end))) {
-
-                    assert(value >= (*rit)->start);
-                    targetRange = *rit;
+                int64_t next = static_cast<int64_t>(raSqn) + stride;
+                if ((next < 0) ||
+                    (next >= static_cast<int64_t>(_segments.size()))) {
+                    break;
                 }
+
+                raSqn = static_cast<StreamSegmentId>(next);
             }
 
-            if (targetRange == nullptr) {
-                return INVALID_STREAM_SEGMENT_ID;
+            // If there are no further segments in the stream or the range
+            // which we can prefetch, we cancel read ahead.
+            if ((raSqn == INVALID_STREAM_SEGMENT_ID) || (raSqn > last)) {
+                break;
             }
 
-            // This is a small hack. We have inserted pointer to the range
-            // structs in the storage locations into the trees. By taking the
-            // address of the range we found in the tree and subtracting its
-            // offset in the storage location, we get a pointer to the storage
-            // location itself. This structure then leads us to the segment
-            // location.
-
-        #ifdef __GNUC__
-        // GCC gives a warning for the offsetof because StorageLocation
-        // defines a constructor which is not standard compliant.
-        #pragma GCC diagnostic push
-        #pragma GCC diagnostic ignored "-Winvalid-offsetof"
-        #endif
-
-            StorageLocation* location = reinterpret_cast<StorageLocation*>(
-                reinterpret_cast<size_t>(targetRange) - (type * sizeof(Range)) -
-                offsetof(StorageLocation, ranges));
-
-        #ifdef __GNUC__
-        #pragma GCC diagnostic pop
-        #endif
-
-            return location->link.sequenceNumber;
+            _readAheadList[count++] = raSqn;
+        }
+
+        return count;
+    }
+
+    uint32_t ServerStream::_getReadAheadBudget(SessionId session) const
+    {
+        // This method must be called with the openLock and lock held!
+
+        // Do not let a single session occupy more than a quarter of the
+        // stream buffer with read ahead. If the session reads multiple
+        // ranges in parallel, the readers share the budget. Otherwise, they
+        // would evict each other's prefetched segments.
+        uint32_t budget = std::max(_getBuffer().getNumSegments() / 4, 1u);
+
+        auto first = _readAhead.lower_bound(ReadAheadKey(session, 0));
+        auto end = _readAhead.upper_bound(
+            ReadAheadKey(session, INVALID_STREAM_SEGMENT_ID));
+
+        uint32_t readers = static_cast<uint32_t>(std::distance(first, end));
+        assert(readers > 0);
+
+        return std::max(budget / readers, 1u);
+    }
+
+    StreamSegmentId ServerStream::_findSequenceNumber(QueryIndexType type,
+                                                      uint64_t value) const
+    {
+        if (type <= QueryIndexType::_QMaxTree) {
+            return _trees[type].find(value);
         } else {
 
             switch (type)
@@ -869,7 +927,8 @@ namespace SimuTrace
 
     size_t ServerStream::_findCycleCountBinarySearch(SegmentId bufferSegment,
                                                      CycleCount cycle,
-                                                     bool reverse) const
+                                                     bool reverse,
+                                                     const EntryRange& range) const
     {
         ServerStreamBuffer& buffer = _getBuffer();
         const SegmentControlElement* ctrl =
@@ -881,8 +940,12 @@ namespace SimuTrace
         assert((cycle >= ctrl->startCycle) && (cycle <= ctrl->endCycle));
         assert(ctrl->entryCount == ctrl->rawEntryCount);
 
-        int64_t start = 0;
-        int64_t end   = ctrl->entryCount - 1;
+        // The range comes from the segment's skip index or spans the
+        // whole segment.
+        int64_t start = range.startIndex;
+        int64_t end   = std::min<uint64_t>(range.endIndex,
+                                           ctrl->entryCount - 1);
+        assert(start <= end);
 
         // The cycle count is only 48 bits wide. We therefore use a
         // mask to cut off any unrelated data.
@@ -890,13 +953,11 @@ namespace SimuTrace
 
         // Deferred equality version from Wikipedia returns the smallest index
         // of the region where entries have the same cycle count.
-        size_t offset = 0;
         while (start < end) {
             const int64_t mid = start + ((end - start) / 2);
-            offset = mid * stype.entrySize;
 
             const CycleCount* pCycleCount = reinterpret_cast<const CycleCount*>(
-                segmentStart + offset);
+                segmentStart + mid * stype.entrySize);
             const CycleCount cycleCount = (*pCycleCount & cycleMask);
 
             assert(mid < end);
@@ -912,10 +973,50 @@ namespace SimuTrace
 
         assert(start == end); // 'start < end' if empty, that cannot happen
 
-        return offset;
+        return static_cast<size_t>(start * stype.entrySize);
+    }
+
+    size_t ServerStream::_findVariableEntry(SegmentId bufferSegment,
+                                            uint64_t index,
+                                            const EntryRange* range) const
+    {
+        ServerStreamBuffer& buffer = _getBuffer();
+        const StreamTypeDescriptor& stype = getType();
+        const byte* segmentStart = buffer.getSegment(bufferSegment);
+        const byte* segmentEnd   = buffer.getSegmentEnd(bufferSegment,
+                                                        stype.entrySize);
+
+        const uint32_t sizeHint = getSizeHint(stype.entrySize);
+
+        // With a skip index, we start at the requested entry if the
+        // segment has an entry offset table, or at the sampled entry before
+        // it. Otherwise, we start at the first entry in the segment and have
+        // to skip the remainder of an entry that started in the previous
+        // segment.
+        size_t start;
+        if (range != nullptr) {
+            assert(index >= range->startIndex);
+            assert(segmentStart + range->startOffset <= segmentEnd);
+
+            start = range->startOffset;
+            index -= range->startIndex;
+        } else {
+            start = findFirstVariableEntry(segmentStart,
+                segmentEnd - segmentStart, sizeHint,
+                buffer.getControlElement(bufferSegment)->entryCount);
+        }
+
+        size_t offset = findVariableEntry(segmentStart + start,
+            segmentEnd - (segmentStart + start), sizeHint, index);
+
+        ThrowOn(offset == static_cast<size_t>(-1),
+                ArgumentOutOfBoundsException, "index");
+
+        return start + offset;
     }
 
     size_t ServerStream::_findOffset(SegmentId bufferSegment,
+                                     const StorageLocation* location,
                                      StreamAccessFlags flags,
                                      QueryIndexType type, uint64_t value) const
     {
@@ -935,6 +1036,22 @@ namespace SimuTrace
 
         bool reverseRead = IsSet(flags, StreamAccessFlags::SafReverseRead);
 
+        // Only entries with variable size and cycle counts need a search.
+        // Without a skip index for the segment, we have to search the
+        // whole segment.
+        const bool search = (type == QueryIndexType::QCycleCount) ||
+            ((type == QueryIndexType::QIndex) &&
+             isVariableEntrySize(stype.entrySize));
+
+        EntryRange range;
+        const bool indexed = search && (location != nullptr) &&
+            _encoder->findEntryRange(*location, type, value, range);
+        if (!indexed) {
+            range.startIndex  = 0;
+            range.startOffset = 0;
+            range.endIndex    = std::numeric_limits<uint64_t>::max();
+        }
+
         size_t offset;
         switch (type)
         {
@@ -951,7 +1068,8 @@ namespace SimuTrace
                 // For variable-sized entries we have to scan through the
                 // segment.
                 if (isVariableEntrySize(stype.entrySize)) {
-                    offset = findVariableEntry(segmentStart, endOffset, idx);
+                    offset = _findVariableEntry(bufferSegment, idx,
+                        (indexed) ? &range : nullptr);
                 } else {
                     offset = idx * stype.entrySize;
                 }
@@ -964,7 +1082,7 @@ namespace SimuTrace
                         NotSupportedException);
 
                 offset = _findCycleCountBinarySearch(bufferSegment, value,
-                                                     reverseRead);
+                                                     reverseRead, range);
                 break;
             }
 
@@ -1008,8 +1126,24 @@ namespace SimuTrace
                (_segments[sequenceNumber] != nullptr);
     }
 
+    void ServerStream::_ensureLoaded() const
+    {
+        if (!_loadPending) {
+            return;
+        }
+
+        LockScope(_loadLock);
+        if (_loadPending) {
+            _store.loadStream(const_cast<ServerStream&>(*this));
+
+            _loadPending = false;
+        }
+    }
+
     void ServerStream::queryInformation(StreamQueryInformation& informationOut) const
     {
+        _ensureLoaded();
+
         LockScopeShared(_lock);
 
         informationOut.descriptor = getDescriptor();
@@ -1033,6 +1167,12 @@ namespace SimuTrace
         _addSegment(sequenceNumber, location);
     }
 
+    void ServerStream::deferLoad()
+    {
+        LockScope(_loadLock);
+        _loadPending = true;
+    }
+
     void ServerStream::addSegment(SessionId session,
                                   StreamSegmentId sequenceNumber,
                                   SegmentId* bufferSegmentOut)
@@ -1092,17 +1232,24 @@ namespace SimuTrace
         _completeSegment(sequenceNumber, location, (location != nullptr));
     }
 
-    StreamSegmentId ServerStream::append(SessionId session,
-                                         SegmentId* bufferSegmentOut,
-                                         StreamWait* wait)
+    StreamSegmentId ServerStream::_append(SessionId session,
+                                          StreamSegmentId sequenceNumber,
+                                          SegmentId* bufferSegmentOut,
+                                          StreamWait* wait)
     {
-        LockScope(_appendLock);
+        // This method must be called with the appendLock held!
 
         LockExclusive(_lock); {
-            // Submit the last appended segment
-            if (_lastAppendSequenceNumber != INVALID_STREAM_SEGMENT_ID) {
-                assert(_lastAppendSequenceNumber < _segments.size());
-                SegmentLocation* loc = _segments[_lastAppendSequenceNumber];
+            // Submit the specified append segment
+            if (sequenceNumber != INVALID_STREAM_SEGMENT_ID) {
+                ThrowOn(_appendList.empty() ||
+                        (_appendList.front() != sequenceNumber),
+                        Exception, stringFormat("Append "
+                        "segments of stream %d must be submitted in order "
+                        "<sqn: %d>.", getId(), sequenceNumber));
+
+                assert(sequenceNumber < _segments.size());
+                SegmentLocation* loc = _segments[sequenceNumber];
 
                 assert(loc != nullptr);
                 assert(loc->id != INVALID_SEGMENT_ID);
@@ -1111,8 +1258,8 @@ namespace SimuTrace
                 assert(loc->referenceMap.size() == 1);
 
                 auto it = loc->referenceMap.find(session);
-                (void)it; // Make compiler happy in release build
-                assert(it != loc->referenceMap.end());
+                ThrowOn(it == loc->referenceMap.end(),
+                        InvalidOperationException);
                 assert(it->second == 1);
 
                 _close(loc, wait, false, nullptr);
@@ -1132,24 +1279,111 @@ namespace SimuTrace
         ServerStreamBuffer& buffer = _getBuffer();
         SegmentId id = buffer.requestSegment(*this, sqn);
 
-        if (id != INVALID_SEGMENT_ID) {
-            LockScopeExclusive(_lock); // Reacquire lock!
+        if (bufferSegmentOut != nullptr) {
+            *bufferSegmentOut = id;
+        }
 
-            SegmentControlElement* ctrl = buffer.getControlElement(id);
-            assert(ctrl != nullptr);
+        if (id == INVALID_SEGMENT_ID) {
+            return INVALID_STREAM_SEGMENT_ID;
+        }
 
-            ctrl->startIndex = _lastAppendIndex;
+        LockScopeExclusive(_lock); // Reacquire lock!
 
-            _addSegmentLocation(new SegmentLocation(sqn, session, id));
+        SegmentControlElement* ctrl = buffer.getControlElement(id);
+        assert(ctrl != nullptr);
 
-            _lastAppendSequenceNumber = _lastSequenceNumber = sqn;
-        }
+        // The start index is only preliminary if there are other open
+        // append segments. We set the final value on submission.
+        ctrl->startIndex = _lastAppendIndex;
 
-        if (bufferSegmentOut != nullptr) {
-            *bufferSegmentOut = id;
+        _addSegmentLocation(new SegmentLocation(sqn, session, id));
+
+        _appendList.push_back(sqn);
+        _lastSequenceNumber = sqn;
+
+        return sqn;
+    }
+
+    StreamSegmentId ServerStream::append(SessionId session,
+                                         SegmentId* bufferSegmentOut,
+                                         StreamWait* wait)
+    {
+        _ensureLoaded();
+
+        LockScope(_appendLock);
+
+        // Submit the oldest open append segment (if any). Producers that
+        // keep a single append segment do not need to specify it.
+        StreamSegmentId sqn = INVALID_STREAM_SEGMENT_ID;
+        LockShared(_lock); {
+            if (!_appendList.empty()) {
+                sqn = _appendList.front();
+            }
+        } Unlock();
+
+        return _append(session, sqn, bufferSegmentOut, wait);
+    }
+
+    StreamSegmentId ServerStream::append(SessionId session,
+                                         StreamSegmentId sequenceNumber,
+                                         SegmentId* bufferSegmentOut,
+                                         StreamWait* wait)
+    {
+        _ensureLoaded();
+
+        LockScope(_appendLock);
+
+        return _append(session, sequenceNumber, bufferSegmentOut, wait);
+    }
+
+    void ServerStream::cancelAppend(SessionId session,
+                                    StreamSegmentId sequenceNumber)
+    {
+        _ensureLoaded();
+
+        LockScope(_appendLock);
+        LockScopeExclusive(_lock);
+
+        // We only release unused segments at the end of the stream. That
+        // way, the stream does not get any holes and the next append can
+        // take over the sequence number.
+        ThrowOn(_appendList.empty() ||
+                (_appendList.back() != sequenceNumber) ||
+                (_lastSequenceNumber != sequenceNumber),
+                InvalidOperationException);
+
+        assert(sequenceNumber < _segments.size());
+        SegmentLocation* loc = _segments[sequenceNumber];
+
+        assert(loc != nullptr);
+        assert(loc->id != INVALID_SEGMENT_ID);
+        assert(loc->referenceCount == 1);
+
+        ThrowOn(loc->referenceMap.find(session) == loc->referenceMap.end(),
+                InvalidOperationException);
+
+        ServerStreamBuffer& buffer = _getBuffer();
+        const SegmentControlElement* ctrl = buffer.getControlElement(loc->id);
+        assert(ctrl != nullptr);
+
+        ThrowOn(ctrl->entryCount > 0, Exception, stringFormat("Append "
+                "segment of stream %d is not empty <sqn: %d>.", getId(),
+                sequenceNumber));
+
+        buffer.purgeSegment(loc->id);
+
+        _openList.remove(loc);
+        _appendList.pop_back();
+
+        _segments[sequenceNumber] = nullptr;
+        if (sequenceNumber == _segments.size() - 1) {
+            _segments.pop_back();
         }
 
-        return _lastAppendSequenceNumber;
+        delete loc;
+
+        // Will be INVALID_STREAM_SEGMENT_ID again for sequence number 0
+        _lastSequenceNumber = sequenceNumber - 1;
     }
 
     StreamSegmentId ServerStream::open(SessionId session,
@@ -1157,8 +1391,11 @@ namespace SimuTrace
                                        StreamAccessFlags flags,
                                        SegmentId* bufferSegmentOut,
                                        size_t* offsetOut,
-                                       StreamWait* wait)
+                                       StreamWait* wait,
+                                       StreamSegmentId last)
     {
+        _ensureLoaded();
+
         LockScope(_openLock);
 
         StreamAccessFlags nflags = flags;
@@ -1170,6 +1407,7 @@ namespace SimuTrace
         bool completed;
         bool handled = false;
         SegmentId id;
+        uint32_t readAhead = 0;
 
         ThrowOn((offsetOut != nullptr) && (wait == nullptr),
                 ArgumentException);
@@ -1181,8 +1419,12 @@ namespace SimuTrace
             ThrowOn(!valid, NotFoundException);
 
             // Find the right sequence number with the adjusted query.
+            // If the caller reads a range of the stream, it must not leave
+            // the range. For all other opens, last is invalid and the check
+            // never applies.
             sqn = _findSequenceNumber(ntype, nvalue);
-            ThrowOn(sqn >= _segments.size(), NotFoundException);
+            ThrowOn((sqn >= _segments.size()) || (sqn > last),
+                    NotFoundException);
 
             // If we test under the lock that the segment does have a storage
             // location assigned, we are guaranteed that the segment location
@@ -1194,6 +1436,12 @@ namespace SimuTrace
             ThrowOnNull(loc->location, OperationInProgressException);
             assert(loc->sequenceNumber == sqn);
 
+            // Remember if the segment has been read ahead and if it is
+            // still loading, before we take it over below.
+            bool prefetched = loc->prefetched;
+            bool loading = (loc->id == INVALID_SEGMENT_ID) &&
+                           (loc->sideId != INVALID_SEGMENT_ID);
+
             if (loc->referenceCount > 0) {
                 // Only the server session is allowed to open segments which
                 // are currently written. However, it may not open segments
@@ -1249,36 +1497,51 @@ namespace SimuTrace
                 handled = true;
             }
 
-            // Before we open the requested segment, we check if the caller
-            // specified sequential scan. In that case, we start asynchronous
-            // read ahead before performing the requested open. While we are
-            // holding the lock, we just find the right sequence numbers to
-            // prefetch.
-            if (IsSet(nflags, StreamAccessFlags::SafSequentialScan)) {
-                QueryIndexType ratype;
-
-                // We first have to determine in which direction we have to
-                // perform read ahead.
-                ratype = IsSet(flags, StreamAccessFlags::SafReverseRead) ?
-                    QueryIndexType::QPreviousValidSequenceNumber :
-                    QueryIndexType::QNextValidSequenceNumber;
-
-                uint32_t readAhead = _readAheadAmount;
-                StreamSegmentId raSqn = sqn;
-
-                while (readAhead > 0) {
-                    // Find the next/previous valid sequence number
-                    // after/before the requested or last prefetched one,
-                    // respectively.
-                    raSqn = _findSequenceNumber(ratype, raSqn);
-
-                    _readAheadList[--readAhead] = raSqn;
-
-                    // If there are no further segments in the stream which we
-                    // can prefetch, we cancel read ahead.
-                    if (raSqn == INVALID_STREAM_SEGMENT_ID) {
-                        break;
+            // Before we open the requested segment, we update the access
+            // pattern of the caller. If the caller specified sequential scan
+            // or follows a stride, we start asynchronous read ahead before
+            // performing the requested open. While we are holding the lock,
+            // we just find the right sequence numbers to prefetch.
+            if (_readAheadAmount > 0) {
+                ReadAheadKey key(session, last);
+
+                auto it = _readAhead.find(key);
+                if (it == _readAhead.end()) {
+                    it = _readAhead.insert(std::make_pair(key,
+                            ReadAheadController(_readAheadAmount,
+                                                _readAheadMax))).first;
+                }
+
+                ReadAheadController& controller = it->second;
+                int64_t stride = controller.update(sqn, nflags,
+                                                   Clock::getTicks());
+
+                if (prefetched) {
+                    controller.hit(loading, _loadTicks);
+
+                    if (loading) {
+                        _readAheadStats.lateHits++;
+                    } else {
+                        _readAheadStats.hits++;
                     }
+                } else if (stride != 0) {
+                    controller.miss(_loadTicks);
+
+                    _readAheadStats.misses++;
+                }
+
+                if (stride != 0) {
+                    uint32_t budget = _getReadAheadBudget(session);
+
+                    readAhead = _collectReadAhead(sqn, stride,
+                                                  controller.getWindow(budget),
+                                                  last);
+                }
+
+                // The reader reached the end of its range. Hand the budget
+                // to the remaining readers of the session.
+                if (sqn == last) {
+                    _readAhead.erase(it);
                 }
             }
 
@@ -1286,46 +1549,39 @@ namespace SimuTrace
 
         // Do the actual read ahead. Since we cannot delete finished segments
         // the collected sequence numbers must still be valid for read ahead!
-        if (IsSet(nflags, StreamAccessFlags::SafSequentialScan)) {
-            uint32_t readAhead = _readAheadAmount;
-
+        if (readAhead > 0) {
             StreamAccessFlags raFlags = static_cast<StreamAccessFlags>(
                     nflags & ~StreamAccessFlags::SafSynchronous);
 
-            while (readAhead > 0) {
-                StreamSegmentId raSqn = _readAheadList[readAhead - 1];
+            for (uint32_t i = 0; i < readAhead; ++i) {
+                StreamSegmentId raSqn = _readAheadList[i];
 
-                // If there are no further segments in the stream which we
-                // can prefetch, we cancel read ahead.
-                if (raSqn == INVALID_STREAM_SEGMENT_ID) {
-                    break;
-                }
-
-                assert(raSqn <= _segments.size());
+                assert(raSqn < _segments.size());
                 SegmentLocation* raloc = _segments[raSqn];
-                assert(raloc != nullptr);
 
-                // The segment might be still in progress
-                if (raloc->location != nullptr) {
+                // A strided read ahead may hit unused sequence numbers and
+                // the segment might be still in progress
+                if ((raloc == nullptr) || (raloc->location == nullptr)) {
+                    continue;
+                }
 
-                    // Only initiate an open, if the segment is not already
-                    // open (which may also be a read ahead in progress) and
-                    // has not been prefetched since the last real open. Since
-                    // the reference count can only be incremented through this
-                    // method, the state is protected by the openLock we hold.
-                    if ((raloc->referenceCount == 0) && (!raloc->prefetched)) {
-                        SegmentId id;
+                // Only initiate an open, if the segment is not already
+                // open (which may also be a read ahead in progress) and
+                // has not been prefetched since the last real open. Since
+                // the reference count can only be incremented through this
+                // method, the state is protected by the openLock we hold.
+                if ((raloc->referenceCount == 0) && (!raloc->prefetched)) {
+                    SegmentId id;
 
-                        _open(session, raSqn, raFlags, id, true);
+                    _open(session, raSqn, raFlags, id, true);
 
-                        // Abort read ahead if unsuccessful
-                        if (id == INVALID_SEGMENT_ID) {
-                            break;
-                        }
+                    // Abort read ahead if unsuccessful
+                    if (id == INVALID_SEGMENT_ID) {
+                        break;
                     }
-                }
 
-                readAhead--;
+                    _readAheadStats.prefetches++;
+                }
             }
         }
 
@@ -1355,7 +1611,8 @@ namespace SimuTrace
                       "See the server log for more information.");
             }
 
-            *offsetOut = _findOffset(id, nflags, ntype, nvalue);
+            *offsetOut = _findOffset(id, loc->location.get(), nflags, ntype,
+                                     nvalue);
 
             completed = true;
         }
@@ -1414,7 +1671,8 @@ namespace SimuTrace
 
         } else {
             assert(loc->referenceCount > 1);
-            assert(sequenceNumber != _lastAppendSequenceNumber);
+            assert(std::find(_appendList.begin(), _appendList.end(),
+                             sequenceNumber) == _appendList.end());
 
             if (it->second == 1) {
                 loc->referenceMap.erase(it);
@@ -1429,6 +1687,15 @@ namespace SimuTrace
     void ServerStream::close(SessionId session, StreamWait* wait,
                              bool ignoreErrors)
     {
+        // The session does not read from the stream anymore. Forget its
+        // access pattern.
+        Lock(_openLock); {
+            _readAhead.erase(
+                _readAhead.lower_bound(ReadAheadKey(session, 0)),
+                _readAhead.upper_bound(
+                    ReadAheadKey(session, INVALID_STREAM_SEGMENT_ID)));
+        } Unlock();
+
         LockScopeExclusive(_lock);
 
         auto lit = _openList.begin();
@@ -1480,6 +1747,8 @@ namespace SimuTrace
         StreamSegmentId sequenceNumber) const
     {
         //TODO: Add locking !!
+        _ensureLoaded();
+
         ThrowOn(!_segmentIsAllocated(sequenceNumber), NotFoundException);
 
         SegmentLocation* loc = _segments[sequenceNumber];
@@ -1492,7 +1761,60 @@ namespace SimuTrace
 
     StreamSegmentId ServerStream::getCurrentSegmentId() const
     {
-        return _lastAppendSequenceNumber;
+        _ensureLoaded();
+
+        LockScopeShared(_lock);
+        return (_appendList.empty()) ? INVALID_STREAM_SEGMENT_ID :
+            _appendList.front();
+    }
+
+    void ServerStream::partition(uint32_t count,
+        std::vector<StreamPartition>& partitionsOut) const
+    {
+        ThrowOn(count == 0, ArgumentOutOfBoundsException, "count");
+
+        _ensureLoaded();
+
+        std::vector<StreamSegmentId> valid;
+
+        // Only segments that have been completed can be opened. We thus
+        // skip holes as well as segments that are still written or
+        // encoded.
+        LockShared(_lock); {
+            valid.reserve(_segments.size());
+
+            for (auto loc : _segments) {
+                if ((loc != nullptr) && (loc->location != nullptr)) {
+                    valid.push_back(loc->sequenceNumber);
+                }
+            }
+        } Unlock();
+
+        partitionsOut.clear();
+
+        // Give each partition the same number of segments. If the segments
+        // do not divide evenly, the sizes differ by one segment.
+        size_t n = std::min(static_cast<size_t>(count), valid.size());
+        size_t start = 0;
+        for (size_t i = 0; i < n; ++i) {
+            size_t end = ((i + 1) * valid.size()) / n;
+            assert(end > start);
+
+            StreamPartition partition;
+            partition.first = valid[start];
+            partition.last  = valid[end - 1];
+
+            partitionsOut.push_back(partition);
+            start = end;
+        }
+    }
+
+    void ServerStream::getReadAheadStatistics(
+        ReadAheadStatistics& statsOut) const
+    {
+        LockScope(_openLock);
+
+        statsOut = _readAheadStats;
     }
 
     ServerStore& ServerStream::getStore() const
@@ -23,12 +23,16 @@
 
 #include "SimuStor.h"
 
+#include "ReadAheadController.h"
+#include "SegmentIndex.h"
+
 namespace SimuTrace
 {
 
     class ServerStore;
     class ServerStreamBuffer;
     class StreamEncoder;
+    struct EntryRange;
 
     /* Wait context used by server streams */
     typedef WaitContext<StreamSegmentLink> StreamWait;
@@ -39,18 +43,6 @@ namespace SimuTrace
     private:
         struct SegmentLocation;
 
-        struct RangeCompare
-        {
-            bool operator() (const Range* left, const Range* right) const
-            {
-                assert((left != nullptr) && (right != nullptr));
-                return (left->start < right->start);
-            }
-        };
-
-        typedef std::set<Range*, RangeCompare>::reverse_iterator
-            ReverseRangeIterator;
-
         typedef std::list<SegmentLocation*>::iterator OpenListIterator;
     private:
         DISABLE_COPY(ServerStream);
@@ -64,10 +56,13 @@ namespace SimuTrace
 
         std::vector<SegmentLocation*> _segments;
         std::list<SegmentLocation*> _openList;
-        std::set<Range*, RangeCompare> _trees[QueryIndexType::_QMaxTree + 1];
+        SegmentIndex _trees[QueryIndexType::_QMaxTree + 1];
 
+        // Open append segments in the order of their sequence numbers. A
+        // producer may reserve several segments ahead (see append()). The
+        // start index of a segment is only known when it is submitted.
         StreamSegmentId _lastSequenceNumber;
-        StreamSegmentId _lastAppendSequenceNumber;
+        std::deque<StreamSegmentId> _appendList;
         uint64_t _lastAppendIndex;
 
         StreamEncoder* _encoder;
@@ -75,11 +70,30 @@ namespace SimuTrace
         // Statistics
         StreamStatistics _stats;
 
-        // Read ahead
+        // Read ahead (protected by _openLock). _loadTicks is the average
+        // time in ns needed to load a segment (protected by _lock). A
+        // session has one controller per range it reads (see open()). The
+        // key is the session and the last sequence number of the range.
+        typedef std::pair<SessionId, StreamSegmentId> ReadAheadKey;
+
         uint32_t _readAheadAmount;
+        uint32_t _readAheadMax;
         std::unique_ptr<StreamSegmentId[]> _readAheadList;
+        std::map<ReadAheadKey, ReadAheadController> _readAhead;
+        ReadAheadStatistics _readAheadStats;
+        uint64_t _loadTicks;
+
+        uint32_t _collectReadAhead(StreamSegmentId sequenceNumber,
+                                   int64_t stride, uint32_t window,
+                                   StreamSegmentId last);
+        uint32_t _getReadAheadBudget(SessionId session) const;
+
+        // Deferred loading of existing segments
+        mutable CriticalSection _loadLock;
+        mutable volatile bool _loadPending;
 
         void _finalize();
+        void _ensureLoaded() const;
 
         SegmentLocation* _addSegmentLocation(SegmentLocation* loc);
         SegmentLocation* _getPreviousSegment(StreamSegmentId sequenceNumber) const;
@@ -96,6 +110,11 @@ namespace SimuTrace
                               OpenListIterator* openListIt,
                               bool success, bool synchronous);
 
+        StreamSegmentId _append(SessionId session,
+                                StreamSegmentId sequenceNumber,
+                                SegmentId* bufferSegmentOut,
+                                StreamWait* wait);
+
         bool _open(SessionId session, StreamSegmentId sequenceNumber,
                    StreamAccessFlags flags, SegmentId& segmentId,
                    bool prefetch, StreamWait* wait = nullptr);
@@ -111,9 +130,15 @@ namespace SimuTrace
 
         size_t _findCycleCountBinarySearch(SegmentId bufferSegment,
                                            CycleCount cycle,
-                                           bool reverse) const;
+                                           bool reverse,
+                                           const EntryRange& range) const;
+
+        size_t _findVariableEntry(SegmentId bufferSegment, uint64_t index,
+                                  const EntryRange* range) const;
 
-        size_t _findOffset(SegmentId bufferSegment, StreamAccessFlags flags,
+        size_t _findOffset(SegmentId bufferSegment,
+                           const StorageLocation* location,
+                           StreamAccessFlags flags,
                            QueryIndexType type, uint64_t value) const;
 
         ServerStreamBuffer& _getBuffer() const;
@@ -128,6 +153,11 @@ namespace SimuTrace
 
         void addSegment(StreamSegmentId sequenceNumber,
                         std::unique_ptr<StorageLocation>& location);
+
+        // Marks the stream's segments as not loaded. The store adds them
+        // with addSegment() on the first access to the stream (see
+        // ServerStore::loadStream()).
+        void deferLoad();
         void addSegment(SessionId session,
                         StreamSegmentId sequenceNumber,
                         SegmentId* bufferSegmentOut);
@@ -138,11 +168,17 @@ namespace SimuTrace
 
         StreamSegmentId append(SessionId session, SegmentId* bufferSegmentOut,
                                StreamWait* wait = nullptr);
+        StreamSegmentId append(SessionId session,
+                               StreamSegmentId sequenceNumber,
+                               SegmentId* bufferSegmentOut,
+                               StreamWait* wait = nullptr);
+        void cancelAppend(SessionId session, StreamSegmentId sequenceNumber);
         StreamSegmentId open(SessionId session, QueryIndexType type,
                              uint64_t value, StreamAccessFlags flags,
                              SegmentId* bufferSegmentOut,
                              size_t* offsetOut = nullptr,
-                             StreamWait* wait = nullptr);
+                             StreamWait* wait = nullptr,
+                             StreamSegmentId last = INVALID_STREAM_SEGMENT_ID);
 
         void close(SessionId session, StreamSegmentId sequenceNumber,
                    StreamWait* wait = nullptr, bool ignoreErrors = false);
@@ -156,6 +192,11 @@ namespace SimuTrace
 
         StreamSegmentId getCurrentSegmentId() const;
 
+        void partition(uint32_t count,
+                       std::vector<StreamPartition>& partitionsOut) const;
+
+        void getReadAheadStatistics(ReadAheadStatistics& statsOut) const;
+
         ServerStore& getStore() const;
         StreamEncoder& getEncoder() const;
     };
@@ -43,8 +43,11 @@ namespace SimuTrace
         SgfLowPriority = 1 << 4, // Segment may be reused early. For
                                  // pre-fetched or random-access data
 
-        SgfPrefetch    = 1 << 5, // Segment will be placed at the head of the
-                                 // standby list at first free
+        SgfPrefetch    = 1 << 5, // Segment has been read ahead and not yet
+                                 // been used. It must not be evicted early.
+
+        SgfReferenced  = 1 << 6, // Segment has been served from the standby
+                                 // list before
 
         SgfMax
     };
@@ -84,16 +87,43 @@ namespace SimuTrace
     }
 #endif
 
+    class ServerStreamBuffer::StandbyLockScope
+    {
+    private:
+        DISABLE_COPY(StandbyLockScope);
+
+        ServerStreamBuffer& _buffer;
+        uint64_t _start;
+
+    public:
+        StandbyLockScope(ServerStreamBuffer& buffer) :
+            _buffer(buffer),
+            _start(0)
+        {
+            _buffer._standbyLock.enter();
+            _start = Clock::getTicks();
+        }
+
+        ~StandbyLockScope()
+        {
+            _buffer._standbyStats.lockTicks += Clock::getTicks() - _start;
+            _buffer._standbyStats.lockCount++;
+
+            _buffer._standbyLock.leave();
+        }
+    };
+
     struct Segment
     {
         CriticalSection lock;
 
-        Segment* next; // used for free-list and standby-list
-        Segment* prev; // used for standby-list only
+        Segment* next; // used for free-list only
 
         SegmentId id;
         SegmentFlags flags;
 
+        uint32_t node; // NUMA node the segment's memory is placed on
+
         bool isSubmitted;
 
         // We hold a copy of the owner information to validate it in the
@@ -115,14 +145,35 @@ namespace SimuTrace
         StreamBuffer(id, segmentSize, numSegments, sharedMemory),
         _cookie(0),
         _segments(nullptr),
-        _freeHead(nullptr),
+        _numNodes(1),
+        _freeLists(nullptr),
+        _allocationWaiters(),
+        _retryCount(0),
+        _retrySleep(0),
         _enableCache(false),
-        _standbyHead(nullptr)
+        _standbyPolicy(),
+        _standbyShards(new StandbyShard[_numStandbyShards]),
+        _standbyStats()
     {
         _cookie = (static_cast<uint64_t>(rand()) << 32) | rand();
 
         _enableCache = !Configuration::get<bool>("server.memmgmt.disableCache");
 
+        _retryCount = Configuration::get<int>("server.memmgmt.retryCount");
+        _retrySleep = Configuration::get<int>("server.memmgmt.retrySleep");
+
+        std::string policy = Configuration::get<std::string>(
+            "server.memmgmt.cachePolicy");
+
+        _standbyPolicy = StandbyPolicy::create(policy, numSegments);
+        ThrowOnNull(_standbyPolicy, ConfigurationException, stringFormat(
+                    "Unknown cache policy '%s' specified in "
+                    "server.memmgmt.cachePolicy.", policy.c_str()));
+
+        if (Configuration::get<bool>("server.memmgmt.numa")) {
+            _numNodes = std::min(System::getNumNumaNodes(), numSegments);
+        }
+
         _initializeSegments();
     }
 
@@ -132,8 +183,52 @@ namespace SimuTrace
 
         flushStandbyList();
 
-        assert(_standbyHead == nullptr);
-        assert(_standbyIndex.empty());
+        assert(_standbyPolicy->getSize() == 0);
+
+        AllocationWaitQueue::Statistics waitStats;
+        _allocationWaiters.getStatistics(waitStats);
+
+        if (waitStats.waits > 0) {
+            LogInfo("Stream buffer %s: %llu segment requests waited for "
+                    "a free segment (%llu failed), %llu ms on average, "
+                    "%llu ms at most.", bufferIdToString(getId()).c_str(),
+                    static_cast<unsigned long long>(waitStats.waits),
+                    static_cast<unsigned long long>(waitStats.timeouts),
+                    static_cast<unsigned long long>(
+                        waitStats.waitTicks / waitStats.waits / 1000000),
+                    static_cast<unsigned long long>(
+                        waitStats.maxWaitTicks / 1000000));
+        }
+
+        if (_enableCache && (_standbyStats.hits + _standbyStats.misses > 0)) {
+            uint64_t lookups = _standbyStats.hits + _standbyStats.misses;
+
+            LogInfo("Stream buffer %s, standby list <policy: %s>: %llu hits "
+                    "in %llu lookups (%.1f%%), %llu evictions, standby lock "
+                    "held %llu ns on average.",
+                    bufferIdToString(getId()).c_str(),
+                    _standbyPolicy->getName().c_str(),
+                    static_cast<unsigned long long>(_standbyStats.hits),
+                    static_cast<unsigned long long>(lookups),
+                    (_standbyStats.hits * 100.0) / lookups,
+                    static_cast<unsigned long long>(_standbyStats.evictions),
+                    static_cast<unsigned long long>(
+                        (_standbyStats.lockCount > 0) ?
+                        _standbyStats.lockTicks / _standbyStats.lockCount : 0));
+        }
+
+        if (_numNodes > 1) {
+            for (uint32_t i = 0; i < _numNodes; ++i) {
+                NodeFreeList& list = _freeLists[i];
+
+                LogInfo("Stream buffer %s, NUMA node %d: %d segments, "
+                        "%llu local and %llu remote allocations.",
+                        bufferIdToString(getId()).c_str(), i,
+                        list.numSegments,
+                        static_cast<unsigned long long>(list.localAllocations),
+                        static_cast<unsigned long long>(list.remoteAllocations));
+            }
+        }
 
     #ifdef _DEBUG
     #if defined(_WIN32)
@@ -149,7 +244,7 @@ namespace SimuTrace
 
             // Check that the segment is free and not in the standby list
             assert(seg.flags == SegmentFlags::SgfFree);
-            assert(seg.prev == nullptr);
+            assert(!_standbyPolicy->contains(seg.id));
 
             assert(dbgSanityCheck(seg.id, 0) == 0);
         }
@@ -174,6 +269,26 @@ namespace SimuTrace
         uint32_t segCount = getNumSegments();
         _segments = new Segment[segCount];
 
+        // The buffer is split into contiguous ranges of segments, one for
+        // each NUMA node. The memory of a range is placed on its node, before
+        // we touch it below.
+        _freeLists = std::unique_ptr<NodeFreeList[]>(
+            new NodeFreeList[_numNodes]);
+
+        if (_numNodes > 1) {
+            SegmentId first = 0;
+            for (uint32_t i = 1; i <= segCount; ++i) {
+                if ((i == segCount) ||
+                    (_getSegmentNode(i) != _getSegmentNode(first))) {
+                    _bindSegmentsToNode(_getSegmentNode(first), first, i - 1);
+                    first = i;
+                }
+            }
+
+            LogInfo("Split stream buffer %s across %d NUMA nodes.",
+                    bufferIdToString(getId()).c_str(), _numNodes);
+        }
+
     #if defined(_WIN32)
     #else
         // In Linux, allocating a shared memory region can be successful,
@@ -190,12 +305,19 @@ namespace SimuTrace
             // the working set on low to medium load.
             for (uint32_t i = 0; i < segCount; ++i) {
                 Segment& seg = _segments[i];
+                uint32_t node = _getSegmentNode(i);
 
-                seg.next = (i == segCount - 1) ? nullptr : &_segments[i + 1];
-                seg.prev = nullptr;
+                seg.next = ((i == segCount - 1) || (_getSegmentNode(i + 1) != node)) ?
+                    nullptr : &_segments[i + 1];
 
                 seg.id = static_cast<SegmentId>(i);
                 seg.flags = SegmentFlags::SgfFree;
+                seg.node = node;
+
+                NodeFreeList& list = _freeLists[node];
+                if (list.numSegments++ == 0) {
+                    list.head = &seg;
+                }
 
                 seg.stream = nullptr;
                 seg.sequenceNumber = INVALID_STREAM_SEGMENT_ID;
@@ -232,8 +354,27 @@ namespace SimuTrace
                     getId()));
         } SigEnd();
     #endif
+    }
 
-        _freeHead = &_segments[0];
+    uint32_t ServerStreamBuffer::_getSegmentNode(SegmentId segment) const
+    {
+        return System::getNumaNodeOfIndex(segment, getNumSegments(), _numNodes);
+    }
+
+    void ServerStreamBuffer::_bindSegmentsToNode(uint32_t node,
+                                                 SegmentId first,
+                                                 SegmentId last)
+    {
+        assert(first <= last);
+        byte* start = getSegment(first);
+        byte* end = (last + 1 < getNumSegments()) ? getSegment(last + 1) :
+            getSegment(0) + getBufferSize();
+
+        if (!System::bindMemoryToNumaNode(start, end - start, node)) {
+            LogWarn("Failed to place segments %d-%d of stream buffer %s on "
+                    "NUMA node %d.", first, last,
+                    bufferIdToString(getId()).c_str(), node);
+        }
     }
 
     uint64_t ServerStreamBuffer::_computeControlCookie(
@@ -276,22 +417,35 @@ namespace SimuTrace
         encoder.notifySegmentCacheClosed(segment.sequenceNumber);
     }
 
-    Segment* ServerStreamBuffer::_dequeueFromFreeList()
+    Segment* ServerStreamBuffer::_dequeueFromFreeList(uint32_t node)
     {
-        Segment* seg = _freeHead;
+        assert(node < _numNodes);
+        Segment* seg = nullptr;
 
-        // As long the head is not null, try to set the head to its next
-        // element. If another thread has already taken the head, the compare
-        // will set seg to the new head and we try again.
-        do {
-            if (seg == nullptr) {
-                return nullptr;
-            }
+        // Prefer segments of the requested node. Only if the node is
+        // exhausted, we take a segment from another node.
+        for (uint32_t i = 0; (i < _numNodes) && (seg == nullptr); ++i) {
+            std::atomic<Segment*>& head = _freeLists[(node + i) % _numNodes].head;
+            seg = head;
+
+            // As long the head is not null, try to set the head to its next
+            // element. If another thread has already taken the head, the
+            // compare will set seg to the new head and we try again.
+            while ((seg != nullptr) &&
+                   !head.compare_exchange_strong(seg, seg->next)) { }
+        }
+
+        if (seg == nullptr) {
+            return nullptr;
+        }
 
-        } while (!_freeHead.compare_exchange_strong(seg, seg->next));
+        if (seg->node == node) {
+            Interlocked::interlockedAdd(&_freeLists[node].localAllocations, 1);
+        } else {
+            Interlocked::interlockedAdd(&_freeLists[node].remoteAllocations, 1);
+        }
 
         assert(seg->flags == SegmentFlags::SgfFree);
-        assert(seg->prev == nullptr);
         assert(seg->stream == nullptr);
         assert(seg->sequenceNumber == INVALID_STREAM_SEGMENT_ID);
 
@@ -308,7 +462,6 @@ namespace SimuTrace
     {
         assert(IsSet(segment.flags, SegmentFlags::SgfInUse));
         assert(segment.next == nullptr);
-        assert(segment.prev == nullptr);
 
     #ifdef _DEBUG
         dbgSanityFill(segment.id, true);
@@ -317,13 +470,23 @@ namespace SimuTrace
         segment.stream = nullptr;
         segment.sequenceNumber = INVALID_STREAM_SEGMENT_ID;
 
+        // Segments always return to the free list of their node
+        std::atomic<Segment*>& head = _freeLists[segment.node].head;
+
         segment.flags = SegmentFlags::SgfFree;
-        segment.next  = _freeHead;
+        segment.next  = head;
 
         // Make segment the new head. If the head is no longer what's stored
         // in segment.next (some other thread must have inserted a segment
         // just now) then update segment.next and try again.
-        while (!_freeHead.compare_exchange_strong(segment.next, &segment)) { }
+        while (!head.compare_exchange_strong(segment.next, &segment)) { }
+
+        // Only take the wait queue's lock if someone is waiting. A waiter
+        // registers before it tries to allocate, so either it sees the
+        // segment or we see the waiter.
+        if (_allocationWaiters.hasWaiters()) {
+            _allocationWaiters.notify();
+        }
     }
 
     void ServerStreamBuffer::_prepareSegment(SegmentId segment,
@@ -376,15 +539,20 @@ namespace SimuTrace
                 "exhausted <try: %d%s>.", bufferIdToString(getId()).c_str(),
                 tryCount, (isScratch) ? ", scratch" : "");
 
-        const uint32_t maxRetryCount = Configuration::get<int>("server.memmgmt.retryCount");
-        const uint32_t sleepTime = Configuration::get<int>("server.memmgmt.retrySleep");
+        return (tryCount < _retryCount);
+    }
 
-        if (tryCount >= maxRetryCount) {
-            return false;
+    Segment* ServerStreamBuffer::_allocateSegment(uint32_t node)
+    {
+        Segment* seg = _dequeueFromFreeList(node);
+        if (seg == nullptr) {
+            // We could not get a segment from the free list. As a second
+            // resort, we try to remove an element from the standby list.
+            // The policy decides which element to evict, if any.
+            seg = _evictFromStandbyList();
         }
 
-        ThreadBase::sleep(sleepTime);
-        return true;
+        return seg;
     }
 
     Segment* ServerStreamBuffer::_tryAllocateFreeSegment(ServerStream* stream,
@@ -393,37 +561,64 @@ namespace SimuTrace
     {
         Segment* seg = nullptr;
         uint32_t tryCount = 1;
+        const bool isScratch = (stream == nullptr);
 
-        while (true) {
-            LogMem("Requesting segment from buffer %s <try: %d, %s>.",
-                   bufferIdToString(getId()).c_str(), tryCount,
-                   _getRequestString(stream, sequenceNumber, location, flags).c_str());
+        // Allocate from the node of the requesting thread
+        const uint32_t node = (_numNodes > 1) ?
+            System::getCurrentNumaNode() % _numNodes : 0;
 
-            seg = _dequeueFromFreeList();
-            if (seg == nullptr) {
-                // We could not get a segment from the free list. As a second
-                // resort, we try to remove an element from the standby list.
-                // This will remove the least recently used item, if any.
-                seg = _evictFromStandbyList();
-            }
+        LogMem("Requesting segment from buffer %s <%s>.",
+               bufferIdToString(getId()).c_str(),
+               _getRequestString(stream, sequenceNumber, location, flags).c_str());
 
-            if (seg != nullptr) {
-                _prepareSegment(seg->id, stream, sequenceNumber);
+        // Requests, which are already waiting for a segment, are served
+        // first. Otherwise, we could starve them.
+        if (!_allocationWaiters.hasWaiters()) {
+            seg = _allocateSegment(node);
+        }
 
-                LogMem("Allocated segment %d from buffer %s <try: %d, %s>",
-                       seg->id, bufferIdToString(getId()).c_str(), tryCount,
-                       _getRequestString(stream, sequenceNumber, location, flags).c_str());
+        // We do not handle contention for prefetching, but instead return
+        // as fast as possible.
+        if ((seg == nullptr) && !prefetch) {
+            AllocationWaitQueue::Waiter waiter;
+
+            // Scratch segments are needed by the encoders to complete the
+            // segments that will be freed next. We serve them first.
+            _allocationWaiters.enter(waiter, (isScratch) ?
+                AllocationWaitQueue::Priority::High :
+                AllocationWaitQueue::Priority::Normal);
+
+            uint64_t deadline = Clock::getTicks() +
+                static_cast<uint64_t>(_retrySleep) * 1000000;
+
+            while (true) {
+                // We get a turn, when a segment has been freed or added to
+                // the standby list.
+                if (_allocationWaiters.wait(waiter, deadline)) {
+                    seg = _allocateSegment(node);
+                    if (seg != nullptr) {
+                        break;
+                    }
+                } else {
+                    if (!_handleContention(tryCount, isScratch)) {
+                        break;
+                    }
 
-                break;
+                    tryCount++;
+                    deadline = Clock::getTicks() +
+                        static_cast<uint64_t>(_retrySleep) * 1000000;
+                }
             }
 
-            // We do not handle contention for prefetching, but instead return
-            // as fast as possible.
-            if (prefetch || !_handleContention(tryCount, (stream == nullptr))) {
-                break;
-            }
+            _allocationWaiters.leave(waiter, (seg != nullptr));
+        }
+
+        if (seg != nullptr) {
+            _prepareSegment(seg->id, stream, sequenceNumber);
 
-            tryCount++;
+            LogMem("Allocated segment %d from buffer %s <try: %d, %s>",
+                   seg->id, bufferIdToString(getId()).c_str(), tryCount,
+                   _getRequestString(stream, sequenceNumber, location, flags).c_str());
         }
 
         return seg;
@@ -435,25 +630,11 @@ namespace SimuTrace
         assert(IsSet(segment.flags, SegmentFlags::SgfInUse));
         assert(IsSet(segment.flags, SegmentFlags::SgfReadOnly));
         assert(IsSet(segment.flags, SegmentFlags::SgfCacheable));
-        assert(segment.next != nullptr);
-        assert(segment.prev != nullptr);
-        assert(_standbyHead != nullptr);
-
-        if (segment.next == &segment) {
-            assert(_standbyHead == &segment);
-            _standbyHead = nullptr;
-        } else {
-            segment.prev->next = segment.next;
-            segment.next->prev = segment.prev;
+        assert(segment.next == nullptr);
 
-            if (&segment == _standbyHead) {
-                _standbyHead = segment.next;
-            }
-        }
+        _standbyPolicy->remove(segment.id);
 
         segment.isSubmitted = false;
-        segment.next = nullptr;
-        segment.prev = nullptr;
     }
 
     void ServerStreamBuffer::_enqueueToStandbyList(Segment& segment)
@@ -463,45 +644,54 @@ namespace SimuTrace
         assert(IsSet(segment.flags, SegmentFlags::SgfReadOnly));
         assert(IsSet(segment.flags, SegmentFlags::SgfCacheable));
         assert(segment.next == nullptr);
-        assert(segment.prev == nullptr);
 
-        if (_standbyHead == nullptr) {
-            segment.next = &segment;
-            segment.prev = &segment;
+        int hints = StandbyHints::ShNone;
+        if (IsSet(segment.flags, SegmentFlags::SgfLowPriority)) {
+            hints |= StandbyHints::ShLowPriority;
+        }
 
-            _standbyHead = &segment;
-        } else {
-            segment.next = _standbyHead;
-            segment.prev = _standbyHead->prev;
+        if (IsSet(segment.flags, SegmentFlags::SgfPrefetch)) {
+            hints |= StandbyHints::ShPrefetch;
+        }
 
-            _standbyHead->prev->next = &segment;
-            _standbyHead->prev = &segment;
+        if (IsSet(segment.flags, SegmentFlags::SgfReferenced)) {
+            hints |= StandbyHints::ShReferenced;
+        }
 
-            if ((!IsSet(segment.flags, SegmentFlags::SgfLowPriority)) ||
-                (IsSet(segment.flags, SegmentFlags::SgfPrefetch))) {
+        assert(segment.stream != nullptr);
+        StoreStreamSegmentLink link(segment.stream->getStore().getId(),
+                                    segment.control.link);
 
-                // Set the segment to be the head of the list. This way it
-                // won't be chosen as victim the next time.
-                _standbyHead = &segment;
+        _standbyPolicy->insert(segment.id, LinkHash()(link),
+                               static_cast<StandbyHints>(hints));
+    }
 
-                segment.flags = static_cast<SegmentFlags>(
-                    segment.flags & ~SegmentFlags::SgfPrefetch);
-            }
-        }
+    ServerStreamBuffer::StandbyShard& ServerStreamBuffer::_getStandbyShard(
+        const StoreStreamSegmentLink& link) const
+    {
+        // The link hash places the store in the low bits. We mix the hash,
+        // so the segments of a store spread over all shards.
+        uint64_t hash = static_cast<uint64_t>(LinkHash()(link));
+        hash *= 0x9E3779B97F4A7C15ull;
+
+        return _standbyShards[(hash >> 32) % _numStandbyShards];
     }
 
     Segment* ServerStreamBuffer::_findStandbySegment(
         StoreStreamSegmentLink& link, bool erase)
     {
-        auto it = _standbyIndex.find(link);
-        if (it == _standbyIndex.end()) {
+        StandbyShard& shard = _getStandbyShard(link);
+        LockScope(shard.lock);
+
+        auto it = shard.index.find(link);
+        if (it == shard.index.end()) {
             return nullptr;
         }
 
         Segment* seg = it->second;
 
         if (erase) {
-            _standbyIndex.erase(it);
+            shard.index.erase(it);
         }
 
         return seg;
@@ -510,19 +700,17 @@ namespace SimuTrace
     Segment* ServerStreamBuffer::_evictFromStandbyList()
     {
         Segment* seg = nullptr;
-        if (_standbyHead != nullptr) {
-            LockScope(_standbyLock);
+        if (_standbyPolicy->getSize() > 0) {
+            StandbyLockScope lock(*this);
 
-            // Someone might drained the standby list in the meantime.
-            if (_standbyHead == nullptr) {
+            // Ask the policy for the victim. Someone might drained the
+            // standby list in the meantime.
+            SegmentId victim = _standbyPolicy->evict();
+            if (victim == INVALID_SEGMENT_ID) {
                 return nullptr;
             }
 
-            // We have a circular doubly-linked list. The prev element points
-            // to the last element in the list, i.e., the least recently used
-            // element.
-            seg = _standbyHead->prev;
-            assert(seg != nullptr);
+            seg = &_segments[victim];
 
             _notifyEncoderCacheClosed(*seg);
 
@@ -535,11 +723,11 @@ namespace SimuTrace
             assert(fseg == seg);
             (void)fseg; // Make compiler happy in release build
 
-            // Remove the segment from the LRU list
-            _dequeueFromStandbyList(*seg);
-
             // Reset segment flags
+            seg->isSubmitted = false;
             seg->flags = SegmentFlags::SgfInUse;
+
+            _standbyStats.evictions++;
         }
 
         return seg;
@@ -548,20 +736,43 @@ namespace SimuTrace
     Segment* ServerStreamBuffer::_removeStandbySegment(
         StoreStreamSegmentLink& link)
     {
-        LockScope(_standbyLock);
+        // Most lookups miss when the cache is busy with new data. Only take
+        // the standby lock if the index has the segment.
+        if (_findStandbySegment(link, false) == nullptr) {
+            Interlocked::interlockedAdd(&_standbyStats.misses, 1);
 
-        // Search the element in the hash map
+            return nullptr;
+        }
+
+        StandbyLockScope lock(*this);
+
+        // The segment might have been evicted in the meantime
         Segment* seg = _findStandbySegment(link, true);
-        if (seg != nullptr) {
-            _dequeueFromStandbyList(*seg);
+        if (seg == nullptr) {
+            Interlocked::interlockedAdd(&_standbyStats.misses, 1);
+
+            return nullptr;
+        }
+
+        _dequeueFromStandbyList(*seg);
+
+        // A read ahead segment is used for the first time. Only further uses
+        // mark the segment as part of the working set.
+        if (IsSet(seg->flags, SegmentFlags::SgfPrefetch)) {
+            seg->flags = static_cast<SegmentFlags>(
+                seg->flags & ~SegmentFlags::SgfPrefetch);
+        } else {
+            seg->flags = seg->flags | SegmentFlags::SgfReferenced;
         }
 
+        Interlocked::interlockedAdd(&_standbyStats.hits, 1);
+
         return seg;
     }
 
     void ServerStreamBuffer::_addStandbySegment(Segment& segment)
     {
-        LockScope(_standbyLock);
+        StandbyLockScope lock(*this);
 
         assert(segment.stream != nullptr);
         StoreId store = segment.stream->getStore().getId();
@@ -573,11 +784,20 @@ namespace SimuTrace
 
         // If the same segment has been requested multiple times, we keep
         // only a single copy on the standby list.
-        if (_findStandbySegment(link, false)) {
-            _purgeSegment(segment.id);
-        } else {
-            _standbyIndex[link] = &segment;
+        bool added;
+        StandbyShard& shard = _getStandbyShard(link);
+        Lock(shard.lock); {
+            added = shard.index.insert(std::make_pair(link, &segment)).second;
+        } Unlock();
+
+        if (added) {
             _enqueueToStandbyList(segment);
+
+            if (_allocationWaiters.hasWaiters()) {
+                _allocationWaiters.notify();
+            }
+        } else {
+            _purgeSegment(segment.id);
         }
     }
 
@@ -660,7 +880,6 @@ namespace SimuTrace
         assert(!IsSet(seg.flags, SegmentFlags::SgfScratch));
         assert(IsSet(seg.flags, SegmentFlags::SgfInUse));
         assert(seg.next == nullptr);
-        assert(seg.prev == nullptr);
 
         assert(seg.stream != nullptr);
         assert(seg.sequenceNumber != INVALID_STREAM_SEGMENT_ID);
@@ -1143,20 +1362,18 @@ namespace SimuTrace
 
     void ServerStreamBuffer::flushStandbyList(StoreId store)
     {
-        LockScope(_standbyLock);
+        StandbyLockScope lock(*this);
 
-        if (_standbyHead == nullptr) {
+        if (_standbyPolicy->getSize() == 0) {
             return;
         }
 
-        // We have a circular doubly-linked list. The prev element points
-        // to the last element in the list
-        Segment* end = _standbyHead->prev;
+        for (uint32_t i = 0; i < getNumSegments(); ++i) {
+            if (!_standbyPolicy->contains(i)) {
+                continue;
+            }
 
-        Segment* seg = _standbyHead;
-        do {
-            assert(seg != nullptr);
-            Segment* nseg = seg->next;
+            Segment* seg = &_segments[i];
 
             assert(seg->stream != nullptr);
             StoreId streamStore = seg->stream->getStore().getId();
@@ -1178,22 +1395,15 @@ namespace SimuTrace
                        seg->stream->getId(),
                        seg->sequenceNumber);
 
-                // Remove the segment from the LRU list and purge it
+                // Remove the segment from the standby list and purge it
                 _dequeueFromStandbyList(*seg);
 
                 _purgeSegment(seg->id);
             }
-
-            if (seg == end) {
-                break;
-            }
-
-            // Move to the next segment
-            seg = nseg;
-        } while (true);
+        }
 
         assert((store != INVALID_STORE_ID) ||
-               ((_standbyHead == nullptr) && (_standbyIndex.empty())));
+               (_standbyPolicy->getSize() == 0));
     }
 
     SegmentControlElement* ServerStreamBuffer::getControlElement(
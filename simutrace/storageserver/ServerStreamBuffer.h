@@ -24,6 +24,9 @@
 #include "SimuStor.h"
 #include "WorkItem.h"
 
+#include "AllocationWaitQueue.h"
+#include "StandbyPolicy.h"
+
 namespace SimuTrace
 {
 
@@ -88,22 +91,84 @@ namespace SimuTrace
         typedef std::unordered_map<StoreStreamSegmentLink, Segment*, LinkHash>
             StandbyIndex;
 
+        // Part of the standby index. Lookups of segments, which are not
+        // cached, only need the lock of the respective shard.
+        struct StandbyShard
+        {
+            CriticalSection lock;
+            StandbyIndex index;
+        };
+
+        struct StandbyStatistics
+        {
+            volatile uint64_t hits;
+            volatile uint64_t misses;
+            uint64_t evictions;
+
+            // Time in ns the standby lock has been held
+            uint64_t lockTicks;
+            uint64_t lockCount;
+
+            StandbyStatistics() :
+                hits(0),
+                misses(0),
+                evictions(0),
+                lockTicks(0),
+                lockCount(0) { }
+        };
+
+        // Acquires the standby lock and accounts the time it is held
+        class StandbyLockScope;
+
+        static const uint32_t _numStandbyShards = 16;
+
+        // Free list of the segments that belong to a single NUMA node
+        struct NodeFreeList
+        {
+            // Singly-linked lock-free stack
+            std::atomic<Segment*> head;
+            uint32_t numSegments;
+
+            // Allocations requested on this node that could be served from
+            // the node's own list or only from another node's list.
+            volatile uint64_t localAllocations;
+            volatile uint64_t remoteAllocations;
+
+            NodeFreeList() :
+                head(nullptr),
+                numSegments(0),
+                localAllocations(0),
+                remoteAllocations(0) { }
+        };
+
     private:
         DISABLE_COPY(ServerStreamBuffer);
 
         uint64_t _cookie;
         Segment* _segments;
 
-        // Free list - singly-linked lock-free stack
-        std::atomic<Segment*> _freeHead;
+        // Free lists - one per NUMA node (see server.memmgmt.numa)
+        uint32_t _numNodes;
+        std::unique_ptr<NodeFreeList[]> _freeLists;
+
+        // Requests waiting for a segment to be freed. A request waits at
+        // most _retryCount times _retrySleep ms.
+        AllocationWaitQueue _allocationWaiters;
+        uint32_t _retryCount;
+        uint32_t _retrySleep;
 
-        // LRU Standby list - circular doubly-linked list + hash map
+        // Standby list - replacement policy + sharded hash map. The lock
+        // order is: _standbyLock before the lock of a shard.
         bool _enableCache;
         CriticalSection _standbyLock;
-        StandbyIndex _standbyIndex;
-        Segment* _standbyHead;
+        std::unique_ptr<StandbyPolicy> _standbyPolicy;
+        std::unique_ptr<StandbyShard[]> _standbyShards;
+        StandbyStatistics _standbyStats;
 
         void _initializeSegments();
+        uint32_t _getSegmentNode(SegmentId segment) const;
+        void _bindSegmentsToNode(uint32_t node, SegmentId first,
+                                 SegmentId last);
 
         uint64_t _computeControlCookie(SegmentControlElement& control,
                                        Segment& segment) const;
@@ -112,13 +177,15 @@ namespace SimuTrace
         void _notifyEncoderCacheClosed(Segment& segment) const;
 
         // Free List -----
-        Segment* _dequeueFromFreeList();
+        Segment* _dequeueFromFreeList(uint32_t node);
         void _enqueueToFreeList(Segment& segment);
 
         void _prepareSegment(SegmentId segment, ServerStream* stream,
                              StreamSegmentId sequenceNumber);
         bool _handleContention(uint32_t tryCount, bool isScratch);
 
+        Segment* _allocateSegment(uint32_t node);
+
         Segment* _tryAllocateFreeSegment(ServerStream* stream,
                                          StreamSegmentId sequenceNumber,
                                          StorageLocation* location,
@@ -129,6 +196,7 @@ namespace SimuTrace
         void _dequeueFromStandbyList(Segment& segment);
         void _enqueueToStandbyList(Segment& segment);
 
+        StandbyShard& _getStandbyShard(const StoreStreamSegmentLink& link) const;
         Segment* _findStandbySegment(StoreStreamSegmentLink& link, bool erase);
         Segment* _evictFromStandbyList();
 
@@ -0,0 +1,347 @@
+/*
+ * Copyright 2015 (C) Karlsruhe Institute of Technology (KIT)
+ * Marc Rittinghaus
+ *
+ * Simutrace Storage Server (storageserver) is part of Simutrace.
+ *
+ * storageserver is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * storageserver is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with storageserver. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "SimuStor.h"
+
+#include "StandbyPolicy.h"
+
+namespace SimuTrace
+{
+
+    //
+    // SegmentList
+    //
+
+    StandbyPolicy::SegmentList::SegmentList() :
+        _head(INVALID_SEGMENT_ID),
+        _tail(INVALID_SEGMENT_ID),
+        _size(0)
+    {
+
+    }
+
+    void StandbyPolicy::SegmentList::pushFront(SegmentId segment,
+                                               SegmentId* next,
+                                               SegmentId* prev)
+    {
+        next[segment] = _head;
+        prev[segment] = INVALID_SEGMENT_ID;
+
+        if (_head != INVALID_SEGMENT_ID) {
+            prev[_head] = segment;
+        } else {
+            _tail = segment;
+        }
+
+        _head = segment;
+        _size++;
+    }
+
+    void StandbyPolicy::SegmentList::pushBack(SegmentId segment,
+                                              SegmentId* next,
+                                              SegmentId* prev)
+    {
+        next[segment] = INVALID_SEGMENT_ID;
+        prev[segment] = _tail;
+
+        if (_tail != INVALID_SEGMENT_ID) {
+            next[_tail] = segment;
+        } else {
+            _head = segment;
+        }
+
+        _tail = segment;
+        _size++;
+    }
+
+    void StandbyPolicy::SegmentList::remove(SegmentId segment,
+                                            SegmentId* next,
+                                            SegmentId* prev)
+    {
+        assert(_size > 0);
+
+        if (prev[segment] != INVALID_SEGMENT_ID) {
+            next[prev[segment]] = next[segment];
+        } else {
+            assert(_head == segment);
+            _head = next[segment];
+        }
+
+        if (next[segment] != INVALID_SEGMENT_ID) {
+            prev[next[segment]] = prev[segment];
+        } else {
+            assert(_tail == segment);
+            _tail = prev[segment];
+        }
+
+        next[segment] = INVALID_SEGMENT_ID;
+        prev[segment] = INVALID_SEGMENT_ID;
+        _size--;
+    }
+
+    //
+    // StandbyPolicy
+    //
+
+    StandbyPolicy::StandbyPolicy(const std::string& name, uint32_t capacity) :
+        _name(name),
+        _capacity(capacity),
+        _next(new SegmentId[capacity]),
+        _prev(new SegmentId[capacity])
+    {
+        for (uint32_t i = 0; i < capacity; ++i) {
+            _next[i] = INVALID_SEGMENT_ID;
+            _prev[i] = INVALID_SEGMENT_ID;
+        }
+    }
+
+    StandbyPolicy::~StandbyPolicy()
+    {
+
+    }
+
+    const std::string& StandbyPolicy::getName() const
+    {
+        return _name;
+    }
+
+    std::unique_ptr<StandbyPolicy> StandbyPolicy::create(
+        const std::string& name, uint32_t capacity)
+    {
+        std::unique_ptr<StandbyPolicy> policy;
+
+        if (name.compare("lru") == 0) {
+            policy = std::unique_ptr<StandbyPolicy>(
+                new LruStandbyPolicy(capacity));
+        } else if (name.compare("2q") == 0) {
+            policy = std::unique_ptr<StandbyPolicy>(
+                new TwoQueueStandbyPolicy(capacity));
+        }
+
+        return policy;
+    }
+
+    //
+    // LruStandbyPolicy
+    //
+
+    LruStandbyPolicy::LruStandbyPolicy(uint32_t capacity) :
+        StandbyPolicy("lru", capacity),
+        _list(),
+        _cached(new bool[capacity])
+    {
+        std::fill(&_cached[0], &_cached[capacity], false);
+    }
+
+    LruStandbyPolicy::~LruStandbyPolicy()
+    {
+
+    }
+
+    void LruStandbyPolicy::insert(SegmentId segment, uint64_t key,
+                                  StandbyHints hints)
+    {
+        assert(segment < _capacity);
+        assert(!_cached[segment]);
+
+        // Low priority segments become the next victims. A prefetched
+        // segment must have the chance to be used at least once, though.
+        if (IsSet(hints, StandbyHints::ShLowPriority) &&
+            !IsSet(hints, StandbyHints::ShPrefetch)) {
+            _list.pushBack(segment, _next.get(), _prev.get());
+        } else {
+            _list.pushFront(segment, _next.get(), _prev.get());
+        }
+
+        _cached[segment] = true;
+    }
+
+    void LruStandbyPolicy::remove(SegmentId segment)
+    {
+        assert(segment < _capacity);
+        assert(_cached[segment]);
+
+        _list.remove(segment, _next.get(), _prev.get());
+        _cached[segment] = false;
+    }
+
+    SegmentId LruStandbyPolicy::evict()
+    {
+        SegmentId victim = _list.getTail();
+
+        if (victim != INVALID_SEGMENT_ID) {
+            remove(victim);
+        }
+
+        return victim;
+    }
+
+    bool LruStandbyPolicy::contains(SegmentId segment) const
+    {
+        assert(segment < _capacity);
+
+        return _cached[segment];
+    }
+
+    uint32_t LruStandbyPolicy::getSize() const
+    {
+        return _list.getSize();
+    }
+
+    //
+    // TwoQueueStandbyPolicy
+    //
+
+    TwoQueueStandbyPolicy::TwoQueueStandbyPolicy(uint32_t capacity) :
+        StandbyPolicy("2q", capacity),
+        _in(),
+        _main(),
+        _queue(new Queue[capacity]),
+        _keys(new uint64_t[capacity]),
+        _inSize(std::max(capacity / 4, 1u)),
+        _ghostSize(std::max(capacity / 2, 1u)),
+        _ghosts(),
+        _ghostIndex()
+    {
+        // The queue sizes follow the recommendation of the 2Q paper:
+        // A1in holds 25% of the cache, A1out remembers 50% of the cache.
+        std::fill(&_queue[0], &_queue[capacity], Queue::QNone);
+    }
+
+    TwoQueueStandbyPolicy::~TwoQueueStandbyPolicy()
+    {
+
+    }
+
+    bool TwoQueueStandbyPolicy::_takeGhost(uint64_t key)
+    {
+        auto it = _ghostIndex.find(key);
+        if (it == _ghostIndex.end()) {
+            return false;
+        }
+
+        // We leave the key in the FIFO. It will be dropped when it reaches
+        // the end of the queue.
+        if (--it->second == 0) {
+            _ghostIndex.erase(it);
+        }
+
+        return true;
+    }
+
+    void TwoQueueStandbyPolicy::_addGhost(uint64_t key)
+    {
+        _ghosts.push_back(key);
+        _ghostIndex[key]++;
+
+        while (_ghosts.size() > _ghostSize) {
+            auto it = _ghostIndex.find(_ghosts.front());
+            if ((it != _ghostIndex.end()) && (--it->second == 0)) {
+                _ghostIndex.erase(it);
+            }
+
+            _ghosts.pop_front();
+        }
+    }
+
+    void TwoQueueStandbyPolicy::insert(SegmentId segment, uint64_t key,
+                                       StandbyHints hints)
+    {
+        assert(segment < _capacity);
+        assert(_queue[segment] == Queue::QNone);
+
+        _keys[segment] = key;
+
+        // Segments, which are used a second time, belong to the working set.
+        if (IsSet(hints, StandbyHints::ShReferenced) || _takeGhost(key)) {
+            _main.pushFront(segment, _next.get(), _prev.get());
+            _queue[segment] = Queue::QMain;
+
+            return;
+        }
+
+        if (IsSet(hints, StandbyHints::ShLowPriority) &&
+            !IsSet(hints, StandbyHints::ShPrefetch)) {
+            _in.pushBack(segment, _next.get(), _prev.get());
+        } else {
+            _in.pushFront(segment, _next.get(), _prev.get());
+        }
+
+        _queue[segment] = Queue::QIn;
+    }
+
+    void TwoQueueStandbyPolicy::remove(SegmentId segment)
+    {
+        assert(segment < _capacity);
+
+        switch (_queue[segment]) {
+            case Queue::QIn: {
+                _in.remove(segment, _next.get(), _prev.get());
+                break;
+            }
+
+            case Queue::QMain: {
+                _main.remove(segment, _next.get(), _prev.get());
+                break;
+            }
+
+            default: {
+                assert(false);
+                return;
+            }
+        }
+
+        _queue[segment] = Queue::QNone;
+    }
+
+    SegmentId TwoQueueStandbyPolicy::evict()
+    {
+        SegmentId victim;
+
+        // Prefer segments, which have been used only once, as long as they
+        // occupy more than their share of the cache.
+        if ((_in.getSize() > _inSize) ||
+            ((_main.getSize() == 0) && (_in.getSize() > 0))) {
+
+            victim = _in.getTail();
+            _addGhost(_keys[victim]);
+        } else {
+            victim = _main.getTail();
+        }
+
+        if (victim != INVALID_SEGMENT_ID) {
+            remove(victim);
+        }
+
+        return victim;
+    }
+
+    bool TwoQueueStandbyPolicy::contains(SegmentId segment) const
+    {
+        assert(segment < _capacity);
+
+        return (_queue[segment] != Queue::QNone);
+    }
+
+    uint32_t TwoQueueStandbyPolicy::getSize() const
+    {
+        return _in.getSize() + _main.getSize();
+    }
+
+}
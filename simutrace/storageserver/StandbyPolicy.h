@@ -0,0 +1,177 @@
+/*
+ * Copyright 2015 (C) Karlsruhe Institute of Technology (KIT)
+ * Marc Rittinghaus
+ *
+ * Simutrace Storage Server (storageserver) is part of Simutrace.
+ *
+ * storageserver is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * storageserver is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with storageserver. If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#ifndef STANDBY_POLICY_H
+#define STANDBY_POLICY_H
+
+#include "SimuStor.h"
+
+namespace SimuTrace
+{
+
+    enum StandbyHints {
+        ShNone        = 0,
+        ShLowPriority = 1 << 0, // Segment may be reused early
+        ShPrefetch    = 1 << 1, // Segment has been read ahead and not yet
+                                // been used
+        ShReferenced  = 1 << 2  // Segment has been served from the cache
+                                // before
+    };
+
+    //
+    // Replacement policy of the standby list (i.e., segment cache) in a
+    // ServerStreamBuffer. The policy only orders the segments, which are
+    // identified by their id in the buffer. Looking up cached segments is
+    // up to the buffer. Each segment carries a key (a hash of the segment's
+    // link), which policies may use to recognize segments that have
+    // recently been evicted. Policies are not synchronized.
+    //
+    class StandbyPolicy
+    {
+    protected:
+        // Intrusive doubly-linked list over the segment ids. The links are
+        // stored in arrays of the policy, indexed by the segment id.
+        class SegmentList
+        {
+        private:
+            SegmentId _head; // most recently inserted
+            SegmentId _tail; // next victim
+            uint32_t _size;
+
+        public:
+            SegmentList();
+
+            void pushFront(SegmentId segment, SegmentId* next, SegmentId* prev);
+            void pushBack(SegmentId segment, SegmentId* next, SegmentId* prev);
+            void remove(SegmentId segment, SegmentId* next, SegmentId* prev);
+
+            SegmentId getTail() const { return _tail; }
+            uint32_t getSize() const { return _size; }
+        };
+
+    private:
+        DISABLE_COPY(StandbyPolicy);
+
+        const std::string _name;
+
+    protected:
+        const uint32_t _capacity;
+
+        std::unique_ptr<SegmentId[]> _next;
+        std::unique_ptr<SegmentId[]> _prev;
+
+        StandbyPolicy(const std::string& name, uint32_t capacity);
+    public:
+        virtual ~StandbyPolicy();
+
+        // Adds the segment to the standby list
+        virtual void insert(SegmentId segment, uint64_t key,
+                            StandbyHints hints) = 0;
+
+        // Removes the segment from the standby list (e.g., on a cache hit)
+        virtual void remove(SegmentId segment) = 0;
+
+        // Removes and returns the next victim or INVALID_SEGMENT_ID, if the
+        // standby list is empty.
+        virtual SegmentId evict() = 0;
+
+        virtual bool contains(SegmentId segment) const = 0;
+        virtual uint32_t getSize() const = 0;
+
+        const std::string& getName() const;
+
+        // Returns a new policy for a buffer with the given number of segments
+        // or nullptr, if the name is unknown. Valid names are "lru" and "2q".
+        static std::unique_ptr<StandbyPolicy> create(const std::string& name,
+                                                     uint32_t capacity);
+    };
+
+    //
+    // Least recently used. Low priority segments are inserted as next
+    // victims unless they have been prefetched and not yet been used.
+    //
+    class LruStandbyPolicy :
+        public StandbyPolicy
+    {
+    private:
+        SegmentList _list;
+        std::unique_ptr<bool[]> _cached;
+
+    public:
+        LruStandbyPolicy(uint32_t capacity);
+        virtual ~LruStandbyPolicy() override;
+
+        virtual void insert(SegmentId segment, uint64_t key,
+                            StandbyHints hints) override;
+        virtual void remove(SegmentId segment) override;
+        virtual SegmentId evict() override;
+
+        virtual bool contains(SegmentId segment) const override;
+        virtual uint32_t getSize() const override;
+    };
+
+    //
+    // Scan-resistant 2Q policy (Johnson and Shasha, VLDB 1994). Segments
+    // enter a FIFO queue (A1in) when they are cached for the first time.
+    // Only segments, which are served from the cache again or which return
+    // shortly after their eviction from A1in (remembered by key in the ghost
+    // queue A1out), move to the LRU queue (Am). A long sequential scan thus
+    // only cycles through A1in and does not evict the working set in Am.
+    //
+    class TwoQueueStandbyPolicy :
+        public StandbyPolicy
+    {
+    private:
+        enum Queue : uint8_t {
+            QNone = 0,
+            QIn,
+            QMain
+        };
+
+        SegmentList _in;
+        SegmentList _main;
+        std::unique_ptr<Queue[]> _queue;
+        std::unique_ptr<uint64_t[]> _keys;
+
+        // Target size of A1in and maximum size of A1out
+        uint32_t _inSize;
+        uint32_t _ghostSize;
+
+        std::deque<uint64_t> _ghosts;
+        std::unordered_map<uint64_t, uint32_t> _ghostIndex;
+
+        bool _takeGhost(uint64_t key);
+        void _addGhost(uint64_t key);
+    public:
+        TwoQueueStandbyPolicy(uint32_t capacity);
+        virtual ~TwoQueueStandbyPolicy() override;
+
+        virtual void insert(SegmentId segment, uint64_t key,
+                            StandbyHints hints) override;
+        virtual void remove(SegmentId segment) override;
+        virtual SegmentId evict() override;
+
+        virtual bool contains(SegmentId segment) const override;
+        virtual uint32_t getSize() const override;
+    };
+
+}
+
+#endif
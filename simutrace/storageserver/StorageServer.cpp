@@ -84,6 +84,7 @@ namespace SimuTrace
         _bindings(),
         _requestPool(nullptr),
         _workerPool(nullptr),
+        _ioPool(nullptr),
         _memoryPool(nullptr),
         _sessionManager(nullptr),
         _storeManager(nullptr),
@@ -507,6 +508,24 @@ namespace SimuTrace
         //_workerPool->setPoolPriority(1);
     #endif
 
+        // Create the I/O pool, which writes encoded frames to disk so the
+        // processing workers do not block on the disk.
+        int ioworkers = Configuration::get<int>("server.iopool.size");
+        if (ioworkers > 0) {
+            _ioPool = std::unique_ptr<WorkerPool>(
+                new WorkerPool(ioworkers, _environment));
+
+            LogInfo("Created %d server I/O worker threads.",
+                    _ioPool->getWorkerCount());
+        }
+
+        if (Configuration::get<bool>("server.memmgmt.numa")) {
+            uint32_t nodes = _workerPool->bindToNumaNodes();
+
+            LogInfo("Distributed processing worker threads across %d NUMA "
+                    "node(s).", nodes);
+        }
+
         // Create memory pool
         uint32_t nseg;
         _determineMemoryPoolConfiguration(nseg);
@@ -626,6 +645,15 @@ namespace SimuTrace
             _workerPool = nullptr;
         }
 
+        // The processing workers are gone, so no new frames can be handed
+        // over to the I/O pool.
+        if (_ioPool != nullptr) {
+            assert(_ioPool->getQueueLength() == 0);
+            _ioPool->close();
+
+            _ioPool = nullptr;
+        }
+
         // All stores should be closed by now, because all sessions are closed.
         // Hence, we can free the store manager.
         if (_storeManager != nullptr) {
@@ -799,6 +827,11 @@ namespace SimuTrace
 
         uint16_t ver = static_cast<uint16_t>(msg.parameter0);
 
+        _negotiateCompression(request.getServerPort(),
+            RpcApi::getCompressionOffer(msg.embedded.parameter1));
+        _negotiateCommandRing(request.getServerPort(),
+                              msg.embedded.parameter1);
+
         server._sessionManager->createSession(request.getPort(), ver);
     }
 
@@ -810,6 +843,11 @@ namespace SimuTrace
         uint16_t ver = static_cast<uint16_t>(msg.parameter0);
         SessionId localId = static_cast<SessionId>(msg.embedded.parameter1);
 
+        _negotiateCompression(request.getServerPort(),
+            RpcApi::getCompressionOffer(msg.embedded.parameter1));
+        _negotiateCommandRing(request.getServerPort(),
+                              msg.embedded.parameter1);
+
         server._sessionManager->openLocalSession(localId, request.getPort(), ver);
     }
 
@@ -820,6 +858,80 @@ namespace SimuTrace
         Throw(NotImplementedException);
     }
 
+    void StorageServer::_negotiateCompression(ServerPort& port,
+                                              uint32_t offer)
+    {
+        // Connections with shared memory do not transfer segments at all.
+        // The session worker returns the selection to the client.
+        if ((offer == 0) ||
+            IsSet(port.getChannelCaps(), ChannelCapabilities::CCapHandleTransfer)) {
+            return;
+        }
+
+        std::string codecName = Configuration::get<std::string>(
+            "server.network.codec");
+
+        const Compression::Codec* codec = Compression::findCodec(codecName);
+        ThrowOnNull(codec, ConfigurationException, stringFormat(
+                    "Unknown compression codec '%s' specified in "
+                    "server.network.codec.", codecName.c_str()));
+
+        if (codec->id == Compression::CiNone) {
+            return;
+        } else if (!IsSet(offer, 1 << codec->id)) {
+            LogWarn("<client: %s> The client does not support compression "
+                    "codec '%s'. Transferring data uncompressed.",
+                    port.getAddress().c_str(), codec->name);
+
+            return;
+        }
+
+        int level = Configuration::get<int>("server.network.codecLevel");
+        uint32_t codecLevel = (level < 0) ? codec->defaultLevel :
+            std::min(static_cast<uint32_t>(level), codec->maxLevel);
+
+        int bufferSize = Configuration::get<int>(
+            "server.network.codecBufferSize");
+        ThrowOn(bufferSize < 0, ConfigurationException,
+                "The compression buffer size (server.network.codecBufferSize) "
+                "must not be negative.");
+
+        port.setCompression(codec->id, codecLevel);
+        port.setCompressionBufferLimit(static_cast<size_t>(bufferSize) MiB);
+
+        LogDebug("<client: %s> Compressing transferred data with codec "
+                 "'%s' (level %d).", port.getAddress().c_str(), codec->name,
+                 codecLevel);
+    }
+
+    void StorageServer::_negotiateCommandRing(ServerPort& port,
+                                              uint64_t parameter1)
+    {
+        if (!RpcApi::hasCommandRingOffer(parameter1) ||
+            !IsSet(port.getChannelCaps(), ChannelCapabilities::CCapCommandRing)) {
+            return;
+        }
+
+        int size = Configuration::get<int>("server.network.commandRingSize");
+        if (size <= 0) {
+            return;
+        }
+
+        // The capacity must be a power of 2
+        uint32_t capacity = COMMAND_RING_MIN_CAPACITY;
+        while ((capacity < static_cast<uint32_t>(size) KiB) &&
+               (capacity < COMMAND_RING_MAX_CAPACITY)) {
+            capacity <<= 1;
+        }
+
+        // The session worker sends the ring to the client and enables it
+        std::unique_ptr<CommandRing> ring(new CommandRing(capacity));
+        port.setCommandRing(ring);
+
+        LogDebug("<client: %s> Created command ring with %d KiB per "
+                 "direction.", port.getAddress().c_str(), capacity >> 10);
+    }
+
     void StorageServer::_processRequest(Request& request)
     {
          // -- This method is called in the context of a worker thread --
@@ -945,6 +1057,11 @@ namespace SimuTrace
         return *_workerPool;
     }
 
+    WorkerPool* StorageServer::getIoPool()
+    {
+        return _ioPool.get();
+    }
+
     ServerStreamBuffer& StorageServer::getMemoryPool()
     {
         return *_memoryPool;
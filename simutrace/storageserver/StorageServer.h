@@ -51,6 +51,7 @@ namespace SimuTrace
         std::unique_ptr<WorkerPool> _requestPool;
 
         std::unique_ptr<WorkerPool> _workerPool;
+        std::unique_ptr<WorkerPool> _ioPool;
         std::unique_ptr<ServerStreamBuffer> _memoryPool;
 
         std::unique_ptr<ServerSessionManager> _sessionManager;
@@ -102,11 +103,15 @@ namespace SimuTrace
         static void _handleSessionOpen(Request& request, Message& msg);
         static void _handleSessionQuery(Request& request, Message& msg);
 
+        static void _negotiateCompression(ServerPort& port, uint32_t offer);
+        static void _negotiateCommandRing(ServerPort& port, uint64_t parameter1);
+
         static void _processRequest(Request& request);
 
         static int _bindingThreadMain(Thread<Binding*>& thread);
     public:
         WorkerPool& getWorkerPool();
+        WorkerPool* getIoPool();
         ServerStreamBuffer& getMemoryPool();
         ServerSessionManager& getSessionManager();
         ServerStoreManager& getStoreManager();
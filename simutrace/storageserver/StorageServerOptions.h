@@ -131,6 +131,45 @@ namespace Options
                     OPT_SHORT_PREFIX "b",
                     OPT_LONG_PREFIX "server.bindings");
 
+        typeMap["server.network.codec"] = libconfig::Setting::Type::TypeString;
+        options.add("none",
+                    false,
+                    1,
+                    0,
+                    "Compression codec for segments transferred to and from "
+                    "clients without shared memory (e.g., socket bindings). "
+                    "Valid values are 'lz4', 'lzma', and 'none'.",
+                    OPT_LONG_PREFIX "server.network.codec");
+
+        typeMap["server.network.codecLevel"] = libconfig::Setting::Type::TypeInt;
+        options.add("-1",
+                    false,
+                    1,
+                    0,
+                    "Compression level for the transfer codec. Use -1 for "
+                    "the codec's default level.",
+                    OPT_LONG_PREFIX "server.network.codecLevel");
+
+        typeMap["server.network.codecBufferSize"] = libconfig::Setting::Type::TypeInt;
+        options.add("64",
+                    false,
+                    1,
+                    0,
+                    "Size in MiB of the largest segment that is compressed "
+                    "for transfer. Each connection keeps a compression "
+                    "buffer of up to this size.",
+                    OPT_LONG_PREFIX "server.network.codecBufferSize");
+
+        typeMap["server.network.commandRingSize"] = libconfig::Setting::Type::TypeInt;
+        options.add("64",
+                    false,
+                    1,
+                    0,
+                    "Size in KiB per direction of the shared memory command "
+                    "ring for clients connected through a local binding. "
+                    "A value of 0 disables command rings.",
+                    OPT_LONG_PREFIX "server.network.commandRingSize");
+
         //
         // Memory Management
         //
@@ -154,6 +193,26 @@ namespace Options
                     "segments to be evicted.",
                     OPT_LONG_PREFIX "server.memmgmt.disableCache");
 
+        typeMap["server.memmgmt.cachePolicy"] = libconfig::Setting::Type::TypeString;
+        options.add("2q",
+                    false,
+                    1,
+                    0,
+                    "Replacement policy of the segment cache. Valid values "
+                    "are 'lru' and '2q' (scan-resistant).",
+                    OPT_LONG_PREFIX "server.memmgmt.cachePolicy");
+
+        typeMap["server.memmgmt.numa"] = libconfig::Setting::Type::TypeBoolean;
+        options.add("",
+                    false,
+                    0,
+                    0,
+                    "Splits stream buffers into one part per NUMA node and "
+                    "pins the processing workers to the nodes. Segments are "
+                    "preferably allocated from the node of the requesting "
+                    "thread.",
+                    OPT_LONG_PREFIX "server.memmgmt.numa");
+
         typeMap["server.memmgmt.retryCount"] = libconfig::Setting::Type::TypeInt;
         options.add("100",
                     false,
@@ -170,8 +229,10 @@ namespace Options
                     1,
                     0,
                     "The number of milliseconds the memory management waits "
-                    "between successive allocation retries on low memory "
-                    "condition. See also: server.memmgmt.retryCount.",
+                    "for a segment to be freed on low memory condition, "
+                    "before it counts a retry. A waiting request is served "
+                    "as soon as a segment becomes available. See also: "
+                    "server.memmgmt.retryCount.",
                     OPT_LONG_PREFIX "server.memmgmt.retrySleep");
 
         typeMap["server.memmgmt.readAhead"] = libconfig::Setting::Type::TypeInt;
@@ -180,9 +241,20 @@ namespace Options
                     1,
                     0,
                     "The number of segments that should be read ahead for "
-                    "sequential scan stream accesses.",
+                    "sequential scan stream accesses. The amount adapts to "
+                    "the reader's consumption rate. See also: "
+                    "server.memmgmt.readAheadMax.",
                     OPT_LONG_PREFIX "server.memmgmt.readAhead");
 
+        typeMap["server.memmgmt.readAheadMax"] = libconfig::Setting::Type::TypeInt;
+        options.add("16",
+                    false,
+                    1,
+                    0,
+                    "The maximum number of segments that may be read ahead "
+                    "for a single reader of a stream.",
+                    OPT_LONG_PREFIX "server.memmgmt.readAheadMax");
+
         //
         // Session Management
         //
@@ -221,6 +293,17 @@ namespace Options
                     "(logical or physical) in the system.",
                     OPT_LONG_PREFIX "server.requestworkerpool.size");
 
+        typeMap["server.iopool.size"] = libconfig::Setting::Type::TypeInt;
+        options.add("2",
+                    false,
+                    1,
+                    0,
+                    "The number of I/O threads used to write encoded frames "
+                    "to disk. This is the maximum number of outstanding "
+                    "frame writes. 0 writes frames directly on the "
+                    "processing workers.",
+                    OPT_LONG_PREFIX "server.iopool.size");
+
         //
         // Simtrace Store
         //
@@ -234,6 +317,55 @@ namespace Options
                     "statistics on store close.",
                     OPT_LONG_PREFIX "store.simtrace.logStreamStats");
 
+        typeMap["store.simtrace.codec"] = libconfig::Setting::Type::TypeString;
+        options.add("lzma",
+                    false,
+                    1,
+                    0,
+                    "Compression codec used for new trace data. Valid "
+                    "values are 'lzma', 'lz4', and 'none'.",
+                    OPT_LONG_PREFIX "store.simtrace.codec");
+
+        typeMap["store.simtrace.codecLevel"] = libconfig::Setting::Type::TypeInt;
+        options.add("-1",
+                    false,
+                    1,
+                    0,
+                    "Compression level for the selected codec. Use -1 for "
+                    "the codec's default level.",
+                    OPT_LONG_PREFIX "store.simtrace.codecLevel");
+
+        typeMap["store.simtrace.blockSize"] = libconfig::Setting::Type::TypeInt;
+        options.add("0",
+                    false,
+                    1,
+                    0,
+                    "Size of the blocks in MiB into which segments are split "
+                    "for parallel compression. Use 0 to compress each "
+                    "segment as a whole. Traces written with blocks cannot "
+                    "be read by storage servers prior to 3.2.2.",
+                    OPT_LONG_PREFIX "store.simtrace.blockSize");
+
+        typeMap["store.simtrace.memoryShards"] = libconfig::Setting::Type::TypeInt;
+        options.add("1",
+                    false,
+                    1,
+                    0,
+                    "Number of shards into which the memory encoder splits "
+                    "each segment for parallel encoding. Use 1 to disable "
+                    "sharding.",
+                    OPT_LONG_PREFIX "store.simtrace.memoryShards");
+
+        typeMap["store.simtrace.skipInterval"] = libconfig::Setting::Type::TypeInt;
+        options.add("4096",
+                    false,
+                    1,
+                    0,
+                    "Number of entries between two samples of the skip index "
+                    "stored with each segment. Use 0 to disable the skip "
+                    "index.",
+                    OPT_LONG_PREFIX "store.simtrace.skipInterval");
+
         typeMap["store.persistentCache"] = libconfig::Setting::Type::TypeInt;
         options.add("0",
                     false,
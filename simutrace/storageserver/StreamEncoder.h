@@ -30,6 +30,16 @@ namespace SimuTrace
     class ServerStore;
     class ServerStreamBuffer;
 
+    // Window of entries in a segment, which contains the entry searched for
+    // in a query (see StreamEncoder::findEntryRange()). The indices are
+    // relative to the start of the segment. For streams with temporal order
+    // these are raw entry indices. The end index is exclusive.
+    struct EntryRange {
+        uint64_t startIndex;
+        size_t startOffset;
+        uint64_t endIndex;
+    };
+
     class StreamEncoder
     {
     public:
@@ -60,6 +70,13 @@ namespace SimuTrace
         virtual bool write(ServerStreamBuffer& buffer, SegmentId segment,
                            std::unique_ptr<StorageLocation>& locationOut) = 0;
 
+        // Narrows the range of entries, which may hold the entry for the
+        // given query value. Returns false, if the encoder has no index for
+        // the segment and the whole segment must be searched.
+        virtual bool findEntryRange(const StorageLocation& location,
+                                    QueryIndexType type, uint64_t value,
+                                    EntryRange& rangeOut) { return false; };
+
         virtual void notifySegmentClosed(StreamSegmentId segment) { };
         virtual void notifySegmentCacheClosed(StreamSegmentId segment) { };
 
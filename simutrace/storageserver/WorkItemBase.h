@@ -28,13 +28,24 @@ namespace SimuTrace
 
     class WorkItemBase
     {
+    public:
+        static const uint32_t InvalidAffinity = 0xFFFFFFFF;
+
     private:
+        uint32_t _affinity;
 
     public:
-        WorkItemBase() { }
+        WorkItemBase() :
+            _affinity(InvalidAffinity) { }
         virtual ~WorkItemBase() { }
 
         virtual void execute() = 0;
+
+        // Items with the same affinity key (e.g., the id of the stream they
+        // work on) are preferably processed by the same worker. This is only
+        // a hint. Idle workers may still steal the item.
+        void setAffinity(uint32_t affinity) { _affinity = affinity; }
+        uint32_t getAffinity() const { return _affinity; }
     };
 
 }
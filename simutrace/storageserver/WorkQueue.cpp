@@ -27,49 +27,169 @@
 namespace SimuTrace
 {
 
-    WorkQueue::WorkQueue(WorkerPool& pool) :
-        _pool(pool),
-        _blocked(false)
+    __thread WorkQueue* WorkQueue::_currentQueue = nullptr;
+    __thread uint32_t WorkQueue::_currentLane = 0;
+
+    WorkQueue::Lane::Lane() :
+        idle(0),
+        enqueued(0),
+        processed(0),
+        stolen(0)
     {
+        for (int p = Priority::Max; p >= 0; --p) {
+            length[p] = 0;
+        }
+    }
 
+    WorkQueue::WorkQueue(WorkerPool& pool, uint32_t laneCount) :
+        _pool(pool),
+        _laneCount(std::max<uint32_t>(1, laneCount)),
+        _lanes(new Lane[_laneCount]),
+        _registeredLanes(0),
+        _nextLane(0),
+        _length(0),
+        _blocked(false),
+        _released(false)
+    {
+        for (int p = Priority::Max; p >= 0; --p) {
+            _pending[p] = 0;
+        }
     }
 
     WorkQueue::~WorkQueue()
     {
-        assert(_queue[Priority::Low].empty());
-        assert(_queue[Priority::Normal].empty());
-        assert(_queue[Priority::High].empty());
+        assert(_length == 0);
+    }
+
+    uint32_t WorkQueue::_getSubmitLane(const WorkItemBase& item)
+    {
+        uint32_t affinity = item.getAffinity();
+        if (affinity != WorkItemBase::InvalidAffinity) {
+            return affinity % _laneCount;
+        }
+
+        // Work submitted by one of our workers most likely operates on
+        // data that is still in the worker's caches.
+        if (_currentQueue == this) {
+            return _currentLane;
+        }
+
+        return Interlocked::interlockedAdd(&_nextLane, 1) % _laneCount;
+    }
+
+    void WorkQueue::_wakeUpWorker(uint32_t preferredLane)
+    {
+        // Wake up the worker of the item's lane if it sleeps. Otherwise,
+        // another idle worker will steal the item.
+        for (uint32_t i = 0; i < _laneCount; ++i) {
+            Lane& lane = _lanes[(preferredLane + i) % _laneCount];
+
+            if (lane.idle == 0) {
+                continue;
+            }
+
+            LockScope(lane.lock);
+            if (lane.idle != 0) {
+                lane.idle = 0;
+                lane.lock.wakeOne();
+
+                return;
+            }
+        }
+
+        // All workers are busy. The item will be picked up as soon as one
+        // of them finishes its current work.
+    }
+
+    std::unique_ptr<WorkItemBase> WorkQueue::_dequeue(Lane& lane, int priority)
+    {
+        LockScope(lane.lock);
+
+        auto& queue = lane.queue[priority];
+        if (queue.empty()) {
+            return nullptr;
+        }
+
+        auto item = std::move(queue.front());
+        queue.pop();
+
+        lane.length[priority]--;
+        Interlocked::interlockedSub(&_pending[priority], 1);
+        Interlocked::interlockedSub(&_length, 1);
+
+        return item;
+    }
+
+    void WorkQueue::registerWorker()
+    {
+        uint32_t lane = Interlocked::interlockedAdd(&_registeredLanes, 1);
+        ThrowOn(lane >= _laneCount, InvalidOperationException);
+
+        _currentQueue = this;
+        _currentLane  = lane;
     }
 
     void WorkQueue::enqueueWork(std::unique_ptr<WorkItemBase>& item,
                                 Priority priority)
     {
-        LockScope(_lock);
-        ThrowOn(_blocked, InvalidOperationException);
+        ThrowOnNull(item, ArgumentNullException, "item");
         ThrowOn(priority > Priority::Max, ArgumentOutOfBoundsException,
                 "priority");
 
-        _queue[priority].push(std::move(item));
-        wakeUpWorkers();
+        uint32_t index = _getSubmitLane(*item);
+        Lane& lane = _lanes[index];
+
+        Lock(lane.lock); {
+            ThrowOn(_blocked, InvalidOperationException);
+
+            lane.queue[priority].push(std::move(item));
+            lane.length[priority]++;
+            lane.enqueued++;
+
+            Interlocked::interlockedAdd(&_pending[priority], 1);
+
+            // This is a full barrier. Workers going to sleep will either
+            // see the new item or we see them being idle (see wait()).
+            Interlocked::interlockedAdd(&_length, 1);
+        } Unlock();
+
+        _wakeUpWorker(index);
     }
 
     std::unique_ptr<WorkItemBase> WorkQueue::dequeueWork()
     {
-        LockScope(_lock);
+        const bool isWorker = (_currentQueue == this);
+        const uint32_t own = (isWorker) ? _currentLane : 0;
 
         for (int p = Priority::Max; p >= 0; --p) {
-            auto& queue = _queue[p];
+            if (_pending[p] == 0) {
+                continue;
+            }
+
+            // Check our own lane first, then steal from the others
+            for (uint32_t i = 0; i < _laneCount; ++i) {
+                Lane& lane = _lanes[(own + i) % _laneCount];
 
-            if (!queue.empty()) {
-                auto item = std::move(queue.front());
-                queue.pop();
+                if (lane.length[p] == 0) {
+                    continue;
+                }
 
-                return item;
+                std::unique_ptr<WorkItemBase> item = _dequeue(lane, p);
+                if (item != nullptr) {
+                    if (isWorker) {
+                        _lanes[own].processed++;
+                        if (i > 0) {
+                            _lanes[own].stolen++;
+                        }
+                    }
+
+                    return item;
+                }
             }
         }
 
         // All queues are empty
-        if (_blocked) {
+        if (_blocked && (_length == 0)) {
             _emptyEvent.signal();
         }
 
@@ -78,26 +198,57 @@ namespace SimuTrace
 
     void WorkQueue::clear()
     {
-        LockScope(_lock);
+        for (uint32_t i = 0; i < _laneCount; ++i) {
+            Lane& lane = _lanes[i];
+            LockScope(lane.lock);
+
+            for (int p = Priority::Max; p >= 0; --p) {
+                // Clear the queue by swapping it with an empty one
+                std::queue<std::unique_ptr<WorkItemBase>> empty;
+                std::swap(lane.queue[p], empty);
 
-        // Clear the queue by swapping it with an empty one
-        std::queue<std::unique_ptr<WorkItemBase>> empty[Priority::Max + 1];
-        std::swap(_queue, empty);
+                Interlocked::interlockedSub(&_pending[p], lane.length[p]);
+                Interlocked::interlockedSub(&_length, lane.length[p]);
+                lane.length[p] = 0;
+            }
+        }
     }
 
     void WorkQueue::block()
     {
-        LockScope(_lock);
-
         _blocked = true;
-        if (isEmpty()) {
+
+        // Enqueue operations check the flag with the lane lock held. Once
+        // we acquired each lock, no further items can enter the queue.
+        for (uint32_t i = 0; i < _laneCount; ++i) {
+            Lock(_lanes[i].lock); {
+            } Unlock();
+        }
+
+        if (_length == 0) {
             _emptyEvent.signal();
         }
     }
 
     void WorkQueue::wait()
     {
-        _workEvent.wait();
+        assert(_currentQueue == this);
+        Lane& lane = _lanes[_currentLane];
+
+        LockScope(lane.lock);
+
+        for (;;) {
+            // This is a full barrier. An enqueue operation will either see
+            // us idle and wake us up, or we see its item (see enqueueWork()).
+            Interlocked::interlockedOr(&lane.idle, 1);
+
+            if ((_length > 0) || _released) {
+                lane.idle = 0;
+                break;
+            }
+
+            lane.lock.wait();
+        }
     }
 
     void WorkQueue::waitEmpty()
@@ -107,34 +258,46 @@ namespace SimuTrace
 
     void WorkQueue::wakeUpWorkers()
     {
-        // BUG! This will only wake up one of the workers! Will be fixed
-        // with the use of conditional variable!
-        _workEvent.signal();
+        _released = true;
+
+        for (uint32_t i = 0; i < _laneCount; ++i) {
+            Lane& lane = _lanes[i];
+            LockScope(lane.lock);
+
+            lane.idle = 0;
+            lane.lock.wakeAll();
+        }
     }
 
     bool WorkQueue::isEmpty() const
     {
-        LockScope(_lock);
+        return (_length == 0);
+    }
 
-        for (int p = Priority::Max; p >= 0; --p) {
-            if (!_queue[p].empty()) {
-                return false;
-            }
-        }
+    uint32_t WorkQueue::getLength() const
+    {
+        return _length;
+    }
 
-        return true;
+    uint32_t WorkQueue::getLaneCount() const
+    {
+        return _laneCount;
     }
 
-    uint32_t WorkQueue::getLength() const
+    void WorkQueue::getLaneStatistics(uint32_t lane,
+                                      LaneStatistics& stats) const
     {
-        LockScope(_lock);
+        ThrowOn(lane >= _laneCount, ArgumentOutOfBoundsException, "lane");
+        const Lane& l = _lanes[lane];
 
-        uint32_t num = 0;
+        stats.length = 0;
         for (int p = Priority::Max; p >= 0; --p) {
-            num += static_cast<uint32_t>(_queue[p].size());
+            stats.length += l.length[p];
         }
 
-        return num;
+        stats.enqueued  = l.enqueued;
+        stats.processed = l.processed;
+        stats.stolen    = l.stolen;
     }
 
     WorkerPool& WorkQueue::getPool() const
@@ -142,4 +305,4 @@ namespace SimuTrace
         return _pool;
     }
 
-}
\ No newline at end of file
+}
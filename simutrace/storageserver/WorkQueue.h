@@ -29,6 +29,19 @@ namespace SimuTrace
     class WorkItemBase;
     class WorkerPool;
 
+    //
+    // The work queue consists of one lane per worker. Each lane holds a
+    // queue for every priority. Workers take items from their own lane
+    // first and steal from the lanes of other workers if their lane is
+    // empty. Items are always processed in the order of their priority,
+    // regardless of the lane they are in.
+    //
+    // An item is put into the lane that matches its affinity key (see
+    // WorkItemBase::setAffinity()), so that work for the same stream
+    // preferably runs on the same worker and finds its data in that
+    // worker's caches. Items without affinity go to the lane of the
+    // submitting worker or are distributed round-robin.
+    //
     class WorkQueue
     {
     public:
@@ -39,22 +52,71 @@ namespace SimuTrace
 
             Max     = High
          };
+
+        struct LaneStatistics {
+            // Number of items currently queued in the lane
+            uint32_t length;
+
+            // Number of items put into the lane
+            uint64_t enqueued;
+
+            // Number of items the lane's worker processed and how many of
+            // them it stole from other lanes
+            uint64_t processed;
+            uint64_t stolen;
+        };
+
     private:
         DISABLE_COPY(WorkQueue);
 
+        struct Lane {
+            // Protects the queues. The lane's worker sleeps on it.
+            ConditionVariable lock;
+            std::queue<std::unique_ptr<WorkItemBase>> queue[Priority::Max + 1];
+
+            volatile uint32_t length[Priority::Max + 1];
+            volatile uint32_t idle;
+
+            // Statistics. Only updated by the lane's worker or with the
+            // lock held.
+            volatile uint64_t enqueued;
+            volatile uint64_t processed;
+            volatile uint64_t stolen;
+
+            Lane();
+        };
+
+        static __thread WorkQueue* _currentQueue;
+        static __thread uint32_t _currentLane;
+
         WorkerPool& _pool;
 
-        mutable CriticalSection _lock;
-        std::queue<std::unique_ptr<WorkItemBase>> _queue[Priority::Max + 1];
+        const uint32_t _laneCount;
+        std::unique_ptr<Lane[]> _lanes;
+
+        volatile uint32_t _registeredLanes;
+        volatile uint32_t _nextLane;
+
+        // Number of items in all lanes in total and per priority
+        volatile uint32_t _length;
+        volatile uint32_t _pending[Priority::Max + 1];
 
-        Event _workEvent;
         Event _emptyEvent;
 
-        bool _blocked;
+        volatile bool _blocked;
+        volatile bool _released;
+
+        uint32_t _getSubmitLane(const WorkItemBase& item);
+        void _wakeUpWorker(uint32_t preferredLane);
+
+        std::unique_ptr<WorkItemBase> _dequeue(Lane& lane, int priority);
     public:
-        WorkQueue(WorkerPool& pool);
+        WorkQueue(WorkerPool& pool, uint32_t laneCount);
         ~WorkQueue();
 
+        // Assigns a lane to the calling worker thread
+        void registerWorker();
+
         void enqueueWork(std::unique_ptr<WorkItemBase>& item,
                          Priority priority = Priority::Normal);
         std::unique_ptr<WorkItemBase> dequeueWork();
@@ -63,18 +125,28 @@ namespace SimuTrace
 
         void block();
 
+        // Waits until the queue contains work or wakeUpWorkers() has been
+        // called. Must only be called by registered workers. Each new work
+        // item wakes up one waiting worker, preferably the worker of the
+        // item's lane.
         void wait();
 
         // Wait for the queue to be empty. Does only work in BLOCKED state!
         void waitEmpty();
+
+        // Wakes up all waiting workers. Any further wait() returns
+        // immediately. This is used to shut down the worker pool.
         void wakeUpWorkers();
 
         bool isEmpty() const;
         uint32_t getLength() const;
 
+        uint32_t getLaneCount() const;
+        void getLaneStatistics(uint32_t lane, LaneStatistics& stats) const;
+
         WorkerPool& getPool() const;
     };
 
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -22,21 +22,43 @@
 #include "WorkerPool.h"
 
 #include "WorkItemBase.h"
+#include "WorkItem.h"
 #include "WorkQueue.h"
 
 namespace SimuTrace
 {
 
+    struct WorkerPool::ParallelContext
+    {
+        ParallelMain main;
+        void* context;
+        uint32_t count;
+
+        volatile uint32_t next;
+
+        // Protected by done
+        ConditionVariable done;
+        uint32_t remaining;
+        std::string error;
+
+        ParallelContext(ParallelMain main, void* context, uint32_t count) :
+            main(main),
+            context(context),
+            count(count),
+            next(0),
+            remaining(count) { }
+    };
+
     WorkerPool::WorkerPool(uint32_t numWorkers, Environment& root) :
         _log("[Worker]", root.log),
         _environment(root),
-        _queue(*this)
+        _queue(*this, (numWorkers == 0) ?
+            System::getNumLogicalProcessors() : numWorkers)
     {
         _environment.log = &_log;
 
-        if (numWorkers == 0) {
-            numWorkers = System::getNumLogicalProcessors();
-        }
+        // Each worker owns a lane in the work queue
+        numWorkers = _queue.getLaneCount();
 
         try {
 
@@ -72,6 +94,8 @@ namespace SimuTrace
         Environment* env = &pool._environment;
         Environment::set(env);
 
+        queue.registerWorker();
+
         while (!thread.shouldStop()) {
             queue.wait();
 
@@ -107,6 +131,75 @@ namespace SimuTrace
         return true;
     }
 
+    bool WorkerPool::_runParallelItem(ParallelContext& context)
+    {
+        uint32_t index = Interlocked::interlockedAdd(&context.next, 1);
+        if (index >= context.count) {
+            return false;
+        }
+
+        std::string error;
+        try {
+            context.main(context.context, index);
+        } catch (const std::exception& e) {
+            error = e.what();
+        }
+
+        LockScope(context.done);
+        if (!error.empty() && context.error.empty()) {
+            context.error = error;
+        }
+
+        assert(context.remaining > 0);
+        if (--context.remaining == 0) {
+            context.done.wakeAll();
+        }
+
+        return true;
+    }
+
+    void WorkerPool::runParallel(uint32_t count, ParallelMain main,
+                                 void* context, WorkQueue::Priority priority)
+    {
+        ThrowOnNull(main, ArgumentNullException, "main");
+        if (count == 0) {
+            return;
+        }
+
+        // Helper work items may be dequeued after we returned, so they
+        // keep the shared context alive on their own.
+        std::shared_ptr<ParallelContext> ctx =
+            std::make_shared<ParallelContext>(main, context, count);
+
+        uint32_t helpers = std::min(count - 1, getWorkerCount());
+        try {
+            for (uint32_t i = 0; i < helpers; ++i) {
+                std::unique_ptr<WorkItemBase> item(
+                    new WorkItem<std::shared_ptr<ParallelContext>>(
+                        [](WorkItem<std::shared_ptr<ParallelContext>>& item,
+                           std::shared_ptr<ParallelContext>& context) {
+                    while (_runParallelItem(*context)) { }
+                }, ctx));
+
+                submitWork(item, priority);
+            }
+        } catch (const InvalidOperationException&) {
+            // The pool is closing and does not accept new work. We process
+            // the remaining items on our own.
+        }
+
+        // Help with the work. We never wait for an item that has not been
+        // started, so this cannot deadlock even if all workers are busy.
+        while (_runParallelItem(*ctx)) { }
+
+        LockScope(ctx->done);
+        while (ctx->remaining > 0) {
+            ctx->done.wait();
+        }
+
+        ThrowOn(!ctx->error.empty(), Exception, ctx->error);
+    }
+
     void WorkerPool::close(bool dropQueue)
     {
         // Prevent new work items from entering the pool.
@@ -120,6 +213,17 @@ namespace SimuTrace
 
         assert(_queue.isEmpty());
 
+        for (uint32_t i = 0; i < _workers.size(); ++i) {
+            WorkQueue::LaneStatistics stats;
+            _queue.getLaneStatistics(i, stats);
+
+            LogDebug("<worker: %d> Processed %llu work items (%llu stolen, "
+                     "%llu submitted to worker).", i,
+                     static_cast<unsigned long long>(stats.processed),
+                     static_cast<unsigned long long>(stats.stolen),
+                     static_cast<unsigned long long>(stats.enqueued));
+        }
+
         // At this point, the queue is empty. Some workers might still process
         // work, others may sleep. We therefore, wake all workers up so they
         // recognize that they should stop.
@@ -150,11 +254,41 @@ namespace SimuTrace
         }
     }
 
+    uint32_t WorkerPool::bindToNumaNodes()
+    {
+        std::vector<uint32_t> nodes;
+        for (uint32_t i = 0; i < System::getNumNumaNodes(); ++i) {
+            if (!System::getNumaNodeProcessors(i).empty()) {
+                nodes.push_back(i);
+            }
+        }
+
+        if (nodes.size() <= 1) {
+            return 1;
+        }
+
+        for (uint32_t i = 0; i < _workers.size(); ++i) {
+            uint32_t node = nodes[i % nodes.size()];
+
+            if (!_workers[i]->setNumaNode(node)) {
+                LogWarn("Failed to bind worker %d to NUMA node %d.", i, node);
+            }
+        }
+
+        return static_cast<uint32_t>(nodes.size());
+    }
+
     uint32_t WorkerPool::getQueueLength() const
     {
         return _queue.getLength();
     }
 
+    void WorkerPool::getWorkerStatistics(uint32_t worker,
+                                         WorkQueue::LaneStatistics& stats) const
+    {
+        _queue.getLaneStatistics(worker, stats);
+    }
+
     uint32_t WorkerPool::getWorkerCount() const
     {
         return static_cast<uint32_t>(_workers.size());
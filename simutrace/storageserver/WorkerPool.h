@@ -32,8 +32,12 @@ namespace SimuTrace
 
     class WorkerPool
     {
+    public:
+        typedef void (*ParallelMain)(void* context, uint32_t index);
+
     private:
         typedef ObjectReference<WorkerThread> WorkerReference;
+        struct ParallelContext;
 
     private:
         DISABLE_COPY(WorkerPool);
@@ -47,6 +51,8 @@ namespace SimuTrace
 
         void _freeWorkers();
         static int _workerMain(WorkerThread& thread);
+
+        static bool _runParallelItem(ParallelContext& context);
     public:
         WorkerPool(uint32_t numWorkers, Environment& root);
 
@@ -57,10 +63,26 @@ namespace SimuTrace
 
         void setPoolPriority(int priority);
 
+        // Distributes the workers round-robin across the NUMA nodes that
+        // have processors and pins each worker to its node. Returns the
+        // number of nodes used.
+        uint32_t bindToNumaNodes();
+
         uint32_t getQueueLength() const;
         uint32_t getWorkerCount() const;
+        void getWorkerStatistics(uint32_t worker,
+                                 WorkQueue::LaneStatistics& stats) const;
 
         bool tryProcessWorkItem();
+
+        // Calls main(context, i) for all i in [0, count) and returns when
+        // all calls have finished. The calling thread takes part in the
+        // work, so this may safely be used from within a worker thread. If
+        // any call throws, the first error is rethrown after all calls
+        // have completed.
+        void runParallel(uint32_t count, ParallelMain main, void* context,
+                         WorkQueue::Priority priority =
+                            WorkQueue::Priority::Normal);
     };
 
 }
@@ -0,0 +1,226 @@
+/*
+ * Copyright 2014 (C) Karlsruhe Institute of Technology (KIT)
+ * Marc Rittinghaus, Thorsten Groeninger
+ *
+ * Simutrace Storage Server (storageserver) is part of Simutrace.
+ *
+ * storageserver is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * storageserver is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with storageserver. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "SimuStor.h"
+
+#include "Simtrace3Blocks.h"
+
+#include "../WorkQueue.h"
+#include "../WorkerPool.h"
+
+namespace SimuTrace {
+namespace Simtrace
+{
+
+    struct Block
+    {
+        const void* source;
+        size_t sourceLength;
+
+        void* destination;
+        size_t destinationLength;
+
+        size_t resultLength;
+    };
+
+    struct BlockContext
+    {
+        const Compression::Codec& codec;
+        uint32_t level;
+
+        std::vector<Block> blocks;
+
+        BlockContext(const Compression::Codec& codec, uint32_t level) :
+            codec(codec),
+            level(level) { }
+    };
+
+    static void _compressBlock(void* context, uint32_t index)
+    {
+        BlockContext* ctx = static_cast<BlockContext*>(context);
+        Block& block = ctx->blocks[index];
+
+        block.resultLength = ctx->codec.compress(block.source,
+                                                 block.sourceLength,
+                                                 block.destination,
+                                                 block.destinationLength,
+                                                 ctx->level);
+    }
+
+    static void _decompressBlock(void* context, uint32_t index)
+    {
+        BlockContext* ctx = static_cast<BlockContext*>(context);
+        Block& block = ctx->blocks[index];
+
+        block.resultLength = ctx->codec.decompress(block.source,
+                                                   block.sourceLength,
+                                                   block.destination,
+                                                   block.destinationLength);
+    }
+
+    size_t compressBlocks(WorkerPool& pool, const Compression::Codec& codec,
+                          uint32_t level, size_t blockSize,
+                          const void* source, size_t sourceLength,
+                          void* destination, size_t destinationLength)
+    {
+        ThrowOn(blockSize == 0, ArgumentException, "blockSize");
+        ThrowOn(sourceLength == 0, ArgumentException, "sourceLength");
+
+        uint32_t blockCount = static_cast<uint32_t>(
+            (sourceLength + blockSize - 1) / blockSize);
+
+        const size_t tableSize = SIMTRACE_V3_BLOCK_TABLE_SIZE(blockCount);
+        ThrowOn(destinationLength <= tableSize, ArgumentException,
+                "destinationLength");
+
+        // Each block is compressed into its own slice of the destination
+        // buffer. We compact the blocks once all of them are done. Every
+        // block gets room for its own data and an equal share of the
+        // remaining space for the codec's headers and incompressible data.
+        // A short last block thus does not take space away from the full
+        // blocks. If the destination is smaller than the source, we split
+        // it in proportion to the block sizes.
+        const size_t capacity = destinationLength - tableSize;
+        const size_t extra = (capacity > sourceLength) ?
+            (capacity - sourceLength) / blockCount : 0;
+
+        const char* src = static_cast<const char*>(source);
+        char* dst = static_cast<char*>(destination) + tableSize;
+
+        BlockContext ctx(codec, level);
+        ctx.blocks.resize(blockCount);
+
+        size_t slice = 0;
+        for (uint32_t i = 0; i < blockCount; ++i) {
+            Block& block = ctx.blocks[i];
+            size_t offset = i * blockSize;
+            size_t length = std::min(blockSize, sourceLength - offset);
+
+            size_t sliceLength = (capacity > sourceLength) ?
+                length + extra : static_cast<size_t>(
+                    static_cast<uint64_t>(capacity) * length / sourceLength);
+
+            block.source            = src + offset;
+            block.sourceLength      = length;
+            block.destination       = dst + slice;
+            block.destinationLength = sliceLength;
+            block.resultLength      = 0;
+
+            slice += sliceLength;
+        }
+
+        assert(slice <= capacity);
+
+        // The blocks are part of work that is already in progress. We
+        // therefore process them with high priority to quickly release the
+        // segment again.
+        pool.runParallel(blockCount, _compressBlock, &ctx,
+                         WorkQueue::Priority::High);
+
+        AttributeBlockTable* table =
+            static_cast<AttributeBlockTable*>(destination);
+
+        table->blockCount = blockCount;
+        table->reserved0  = 0;
+        table->blockSize  = blockSize;
+
+        uint64_t* offsets = table->offsets;
+        uint64_t offset = 0;
+        for (uint32_t i = 0; i < blockCount; ++i) {
+            const Block& block = ctx.blocks[i];
+            assert(dst + offset <= block.destination);
+
+            offsets[i] = offset;
+            memmove(dst + offset, block.destination, block.resultLength);
+
+            offset += block.resultLength;
+        }
+
+        offsets[blockCount] = offset;
+
+        return tableSize + static_cast<size_t>(offset);
+    }
+
+    size_t decompressBlocks(WorkerPool& pool, const Compression::Codec& codec,
+                            const void* source, size_t sourceLength,
+                            void* destination, size_t destinationLength)
+    {
+        const size_t minTableSize = SIMTRACE_V3_BLOCK_TABLE_SIZE(0);
+        ThrowOn(sourceLength < minTableSize, Exception,
+                "The block table is truncated.");
+
+        const AttributeBlockTable* table =
+            static_cast<const AttributeBlockTable*>(source);
+
+        uint32_t blockCount = table->blockCount;
+        uint64_t blockSize = table->blockSize;
+        const size_t tableSize = SIMTRACE_V3_BLOCK_TABLE_SIZE(blockCount);
+
+        ThrowOn((blockCount == 0) || (blockSize == 0) ||
+                (blockSize > destinationLength) ||
+                (sourceLength < tableSize) ||
+                (blockSize * (blockCount - 1) >= destinationLength),
+                Exception, "The block table is corrupted.");
+
+        const uint64_t* offsets = table->offsets;
+        const uint64_t dataLength = sourceLength - tableSize;
+
+        const char* src = static_cast<const char*>(source) + tableSize;
+        char* dst = static_cast<char*>(destination);
+
+        BlockContext ctx(codec, 0);
+        ctx.blocks.resize(blockCount);
+
+        for (uint32_t i = 0; i < blockCount; ++i) {
+            Block& block = ctx.blocks[i];
+            size_t offset = static_cast<size_t>(i * blockSize);
+
+            ThrowOn((offsets[i] > offsets[i + 1]) ||
+                    (offsets[i + 1] > dataLength), Exception,
+                    "The block table is corrupted.");
+
+            block.source            = src + offsets[i];
+            block.sourceLength      = static_cast<size_t>(
+                offsets[i + 1] - offsets[i]);
+            block.destination       = dst + offset;
+            block.destinationLength = static_cast<size_t>(std::min<uint64_t>(
+                blockSize, destinationLength - offset));
+            block.resultLength      = 0;
+        }
+
+        pool.runParallel(blockCount, _decompressBlock, &ctx,
+                         WorkQueue::Priority::High);
+
+        size_t length = 0;
+        for (uint32_t i = 0; i < blockCount; ++i) {
+            const Block& block = ctx.blocks[i];
+
+            // All blocks but the last must be complete. Otherwise, the data
+            // of the following blocks would be at the wrong offset.
+            ThrowOn((i < blockCount - 1) && (block.resultLength != blockSize),
+                    Exception, "The block table is corrupted.");
+
+            length += block.resultLength;
+        }
+
+        return length;
+    }
+
+}
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2014 (C) Karlsruhe Institute of Technology (KIT)
+ * Marc Rittinghaus, Thorsten Groeninger
+ *
+ * Simutrace Storage Server (storageserver) is part of Simutrace.
+ *
+ * storageserver is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * storageserver is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with storageserver. If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#ifndef SIMTRACE3_BLOCKS_H
+#define SIMTRACE3_BLOCKS_H
+
+#include "SimuStor.h"
+#include "Simtrace3Format.h"
+
+namespace SimuTrace {
+
+    class WorkerPool;
+
+namespace Simtrace
+{
+
+    // Compresses the source in blocks of blockSize bytes, which are
+    // processed in parallel on the given worker pool. The destination
+    // receives an AttributeBlockTable followed by the compressed blocks
+    // (see SIMTRACE_V3_ATTRIBUTE_FLAG_BLOCKS). Returns the number of bytes
+    // written to the destination.
+    size_t compressBlocks(WorkerPool& pool, const Compression::Codec& codec,
+                          uint32_t level, size_t blockSize,
+                          const void* source, size_t sourceLength,
+                          void* destination, size_t destinationLength);
+
+    // Decompresses data written by compressBlocks(). Returns the number of
+    // bytes written to the destination. Throws if the block table is
+    // corrupted or a block cannot be decompressed.
+    size_t decompressBlocks(WorkerPool& pool, const Compression::Codec& codec,
+                            const void* source, size_t sourceLength,
+                            void* destination, size_t destinationLength);
+
+}
+}
+#endif
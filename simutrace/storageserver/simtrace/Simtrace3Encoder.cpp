@@ -60,12 +60,17 @@ namespace Simtrace
     Simtrace3Encoder::Simtrace3Encoder(ServerStore& store,
                                        const std::string& friendlyName,
                                        ServerStream* stream,
-                                       bool needScratch) :
+                                       bool needScratch,
+                                       bool needIndex) :
         StreamEncoder(store, friendlyName),
         _stream(stream),
-        _needScratch(needScratch)
+        _needScratch(needScratch),
+        _skipInterval(0)
     {
-
+        int interval = Configuration::get<int>("store.simtrace.skipInterval");
+        if (needIndex && (interval > 0)) {
+            _skipInterval = static_cast<uint32_t>(interval);
+        }
     }
 
     Simtrace3Encoder::~Simtrace3Encoder()
@@ -73,13 +78,37 @@ namespace Simtrace
 
     }
 
+    struct Simtrace3Encoder::CommitContext
+    {
+        Simtrace3Encoder& encoder;
+        ServerStreamBuffer& buffer;
+        SegmentId segment;
+        StreamSegmentId sequenceNumber;
+
+        // The frame references memory in the scratch segment and the
+        // index. All must be kept alive until the frame has been written.
+        std::unique_ptr<Simtrace3Frame> frame;
+        std::unique_ptr<ScratchSegment> target;
+        std::vector<byte> index;
+
+        CommitContext(Simtrace3Encoder& encoder,
+                      ServerStreamBuffer& buffer,
+                      SegmentId segment,
+                      StreamSegmentId sequenceNumber) :
+            encoder(encoder),
+            buffer(buffer),
+            segment(segment),
+            sequenceNumber(sequenceNumber),
+            frame(),
+            target(),
+            index() { }
+    };
+
     void Simtrace3Encoder::_writerMain(WorkItem<WorkerContext>& workItem,
                                        WorkerContext& context)
     {
         // -- This method is called in the context of a worker thread --
         SwapEnvironment(&StorageServer::getInstance().getEnvironment());
-        Simtrace3Store& store = static_cast<Simtrace3Store&>(
-            context.encoder._getStore());
 
         assert(context.encoder._stream != nullptr);
         ServerStream* stream = context.encoder._stream;
@@ -92,17 +121,97 @@ namespace Simtrace
 
         assert(context.location == nullptr);
 
+        std::shared_ptr<CommitContext> commit;
         try {
-            std::unique_ptr<ScratchSegment> target;
+            commit = std::make_shared<CommitContext>(context.encoder, buffer,
+                context.segment, ctrl->link.sequenceNumber);
+
             if (context.encoder._needScratch) {
-                target = std::unique_ptr<ScratchSegment>(new ScratchSegment());
+                commit->target = std::unique_ptr<ScratchSegment>(
+                    new ScratchSegment());
             }
 
             // Create the frame and add the data attribute
-            Simtrace3Frame frame(stream, ctrl);
+            commit->frame = std::unique_ptr<Simtrace3Frame>(
+                new Simtrace3Frame(stream, ctrl));
+
+            // The index describes the raw entries. We therefore build it
+            // before the encoder processes the segment.
+            if (context.encoder._buildIndex(buffer, context.segment,
+                                            commit->index)) {
+                commit->frame->addAttribute(
+                    Simtrace3AttributeType::SatSkipIndex,
+                    commit->index.size(), commit->index.data());
+            }
 
-            context.encoder._encode(frame, context.segment,
-                                    ctrl->link.sequenceNumber, target.get());
+            context.encoder._encode(*commit->frame, context.segment,
+                                    ctrl->link.sequenceNumber,
+                                    commit->target.get());
+
+        } catch (const std::exception& e) {
+            std::string bids =
+                ServerStreamBuffer::bufferIdToString(context.buffer.getId());
+
+            LogError("<encoder: '%s'> Encoding of segment %d in buffer %s "
+                        "failed <stream: %d, sqn: %d>. Exception: '%s'. "
+                        "The data will be discarded.",
+                        context.encoder.getFriendlyName().c_str(),
+                        context.segment, bids.c_str(), stream->getId(),
+                        ctrl->link.sequenceNumber, e.what());
+
+            stream->completeSegment(ctrl->link.sequenceNumber, nullptr);
+            return;
+        }
+
+        // Hand the frame over to the I/O pool, so we can continue with the
+        // next segment while the frame is written to disk. Like the
+        // encoding, writes for hidden streams get the highest priority.
+        WorkerPool* ioPool = StorageServer::getInstance().getIoPool();
+        if (ioPool != nullptr) {
+            std::unique_ptr<WorkItemBase> item(
+                new WorkItem<std::shared_ptr<CommitContext>>(_commitMain,
+                                                             commit));
+            item->setAffinity(stream->getId());
+
+            WorkQueue::Priority prio =
+                IsSet(stream->getDescriptor().flags, StreamFlags::SfHidden) ?
+                WorkQueue::Priority::High :
+                WorkQueue::Priority::Normal;
+
+            try {
+                ioPool->submitWork(item, prio);
+
+                return;
+            } catch (const InvalidOperationException&) {
+                // The pool is closing. We write the frame on our own.
+            }
+        }
+
+        _commitFrame(*commit);
+    }
+
+    void Simtrace3Encoder::_commitMain(
+        WorkItem<std::shared_ptr<CommitContext>>& workItem,
+        std::shared_ptr<CommitContext>& context)
+    {
+        // -- This method is called in the context of an I/O pool thread --
+        SwapEnvironment(&StorageServer::getInstance().getEnvironment());
+
+        _commitFrame(*context);
+
+        // Release the scratch segment right away
+        context = nullptr;
+    }
+
+    void Simtrace3Encoder::_commitFrame(CommitContext& context)
+    {
+        Simtrace3Store& store = static_cast<Simtrace3Store&>(
+            context.encoder._getStore());
+        ServerStream* stream = context.encoder._stream;
+        assert(stream != nullptr);
+
+        try {
+            Simtrace3Frame& frame = *context.frame;
 
             // Build a storage location and write the frame into the store
             auto location = context.encoder.makeStorageLocation(frame);
@@ -114,20 +223,20 @@ namespace Simtrace
 
             // Everything went fine. Complete the given segment. This will
             // make the segment available for read access.
-            stream->completeSegment(ctrl->link.sequenceNumber, &location);
+            stream->completeSegment(context.sequenceNumber, &location);
 
         } catch (const std::exception& e) {
             std::string bids =
                 ServerStreamBuffer::bufferIdToString(context.buffer.getId());
 
-            LogError("<encoder: '%s'> Encoding of segment %d in buffer %s "
+            LogError("<encoder: '%s'> Writing of segment %d in buffer %s "
                         "failed <stream: %d, sqn: %d>. Exception: '%s'. "
                         "The data will be discarded.",
                         context.encoder.getFriendlyName().c_str(),
                         context.segment, bids.c_str(), stream->getId(),
-                        ctrl->link.sequenceNumber, e.what());
+                        context.sequenceNumber, e.what());
 
-            stream->completeSegment(ctrl->link.sequenceNumber, nullptr);
+            stream->completeSegment(context.sequenceNumber, nullptr);
         }
     }
 
@@ -180,6 +289,301 @@ namespace Simtrace
         }
     }
 
+    bool Simtrace3Encoder::_buildIndex(ServerStreamBuffer& buffer,
+                                       SegmentId id,
+                                       std::vector<byte>& indexOut) const
+    {
+        const StreamTypeDescriptor& type = _stream->getType();
+        const SegmentControlElement* ctrl = buffer.getControlElement(id);
+
+        // Opening a segment by entry index only requires a search for
+        // variable-sized entries. Opening by cycle count requires temporal
+        // order. For all other streams, an index would not help.
+        if (_skipInterval == 0) {
+            return false;
+        }
+
+        const byte* segment = buffer.getSegment(id);
+        std::vector<SkipIndexSample> samples;
+        std::vector<uint32_t> distances;
+
+        if (isVariableEntrySize(type.entrySize)) {
+            // We sample the first block of every interval-th entry. Each
+            // block occupies a slot of sizeHint bytes. An entry starts with
+            // the slot following the last block of the previous entry. The
+            // offset table records the first slot of every entry relative
+            // to the sample before it, so an entry is found without walking
+            // the blocks in between.
+            const uint32_t sizeHint = getSizeHint(type.entrySize);
+
+            const size_t size = buffer.getSegmentEnd(id, type.entrySize) -
+                segment;
+            const size_t first = findFirstVariableEntry(segment, size,
+                sizeHint, ctrl->entryCount);
+
+            samples.reserve((ctrl->entryCount + _skipInterval - 1) /
+                            _skipInterval);
+            distances.reserve(ctrl->entryCount);
+
+            uint64_t index = 0;
+            uint32_t sampleRaw = 0;
+            bool entryStart = true;
+            for (uint32_t raw = static_cast<uint32_t>(first / sizeHint);
+                 raw < ctrl->rawEntryCount; ++raw) {
+                const size_t offset = getVBufferOffsetFromIndex(raw,
+                                                                sizeHint);
+                const VDataBlockHeader* header =
+                    reinterpret_cast<const VDataBlockHeader*>(
+                        segment + offset);
+
+                if (entryStart) {
+                    ThrowOn(index >= ctrl->entryCount, Exception,
+                            "Variable-sized entries are corrupted.");
+
+                    if (index % _skipInterval == 0) {
+                        SkipIndexSample sample;
+                        sample.cycleCount = 0;
+                        sample.index      = index;
+                        sample.offset     = offset;
+
+                        samples.push_back(sample);
+                        sampleRaw = raw;
+                    }
+
+                    distances.push_back(raw - sampleRaw);
+                    index++;
+                }
+
+                entryStart = !header->continuation;
+            }
+
+        } else if (IsSet(type.flags, StreamTypeFlags::StfTemporalOrder)) {
+            assert(ctrl->entryCount == ctrl->rawEntryCount);
+            if (ctrl->entryCount <= _skipInterval) {
+                return false;
+            }
+
+            const CycleCount cycleMask = TEMPORAL_ORDER_CYCLE_COUNT_MASK;
+
+            samples.resize((ctrl->rawEntryCount + _skipInterval - 1) /
+                           _skipInterval);
+
+            for (uint32_t i = 0; i < samples.size(); ++i) {
+                SkipIndexSample& sample = samples[i];
+
+                sample.index  = static_cast<uint64_t>(i) * _skipInterval;
+                sample.offset = sample.index * type.entrySize;
+
+                sample.cycleCount = *reinterpret_cast<const CycleCount*>(
+                    segment + sample.offset) & cycleMask;
+            }
+
+        } else {
+            return false;
+        }
+
+        if (samples.empty()) {
+            return false;
+        }
+
+        const size_t indexSize = SIMTRACE_V3_SKIP_INDEX_SIZE(samples.size());
+        uint32_t width = 0;
+
+        if (!distances.empty()) {
+            const uint32_t maxDistance =
+                *std::max_element(distances.begin(), distances.end());
+            width = (maxDistance > 0xffff) ? sizeof(uint32_t) :
+                                             sizeof(uint16_t);
+
+            indexOut.resize(indexSize +
+                SIMTRACE_V3_ENTRY_OFFSETS_SIZE(distances.size(), width));
+        } else {
+            indexOut.resize(indexSize);
+        }
+
+        AttributeSkipIndex* index =
+            reinterpret_cast<AttributeSkipIndex*>(indexOut.data());
+
+        index->interval    = _skipInterval;
+        index->sampleCount = static_cast<uint32_t>(samples.size());
+
+        memcpy(index->samples, samples.data(),
+               samples.size() * sizeof(SkipIndexSample));
+
+        if (width > 0) {
+            SkipIndexEntryOffsets* offsets =
+                reinterpret_cast<SkipIndexEntryOffsets*>(
+                    indexOut.data() + indexSize);
+
+            offsets->entryCount = static_cast<uint32_t>(distances.size());
+            offsets->width      = width;
+
+            if (width == sizeof(uint32_t)) {
+                memcpy(offsets->offsets, distances.data(),
+                       distances.size() * sizeof(uint32_t));
+            } else {
+                uint16_t* out = reinterpret_cast<uint16_t*>(offsets->offsets);
+                for (size_t i = 0; i < distances.size(); ++i) {
+                    out[i] = static_cast<uint16_t>(distances[i]);
+                }
+            }
+        }
+
+        return true;
+    }
+
+    void Simtrace3Encoder::_loadIndex(Simtrace3Frame& frame,
+                                      Simtrace3StorageLocation& location)
+    {
+        // The index does not change. We thus only load it once.
+        if (!location.skipIndex.empty()) {
+            return;
+        }
+
+        const AttributeHeaderDescription* attr =
+            frame.findAttribute(Simtrace3AttributeType::SatSkipIndex);
+        if (attr == nullptr) {
+            return;
+        }
+
+        const AttributeSkipIndex* index =
+            reinterpret_cast<const AttributeSkipIndex*>(attr->buffer);
+
+        ThrowOn((attr->header.size < SIMTRACE_V3_SKIP_INDEX_SIZE(1)) ||
+                (attr->header.size <
+                    SIMTRACE_V3_SKIP_INDEX_SIZE(index->sampleCount)) ||
+                (index->sampleCount == 0), Exception,
+                "Corrupted skip index.");
+
+        location.skipIndex.assign(index->samples,
+                                  index->samples + index->sampleCount);
+
+        // The entry offset table is optional
+        const uint64_t indexSize =
+            SIMTRACE_V3_SKIP_INDEX_SIZE(index->sampleCount);
+        if (attr->header.size == indexSize) {
+            return;
+        }
+
+        const SkipIndexEntryOffsets* offsets =
+            reinterpret_cast<const SkipIndexEntryOffsets*>(
+                reinterpret_cast<const byte*>(attr->buffer) + indexSize);
+
+        ThrowOn((attr->header.size - indexSize <
+                    SIMTRACE_V3_ENTRY_OFFSETS_SIZE(0, 0)) ||
+                ((offsets->width != sizeof(uint16_t)) &&
+                 (offsets->width != sizeof(uint32_t))) ||
+                (attr->header.size - indexSize <
+                    SIMTRACE_V3_ENTRY_OFFSETS_SIZE(offsets->entryCount,
+                                                   offsets->width)),
+                Exception, "Corrupted entry offset table.");
+
+        location.entryOffsets.assign(offsets->offsets, offsets->offsets +
+            offsets->entryCount * offsets->width);
+        location.entryOffsetWidth = offsets->width;
+    }
+
+    bool Simtrace3Encoder::findEntryRange(const StorageLocation& location,
+                                          QueryIndexType type, uint64_t value,
+                                          EntryRange& rangeOut)
+    {
+        const Simtrace3StorageLocation& sim3location =
+            static_cast<const Simtrace3StorageLocation&>(location);
+
+        // The index is loaded with the frame, when the segment is written
+        // or decoded. Segments are only searched after decoding, so we do
+        // not have to read the frame here.
+        const std::vector<SkipIndexSample>& samples = sim3location.skipIndex;
+        if (samples.empty()) {
+            return false;
+        }
+
+        const SkipIndexSample* begin = samples.data();
+        const SkipIndexSample* end = begin + samples.size();
+        const SkipIndexSample* first;
+        const SkipIndexSample* last;
+
+        switch (type)
+        {
+            case QueryIndexType::QIndex: {
+                if (!isVariableEntrySize(_stream->getType().entrySize)) {
+                    return false;
+                }
+
+                assert(value >= location.ranges.ranges[QIndex].start);
+                value -= location.ranges.ranges[QIndex].start;
+
+                // The entry lies between the last sample at or before it
+                // and the next sample.
+                last = std::upper_bound(begin, end, value,
+                    [](uint64_t v, const SkipIndexSample& s) {
+                        return v < s.index; });
+
+                ThrowOn(last == begin, Exception, "Corrupted skip index.");
+                first = last - 1;
+
+                // With the offset table, we can directly point to the entry.
+                const std::vector<byte>& offsets = sim3location.entryOffsets;
+                const uint32_t width = sim3location.entryOffsetWidth;
+                if ((width > 0) && (value < offsets.size() / width)) {
+                    const uint32_t sizeHint =
+                        getSizeHint(_stream->getType().entrySize);
+
+                    uint32_t distance;
+                    if (width == sizeof(uint32_t)) {
+                        distance = reinterpret_cast<const uint32_t*>(
+                            offsets.data())[value];
+                    } else {
+                        distance = reinterpret_cast<const uint16_t*>(
+                            offsets.data())[value];
+                    }
+
+                    rangeOut.startIndex  = value;
+                    rangeOut.startOffset = static_cast<size_t>(first->offset +
+                        getVBufferOffsetFromIndex(distance, sizeHint));
+                    rangeOut.endIndex    = value + 1;
+
+                    return true;
+                }
+
+                break;
+            }
+
+            case QueryIndexType::QCycleCount: {
+                if (!IsSet(_stream->getType().flags,
+                           StreamTypeFlags::StfTemporalOrder)) {
+                    return false;
+                }
+
+                // The entry lies after the last sample with a lower cycle
+                // count and before the first sample with a higher one.
+                first = std::lower_bound(begin, end, value,
+                    [](const SkipIndexSample& s, CycleCount v) {
+                        return s.cycleCount < v; });
+                last = std::upper_bound(first, end, value,
+                    [](CycleCount v, const SkipIndexSample& s) {
+                        return v < s.cycleCount; });
+
+                if (first != begin) {
+                    first--;
+                }
+
+                break;
+            }
+
+            default: {
+                return false;
+            }
+        }
+
+        rangeOut.startIndex  = first->index;
+        rangeOut.startOffset = static_cast<size_t>(first->offset);
+        rangeOut.endIndex    = (last != end) ? last->index :
+            std::numeric_limits<uint64_t>::max();
+
+        return true;
+    }
+
     ServerStream* Simtrace3Encoder::_getStream() const
     {
         return _stream;
@@ -193,6 +597,10 @@ namespace Simtrace
         std::unique_ptr<WorkItemBase> workItem(
             new WorkItem<WorkerContext>(_writerMain, ctx));
 
+        // Keep the segments of a stream on the same worker, so it finds
+        // the stream's encoder state in its caches.
+        workItem->setAffinity(_getStream()->getId());
+
         // Hidden streams are usually the backbone for other encoders. Encoding
         // these gets highest priority before jobs on hidden streams starve
         // because of too many new jobs from the client and eventually livelock
@@ -224,6 +632,7 @@ namespace Simtrace
         } else {
             std::unique_ptr<WorkItemBase> workItem(
                 new WorkItem<WorkerContext>(_readerMain, ctx));
+            workItem->setAffinity(_getStream()->getId());
 
             WorkQueue::Priority prio =
                 IsSet(_getStream()->getDescriptor().flags, StreamFlags::SfHidden) ?
@@ -241,8 +650,14 @@ namespace Simtrace
     std::unique_ptr<StorageLocation> Simtrace3Encoder::makeStorageLocation(
             Simtrace3Frame& frame)
     {
-        return std::unique_ptr<StorageLocation>(
+        std::unique_ptr<Simtrace3StorageLocation> location(
             new Simtrace3StorageLocation(frame));
+
+        // Frames of new segments carry the index. When opening a store, the
+        // frame only holds the header and the index is loaded on decode.
+        _loadIndex(frame, *location);
+
+        return std::unique_ptr<StorageLocation>(location.release());
     };
 
 }
@@ -43,7 +43,12 @@ namespace Simtrace
         ServerStream* _stream;
         bool _needScratch;
 
+        // Number of entries between two samples of the skip index. 0
+        // disables the skip index.
+        uint32_t _skipInterval;
+
         struct WorkerContext;
+        struct CommitContext;
 
         virtual void _encode(Simtrace3Frame& frame, SegmentId id,
                              StreamSegmentId sequenceNumber,
@@ -57,12 +62,27 @@ namespace Simtrace
         static void _readerMain(WorkItem<WorkerContext>& workItem,
                                 WorkerContext& context);
 
+        static void _commitMain(
+            WorkItem<std::shared_ptr<CommitContext>>& workItem,
+            std::shared_ptr<CommitContext>& context);
+        static void _commitFrame(CommitContext& context);
+
+        bool _buildIndex(ServerStreamBuffer& buffer, SegmentId id,
+                         std::vector<byte>& indexOut) const;
+
     protected:
         ServerStream* _getStream() const;
 
+        // Keeps the skip index and the entry offset table of the frame
+        // with the storage location.
+        // Encoders call this when they read the frame to decode a segment.
+        void _loadIndex(Simtrace3Frame& frame,
+                        Simtrace3StorageLocation& location);
+
     public:
         Simtrace3Encoder(ServerStore& store, const std::string& friendlyName,
-                         ServerStream* stream, bool needScratch);
+                         ServerStream* stream, bool needScratch,
+                         bool needIndex);
         virtual ~Simtrace3Encoder() override;
 
         virtual void initialize(Simtrace3Frame& frame, bool isOpen) { };
@@ -73,6 +93,10 @@ namespace Simtrace
         virtual bool write(ServerStreamBuffer& buffer, SegmentId segment,
                            std::unique_ptr<StorageLocation>& locationOut) override;
 
+        virtual bool findEntryRange(const StorageLocation& location,
+                                    QueryIndexType type, uint64_t value,
+                                    EntryRange& rangeOut) override;
+
         std::unique_ptr<StorageLocation> makeStorageLocation(
             Simtrace3Frame& frame);
     };
@@ -43,6 +43,7 @@ namespace Simtrace
         SatData              = 0x00,
         SatStreamDescription = 0x01,
         SatAssociatedStreams = 0x02,
+        SatSkipIndex         = 0x03,
 
         /* Encoders can freely use the types from this base on */
         SatEncoderSpecific   = 0x20,
@@ -75,13 +76,82 @@ namespace Simtrace
 
         uint8_t type;
 
-        uint8_t reserved0[3];
+        /* Compression codec used for the attribute payload. See
+           Compression::CodecId. Older writers leave this 0 (LZMA). */
+        uint8_t codec;
+
+        /* See SIMTRACE_V3_ATTRIBUTE_FLAG_* */
+        uint8_t flags;
+
+        uint8_t reserved0[1];
         uint64_t reserved1;
 
         uint64_t size;
         uint64_t uncompressedSize;
     };
 
+    /* The payload is split into independently compressed blocks and starts
+       with an AttributeBlockTable. */
+#define SIMTRACE_V3_ATTRIBUTE_FLAG_BLOCKS 0x01
+
+    /* Blocks can be compressed and decompressed in parallel. All blocks
+       except the last one hold blockSize bytes of uncompressed data. The
+       offsets are relative to the end of the table. offsets[blockCount]
+       marks the end of the last block. */
+    struct AttributeBlockTable {
+        uint32_t blockCount;
+        uint32_t reserved0;
+
+        uint64_t blockSize;
+        uint64_t offsets[1];
+    };
+
+#define SIMTRACE_V3_BLOCK_TABLE_SIZE(blockCount) \
+    (offsetof(AttributeBlockTable, offsets) + \
+     ((blockCount) + 1) * sizeof(uint64_t))
+
+    /* The skip index of a data frame samples the position of every
+       interval-th entry in the uncompressed segment. The first sample
+       describes the first entry. For streams with temporal order, the
+       samples refer to raw entries and record their cycle count. For
+       streams with variable-sized entries, the samples refer to the
+       entries starting in the segment and point to their first block. The
+       cycle count is 0 in that case. With blocks, the block holding a
+       sample follows from the offset and the block size. */
+    struct SkipIndexSample {
+        CycleCount cycleCount;
+        uint64_t index;
+        uint64_t offset;
+    };
+
+    struct AttributeSkipIndex {
+        uint32_t interval;
+        uint32_t sampleCount;
+
+        SkipIndexSample samples[1];
+    };
+
+#define SIMTRACE_V3_SKIP_INDEX_SIZE(sampleCount) \
+    (offsetof(AttributeSkipIndex, samples) + \
+     (sampleCount) * sizeof(SkipIndexSample))
+
+    /* For streams with variable-sized entries, the skip index is followed
+       by an entry offset table. It holds for every entry starting in the
+       segment the distance in slots of sizeHint bytes from the entry's first
+       block to the first block of the entry sampled before it. The
+       distances are stored with 2 bytes each, or with 4 bytes if any of
+       them exceeds 0xffff. */
+    struct SkipIndexEntryOffsets {
+        uint32_t entryCount;
+        uint32_t width;
+
+        byte offsets[1];
+    };
+
+#define SIMTRACE_V3_ENTRY_OFFSETS_SIZE(entryCount, width) \
+    (offsetof(SkipIndexEntryOffsets, offsets) + \
+     (entryCount) * (width))
+
     struct AttributeHeaderLink {
         uint64_t type               : 8;
         uint64_t reserved0          : 8;
@@ -118,7 +118,9 @@ namespace Simtrace
     void Simtrace3Frame::addAttribute(Simtrace3AttributeType type,
                                       uint64_t uncompressedSize,
                                       uint64_t size,
-                                      void* buffer)
+                                      void* buffer,
+                                      uint8_t codec,
+                                      uint8_t flags)
     {
         AttributeHeaderDescription description;
         memset(&description, 0, sizeof(AttributeHeaderDescription));
@@ -133,6 +135,8 @@ namespace Simtrace
         attrHeader->type             = type;
         attrHeader->size             = size;
         attrHeader->uncompressedSize = uncompressedSize;
+        attrHeader->codec            = codec;
+        attrHeader->flags            = flags;
 
         attrHeader->reserved1        = 0;
         memset(attrHeader->reserved0, 0, sizeof(attrHeader->reserved0));
@@ -56,7 +56,8 @@ namespace Simtrace
                           void* buffer);
         void addAttribute(Simtrace3AttributeType type,
                           uint64_t uncompressedSize,
-                          uint64_t size, void* buffer);
+                          uint64_t size, void* buffer,
+                          uint8_t codec = 0, uint8_t flags = 0);
         void addAttribute(AttributeHeaderDescription& desc);
 
         AttributeHeaderDescription* findAttribute(Simtrace3AttributeType type);
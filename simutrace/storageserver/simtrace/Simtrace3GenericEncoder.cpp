@@ -26,12 +26,12 @@
 #include "../ServerStreamBuffer.h"
 
 #include "../StorageServer.h"
-#include "../WorkItem.h"
 #include "../WorkerPool.h"
 
 #include "Simtrace3Store.h"
 #include "Simtrace3Frame.h"
 #include "Simtrace3Encoder.h"
+#include "Simtrace3Blocks.h"
 
 #include "ProfileSimtrace3GenericEncoder.h"
 
@@ -41,8 +41,38 @@ namespace Simtrace
 
     Simtrace3GenericEncoder::Simtrace3GenericEncoder(ServerStore& store,
                                                      ServerStream* stream) :
-        Simtrace3Encoder(store, "Simtrace3 LZMA Encoder", stream, true)
+        Simtrace3Encoder(store, "Simtrace3 Generic Encoder", stream, true,
+                         true),
+        _codec(nullptr),
+        _level(0),
+        _blockSize(0)
     {
+        std::string codecName = Configuration::get<std::string>(
+            "store.simtrace.codec");
+
+        _codec = Compression::findCodec(codecName);
+        ThrowOnNull(_codec, ConfigurationException, stringFormat(
+                    "Unknown compression codec '%s' specified in "
+                    "store.simtrace.codec.", codecName.c_str()));
+
+        int level = Configuration::get<int>("store.simtrace.codecLevel");
+        if (level < 0) {
+            _level = _codec->defaultLevel;
+        } else if (static_cast<uint32_t>(level) > _codec->maxLevel) {
+            LogWarn("Compression level %d exceeds the maximum level of "
+                    "codec '%s'. Using level %d.", level, _codec->name,
+                    _codec->maxLevel);
+
+            _level = _codec->maxLevel;
+        } else {
+            _level = static_cast<uint32_t>(level);
+        }
+
+        int blockSize = Configuration::get<int>("store.simtrace.blockSize");
+        if (blockSize > 0) {
+            _blockSize = static_cast<size_t>(blockSize) MiB;
+        }
+
         profileCreateProfiler();
     }
 
@@ -63,12 +93,43 @@ namespace Simtrace
         size_t sourceLength = getEntrySize(&_getStream()->getType()) *
             ctrl->rawEntryCount;
 
-        targetLength = Compression::lzmaCompress(sourceBuffer, sourceLength,
-                                                 targetBuffer, targetLength,
-                                                 defaultCompressionLevel);
+        Compression::CodecId codec = _codec->id;
+        uint8_t flags = 0;
+
+        try {
+            if ((_blockSize > 0) && (sourceLength > _blockSize)) {
+                targetLength = compressBlocks(
+                    StorageServer::getInstance().getWorkerPool(), *_codec,
+                    _level, _blockSize, sourceBuffer, sourceLength,
+                    targetBuffer, targetLength);
+
+                flags = SIMTRACE_V3_ATTRIBUTE_FLAG_BLOCKS;
+            } else {
+                targetLength = _codec->compress(sourceBuffer, sourceLength,
+                                                targetBuffer, targetLength,
+                                                _level);
+            }
+        } catch (const std::exception& e) {
+            // Incompressible data may not fit into the target buffer. We
+            // rather store the segment uncompressed than losing it.
+            LogWarn("<encoder: '%s'> Compression of segment %d failed "
+                    "<stream: %d, sqn: %d>. Exception: '%s'. The segment "
+                    "will be stored uncompressed.", getFriendlyName().c_str(),
+                    id, _getStream()->getId(), sequenceNumber, e.what());
+
+            targetLength = Compression::storeCompress(sourceBuffer,
+                                                      sourceLength,
+                                                      targetBuffer,
+                                                      target->getLength(),
+                                                      0);
+
+            codec = Compression::CodecId::CiNone;
+            flags = 0;
+        }
 
         frame.addAttribute(Simtrace3AttributeType::SatData, sourceLength,
-                           targetLength, targetBuffer);
+                           targetLength, targetBuffer,
+                           static_cast<uint8_t>(codec), flags);
     }
 
     void Simtrace3GenericEncoder::_decode(Simtrace3StorageLocation& location,
@@ -83,6 +144,8 @@ namespace Simtrace
         // Load frame description and attributes into memory
         store.readFrame(frame, location);
 
+        _loadIndex(frame, location);
+
         // Find data attribute
         AttributeHeaderDescription* dataAttr = nullptr;
         dataAttr = frame.findAttribute(Simtrace3AttributeType::SatData);
@@ -96,6 +159,13 @@ namespace Simtrace
                 sizeToString(dataAttr->header.uncompressedSize).c_str(),
                 sizeToString(buffer.getSegmentSize()).c_str()));
 
+        // The codec is recorded in the attribute header. Files written
+        // before codecs became selectable carry 0, which maps to LZMA.
+        const Compression::Codec* codec = Compression::findCodec(
+            static_cast<Compression::CodecId>(dataAttr->header.codec));
+
+        ThrowOnNull(codec, NotSupportedException);
+
         // Decompress the input buffer. This may take considerable time!
         void* targetBuffer = buffer.getSegment(id);
         void* sourceBuffer = dataAttr->buffer;
@@ -103,10 +173,14 @@ namespace Simtrace
         size_t targetLength = static_cast<size_t>(buffer.getSegmentSize());
         size_t sourceLength = static_cast<size_t>(dataAttr->header.size);
 
-        targetLength = Compression::lzmaDecompress(sourceBuffer,
-                                                   sourceLength,
-                                                   targetBuffer,
-                                                   targetLength);
+        if (IsSet(dataAttr->header.flags, SIMTRACE_V3_ATTRIBUTE_FLAG_BLOCKS)) {
+            targetLength = decompressBlocks(
+                StorageServer::getInstance().getWorkerPool(), *codec,
+                sourceBuffer, sourceLength, targetBuffer, targetLength);
+        } else {
+            targetLength = codec->decompress(sourceBuffer, sourceLength,
+                                             targetBuffer, targetLength);
+        }
 
         if (targetLength != dataAttr->header.uncompressedSize) {
             LogWarn("Size mismatch after decompression "
@@ -36,7 +36,14 @@ namespace Simtrace
     private:
         DISABLE_COPY(Simtrace3GenericEncoder);
 
-        static const int defaultCompressionLevel = 4;
+        // Codec and level used to compress new segments. Existing
+        // segments are decoded with the codec recorded in their frame.
+        const Compression::Codec* _codec;
+        uint32_t _level;
+
+        // Segments larger than the block size are split into blocks, which
+        // are compressed independently and in parallel. 0 disables blocks.
+        size_t _blockSize;
 
         virtual void _encode(Simtrace3Frame& frame, SegmentId id,
                              StreamSegmentId sequenceNumber,
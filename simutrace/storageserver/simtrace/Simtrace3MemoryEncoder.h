@@ -36,6 +36,7 @@
 #include "VPC4/IpPredictor.h"
 #include "VPC4/ValuePredictor.h"
 #include "VPC4/CyclePredictor.h"
+#include "VPC4/PredictorPool.h"
 
 #include "Simtrace3Store.h"
 #include "Simtrace3Encoder.h"
@@ -112,6 +113,23 @@ namespace Simtrace
         static const uint32_t lineCount = 3;
     };
 
+    // Encoder specific attribute types of the memory encoder
+    enum MemoryAttributeType
+    {
+        // Number of shards per segment (see AttributeMemoryShards)
+        MatShards = Simtrace3AttributeType::SatEncoderSpecific
+    };
+
+    // Segments of memory streams may be split into shards, which are
+    // encoded independently (i.e., each with its own set of predictors).
+    // The number of shards actually used for a segment follows from the
+    // shard count stored in the frame and the segment's entry count (see
+    // Simtrace3MemoryEncoder::_getShardBegin()).
+    struct AttributeMemoryShards {
+        uint32_t shardCount;
+        uint32_t reserved0;
+    };
+
     template<typename T>
     class Simtrace3MemoryEncoder :
         public Simtrace3Encoder
@@ -179,6 +197,25 @@ namespace Simtrace
             static const unsigned char fillChar = 0xFF;
         };
 
+        struct ShardLayout
+        {
+            static const uint32_t maxShardCount = 64;
+
+            // Splitting a segment into tiny shards costs compression without
+            // gaining speed. Each shard thus holds at least this number of
+            // entries. Shard boundaries are aligned so that shards always
+            // start at a byte boundary in the predictor id streams.
+            static const uint32_t minEntryCount = 64 * 1024;
+            static const uint32_t alignment = 4096;
+
+            // The association data of memory streams whose segments may be
+            // sharded carries this layout revision in the upper 16 bits of
+            // the stream count. Readers, which do not know about sharding,
+            // thus refuse to open the stream instead of decoding garbage.
+            static const uint32_t revisionShift = 16;
+            static const uint32_t revision = 1;
+        };
+
         typedef AttributeAssociatedStreams<
             TypeInfo::totalStreamCount
         > AssociatedStreams;
@@ -758,7 +795,58 @@ namespace Simtrace
                 location(location) { }
         };
 
+        // All predictors needed to encode or decode a segment
+        struct PredictorSet
+        {
+            IpPredictor<AddressType> ip;
+            CyclePredictor<CycleCount, AddressType> cycle;
+            ValuePredictor<DataType, AddressType> value[TypeInfo::dataFieldCount];
+
+            void reset(CycleCount startCycle)
+            {
+                ip.reset();
+                cycle.reset(startCycle);
+
+                for (uint32_t i = 0; i < TypeInfo::dataFieldCount; ++i) {
+                    value[i].reset();
+                }
+            }
+        };
+
+        // Buffer pointers of a contiguous range of entries in a segment,
+        // which is encoded independently from the rest of the segment.
+        struct Shard
+        {
+            T* entryBuffer;
+            uint32_t entryCount;
+
+            PredictorId* idBuffers[TypeInfo::idStreamCount];
+            DataType* dataBuffers[TypeInfo::dataStreamCount];
+            CycleCount* cycleDataBuffer;
+            uint16_t* metaDataBuffer;
+        };
+
+        struct ShardContext
+        {
+            Simtrace3MemoryEncoder& encoder;
+            std::vector<Shard>& shards;
+            CycleCount startCycle;
+
+        #ifdef SIMUTRACE_PROFILING_SIMTRACE3_VPC4_PREDICTORS_ENABLE
+            ProfileContext* profileContext;
+        #endif
+
+            ShardContext(Simtrace3MemoryEncoder& encoder,
+                         std::vector<Shard>& shards,
+                         CycleCount startCycle) :
+                encoder(encoder),
+                shards(shards),
+                startCycle(startCycle) { }
+        };
+
     private:
+        static PredictorPool<PredictorSet> _predictorPool;
+
         StreamWait _globalWaitContext;
 
         CriticalSection _lock;
@@ -766,6 +854,16 @@ namespace Simtrace
         bool _initialized;
         SegmentLine _lines[TypeInfo::lineCount];
 
+        // Set if the segments of the stream may be sharded. The attribute is
+        // added to the frame of each segment written.
+        bool _sharded;
+        AttributeMemoryShards _shardAttribute;
+
+        // Shard count read from the first decoded frame. The writer uses the
+        // same count for all segments of a stream, so we read the frame only
+        // once instead of for every segment. 0 if not read, yet.
+        std::atomic<uint32_t> _decodeShardCount;
+
     #ifdef SIMUTRACE_PROFILING_SIMTRACE3_VPC4_PREDICTORS_ENABLE
         std::unique_ptr<Profiler> _profiler;
     #endif
@@ -851,16 +949,30 @@ namespace Simtrace
             if (assoc != nullptr) {
                 // We are opening a store and should only restore the
                 // stream association. The streams are already registered.
-                ThrowOn(assoc->streamCount != TypeInfo::totalStreamCount,
+                const uint32_t revision =
+                    assoc->streamCount >> ShardLayout::revisionShift;
+                const uint32_t streamCount = assoc->streamCount &
+                    ((1 << ShardLayout::revisionShift) - 1);
+
+                ThrowOn((streamCount != TypeInfo::totalStreamCount) ||
+                        (revision > ShardLayout::revision),
                         Exception, stringFormat("Corrupted or incompatible "
                             "stream association data for stream %d. Expected "
-                            "%d streams, found %d.", _getStream()->getId(),
-                            TypeInfo::totalStreamCount, assoc->streamCount));
+                            "%d streams, found %d (revision %d).",
+                            _getStream()->getId(),
+                            TypeInfo::totalStreamCount, streamCount,
+                            revision));
+
+                _sharded = (revision >= ShardLayout::revision);
 
                 // We have to reset the stream counter so we make a private
                 // copy of the attribute.
                 assocStreams = *assoc;
                 assocStreams.streamCount = 0;
+            } else {
+                // New streams use the sharded layout only if requested, so
+                // that older readers can still read the trace otherwise.
+                _sharded = (_shardAttribute.shardCount > 1);
             }
 
             // Meta data
@@ -901,6 +1013,11 @@ namespace Simtrace
                 // stream so we know from which hidden streams to read later
                 Simtrace3Frame frame(_getStream());
 
+                if (_sharded) {
+                    assocStreams.streamCount |=
+                        ShardLayout::revision << ShardLayout::revisionShift;
+                }
+
                 frame.addAttribute(Simtrace3AttributeType::SatAssociatedStreams,
                                    sizeof(AssociatedStreams), &assocStreams);
 
@@ -911,6 +1028,29 @@ namespace Simtrace
             _initialized = true;
         }
 
+        std::unique_ptr<PredictorSet> _acquirePredictors(CycleCount startCycle)
+        {
+            bool isNew;
+            std::unique_ptr<PredictorSet> predictors =
+                _predictorPool.acquire(isNew);
+
+            // Encoder and decoder must start with identically initialized
+            // predictors, so a reused set needs a reset.
+            if (isNew) {
+                predictors->cycle.setCycleCount(startCycle);
+            } else {
+                predictors->reset(startCycle);
+            }
+
+            return predictors;
+        }
+
+        void _releasePredictors(std::unique_ptr<PredictorSet>& predictors)
+        {
+            _predictorPool.release(predictors,
+                StorageServer::getInstance().getWorkerPool().getWorkerCount());
+        }
+
         inline void _ensureInitialized()
         {
             // We lazily create the hidden streams to avoid running into
@@ -922,147 +1062,328 @@ namespace Simtrace
             }
         }
 
-        virtual void _encode(Simtrace3Frame& frame, SegmentId id,
-                             StreamSegmentId sequenceNumber,
-                             ScratchSegment* target) override
+        static uint32_t _getShardBegin(uint32_t shardCount, uint32_t entryCount,
+                                       uint32_t index)
         {
-            assert(_initialized);
+            assert(shardCount > 0);
 
-            SubSegmentContext ctx(*this, _getStream(), id, sequenceNumber, false);
+            // Use fewer shards for small segments
+            uint32_t count = std::max<uint32_t>(1, std::min<uint32_t>(
+                shardCount, entryCount / ShardLayout::minEntryCount));
 
-            // Copy the start pointers for the data buffers. We need them later
-            // to compute the unused sub segment size.
-            byte* orgDataBuffers[TypeInfo::dataStreamCount];
-            memcpy(orgDataBuffers, ctx.dataBuffers, sizeof(orgDataBuffers));
-            byte* orgCycleBuffer = (byte*)ctx.cycleDataBuffer;
+            uint32_t size = (entryCount + count - 1) / count;
+            size = (size + ShardLayout::alignment - 1) &
+                ~(ShardLayout::alignment - 1);
 
-            // Create and initialize the predictors.
-            std::unique_ptr<IpPredictor<AddressType>> ipPredictor(
-                new IpPredictor<AddressType>());
-            std::unique_ptr<CyclePredictor<CycleCount, AddressType>> cyclePredictor(
-                new CyclePredictor<CycleCount, AddressType>(ctx.getStartCycle()));
-            std::unique_ptr<ValuePredictor<DataType, AddressType>[]> valuePredictor(
-                new ValuePredictor<DataType, AddressType>[TypeInfo::dataFieldCount]);
+            return std::min<uint64_t>(static_cast<uint64_t>(index) * size,
+                                      entryCount);
+        }
+
+        // Sets up the buffer pointers of all shards in the given sub segment
+        // context. Shard i encodes the entries [begin_i, begin_i+1) and
+        // places its output at the same offset in every hidden stream. Since
+        // each entry needs at most one id and one data field per stream, the
+        // output of a shard never overlaps with the next one.
+        void _setupShards(SubSegmentContext& ctx, uint32_t shardCount,
+                          std::vector<Shard>& shards)
+        {
+            const uint32_t entryCount = ctx.getEntryCount();
+
+            for (uint32_t i = 0; i < shardCount; ++i) {
+                uint32_t begin = _getShardBegin(shardCount, entryCount, i);
+                uint32_t end = _getShardBegin(shardCount, entryCount, i + 1);
+                if ((begin == end) && (i > 0)) {
+                    break;
+                }
+
+                Shard shard;
+                shard.entryBuffer = ctx.entryBuffer + begin;
+                shard.entryCount  = end - begin;
+
+                for (uint32_t j = 0; j < TypeInfo::idStreamCount; ++j) {
+                #ifdef VPC_HALF_BYTE_ENCODING
+                    shard.idBuffers[j] = ctx.idBuffers[j] + begin / 2;
+                #else
+                    shard.idBuffers[j] = ctx.idBuffers[j] + begin;
+                #endif
+                }
+
+                for (uint32_t j = 0; j < TypeInfo::dataStreamCount; ++j) {
+                    shard.dataBuffers[j] = ctx.dataBuffers[j] + begin;
+                }
+
+                shard.cycleDataBuffer = ctx.cycleDataBuffer + begin;
+                shard.metaDataBuffer  = ctx.metaDataBuffer + begin;
+
+                shards.push_back(shard);
+            }
+
+            assert(!shards.empty());
+        }
+
+        void _processShards(SubSegmentContext& ctx, std::vector<Shard>& shards,
+                            WorkerPool::ParallelMain main)
+        {
+            ShardContext context(*this, shards, ctx.getStartCycle());
 
         #ifdef SIMUTRACE_PROFILING_SIMTRACE3_VPC4_PREDICTORS_ENABLE
-            cyclePredictor.addToProfileContext(ctx.profileContext, "cc");
-            ipPredictor.addToProfileContext(ctx.profileContext, "ip");
+            context.profileContext = &ctx.profileContext;
+        #endif
+
+            if (shards.size() == 1) {
+                main(&context, 0);
+            } else {
+                // The shards are part of work that is already in progress.
+                // We therefore process them with high priority to quickly
+                // release the segment again.
+                StorageServer::getInstance().getWorkerPool().runParallel(
+                    static_cast<uint32_t>(shards.size()), main, &context,
+                    WorkQueue::Priority::High);
+            }
+        }
+
+        static void _encodeShard(void* context, uint32_t index)
+        {
+            ShardContext* ctx = static_cast<ShardContext*>(context);
+            Shard& shard = ctx->shards[index];
+
+            // Get a set of initialized predictors. Each shard starts with
+            // fresh predictors, so it can be decoded independently.
+            std::unique_ptr<PredictorSet> predictors =
+                ctx->encoder._acquirePredictors(ctx->startCycle);
+
+            IpPredictor<AddressType>* ipPredictor = &predictors->ip;
+            CyclePredictor<CycleCount, AddressType>* cyclePredictor =
+                &predictors->cycle;
+            ValuePredictor<DataType, AddressType>* valuePredictor =
+                predictors->value;
+
+        #ifdef SIMUTRACE_PROFILING_SIMTRACE3_VPC4_PREDICTORS_ENABLE
+            assert(ctx->shards.size() == 1);
+            cyclePredictor->addToProfileContext(*ctx->profileContext, "cc");
+            ipPredictor->addToProfileContext(*ctx->profileContext, "ip");
             for (int i = 0; i < TypeInfo::dataFieldCount; ++i) {
-                valuePredictor[i].addToProfileContext(ctx.profileContext,
+                valuePredictor[i].addToProfileContext(*ctx->profileContext,
                     stringFormat("v[%d]",i).c_str());
             }
         #endif
 
-            uint32_t entryCount = ctx.getEntryCount();
-            for (uint32_t j = 0; j < entryCount; ++j, ++ctx.entryBuffer) {
-                const T* entry = ctx.entryBuffer;
+            const T* entry = shard.entryBuffer;
+            for (uint32_t j = 0; j < shard.entryCount; ++j, ++entry) {
 
                 // Encode instruction pointer
-                ipPredictor->encodeIp(&ctx.idBuffers[0],
-                                      &ctx.dataBuffers[0],
+                ipPredictor->encodeIp(&shard.idBuffers[0],
+                                      &shard.dataBuffers[0],
                                       entry->ip);
 
                 // Encode value fields (address and potentially data)
                 for (uint32_t i = 0; i < TypeInfo::dataFieldCount; ++i) {
-                    valuePredictor[i].encodeValue(&ctx.idBuffers[i + 1],
-                                                  &ctx.dataBuffers[i + 1],
+                    valuePredictor[i].encodeValue(&shard.idBuffers[i + 1],
+                                                  &shard.dataBuffers[i + 1],
                                                   entry->dataFields[i],
                                                   entry->ip);
                 }
 
                 // Encode metadata (incl. cycle count)
                 static const uint32_t ccidx = 1 + TypeInfo::dataFieldCount;
-                cyclePredictor->encodeCycle(&ctx.idBuffers[ccidx],
-                                            &ctx.cycleDataBuffer,
+                cyclePredictor->encodeCycle(&shard.idBuffers[ccidx],
+                                            &shard.cycleDataBuffer,
                                             entry->metadata.cycleCount,
                                             entry->ip);
 
-                *ctx.metaDataBuffer = static_cast<uint16_t>(
+                *shard.metaDataBuffer = static_cast<uint16_t>(
                     (entry->metadata.value & ~TEMPORAL_ORDER_CYCLE_COUNT_MASK)
                     >> TEMPORAL_ORDER_CYCLE_COUNT_BITS);
-                ctx.metaDataBuffer++;
+                shard.metaDataBuffer++;
             }
 
-            // For every successful prediction, the data space is not used and
-            // there is still the data present from the last use of the
-            // hidden stream segment in the stream buffer. To improve
-            // compression, we fill up the remaining space in the sub segments
-            // with a special char.
-            // N.B. We do not fill remaining space for id buffers and the meta
-            // buffer. For these only the last segment will not be entirely
-            // filled. Doing checks here all the time is thus in 99% useless
-            // and we are better off with less compression of the single last
-            // segment.
-            for (uint32_t i = 0; i < TypeInfo::dataStreamCount; ++i) {
-                size_t usedSpace, remainingSpace;
-
-                usedSpace = (size_t)ctx.dataBuffers[i] - (size_t)orgDataBuffers[i];
-                remainingSpace = MemoryLayout::dataSubSegmentSize - usedSpace;
-                memset(ctx.dataBuffers[i], MemoryLayout::fillChar, remainingSpace);
-            }
-
-            size_t usedCycleSpace = (byte*)ctx.cycleDataBuffer - orgCycleBuffer;
-            size_t remainingCycleSpace = MemoryLayout::cycleSubSegmentSize - usedCycleSpace;
-            memset(ctx.cycleDataBuffer, MemoryLayout::fillChar, remainingCycleSpace);
-
-            // Mark the subsegment to contain valid data
-            ctx.markValid();
+            ctx->encoder._releasePredictors(predictors);
         }
 
-        virtual void _decode(Simtrace3StorageLocation& location, SegmentId id,
-                             StreamSegmentId sequenceNumber) override
+        static void _decodeShard(void* context, uint32_t index)
         {
-            assert(_initialized);
-
-            SubSegmentContext ctx(*this, _getStream(), id, sequenceNumber, true);
+            ShardContext* ctx = static_cast<ShardContext*>(context);
+            Shard& shard = ctx->shards[index];
 
             CycleCount cycleCount = 0;
 
-            std::unique_ptr<IpPredictor<AddressType>> ipPredictor(
-                new IpPredictor<AddressType>());
-            std::unique_ptr<CyclePredictor<CycleCount, AddressType>> cyclePredictor(
-                new CyclePredictor<CycleCount, AddressType>(ctx.getStartCycle()));
-            std::unique_ptr<ValuePredictor<DataType, AddressType>[]> valuePredictor(
-                new ValuePredictor<DataType, AddressType>[TypeInfo::dataFieldCount]);
+            std::unique_ptr<PredictorSet> predictors =
+                ctx->encoder._acquirePredictors(ctx->startCycle);
+
+            IpPredictor<AddressType>* ipPredictor = &predictors->ip;
+            CyclePredictor<CycleCount, AddressType>* cyclePredictor =
+                &predictors->cycle;
+            ValuePredictor<DataType, AddressType>* valuePredictor =
+                predictors->value;
 
-            uint32_t entryCount = ctx.getEntryCount();
-            for (uint32_t j = 0; j < entryCount; ++j, ++ctx.entryBuffer) {
-                T* entry = ctx.entryBuffer;
+            T* entry = shard.entryBuffer;
+            for (uint32_t j = 0; j < shard.entryCount; ++j, ++entry) {
 
                 // Decode the instruction pointer. We use this as key for
                 // most of the other members.
-                ipPredictor->decodeIp(&ctx.idBuffers[0],
-                                      &ctx.dataBuffers[0],
+                ipPredictor->decodeIp(&shard.idBuffers[0],
+                                      &shard.dataBuffers[0],
                                       entry->ip);
 
                 // Decode the value fields (address and potentially data)
                 for (uint32_t i = 0; i < TypeInfo::dataFieldCount; ++i) {
-                    valuePredictor[i].decodeValue(&ctx.idBuffers[i + 1],
-                                                  &ctx.dataBuffers[i + 1],
+                    valuePredictor[i].decodeValue(&shard.idBuffers[i + 1],
+                                                  &shard.dataBuffers[i + 1],
                                                   entry->ip,
                                                   entry->dataFields[i]);
                 }
 
                 // Decode metadata (incl. cycle count).
                 entry->metadata.value =
-                    (static_cast<uint64_t>(*ctx.metaDataBuffer)
+                    (static_cast<uint64_t>(*shard.metaDataBuffer)
                     << TEMPORAL_ORDER_CYCLE_COUNT_BITS);
-                ctx.metaDataBuffer++;
+                shard.metaDataBuffer++;
 
                 static const uint32_t ccidx = 1 + TypeInfo::dataFieldCount;
-                cyclePredictor->decodeCycle(&ctx.idBuffers[ccidx],
-                                            &ctx.cycleDataBuffer,
+                cyclePredictor->decodeCycle(&shard.idBuffers[ccidx],
+                                            &shard.cycleDataBuffer,
                                             entry->ip, cycleCount);
 
                 entry->metadata.cycleCount = cycleCount;
             }
+
+            ctx->encoder._releasePredictors(predictors);
+        }
+
+        virtual void _encode(Simtrace3Frame& frame, SegmentId id,
+                             StreamSegmentId sequenceNumber,
+                             ScratchSegment* target) override
+        {
+            assert(_initialized);
+
+            SubSegmentContext ctx(*this, _getStream(), id, sequenceNumber, false);
+
+            // Record the shard count in the frame, so the decoder can
+            // reconstruct the shard boundaries.
+            uint32_t shardCount = 1;
+            if (_sharded) {
+                shardCount = _shardAttribute.shardCount;
+
+                frame.addAttribute(
+                    static_cast<Simtrace3AttributeType>(MatShards),
+                    sizeof(AttributeMemoryShards), &_shardAttribute);
+            }
+
+            std::vector<Shard> shards;
+            _setupShards(ctx, shardCount, shards);
+
+            _processShards(ctx, shards, _encodeShard);
+
+            // For every successful prediction, the data space is not used and
+            // there is still the data present from the last use of the
+            // hidden stream segment in the stream buffer. To improve
+            // compression, we fill up the remaining space in the sub segments
+            // (i.e., the gap behind each shard) with a special char.
+            // N.B. We do not fill remaining space for id buffers and the meta
+            // buffer. For these only the last segment will not be entirely
+            // filled. Doing checks here all the time is thus in 99% useless
+            // and we are better off with less compression of the single last
+            // segment.
+            for (uint32_t k = 0; k < shards.size(); ++k) {
+                Shard& shard = shards[k];
+
+                // Each shard may use the space up to the beginning of the
+                // next shard. The last one gets the rest of the sub segment.
+                size_t dataEnd = MemoryLayout::dataSubSegmentSize /
+                    sizeof(DataType);
+                size_t cycleEnd = MemoryLayout::cycleSubSegmentSize /
+                    sizeof(CycleCount);
+
+                if (k < shards.size() - 1) {
+                    dataEnd = shards[k + 1].entryBuffer - ctx.entryBuffer;
+                    cycleEnd = dataEnd;
+                }
+
+                for (uint32_t i = 0; i < TypeInfo::dataStreamCount; ++i) {
+                    DataType* end = ctx.dataBuffers[i] + dataEnd;
+
+                    assert(shard.dataBuffers[i] <= end);
+                    memset(shard.dataBuffers[i], MemoryLayout::fillChar,
+                           (end - shard.dataBuffers[i]) * sizeof(DataType));
+                }
+
+                CycleCount* end = ctx.cycleDataBuffer + cycleEnd;
+
+                assert(shard.cycleDataBuffer <= end);
+                memset(shard.cycleDataBuffer, MemoryLayout::fillChar,
+                       (end - shard.cycleDataBuffer) * sizeof(CycleCount));
+            }
+
+            // Mark the subsegment to contain valid data
+            ctx.markValid();
+        }
+
+        uint32_t _readShardCount(Simtrace3StorageLocation& location,
+                                 StreamSegmentId sequenceNumber)
+        {
+            Simtrace3Store& store = static_cast<Simtrace3Store&>(_getStore());
+            Simtrace3Frame frame;
+
+            store.readFrame(frame, location);
+
+            AttributeHeaderDescription* attr = frame.findAttribute(
+                static_cast<Simtrace3AttributeType>(MatShards));
+
+            if (attr == nullptr) {
+                return 1;
+            }
+
+            ThrowOn(attr->header.size < sizeof(AttributeMemoryShards),
+                    Exception, "Corrupted shard attribute.");
+
+            uint32_t shardCount = reinterpret_cast<AttributeMemoryShards*>(
+                attr->buffer)->shardCount;
+
+            ThrowOn((shardCount == 0) ||
+                    (shardCount > ShardLayout::maxShardCount),
+                    Exception, stringFormat("Unsupported shard count "
+                        "%d <stream: %d, sqn: %d>.", shardCount,
+                        _getStream()->getId(), sequenceNumber));
+
+            return shardCount;
+        }
+
+        virtual void _decode(Simtrace3StorageLocation& location, SegmentId id,
+                             StreamSegmentId sequenceNumber) override
+        {
+            assert(_initialized);
+
+            uint32_t shardCount = 1;
+            if (_sharded) {
+                shardCount = _decodeShardCount;
+                if (shardCount == 0) {
+                    shardCount = _readShardCount(location, sequenceNumber);
+                    _decodeShardCount = shardCount;
+                }
+            }
+
+            SubSegmentContext ctx(*this, _getStream(), id, sequenceNumber, true);
+
+            std::vector<Shard> shards;
+            _setupShards(ctx, shardCount, shards);
+
+            _processShards(ctx, shards, _decodeShard);
         }
 
     public:
         Simtrace3MemoryEncoder(ServerStore& store, ServerStream* stream) :
-            Simtrace3Encoder(store, "Simtrace3 Memory Encoder", stream, false),
-            _initialized(false)
+            // The decoder does not read the frame of each segment, so it
+            // could not load a skip index. Segments are instead searched
+            // with a binary search after decoding.
+            Simtrace3Encoder(store, "Simtrace3 Memory Encoder", stream, false,
+                             false),
+            _initialized(false),
+            _sharded(false),
+            _decodeShardCount(0)
         {
+            memset(&_shardAttribute, 0, sizeof(AttributeMemoryShards));
+            _shardAttribute.shardCount = 1;
+
             // If this is just an initialization to get the friendly name,
             // we do not have to proceed further.
             if (stream == nullptr) {
@@ -1081,6 +1402,17 @@ namespace Simtrace
             ThrowOn(!IsSet(desc.flags, StreamTypeFlags::StfTemporalOrder),
                     NotSupportedException);
 
+            // The profiler collects the usage of a single set of predictors
+            // per segment. We thus do not shard segments when profiling.
+        #ifndef SIMUTRACE_PROFILING_SIMTRACE3_VPC4_PREDICTORS_ENABLE
+            int shardCount = Configuration::get<int>(
+                "store.simtrace.memoryShards");
+
+            _shardAttribute.shardCount = static_cast<uint32_t>(
+                std::max(1, std::min(shardCount,
+                    static_cast<int>(ShardLayout::maxShardCount))));
+        #endif
+
             // Initialize profiling code, if necessary. The profiler gives us
             // stats on predictor usage when writing.
         #ifdef SIMUTRACE_PROFILING_SIMTRACE3_VPC4_PREDICTORS_ENABLE
@@ -1221,6 +1553,10 @@ namespace Simtrace
         }
     };
 
+    template<typename T>
+    PredictorPool<typename Simtrace3MemoryEncoder<T>::PredictorSet>
+        Simtrace3MemoryEncoder<T>::_predictorPool;
+
 }
 }
 
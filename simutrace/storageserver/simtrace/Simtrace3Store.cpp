@@ -64,6 +64,10 @@ namespace Simtrace
     Simtrace3Store::~Simtrace3Store()
     {
         _finalizeHeader();
+
+        if (Configuration::get<bool>("store.simtrace.logStreamStats")) {
+            _logReadAheadStats();
+        }
     }
 
     void Simtrace3Store::_initializeEncoderMap()
@@ -110,60 +114,167 @@ namespace Simtrace
 
     }
 
-    void Simtrace3Store::_openFrame(FrameDirectoryEntry& entry)
+    struct Simtrace3Store::DirectoryScan
     {
-        const FrameHeader& fheader = entry.framelink.frameHeader;
+        // Metadata frames are opened right away. Their order matters,
+        // so we keep them in the order of the directory.
+        std::vector<FrameHeaderLink> metadata;
+        std::vector<std::pair<StreamId, uint32_t>> frames;
+    };
 
-        // Check if this is a zero frame (i.e., it contains meta data
-        // for the stream and no actual data). In that case, we just
-        // add the meta data to the stream (create it if it does not
-        // exist). Otherwise, we add the segment as data to the stream.
-        if (fheader.sequenceNumber == INVALID_STREAM_SEGMENT_ID) {
-            Simtrace3Frame frame;
-            _readFrame(frame, entry.framelink.offset, fheader.totalSize);
+    struct Simtrace3Store::ScanContext
+    {
+        Simtrace3Store& store;
+        std::vector<DirectoryScan>& scans;
 
-            ThrowOn(!frame.validateHash(), Exception,
-                    "Corrupted metadata frame detected.");
+        ScanContext(Simtrace3Store& store, std::vector<DirectoryScan>& scans) :
+            store(store),
+            scans(scans) { }
+    };
 
-            // Check if we already registered this stream. If not
-            // create it from the frame.
-            ServerStream* stream =
-                static_cast<ServerStream*>(findStream(fheader.streamId));
+    void Simtrace3Store::_openMetadataFrame(const FrameHeaderLink& link)
+    {
+        const FrameHeader& fheader = link.frameHeader;
+        assert(fheader.sequenceNumber == INVALID_STREAM_SEGMENT_ID);
+
+        // This is a zero frame (i.e., it contains meta data for the stream
+        // and no actual data). We just add the meta data to the stream
+        // (create it if it does not exist).
+        Simtrace3Frame frame;
+        _readFrame(frame, link.offset, fheader.totalSize);
+
+        ThrowOn(!frame.validateHash(), Exception,
+                "Corrupted metadata frame detected.");
+
+        // Check if we already registered this stream. If not
+        // create it from the frame.
+        ServerStream* stream =
+            static_cast<ServerStream*>(findStream(fheader.streamId));
+
+        if (stream == nullptr) {
+            stream = _openStream(frame);
+            assert(stream != nullptr);
+        }
 
-            if (stream == nullptr) {
-                stream = _openStream(frame);
-                assert(stream != nullptr);
-            }
+        // The zero frame should not contain data.
+        assert(frame.findAttribute(
+                Simtrace3AttributeType::SatData) == nullptr);
 
-            // The zero frame should not contain data.
-            assert(frame.findAttribute(
-                    Simtrace3AttributeType::SatData) == nullptr);
+        // Inform the encoder about the meta data
+        Simtrace3Encoder& encoder =
+            static_cast<Simtrace3Encoder&>(stream->getEncoder());
 
-            // Inform the encoder about the meta data
-            Simtrace3Encoder& encoder =
-                static_cast<Simtrace3Encoder&>(stream->getEncoder());
+        encoder.initialize(frame, true);
+    }
 
-            encoder.initialize(frame, true);
+    void Simtrace3Store::_openDataFrame(ServerStream& stream,
+                                        const FrameHeaderLink& link)
+    {
+        const FrameHeader& fheader = link.frameHeader;
+        assert(fheader.streamId == stream.getId());
 
-        } else {
-            // This is a data frame. Add the segment to its stream
-            ServerStream& stream =
-                static_cast<ServerStream&>(getStream(fheader.streamId));
-            Simtrace3Encoder& encoder =
-                static_cast<Simtrace3Encoder&>(stream.getEncoder());
+        // This is a data frame. Add the segment to its stream
+        Simtrace3Encoder& encoder =
+            static_cast<Simtrace3Encoder&>(stream.getEncoder());
+
+        Simtrace3Frame frame(fheader);
+
+        auto location = encoder.makeStorageLocation(frame);
+
+        Simtrace3StorageLocation* sim3location =
+            static_cast<Simtrace3StorageLocation*>(location.get());
+
+        sim3location->offset = link.offset;
+        sim3location->size   = fheader.totalSize;
+
+        stream.addSegment(fheader.sequenceNumber, location);
+    }
+
+    void Simtrace3Store::_collectDirectories()
+    {
+        const uint32_t count = _header->v3.directoryCount;
+        const size_t dirSize = _header->v3.directoryCapacity *
+            sizeof(FrameDirectoryEntry);
+
+        _directoryOffsets.clear();
+        _directoryOffsets.reserve(count);
+
+        // The directory table in the header gives us the offsets of the
+        // first directories directly.
+        uint32_t tableCount = std::min<uint32_t>(count,
+            SIMTRACE_V3_DIRECTORY_TABLE_SIZE);
+        for (uint32_t i = 0; i < tableCount; ++i) {
+            FileOffset offset = _header->v3.directories[i];
+            ThrowOn((offset == 0) || (offset + dirSize > _file->getSize()),
+                    Exception, "Directory link corrupted.");
+
+            _directoryOffsets.push_back(offset);
+        }
+
+        // All further directories can only be reached through the link in
+        // the last entry of the preceding directory.
+        while (_directoryOffsets.size() < count) {
+            FrameDirectoryEntry link;
+            _file->read(&link, _directoryOffsets.back() + dirSize -
+                        sizeof(FrameDirectoryEntry));
+
+            ThrowOn(link.markerValue != SIMTRACE_V3_DIRECTORY_LINK_MARKER,
+                    Exception, "Directory structure corrupted.");
 
-            Simtrace3Frame frame(fheader);
+            FileOffset offset = link.directoryLink.nextDirectory;
+            ThrowOn((offset == 0) || (offset + dirSize > _file->getSize()),
+                    Exception, "Directory link corrupted.");
 
-            auto location = encoder.makeStorageLocation(frame);
+            _directoryOffsets.push_back(offset);
+        }
+    }
 
-            Simtrace3StorageLocation* sim3location =
-                static_cast<Simtrace3StorageLocation*>(location.get());
+    void Simtrace3Store::_scanDirectory(uint32_t directory, DirectoryScan& scan)
+    {
+        assert(directory < _directoryOffsets.size());
+        const uint32_t capacity = _header->v3.directoryCapacity;
 
-            sim3location->offset = entry.framelink.offset;
-            sim3location->size   = fheader.totalSize;
+        // Each scan uses its own mapping, so we can scan directories
+        // concurrently.
+        FileBackedMemorySegment mapping(*_headerMapping);
+        mapping.updateSize();
+        mapping.map(_directoryOffsets[directory],
+                    capacity * sizeof(FrameDirectoryEntry));
 
-            stream.addSegment(fheader.sequenceNumber, location);
+        FrameDirectory entries =
+            reinterpret_cast<FrameDirectory>(mapping.getBuffer());
+
+        for (uint32_t index = 0; index < capacity; ++index) {
+            const FrameDirectoryEntry& entry = entries[index];
+
+            const uint32_t marker = entry.markerValue;
+            if (marker == SIMTRACE_V3_FRAME_MARKER) {
+                const FrameHeader& fheader = entry.framelink.frameHeader;
+
+                if (fheader.sequenceNumber == INVALID_STREAM_SEGMENT_ID) {
+                    scan.metadata.push_back(entry.framelink);
+                } else {
+                    scan.frames.push_back(
+                        std::make_pair(fheader.streamId, index));
+                }
+            } else {
+                // Either a link to the next directory or no further entries
+                // in the store.
+                assert((marker == SIMTRACE_V3_DIRECTORY_LINK_MARKER) ||
+                       (marker == 0));
+
+                return;
+            }
         }
+
+        Throw(Exception, "Directory structure corrupted.");
+    }
+
+    void Simtrace3Store::_scanDirectoryMain(void* context, uint32_t index)
+    {
+        ScanContext* ctx = static_cast<ScanContext*>(context);
+
+        ctx->store._scanDirectory(index, ctx->scans[index]);
     }
 
     void Simtrace3Store::_openStore(const std::string& path)
@@ -181,37 +292,41 @@ namespace Simtrace
         }
 
         if (_header->v3.directoryCount > 0) {
-            // For each directory, we iterate over its entries (i.e., frames)
-            // and add them to the corresponding stream. If the stream does not
-            // exist, we create it.
-            FileOffset dirOffset = _header->v3.directories[0];
-            ThrowOn(dirOffset == 0, Exception, "First directory link corrupted.");
-
-            _mapDirectory(dirOffset);
-
-            uint32_t index = 0;
-            while (true) {
-                ThrowOn(index >= _header->v3.directoryCapacity, Exception,
-                        "Directory structure corrupted.");
-
-                assert(_directory != nullptr);
-                FrameDirectoryEntry* entry = &_directory[index];
-
-                const uint32_t marker = entry->markerValue;
-                if (marker == SIMTRACE_V3_FRAME_MARKER) {
-                    _openFrame(*entry);
+            _collectDirectories();
+
+            // Scan all directories in parallel. This only reads the frame
+            // directory entries.
+            std::vector<DirectoryScan> scans(_directoryOffsets.size());
+            ScanContext ctx(*this, scans);
+
+            StorageServer::getInstance().getWorkerPool().runParallel(
+                static_cast<uint32_t>(scans.size()), _scanDirectoryMain, &ctx,
+                WorkQueue::Priority::High);
+
+            // Create the streams from the metadata frames in the order of
+            // the directories, so the encoders observe the same order as
+            // when the store has been written.
+            for (auto& scan : scans) {
+                for (auto& link : scan.metadata) {
+                    _openMetadataFrame(link);
+                }
+            }
 
-                    index++;
-                } else if (marker == SIMTRACE_V3_DIRECTORY_LINK_MARKER) {
-                    _mapDirectory(entry->directoryLink.nextDirectory);
+            // Data frames are only added to a stream when the stream is
+            // accessed for the first time. This way, the open time depends
+            // on the number of streams, not on the size of the trace.
+            for (uint32_t d = 0; d < scans.size(); ++d) {
+                for (auto& frame : scans[d].frames) {
+                    _deferredFrames[frame.first].push_back({ d, frame.second });
+                }
+            }
 
-                    index = 0;
-                } else {
-                    assert(marker == 0);
+            for (auto& deferred : _deferredFrames) {
+                // Throws, if the stream does not exist
+                ServerStream& stream =
+                    static_cast<ServerStream&>(getStream(deferred.first));
 
-                    // No further entries in the store
-                    break;
-                }
+                stream.deferLoad();
             }
         }
 
@@ -221,6 +336,46 @@ namespace Simtrace
         _readMode = true;
     }
 
+    void Simtrace3Store::loadStream(ServerStream& stream)
+    {
+        // The map is not modified after the store has been opened, so we
+        // do not need a lock to find the stream's frames. The stream makes
+        // sure that it is loaded only once.
+        auto it = _deferredFrames.find(stream.getId());
+        if (it == _deferredFrames.end()) {
+            return;
+        }
+
+        std::vector<FrameReference> frames;
+        frames.swap(it->second);
+
+        const uint32_t capacity = _header->v3.directoryCapacity;
+        FileBackedMemorySegment mapping(*_headerMapping);
+        mapping.updateSize();
+
+        FrameDirectory entries = nullptr;
+        uint32_t directory = 0;
+
+        for (auto& frame : frames) {
+            if ((entries == nullptr) || (frame.directory != directory)) {
+                mapping.unmap();
+
+                directory = frame.directory;
+                mapping.map(_directoryOffsets[directory],
+                            capacity * sizeof(FrameDirectoryEntry));
+
+                entries = reinterpret_cast<FrameDirectory>(
+                    mapping.getBuffer());
+            }
+
+            assert(frame.index < capacity);
+            _openDataFrame(stream, entries[frame.index].framelink);
+        }
+
+        LogDebug("<store: %s> Loaded %zu segments of stream %d.",
+                 getName().c_str(), frames.size(), stream.getId());
+    }
+
     void Simtrace3Store::_createStore(const std::string& path)
     {
         _file = std::unique_ptr<File>(
@@ -359,7 +514,7 @@ namespace Simtrace
             sizeof(FrameDirectoryEntry);
         FileOffset offset = _reserveSpace(directorySize);
 
-        if (_header->v3.directoryCount < _header->v3.directoryCapacity) {
+        if (_header->v3.directoryCount < SIMTRACE_V3_DIRECTORY_TABLE_SIZE) {
             _header->v3.directories[_header->v3.directoryCount] = offset;
         }
 
@@ -460,27 +615,31 @@ namespace Simtrace
         const FrameHeader& header = frame.getHeader();
         FileOffset frameOffset = _file->commitSpace(header.totalSize);
 
-        // Write frame header to store
-        FileOffset offset = frameOffset;
-        offset += _file->write(&header, offset);
+        // A frame consists of the frame header followed by multiple
+        // attributes. All attributes are saved in the order they were added.
+        // Each attribute has a header and associated data. We gather the
+        // whole frame and write it with a single call.
+        AttributeList& attributes = frame.getAttributeList();
+        std::vector<File::IoVector> vectors;
+        vectors.reserve(1 + 2 * attributes.size());
+
+        vectors.push_back({ &header, sizeof(FrameHeader) });
 
-        // A frame consists of multiple attributes. All attributes are
-        // saved in the order they were added. Each attribute has a
-        // header and associated data.
         uncompressedBytesWritten = sizeof(FrameHeader);
-        AttributeList& attributes = frame.getAttributeList();
         for (auto i = 0; i < attributes.size(); ++i) {
             AttributeHeaderDescription& description = attributes[i];
 
-            offset += _file->write(&description.header, offset);
-            offset += _file->write(description.buffer,
-                                   description.header.size,
-                                   offset);
+            vectors.push_back({ &description.header, sizeof(AttributeHeader) });
+            vectors.push_back({ description.buffer, description.header.size });
 
             uncompressedBytesWritten += description.header.uncompressedSize +
                                         sizeof(AttributeHeader);
         }
 
+        size_t written = _file->write(vectors, frameOffset);
+        ThrowOn(written != header.totalSize, Exception,
+                "Frame size does not match the written data.");
+
         LogDebug("<store: %s> Written frame to store <stream: %d, sqn: %d, "
                  "size: %s (%s), attr#: %d>.", getName().c_str(),
                  header.streamId, header.sequenceNumber,
@@ -673,6 +832,40 @@ namespace Simtrace
         LogInfo("%s", str.str().c_str());
     }
 
+    void Simtrace3Store::_logReadAheadStats()
+    {
+        std::vector<Stream*> streams;
+        this->Store::_enumerateStreams(streams, SefRegular);
+
+        std::ostringstream str;
+        bool empty = true;
+
+        str << "<store: " << this->getName() << "> Read-Ahead";
+
+        for (auto stream : streams) {
+            ReadAheadStatistics stats;
+            static_cast<ServerStream*>(stream)->getReadAheadStatistics(stats);
+
+            if ((stats.prefetches == 0) && (stats.misses == 0)) {
+                continue;
+            }
+
+            str << std::endl
+                << " " << stream->getName()
+                << " (prefetches: " << stats.prefetches
+                << " hits: " << stats.hits
+                << " late: " << stats.lateHits
+                << " misses: " << stats.misses
+                << ")";
+
+            empty = false;
+        }
+
+        if (!empty) {
+            LogInfo("%s", str.str().c_str());
+        }
+    }
+
     FileOffset Simtrace3Store::commitFrame(Simtrace3Frame& frame)
     {
         ThrowOn(_readMode || _loading, InvalidOperationException);
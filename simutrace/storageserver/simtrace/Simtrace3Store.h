@@ -41,12 +41,24 @@ namespace Simtrace
         FileOffset offset;
         uint64_t size;
 
+        // Skip index of the segment (see Simtrace3Encoder::_loadIndex()).
+        // Empty, if the frame has no index or has not been read, yet.
+        std::vector<SkipIndexSample> skipIndex;
+
+        // Entry offset table of a segment with variable-sized entries, with
+        // entryOffsetWidth bytes per entry (see AttributeEntryOffsets).
+        std::vector<byte> entryOffsets;
+        uint32_t entryOffsetWidth;
+
         Simtrace3StorageLocation(Simtrace3Frame& frame) :
             StorageLocation(StreamSegmentLink(
                                 frame.getHeader().streamId,
                                 frame.getHeader().sequenceNumber)),
             offset(INVALID_FILE_OFFSET),
-            size(0)
+            size(0),
+            skipIndex(),
+            entryOffsets(),
+            entryOffsetWidth(0)
         {
             const FrameHeader& header = frame.getHeader();
             ranges.startCycle = header.startCycle;
@@ -72,6 +84,16 @@ namespace Simtrace
     class Simtrace3Store :
         public ServerStore
     {
+    private:
+        // Position of a data frame in the frame directories
+        struct FrameReference {
+            uint32_t directory;
+            uint32_t index;
+        };
+
+        struct DirectoryScan;
+        struct ScanContext;
+
     private:
         DISABLE_COPY(Simtrace3Store);
 
@@ -88,9 +110,18 @@ namespace Simtrace
         FrameDirectory _directory;
         uint32_t _nextFrameIndex;
 
+        // Data frames of an opened store are added to their streams on
+        // first access to the stream (see loadStream()).
+        std::vector<FileOffset> _directoryOffsets;
+        std::unordered_map<StreamId, std::vector<FrameReference>> _deferredFrames;
+
         void _initializeEncoderMap();
 
-        void _openFrame(FrameDirectoryEntry& entry);
+        void _openMetadataFrame(const FrameHeaderLink& link);
+        void _openDataFrame(ServerStream& stream, const FrameHeaderLink& link);
+        void _collectDirectories();
+        void _scanDirectory(uint32_t directory, DirectoryScan& scan);
+        static void _scanDirectoryMain(void* context, uint32_t index);
         void _openStore(const std::string& path);
         void _createStore(const std::string& path);
 
@@ -124,6 +155,7 @@ namespace Simtrace
                              StreamStatistics& stats,
                              uint64_t size, uint64_t usize);
         void _logStoreStats();
+        void _logReadAheadStats();
     public:
         Simtrace3Store(StoreId store, const std::string& path);
         virtual ~Simtrace3Store() override;
@@ -135,6 +167,8 @@ namespace Simtrace
 
         void readAttribute(Simtrace3Frame& frame, uint32_t index,
                            void* buffer);
+
+        virtual void loadStream(ServerStream& stream) override;
     };
 
 }
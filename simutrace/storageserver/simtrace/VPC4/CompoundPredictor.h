@@ -27,6 +27,7 @@
 #include "SimuStor.h"
 
 #include "Predictor.h"
+#include "PredictorVector.h"
 
 // With half-byte encoding, each predictor id is encoded with 4 bits in the
 // final output stream.
@@ -106,53 +107,66 @@ namespace SimuTrace
             return data;
         }
 
-        PredictorId _evaluateContext(PredictorId** codeBuffer, T** dataBuffer,
-                                     PredictionContext<T>& context, T data)
+        // In VPC, multiple predictors are used to predict a certain value
+        // (e.g., Ip). If more than one predictor is correct, VPC picks the
+        // predictor with the highest usage count [3.3 The VPC3 Algorithm] to
+        // generate an output stream with high homogeneity. If the usage
+        // counts are equal, the predictor with the highest id is chosen.
+        // The mask contains a bit for each predictor that predicted the
+        // value correctly (see PredictorVector).
+        PredictorId _selectPredictor(uint32_t mask) const
         {
-            // If we could predict the value, we increment the usage count of
-            // the actual used predictor and return its id.
-            if (context.isPredicted()) {
-                assert(context.predictor != nullptr);
-                assert(context.predictorId < NotPredictedId);
+            PredictorId id = NotPredictedId;
+            uint64_t usageCount = 0;
 
-            #ifdef SIMUTRACE_PROFILING_SIMTRACE3_VPC4_PREDICTORS_ENABLE
-                incrementUsageCount(context.predictorId);
-            #endif
+            // The loop has a fixed trip count and no data dependent branches,
+            // so that the compiler can unroll it and use conditional moves.
+            for (PredictorId i = 0; i < maxPredictor; ++i) {
+                const bool select = (((mask >> i) & 0x1) != 0) &&
+                                    (this->_usageCount[i] >= usageCount);
 
-                context.predictor->incrementUsageCount(context.predictorId);
-            } else {
-            #ifdef SIMUTRACE_PROFILING_SIMTRACE3_VPC4_PREDICTORS_ENABLE
-                incrementUsageCount(NotPredictedId);
-            #endif
+                id = select ? i : id;
 
-                // We could not predict the value. Write the data to the data
-                // buffer and move to the next buffer slot.
-                _writeData(dataBuffer, data);
+                // cache the usage count
+                usageCount = select ? this->_usageCount[i] : usageCount;
+            }
+
+            return id;
+        }
+
+        PredictorId _evaluateMatches(PredictorId** codeBuffer, T** dataBuffer,
+                                     uint32_t mask, T data)
+        {
+            assert(mask < (1U << maxPredictor));
+            PredictorId id = _selectPredictor(mask);
 
-                context.predictorId = NotPredictedId;
+            // We increment the usage count of the actual used predictor. If
+            // we could not predict the value, we write the data to the data
+            // buffer and move to the next buffer slot.
+            this->incrementUsageCount(id);
+
+            if (id == NotPredictedId) {
+                _writeData(dataBuffer, data);
             }
 
             // Encode the predictor id
-            _writePredictorId(codeBuffer, context.predictorId);
+            _writePredictorId(codeBuffer, id);
 
-            return context.predictorId;
+            return id;
         }
 
         void _reset()
         {
+            Predictor<T>::reset();
             _halfByte = true;
         }
 
     public:
-    #ifdef SIMUTRACE_PROFILING_SIMTRACE3_VPC4_PREDICTORS_ENABLE
+        // The usage counts are required to select a predictor. The last
+        // counter tracks the values that could not be predicted.
         CompoundPredictor() :
             Predictor<T>(0, maxPredictor + 1),
             _halfByte(true) { }
-    #else
-        CompoundPredictor() :
-            Predictor<T>(0),
-            _halfByte(true) { }
-    #endif
 
         static const PredictorId NotPredictedId = maxPredictor;
 
@@ -161,7 +175,7 @@ namespace SimuTrace
         {
             for (int i = 0; i < maxPredictor + 1; ++i) {
                 context.add(stringFormat("%s[%d]", prefix, i).c_str(),
-                            _usageCount[i], false);
+                            this->_usageCount[i], false);
             }
         }
     #endif
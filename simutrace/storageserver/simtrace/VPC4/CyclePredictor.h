@@ -46,23 +46,28 @@ namespace SimuTrace
         // b) 131.072 (2^17) lines in the 1st order FCM
         // c) 524.288 (2^19) lines in the 3rd order FCM
         // d) a history length of 2 values
+        typedef FiniteContextMethodPredictor<T, 17, 1, 2> FirstOrderFcm;
+        typedef FiniteContextMethodPredictor<T, 19, 3, 2> ThirdOrderFcm;
+
         FcmHistory<T, 17, 3> _sharedFcmHistory;
-        FiniteContextMethodPredictor<T, 17, 1, 2, T, 0, 17, 3> _firstOrderFcmPredictor;
-        FiniteContextMethodPredictor<T, 19, 3, 2, T, 0, 17, 3> _thirdOrderFcmPredictor;
+        FirstOrderFcm _firstOrderFcmPredictor;
+        ThirdOrderFcm _thirdOrderFcmPredictor;
 
         T _referenceCycleCount;
 
         inline bool _getCycleCount(PredictorId** codeBuffer, T** dataBuffer,
+                                   const typename FirstOrderFcm::Line& first,
+                                   const typename ThirdOrderFcm::Line& third,
                                    T& out)
         {
             PredictorId id = this->_readPredictorId(codeBuffer);
 
             if (id < 2) {
-                out = _firstOrderFcmPredictor.getValue(id);
+                out = _firstOrderFcmPredictor.getValue(first, id);
 
                 return true;
             } else if (id < 4) {
-                out = _thirdOrderFcmPredictor.getValue(id);
+                out = _thirdOrderFcmPredictor.getValue(third, id);
 
                 return true;
             } else {
@@ -75,39 +80,61 @@ namespace SimuTrace
     public:
         CyclePredictor(T referenceCycleCount) :
             _sharedFcmHistory(),
-            _firstOrderFcmPredictor(0, _sharedFcmHistory),
-            _thirdOrderFcmPredictor(2, _sharedFcmHistory),
+            _firstOrderFcmPredictor(0),
+            _thirdOrderFcmPredictor(2),
             _referenceCycleCount(referenceCycleCount) { }
 
         CyclePredictor() :
             CyclePredictor(0) { }
 
+        void reset(T referenceCycleCount)
+        {
+            this->_reset();
+
+            _sharedFcmHistory.reset();
+            _firstOrderFcmPredictor.reset();
+            _thirdOrderFcmPredictor.reset();
+
+            _referenceCycleCount = referenceCycleCount;
+        }
+
         PredictorId encodeCycle(PredictorId** codeBuffer, T** dataBuffer,
                                 const T cycle, const K ip)
         {
-            PredictionContext<T> context;
-
             const T stride = cycle - _referenceCycleCount;
             const T value  = stride + ip;
 
             _referenceCycleCount = cycle;
 
-            // Evaluate 1st and 3rd order predictors and update the shared
-            // history afterwards.
-            _firstOrderFcmPredictor.predictValue(context, value);
-            _thirdOrderFcmPredictor.predictValue(context, value);
+            typename FirstOrderFcm::Line& first =
+                _firstOrderFcmPredictor.getLine(_sharedFcmHistory.get(1));
+            typename ThirdOrderFcm::Line& third =
+                _thirdOrderFcmPredictor.getLine(_sharedFcmHistory.get(3));
+
+            // Evaluate 1st and 3rd order predictors and update the
+            // predictors and the shared history afterwards.
+            uint32_t mask = _firstOrderFcmPredictor.match(first, value) |
+                            _thirdOrderFcmPredictor.match(third, value);
+
+            FirstOrderFcm::update(first, value);
+            ThirdOrderFcm::update(third, value);
 
             _sharedFcmHistory.update(value);
 
-            return this->_evaluateContext(codeBuffer, dataBuffer, context, stride);
+            return this->_evaluateMatches(codeBuffer, dataBuffer, mask, stride);
         }
 
         void decodeCycle(PredictorId** codeBuffer, T** dataBuffer, const K ip,
                          T& out)
         {
+            typename FirstOrderFcm::Line& first =
+                _firstOrderFcmPredictor.getLine(_sharedFcmHistory.get(1));
+            typename ThirdOrderFcm::Line& third =
+                _thirdOrderFcmPredictor.getLine(_sharedFcmHistory.get(3));
+
             T stride, update;
 
-            if (_getCycleCount(codeBuffer, dataBuffer, stride)) {
+            if (_getCycleCount(codeBuffer, dataBuffer, first, third, stride)) {
                 update = stride;
                 stride -= ip;
             } else {
@@ -115,8 +142,8 @@ namespace SimuTrace
             }
 
             // Update the predictors and the history
-            _firstOrderFcmPredictor.update(update);
-            _thirdOrderFcmPredictor.update(update);
+            FirstOrderFcm::update(first, update);
+            ThirdOrderFcm::update(third, update);
 
             _sharedFcmHistory.update(update);
 
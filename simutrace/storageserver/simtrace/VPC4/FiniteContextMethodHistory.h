@@ -29,42 +29,86 @@
 namespace SimuTrace
 {
 
+    // A fold & mask hash using XOR. Maps a symbol to the hash that is
+    // shifted into a history.
+    template<typename T, uint32_t hashSize>
+    inline HashType fcmHash(const T value)
+    {
+        HashType hash = 0;
+        T tmp = value;
+
+        while (tmp > 0) {
+            hash ^= tmp;
+            tmp = tmp >> hashSize;
+        }
+
+        return hash & ((1 << hashSize) - 1);
+    }
+
+    // Shifts the hash of a new symbol into a history of the given order.
+    // Element i holds the hashed history of order i + 1.
+    template<typename T, uint32_t hashSize, uint32_t order>
+    inline void fcmUpdateHistory(HashType* history, const T value)
+    {
+        HashType hash = fcmHash<T, hashSize>(value);
+
+        for (int i = order - 1; i > 0; --i) {
+            history[i] = (history[i - 1] << 1) ^ hash;
+        }
+
+        history[0] = hash;
+    }
+
     template<typename T, typename K, uint32_t tableSize,
              uint32_t hashSize, uint32_t order>
     class KeyedFcmHistory
     {
     private:
-        static const HashType _hashMask = (1 << hashSize) - 1;
         static const HashType _tableMask = (1 << tableSize) - 1;
 
         uint32_t _index;
         HashType _historyTable[1 << tableSize][order];
 
-        inline HashType _hash(const T value) const
-        {
-            // A fold & mask hash using XOR
-            HashType hash = 0;
-            T tmp = value;
+        Generation _generation;
+        Generation _lineGeneration[1 << tableSize];
 
-            while (tmp > 0) {
-                hash ^= tmp;
-                tmp = tmp >> hashSize;
+        inline void _validateLine(uint32_t index)
+        {
+            if (_lineGeneration[index] != _generation) {
+                memset(_historyTable[index], 0, sizeof(_historyTable[index]));
+                _lineGeneration[index] = _generation;
             }
-
-            return hash & _hashMask;
         }
 
     public:
         KeyedFcmHistory() :
-            _index(0)
+            _index(0),
+            _generation(0)
         {
             memset(_historyTable, 0, sizeof(_historyTable));
+            memset(_lineGeneration, 0, sizeof(_lineGeneration));
+        }
+
+        // Brings the history into the same state as a newly constructed one
+        void reset()
+        {
+            _index = 0;
+            _generation++;
+
+            if (_generation == 0) {
+                memset(_historyTable, 0, sizeof(_historyTable));
+                memset(_lineGeneration, 0, sizeof(_lineGeneration));
+            } else {
+                _validateLine(0);
+            }
         }
 
         void setKey(const K key)
         {
             _index = static_cast<uint32_t>(key & _tableMask);
             assert(_index < (1 << tableSize));
+
+            _validateLine(_index);
         }
 
         HashType get(uint32_t predictorOrder) const
@@ -81,14 +125,8 @@ namespace SimuTrace
 
         void update(const T value)
         {
-            HashType hash = _hash(value);
-
-            for (int i = order - 1; i > 0; --i) {
-                _historyTable[this->_index][i] =
-                    (_historyTable[this->_index][i - 1] << 1) ^ hash;
-            }
-
-            _historyTable[this->_index][0] = hash;
+            fcmUpdateHistory<T, hashSize, order>(_historyTable[this->_index],
+                                                 value);
         }
 
     };
@@ -96,10 +134,5 @@ namespace SimuTrace
     template<typename T, uint32_t hashSize, uint32_t order>
     using FcmHistory = KeyedFcmHistory<T, T, 0, hashSize, order>;
 
-    template<typename T, typename hKey, uint32_t hTableSize,
-             uint32_t hHashSize, uint32_t hOrder>
-    using HistoryReference =
-        ObjectReference<KeyedFcmHistory<T, hKey, hTableSize, hHashSize, hOrder>>;
-
 }
 #endif
\ No newline at end of file
@@ -25,6 +25,8 @@
 #define FINITE_CONTEXT_METHOD_PREDICTOR_H
 
 #include "Predictor.h"
+#include "PredictorTable.h"
+#include "PredictorVector.h"
 
 #include "FiniteContextMethodHistory.h"
 
@@ -46,121 +48,96 @@ namespace SimuTrace
     // hashed input sequence.
     //
     // To allow multiple FCMs to share a common input sequence history, the
-    // history implementation is encapsulated in the FcmHistory classes. If no
-    // history is specified in the constructor, a simple history of the
-    // specified order is created.
+    // history is maintained by the owner of the predictor (see FcmHistory),
+    // which passes the hashed history of the predictor's order to getLine().
+    // The owner matches the returned line against the input and updates the
+    // line afterwards.
     //
 
+    // A line holds the prediction history for one hashed input history and
+    // the generation tag of the line. FCM tables are large and accessed at
+    // random, so we do not pad the lines to keep the footprint low.
+    template<typename T, uint32_t lineLength>
+    struct FcmLine {
+        T values[lineLength];
+        Generation generation;
+    };
+
     // T: symbol type
     // tableSize: size of the hash table
     // order: length of the input history to match against
     // lineLength: length of the prediction history for each input history.
     //             For each input, the predictor will provide lineLength
     //             predictions.
-    template<typename T, uint32_t tableSize, uint32_t order, uint32_t lineLength,
-             typename hKey, uint32_t hTableSize, uint32_t hHashSize, uint32_t hOrder>
+    template<typename T, uint32_t tableSize, uint32_t order,
+             uint32_t lineLength>
     class FiniteContextMethodPredictor :
         public Predictor<T>
     {
-    private:
-        typedef KeyedFcmHistory<T, hKey, hTableSize, hHashSize, hOrder> History;
-    private:
-        static const uint32_t _tableMask = (1 << tableSize) - 1;
-
-        T _valueTable[1 << tableSize][lineLength];
-        HistoryReference<T, hKey, hTableSize, hHashSize, hOrder> _history;
+    public:
+        typedef FcmLine<T, lineLength> Line;
 
-        inline HashType _mask(HashType index) const
-        {
-            return index & _tableMask;
-        }
+    private:
+        // Lines are initialized lazily. See Generation.
+        PredictorTable<Line, tableSize> _table;
+        Generation _generation;
 
-        void _initialize()
+        inline void _initializeLine(Line& line) const
         {
             // It does not make sense to initialize the prediction history to
             // all 0s, as we would then predict the same value multiple times.
-            for (uint32_t index = 0; index < (1 << tableSize); ++index) {
-                for (uint32_t i = 0; i < lineLength; ++i) {
-                    _valueTable[index][i] = i;
-                }
+            for (uint32_t i = 0; i < lineLength; ++i) {
+                line.values[i] = i;
             }
-        }
 
-        inline void _update(HashType index, T newValue)
-        {
-            assert(index < (1 << tableSize));
-
-            // VPC4 only updates the value history if the first value is
-            // different from the input to avoid an unnecessary insertion of
-            // the same value. A full compare is not done to prevent the
-            // decoding step from having to check against all entries in all
-            // predictors to determine if an update should be performed.
-            if (_valueTable[index][0] != newValue) {
-                // Shift the value history to make room for the new value.
-                for (int i = lineLength - 1; i > 0; --i) {
-                    _valueTable[index][i] = _valueTable[index][i - 1];
-                }
-
-                _valueTable[index][0] = newValue;
-            }
+            line.generation = _generation;
         }
 
     public:
         FiniteContextMethodPredictor(PredictorId idBase) :
-            Predictor<T>(idBase, lineLength),
-            _history(new FcmHistory<T, tableSize, order>(),
-                     [](FcmHistory<T, tableSize, order>* instance)
-                     { delete instance; })
-        {
-            _initialize();
-        }
+            Predictor<T>(idBase),
+            _table(),
+            _generation(1) { }
 
-        FiniteContextMethodPredictor(PredictorId idBase, History& history) :
-            Predictor<T>(idBase, lineLength),
-            _history(&history, NullDeleter<History>::deleter)
+        // Brings the predictor into the same state as a newly constructed
+        // one. The history must be reset by its owner.
+        void reset()
         {
-            _initialize();
+            if (!advanceGeneration(_generation)) {
+                _table.clear();
+            }
         }
 
-        void predictValue(PredictionContext<T>& context, const T value)
+        // Returns the line for the given hashed history of the predictor's
+        // order.
+        inline Line& getLine(HashType history)
         {
-            assert(_history != nullptr);
-            HashType index = _mask(_history->get(order));
-
-            // We iterate over the value history and perform a prediction check
-            // for each element in the value history. This way, we predict the
-            // most recent value, the second recent value, etc.
-            assert(index < (1 << tableSize));
-            for (int i = 0; i < lineLength; ++i) {
-                if ((this->_usageCount[i] >= context.usageCount) &&
-                    (_valueTable[index][i] == value)) {
-
-                    context.predictor   = this;
-                    context.predictorId = i + this->_idBase;
-
-                    // cache the usage count
-                    context.usageCount  = this->_usageCount[i];
-                }
+            Line& line = _table.get(history);
+
+            if (line.generation != _generation) {
+                _initializeLine(line);
             }
 
-            _update(index, value);
+            return line;
         }
 
-        const T getValue(PredictorId id) const
+        // Returns a mask with a bit set for each predictor id (i.e., value in
+        // the line) that matches the given value.
+        inline uint32_t match(const Line& line, T value) const
         {
-            assert(_history != nullptr);
-            HashType index = _mask(_history->get(order));
+            return PredictorVector<T, lineLength>::match(line.values, value) <<
+                this->_idBase;
+        }
 
+        inline T getValue(const Line& line, PredictorId id) const
+        {
             assert((id >= this->_idBase) && ((id - this->_idBase) < lineLength));
-            return _valueTable[index][id - this->_idBase];
+            return line.values[id - this->_idBase];
         }
 
-        void update(const T value)
+        static inline void update(Line& line, T newValue)
         {
-            assert(_history != nullptr);
-            HashType index = _mask(_history->get(order));
-
-            _update(index, value);
+            updateValueHistory<T, lineLength>(line.values, newValue);
         }
 
     };
@@ -45,18 +45,23 @@ namespace SimuTrace
         // b) 131.072 (2^17) lines in the 1st order FCM
         // c) 524.288 (2^19) lines in the 3rd order FCM
         // d) a history length of 2 values
+        typedef FiniteContextMethodPredictor<T, 17, 1, 2> FirstOrderFcm;
+        typedef FiniteContextMethodPredictor<T, 19, 3, 2> ThirdOrderFcm;
+
         FcmHistory<T, 17, 3> _sharedFcmHistory;
-        FiniteContextMethodPredictor<T, 17, 1, 2, T, 0, 17, 3> _firstOrderFcmPredictor;
-        FiniteContextMethodPredictor<T, 19, 3, 2, T, 0, 17, 3> _thirdOrderFcmPredictor;
+        FirstOrderFcm _firstOrderFcmPredictor;
+        ThirdOrderFcm _thirdOrderFcmPredictor;
 
-        inline void _getIp(PredictorId** codeBuffer, T** dataBuffer, T& out)
+        inline void _getIp(PredictorId** codeBuffer, T** dataBuffer,
+                           const typename FirstOrderFcm::Line& first,
+                           const typename ThirdOrderFcm::Line& third, T& out)
         {
             PredictorId id = this->_readPredictorId(codeBuffer);
 
             if (id < 2)  {
-                out = _firstOrderFcmPredictor.getValue(id);
+                out = _firstOrderFcmPredictor.getValue(first, id);
             } else if (id < 4) {
-                out = _thirdOrderFcmPredictor.getValue(id);
+                out = _thirdOrderFcmPredictor.getValue(third, id);
             } else {
                 assert(id == IpPredictor::NotPredictedId);
                 out = this->_readData(dataBuffer);
@@ -66,34 +71,54 @@ namespace SimuTrace
     public:
         IpPredictor() :
             _sharedFcmHistory(),
-            _firstOrderFcmPredictor(0, _sharedFcmHistory),
-            _thirdOrderFcmPredictor(2, _sharedFcmHistory) { }
+            _firstOrderFcmPredictor(0),
+            _thirdOrderFcmPredictor(2) { }
+
+        void reset()
+        {
+            this->_reset();
+
+            _sharedFcmHistory.reset();
+            _firstOrderFcmPredictor.reset();
+            _thirdOrderFcmPredictor.reset();
+        }
 
         PredictorId encodeIp(PredictorId** codeBuffer, T** dataBuffer,
                              const T ip)
         {
-            PredictionContext<T> context;
+            typename FirstOrderFcm::Line& first =
+                _firstOrderFcmPredictor.getLine(_sharedFcmHistory.get(1));
+            typename ThirdOrderFcm::Line& third =
+                _thirdOrderFcmPredictor.getLine(_sharedFcmHistory.get(3));
+
+            // Evaluate 1st and 3rd order predictors and update the
+            // predictors and the shared history afterwards.
+            uint32_t mask = _firstOrderFcmPredictor.match(first, ip) |
+                            _thirdOrderFcmPredictor.match(third, ip);
 
-            // Evaluate 1st and 3rd order predictors and update the shared
-            // history afterwards.
-            _firstOrderFcmPredictor.predictValue(context, ip);
-            _thirdOrderFcmPredictor.predictValue(context, ip);
+            FirstOrderFcm::update(first, ip);
+            ThirdOrderFcm::update(third, ip);
 
             _sharedFcmHistory.update(ip);
 
-            return this->_evaluateContext(codeBuffer, dataBuffer, context, ip);
+            return this->_evaluateMatches(codeBuffer, dataBuffer, mask, ip);
         }
 
         void decodeIp(PredictorId** codeBuffer, T** dataBuffer, T& out)
         {
+            typename FirstOrderFcm::Line& first =
+                _firstOrderFcmPredictor.getLine(_sharedFcmHistory.get(1));
+            typename ThirdOrderFcm::Line& third =
+                _thirdOrderFcmPredictor.getLine(_sharedFcmHistory.get(3));
+
             T result;
 
             // Get the value from the specified predictor
-            _getIp(codeBuffer, dataBuffer, result);
+            _getIp(codeBuffer, dataBuffer, first, third, result);
 
             // Update the predictors and the history
-            _firstOrderFcmPredictor.update(result);
-            _thirdOrderFcmPredictor.update(result);
+            FirstOrderFcm::update(first, result);
+            ThirdOrderFcm::update(third, result);
 
             _sharedFcmHistory.update(result);
 
@@ -34,34 +34,29 @@ namespace SimuTrace
 #define INVALID_PREDICTOR_INDEX std::numeric_limits<uint8_t>::max()
     typedef uint8_t PredictorId;
 
-    template<typename T> class Predictor;
+    // The predictor tables are large and resetting them between segments
+    // by rewriting every line is expensive. Instead, each table line is
+    // tagged with the generation in which it was last initialized. A reset
+    // only advances the generation and lines are lazily re-initialized on
+    // their next access. The tag is stored in the line itself, so checking
+    // it does not cost an additional cache miss. Generation 0 marks a line
+    // that has never been initialized (see PredictorTable). The tags are
+    // only rewritten when the generation wraps around.
+    typedef uint16_t Generation;
 
-    // In VPC, multiple predictors are used to predict a certain value
-    // (e.g., Ip). If more than one predictor is correct, VPC picks the
-    // predictor with the highest usage count [3.3 The VPC3 Algorithm] to
-    // generate an output stream with high homogeneity. We thus send a
-    // prediction context through all predictors and each predictor may set
-    // itself as best predictor, if its usage count exceeds the current one.
-    template<typename T>
-    struct PredictionContext {
-        uint64_t usageCount;
-
-        Predictor<T>* predictor;
-        PredictorId predictorId;
-
-        PredictionContext() :
-            usageCount(0),
-            predictor(nullptr),
-            predictorId(INVALID_PREDICTOR_INDEX) {}
-
-        inline bool isPredicted() const
-        {
-            assert((predictor == nullptr) ||
-                   (predictorId != INVALID_PREDICTOR_INDEX));
+    // Advances the generation. Returns false if the generation wrapped
+    // around. The caller then has to invalidate all lines.
+    inline bool advanceGeneration(Generation& generation)
+    {
+        generation++;
 
-            return (predictor != nullptr);
+        if (generation == 0) {
+            generation = 1;
+            return false;
         }
-    };
+
+        return true;
+    }
 
     template<typename T>
     class Predictor
@@ -69,17 +64,28 @@ namespace SimuTrace
     protected:
         PredictorId _idBase;
 
+        uint32_t _maxPredictors;
         std::unique_ptr<uint64_t[]> _usageCount;
     public:
         Predictor(PredictorId idBase) :
             _idBase(idBase),
+            _maxPredictors(0),
             _usageCount(nullptr) { }
 
         Predictor(PredictorId idBase, uint32_t maxPredictors) :
             _idBase(idBase),
+            _maxPredictors(maxPredictors),
             _usageCount(new uint64_t[maxPredictors])
         {
-            memset(_usageCount.get(), 0, sizeof(_usageCount));
+            reset();
+        }
+
+        void reset()
+        {
+            if (_usageCount != nullptr) {
+                memset(_usageCount.get(), 0,
+                       _maxPredictors * sizeof(uint64_t));
+            }
         }
 
         void incrementUsageCount(PredictorId id)
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2014 (C) Karlsruhe Institute of Technology (KIT)
+ * Marc Rittinghaus, Thorsten Groeninger
+ *
+ * Simutrace Storage Server (storageserver) is part of Simutrace.
+ *
+ * storageserver is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * storageserver is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with storageserver. If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#ifndef PREDICTOR_POOL_H
+#define PREDICTOR_POOL_H
+
+#include "SimuStor.h"
+
+namespace SimuTrace
+{
+
+    // Predictors own tables of several MiB, which are expensive to allocate
+    // and initialize for every segment. The pool keeps predictors that are
+    // not in use, so the next segment only needs to reset them (see
+    // Generation). Each worker holds at most one predictor set at a time, so
+    // limiting the pool to the number of workers effectively gives every
+    // worker its own set without binding memory to threads that may exit.
+    template<typename T>
+    class PredictorPool
+    {
+    private:
+        DISABLE_COPY(PredictorPool);
+
+        CriticalSection _lock;
+        std::vector<std::unique_ptr<T>> _free;
+
+    public:
+        PredictorPool() { }
+
+        // Returns a predictor set that has not been reset yet. The caller is
+        // responsible to bring the predictors into a defined state.
+        std::unique_ptr<T> acquire(bool& isNew)
+        {
+            Lock(_lock); {
+                if (!_free.empty()) {
+                    std::unique_ptr<T> item = std::move(_free.back());
+                    _free.pop_back();
+
+                    isNew = false;
+                    return item;
+                }
+            } Unlock();
+
+            isNew = true;
+            return std::unique_ptr<T>(new T());
+        }
+
+        void release(std::unique_ptr<T>& item, size_t maxCached)
+        {
+            if (item == nullptr) {
+                return;
+            }
+
+            LockScope(_lock);
+            if (_free.size() < maxCached) {
+                _free.push_back(std::move(item));
+            } else {
+                item.reset();
+            }
+        }
+
+        void clear()
+        {
+            LockScope(_lock);
+            _free.clear();
+        }
+    };
+
+}
+#endif
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2015 (C) Karlsruhe Institute of Technology (KIT)
+ * Marc Rittinghaus
+ *
+ * Simutrace Storage Server (storageserver) is part of Simutrace.
+ *
+ * storageserver is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * storageserver is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with storageserver. If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#ifndef PREDICTOR_TABLE_H
+#define PREDICTOR_TABLE_H
+
+#include "SimuStor.h"
+
+#include "Predictor.h"
+
+namespace SimuTrace
+{
+
+#define VPC_CACHE_LINE_SIZE 64
+
+    // Size of a table line holding the given number of bytes, rounded up to
+    // the next power of two. Lines of this size never straddle a cache line.
+    template<size_t size>
+    struct PredictorLineSize
+    {
+        static_assert(size <= VPC_CACHE_LINE_SIZE,
+                      "Predictor line exceeds a cache line.");
+
+        static const size_t value =
+            (size <= 8)  ? 8  :
+            (size <= 16) ? 16 :
+            (size <= 32) ? 32 : VPC_CACHE_LINE_SIZE;
+    };
+
+    // A predictor table of 2^tableSize lines. The lines are stored in page
+    // aligned memory. Lines with a power of two size (see PredictorLineSize)
+    // thus never straddle a cache line. Smaller, unpadded lines may straddle
+    // occasionally, but keep the table's cache footprint low.
+    //
+    // The memory is obtained zero-filled from the operating system. A line
+    // with a generation tag of 0 is therefore never valid and the first
+    // generation in use must be 1 (see Generation). Pages of the table which
+    // are never accessed consequently are not backed by physical memory.
+    template<typename Line, uint32_t tableSize>
+    class PredictorTable
+    {
+    private:
+        static_assert(sizeof(Line) <= VPC_CACHE_LINE_SIZE,
+                      "Predictor line exceeds a cache line.");
+
+        DISABLE_COPY(PredictorTable);
+
+        static const HashType _tableMask = (1 << tableSize) - 1;
+
+        std::unique_ptr<PrivateMemorySegment> _memory;
+        Line* _lines;
+
+    public:
+        PredictorTable() :
+            _memory(new PrivateMemorySegment(sizeof(Line) << tableSize)),
+            _lines(reinterpret_cast<Line*>(_memory->map())) { }
+
+        ~PredictorTable()
+        {
+            _memory->unmap();
+        }
+
+        // Invalidates all lines by clearing their generation tags
+        void clear()
+        {
+            _memory->zero();
+        }
+
+        inline Line& get(HashType index)
+        {
+            return _lines[index & _tableMask];
+        }
+
+        inline const Line& get(HashType index) const
+        {
+            return _lines[index & _tableMask];
+        }
+    };
+
+}
+#endif
@@ -0,0 +1,221 @@
+/*
+ * Copyright 2015 (C) Karlsruhe Institute of Technology (KIT)
+ * Marc Rittinghaus
+ *
+ * Simutrace Storage Server (storageserver) is part of Simutrace.
+ *
+ * storageserver is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * storageserver is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with storageserver. If not, see <http://www.gnu.org/licenses/>.
+ */
+#pragma once
+#ifndef PREDICTOR_VECTOR_H
+#define PREDICTOR_VECTOR_H
+
+#include "SimuStor.h"
+
+// The instruction set is chosen at compile time. SSE2 is part of every
+// x86-64 target. SSE4.1 and AVX2 are only used if the compiler has been
+// told that the target supports them (e.g., with BUILD_CONFIG_OPTIMIZE_AVX2
+// in cmake). Other targets use the scalar implementation.
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define VPC_VECTOR_AVX2
+#elif defined(__SSE4_1__)
+#include <smmintrin.h>
+#define VPC_VECTOR_SSE41
+#elif defined(__SSE2__) || defined(_M_X64) || \
+      (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define VPC_VECTOR_SSE2
+#endif
+
+namespace SimuTrace
+{
+
+    //
+    // Operations on the value history of a predictor line (i.e., the n most
+    // recent values that followed a certain context).
+    //
+    // match() compares all values against the input at once and returns a
+    // bit mask with bit i set if values[i] equals the input. Selecting the
+    // final predictor from the mask is left to the caller (see
+    // CompoundPredictor::_selectPredictor()).
+    //
+    // insert() shifts the history by one and inserts a new value at the
+    // front. The vectorized versions write the history with the same width
+    // that match() reads it. Otherwise, the match on a recently updated line
+    // could not be served from the store buffer and would stall.
+    //
+    template<typename T, uint32_t n>
+    struct PredictorVector
+    {
+        static inline uint32_t match(const T* values, const T value)
+        {
+            uint32_t mask = 0;
+
+            for (uint32_t i = 0; i < n; ++i) {
+                mask |= static_cast<uint32_t>(values[i] == value) << i;
+            }
+
+            return mask;
+        }
+
+        static inline void insert(T* values, const T value)
+        {
+            for (int i = n - 1; i > 0; --i) {
+                values[i] = values[i - 1];
+            }
+
+            values[0] = value;
+        }
+    };
+
+#if defined(VPC_VECTOR_AVX2) || defined(VPC_VECTOR_SSE41) || \
+    defined(VPC_VECTOR_SSE2)
+
+    inline __m128i _vpcCompare64(__m128i a, __m128i b)
+    {
+    #if defined(VPC_VECTOR_SSE2)
+        // SSE2 has no 64-bit compare. We compare the 32-bit halves and
+        // combine the result of each half with its neighbor.
+        __m128i r = _mm_cmpeq_epi32(a, b);
+        return _mm_and_si128(r,
+                             _mm_shuffle_epi32(r, _MM_SHUFFLE(2, 3, 0, 1)));
+    #else
+        return _mm_cmpeq_epi64(a, b);
+    #endif
+    }
+
+    inline uint32_t _vpcMask64(__m128i r)
+    {
+        return static_cast<uint32_t>(_mm_movemask_pd(_mm_castsi128_pd(r)));
+    }
+
+    template<>
+    struct PredictorVector<uint64_t, 2>
+    {
+        static inline uint32_t match(const uint64_t* values,
+                                     const uint64_t value)
+        {
+            __m128i c = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(values));
+
+            return _vpcMask64(_vpcCompare64(c, _mm_set1_epi64x(value)));
+        }
+
+        static inline void insert(uint64_t* values, const uint64_t value)
+        {
+            __m128i* line = reinterpret_cast<__m128i*>(values);
+            __m128i c = _mm_loadu_si128(line);
+
+            // (value, values[0])
+            _mm_storeu_si128(line,
+                             _mm_unpacklo_epi64(_mm_set1_epi64x(value), c));
+        }
+    };
+
+    template<>
+    struct PredictorVector<uint64_t, 4>
+    {
+        static inline uint32_t match(const uint64_t* values,
+                                     const uint64_t value)
+        {
+        #if defined(VPC_VECTOR_AVX2)
+            __m256i c = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(values));
+            __m256i r = _mm256_cmpeq_epi64(c, _mm256_set1_epi64x(value));
+
+            return static_cast<uint32_t>(
+                _mm256_movemask_pd(_mm256_castsi256_pd(r)));
+        #else
+            const __m128i* line = reinterpret_cast<const __m128i*>(values);
+            const __m128i v = _mm_set1_epi64x(value);
+
+            return _vpcMask64(_vpcCompare64(_mm_loadu_si128(line), v)) |
+                (_vpcMask64(_vpcCompare64(_mm_loadu_si128(line + 1), v)) << 2);
+        #endif
+        }
+
+        static inline void insert(uint64_t* values, const uint64_t value)
+        {
+        #if defined(VPC_VECTOR_AVX2)
+            __m256i* line = reinterpret_cast<__m256i*>(values);
+            __m256i c = _mm256_loadu_si256(line);
+
+            // (values[0], values[0], values[1], values[2]) and replace the
+            // first element with the new value
+            c = _mm256_permute4x64_epi64(c, _MM_SHUFFLE(2, 1, 0, 0));
+            c = _mm256_blend_epi32(c, _mm256_set1_epi64x(value), 0x03);
+
+            _mm256_storeu_si256(line, c);
+        #else
+            __m128i* line = reinterpret_cast<__m128i*>(values);
+            __m128i c0 = _mm_loadu_si128(line);
+            __m128i c1 = _mm_loadu_si128(line + 1);
+
+            // (value, values[0]), (values[1], values[2])
+            __m128i n1 = _mm_castpd_si128(_mm_shuffle_pd(
+                _mm_castsi128_pd(c0), _mm_castsi128_pd(c1), 0x1));
+
+            _mm_storeu_si128(line,
+                             _mm_unpacklo_epi64(_mm_set1_epi64x(value), c0));
+            _mm_storeu_si128(line + 1, n1);
+        #endif
+        }
+    };
+
+    template<>
+    struct PredictorVector<uint32_t, 4>
+    {
+        static inline uint32_t match(const uint32_t* values,
+                                     const uint32_t value)
+        {
+            __m128i c = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(values));
+            __m128i r = _mm_cmpeq_epi32(c, _mm_set1_epi32(value));
+
+            return static_cast<uint32_t>(
+                _mm_movemask_ps(_mm_castsi128_ps(r)));
+        }
+
+        static inline void insert(uint32_t* values, const uint32_t value)
+        {
+            __m128i* line = reinterpret_cast<__m128i*>(values);
+            __m128i c = _mm_loadu_si128(line);
+
+            // (value, values[0], values[1], values[2])
+            c = _mm_or_si128(_mm_slli_si128(c, 4),
+                             _mm_cvtsi32_si128(static_cast<int>(value)));
+
+            _mm_storeu_si128(line, c);
+        }
+    };
+
+#endif
+
+    // Inserts a new value into a last n value history. VPC4 only updates
+    // the value history if the first value is different from the input to
+    // avoid an unnecessary insertion of the same value. A full compare is
+    // not done to prevent the decoding step from having to check against all
+    // entries in all predictors to determine if an update should be
+    // performed.
+    template<typename T, uint32_t n>
+    inline void updateValueHistory(T* values, const T newValue)
+    {
+        if (values[0] != newValue) {
+            PredictorVector<T, n>::insert(values, newValue);
+        }
+    }
+
+}
+#endif
@@ -27,8 +27,9 @@
 #include "Predictor.h"
 #include "CompoundPredictor.h"
 
+#include "PredictorTable.h"
+#include "FiniteContextMethodHistory.h"
 #include "FiniteContextMethodPredictor.h"
-#include "KeyedLastNValuePredictor.h"
 
 namespace SimuTrace
 {
@@ -48,111 +49,176 @@ namespace SimuTrace
         // c) 131.072 (2^17) lines in the 1st order DFCM
         // d) 524.288 (2^19) lines in the 3rd order DFCM
         // e) a history of 2 values per DFCM
-        KeyedFcmHistory<T, K, 16, 17, 3> _sharedDfcmHistory;
-        FiniteContextMethodPredictor<T, 17, 1, 2, K, 16, 17, 3> _firstOrderDfcmPredictor;
-        FiniteContextMethodPredictor<T, 19, 3, 2, K, 16, 17, 3> _thirdOrderDfcmPredictor;
+        typedef FiniteContextMethodPredictor<T, 17, 1, 2> FirstOrderDfcm;
+        typedef FiniteContextMethodPredictor<T, 19, 3, 2> ThirdOrderDfcm;
 
         // Finite Context Method Predictor (FCM)
         // A single 1st order FCM with:
         // a) 65.536 (2^16) lines in the (private) history
         // b) 524.288 (2^19) lines in the FCM
         // c) a history of 2 values in the FCM
-        KeyedFcmHistory<T, K, 16, 19, 1> _privateFcmHistory;
-        FiniteContextMethodPredictor<T, 19, 1, 2, K, 16, 19, 1> _firstOrderFcmPredictor;
+        typedef FiniteContextMethodPredictor<T, 19, 1, 2> FirstOrderFcm;
 
         // Last Value Predictor (LV)
         // A single last 4 value predictor with:
         // a) 65.536 (2^16) lines
-        KeyedLastNValuePredictor<T, K, 16, 4> _last4ValuePredictor;
 
-        inline void _setKey(K key)
+        // The histories and the last value predictor are all indexed by the
+        // key. Instead of keeping a separate table for each of them, we
+        // store everything that belongs to a key in a single cache line.
+        struct KeyLine {
+            static const size_t payloadSize = sizeof(T) * 4 +
+                sizeof(HashType) * 4 + sizeof(Generation);
+
+            T lastValues[4];
+            HashType dfcmHistory[3];
+            HashType fcmHistory[1];
+
+            Generation generation;
+            uint8_t padding[PredictorLineSize<payloadSize>::value -
+                            payloadSize];
+        };
+
+        PredictorTable<KeyLine, 16> _keyTable;
+        Generation _generation;
+
+        FirstOrderDfcm _firstOrderDfcmPredictor;
+        ThirdOrderDfcm _thirdOrderDfcmPredictor;
+        FirstOrderFcm _firstOrderFcmPredictor;
+
+        inline KeyLine& _getKeyLine(K key)
         {
-            _sharedDfcmHistory.setKey(key);
-            _privateFcmHistory.setKey(key);
-            _last4ValuePredictor.setKey(key);
+            KeyLine& line = _keyTable.get(static_cast<HashType>(key));
+
+            if (line.generation != _generation) {
+                // Like in the FCM, the last values are initialized to
+                // distinct values.
+                for (uint32_t i = 0; i < 4; ++i) {
+                    line.lastValues[i] = i;
+                }
+
+                memset(line.dfcmHistory, 0, sizeof(line.dfcmHistory));
+                memset(line.fcmHistory, 0, sizeof(line.fcmHistory));
+
+                line.generation = _generation;
+            }
+
+            return line;
         }
 
-        inline void _getValue(PredictorId** codeBuffer, T** dataBuffer, T& out)
+        inline void _getValue(PredictorId** codeBuffer, T** dataBuffer,
+                              const KeyLine& key,
+                              const typename FirstOrderDfcm::Line& firstDfcm,
+                              const typename ThirdOrderDfcm::Line& thirdDfcm,
+                              const typename FirstOrderFcm::Line& fcm, T& out)
         {
             PredictorId id = this->_readPredictorId(codeBuffer);
 
             if (id < 2) {
-                out = _firstOrderDfcmPredictor.getValue(id) +
-                      _last4ValuePredictor.getMostRecentValue();
+                out = _firstOrderDfcmPredictor.getValue(firstDfcm, id) +
+                      key.lastValues[0];
             } else if (id < 4) {
-                out = _thirdOrderDfcmPredictor.getValue(id) +
-                      _last4ValuePredictor.getMostRecentValue();
+                out = _thirdOrderDfcmPredictor.getValue(thirdDfcm, id) +
+                      key.lastValues[0];
             } else if (id < 8) {
-                out = _last4ValuePredictor.getValue(id);
+                out = key.lastValues[id - 4];
             } else if (id < 10) {
-                out = _firstOrderFcmPredictor.getValue(id);
+                out = _firstOrderFcmPredictor.getValue(fcm, id);
             } else {
                 assert(id == ValuePredictor::NotPredictedId);
                 out = this->_readData(dataBuffer);
             }
         }
 
+        inline void _update(KeyLine& key,
+                            typename FirstOrderDfcm::Line& firstDfcm,
+                            typename ThirdOrderDfcm::Line& thirdDfcm,
+                            typename FirstOrderFcm::Line& fcm,
+                            const T value, const T stride)
+        {
+            FirstOrderDfcm::update(firstDfcm, stride);
+            ThirdOrderDfcm::update(thirdDfcm, stride);
+
+            updateValueHistory<T, 4>(key.lastValues, value);
+
+            FirstOrderFcm::update(fcm, value);
+
+            // Now, that we updated all predictors, we can update the DFCM
+            // and FCM history
+            fcmUpdateHistory<T, 17, 3>(key.dfcmHistory, stride);
+            fcmUpdateHistory<T, 19, 1>(key.fcmHistory, value);
+        }
+
     public:
         ValuePredictor() :
-            _sharedDfcmHistory(),
-            _firstOrderDfcmPredictor(0, _sharedDfcmHistory),
-            _thirdOrderDfcmPredictor(2, _sharedDfcmHistory),
-            _privateFcmHistory(),
-            _firstOrderFcmPredictor(8, _privateFcmHistory),
-            _last4ValuePredictor(4) { }
+            _keyTable(),
+            _generation(1),
+            _firstOrderDfcmPredictor(0),
+            _thirdOrderDfcmPredictor(2),
+            _firstOrderFcmPredictor(8) { }
+
+        void reset()
+        {
+            this->_reset();
+
+            if (!advanceGeneration(_generation)) {
+                _keyTable.clear();
+            }
+
+            _firstOrderDfcmPredictor.reset();
+            _thirdOrderDfcmPredictor.reset();
+            _firstOrderFcmPredictor.reset();
+        }
 
         PredictorId encodeValue(PredictorId** codeBuffer, T** dataBuffer,
                                 const T value, const K key)
         {
-            PredictionContext<T> context;
+            KeyLine& keyLine = _getKeyLine(key);
 
-            // Setup the predictors and histories to use the current key
-            _setKey(key);
+            typename FirstOrderDfcm::Line& firstDfcm =
+                _firstOrderDfcmPredictor.getLine(keyLine.dfcmHistory[0]);
+            typename ThirdOrderDfcm::Line& thirdDfcm =
+                _thirdOrderDfcmPredictor.getLine(keyLine.dfcmHistory[2]);
+            typename FirstOrderFcm::Line& fcm =
+                _firstOrderFcmPredictor.getLine(keyLine.fcmHistory[0]);
 
             // The last value needed to compute the stride is obtained from the
             // L4V predictor [5.5 VPC3 and VPC4 Predictor Configurations].
-            T stride = value - _last4ValuePredictor.getMostRecentValue();
+            const T stride = value - keyLine.lastValues[0];
 
             // Evaluate the predictors
-            _firstOrderDfcmPredictor.predictValue(context, stride);
-            _thirdOrderDfcmPredictor.predictValue(context, stride);
-
-            _last4ValuePredictor.predictValue(context, value);
-
-            _firstOrderFcmPredictor.predictValue(context, value);
+            uint32_t mask =
+                _firstOrderDfcmPredictor.match(firstDfcm, stride) |
+                _thirdOrderDfcmPredictor.match(thirdDfcm, stride) |
+                (PredictorVector<T, 4>::match(keyLine.lastValues, value) << 4) |
+                _firstOrderFcmPredictor.match(fcm, value);
 
-            // Now, that we gave all predictors a chance, we update the
-            // history of the DFCMs and the FCM.
-            _sharedDfcmHistory.update(stride);
-            _privateFcmHistory.update(value);
+            _update(keyLine, firstDfcm, thirdDfcm, fcm, value, stride);
 
-            return this->_evaluateContext(codeBuffer, dataBuffer, context, value);
+            return this->_evaluateMatches(codeBuffer, dataBuffer, mask, value);
         }
 
         void decodeValue(PredictorId** codeBuffer, T** dataBuffer, const K key,
                          T& out)
         {
-            T result;
+            KeyLine& keyLine = _getKeyLine(key);
+
+            typename FirstOrderDfcm::Line& firstDfcm =
+                _firstOrderDfcmPredictor.getLine(keyLine.dfcmHistory[0]);
+            typename ThirdOrderDfcm::Line& thirdDfcm =
+                _thirdOrderDfcmPredictor.getLine(keyLine.dfcmHistory[2]);
+            typename FirstOrderFcm::Line& fcm =
+                _firstOrderFcmPredictor.getLine(keyLine.fcmHistory[0]);
 
-            // Setup the predictors and histories to use the current key
-            _setKey(key);
+            T result;
 
             // Get the value from the specified predictor
-            _getValue(codeBuffer, dataBuffer, result);
+            _getValue(codeBuffer, dataBuffer, keyLine, firstDfcm, thirdDfcm,
+                      fcm, result);
 
             // Update the predictors and the histories
-            T stride = result - _last4ValuePredictor.getMostRecentValue();
-            _firstOrderDfcmPredictor.update(stride);
-            _thirdOrderDfcmPredictor.update(stride);
-
-            _last4ValuePredictor.update(result);
-
-            _firstOrderFcmPredictor.update(result);
-
-            // Now, that we updated all predictors, we can update the DFCM
-            // and FCM history
-            _sharedDfcmHistory.update(stride);
-            _privateFcmHistory.update(result);
+            T stride = result - keyLine.lastValues[0];
+            _update(keyLine, firstDfcm, thirdDfcm, fcm, result, stride);
 
             out = result;
         }
@@ -0,0 +1,213 @@
+/*
+ * Copyright 2015 (C) Karlsruhe Institute of Technology (KIT)
+ * Marc Rittinghaus
+ *
+ * This test is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This test is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this test. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "SimuStor.h"
+
+#include "AllocationWaitQueue.h"
+
+using namespace SimuTrace;
+
+// Measures the time it takes to get a segment from an oversubscribed pool.
+// More threads than there are segments repeatedly take a segment, hold it
+// for a while and return it. We compare waiting in an AllocationWaitQueue,
+// as done by the ServerStreamBuffer, with sleeping for a fixed time and
+// retrying, as done before. We report the median, 99th percentile and
+// maximum wait time.
+//
+// Usage: tst_allocationwait [segments] [threads] [rounds]
+
+static const uint32_t holdTime = 2;     // ms
+static const uint32_t retrySleep = 50;  // ms
+
+struct Pool
+{
+    CriticalSection lock;
+    uint32_t available;
+
+    AllocationWaitQueue waiters;
+    bool useQueue;
+
+    uint32_t rounds;
+
+    CriticalSection resultLock;
+    std::vector<uint64_t> waitTimes;
+
+    Pool(uint32_t size, bool useQueue, uint32_t rounds) :
+        available(size),
+        useQueue(useQueue),
+        rounds(rounds) { }
+
+    bool tryTake()
+    {
+        LockScope(lock);
+
+        if (available == 0) {
+            return false;
+        }
+
+        available--;
+        return true;
+    }
+
+    void take()
+    {
+        if (!useQueue) {
+            while (!tryTake()) {
+                ThreadBase::sleep(retrySleep);
+            }
+
+            return;
+        }
+
+        if (!waiters.hasWaiters() && tryTake()) {
+            return;
+        }
+
+        AllocationWaitQueue::Waiter waiter;
+        waiters.enter(waiter, AllocationWaitQueue::Priority::Normal);
+
+        while (true) {
+            if (waiters.wait(waiter, Clock::getTicks() + 1000000000ull) &&
+                tryTake()) {
+                break;
+            }
+        }
+
+        waiters.leave(waiter, true);
+    }
+
+    void give()
+    {
+        Lock(lock); {
+            available++;
+        } Unlock();
+
+        if (useQueue) {
+            waiters.notify();
+        }
+    }
+};
+
+static int _threadMain(Thread<Pool*>& thread)
+{
+    Pool* pool = thread.getArgument();
+    std::vector<uint64_t> times;
+
+    for (uint32_t i = 0; i < pool->rounds; ++i) {
+        uint64_t start = Clock::getTicks();
+        pool->take();
+        times.push_back(Clock::getTicks() - start);
+
+        ThreadBase::sleep(holdTime);
+
+        pool->give();
+    }
+
+    LockScope(pool->resultLock);
+    pool->waitTimes.insert(pool->waitTimes.end(), times.begin(), times.end());
+
+    return 0;
+}
+
+static double _ms(uint64_t ticks)
+{
+    // Clock ticks are in nanoseconds
+    return ticks / 1000000.0;
+}
+
+static std::vector<uint64_t> _run(uint32_t segmentCount, uint32_t threadCount,
+                                  uint32_t rounds, bool useQueue)
+{
+    Pool pool(segmentCount, useQueue, rounds);
+    std::vector<std::unique_ptr<Thread<Pool*>>> threads;
+
+    for (uint32_t i = 0; i < threadCount; ++i) {
+        Pool* arg = &pool;
+        threads.push_back(std::unique_ptr<Thread<Pool*>>(
+            new Thread<Pool*>(_threadMain, arg)));
+
+        threads.back()->start();
+    }
+
+    // We do not join the threads. The thread objects detach on destruction.
+    for (auto& thread : threads) {
+        while (thread->isRunning()) {
+            ThreadBase::sleep(1);
+        }
+    }
+
+    assert(pool.available == segmentCount);
+
+    std::sort(pool.waitTimes.begin(), pool.waitTimes.end());
+
+    return pool.waitTimes;
+}
+
+static void _print(const char* name, const std::vector<uint64_t>& times)
+{
+    std::cout << std::fixed << std::setprecision(3)
+              << "[Test] " << name << ": median "
+              << _ms(times[times.size() / 2]) << " ms, p99 "
+              << _ms(times[times.size() * 99 / 100]) << " ms, max "
+              << _ms(times.back()) << " ms" << std::endl;
+}
+
+int main(int argc, const char* argv[])
+{
+    uint32_t segmentCount = 4;
+    uint32_t threadCount = 16;
+    uint32_t rounds = 50;
+
+    if (argc > 1) {
+        segmentCount = static_cast<uint32_t>(atol(argv[1]));
+    }
+
+    if (argc > 2) {
+        threadCount = static_cast<uint32_t>(atol(argv[2]));
+    }
+
+    if (argc > 3) {
+        rounds = static_cast<uint32_t>(atol(argv[3]));
+    }
+
+    std::cout << "[Test] Allocation wait, " << segmentCount << " segments, "
+              << threadCount << " threads, " << rounds << " rounds."
+              << std::endl;
+
+    std::vector<uint64_t> queue = _run(segmentCount, threadCount, rounds, true);
+    std::vector<uint64_t> retry = _run(segmentCount, threadCount, rounds, false);
+
+    _print("wait queue  ", queue);
+    _print("sleep, retry", retry);
+
+    // With FIFO service, a request waits for the requests ahead of it,
+    // which hold a segment for holdTime each. This should stay well below
+    // a single sleep of the retry loop.
+    uint64_t p99 = queue[queue.size() * 99 / 100];
+
+    bool ok = (queue.size() == threadCount * rounds) &&
+              (_ms(p99) < retrySleep);
+
+    if (!ok) {
+        std::cout << "[Test] Wait time exceeds " << retrySleep << " ms."
+                  << std::endl;
+    }
+
+    std::cout << "[Test] " << ((ok) ? "ok." : "failed.") << std::endl;
+
+    return (ok) ? 0 : 1;
+}
@@ -292,6 +292,18 @@ int main(int argc, char *argv[])
         session = StSessionCreate("local:/tmp/.simutrace");
         ThrowOn(session == INVALID_SESSION_ID);
 
+        // We run the test with pipelined appends by default, so holes are
+        // also tested while appends are still in flight. Synchronous appends
+        // can be tested by passing a window of 1 on the command line.
+        std::string window = (argc > 1) ? argv[1] : "4";
+        std::string config = "client: { stream: { appendWindow = " +
+            window + "; }; };";
+
+        std::cout << "[Test] Using an append window of " << window
+                  << " segments." << std::endl;
+
+        ThrowOn(!StSessionSetConfiguration(session, config.c_str()));
+
         ThrowTestFailOn(!Test<DataRead32>::run(session, conf));
         ThrowTestFailOn(!Test<DataRead64>::run(session, conf));
         ThrowTestFailOn(!Test<Read32>::run(session, conf));
@@ -0,0 +1,262 @@
+/*
+ * Copyright 2015 (C) Karlsruhe Institute of Technology (KIT)
+ * Marc Rittinghaus
+ *
+ * This test is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This test is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this test. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "SimuStor.h"
+
+#include "WorkQueue.h"
+#include "WorkerPool.h"
+
+#include "Simtrace3Blocks.h"
+
+#include <functional>
+#include <random>
+
+using namespace SimuTrace;
+using namespace SimuTrace::Simtrace;
+using namespace SimuTrace::Compression;
+
+// Writes data in the block format (store.simtrace.blockSize) and reads it
+// back with each codec. The data sizes cover a single partial block, exact
+// multiples of the block size and a short last block. We also check the
+// layout of the block table and that a decoder rejects corrupted tables
+// instead of writing outside of the destination.
+
+typedef std::vector<char> Buffer;
+
+#define BLOCK_SIZE (64 * 1024)
+
+static Buffer _trace(size_t size, uint32_t seed)
+{
+    // Resembles memory accesses: slowly increasing cycle counts and
+    // addresses with some noise
+    std::mt19937 rng(seed);
+    Buffer data(size);
+
+    uint64_t cycle = 0;
+    for (size_t i = 0; i < size; i += sizeof(uint64_t)) {
+        cycle += rng() % 16;
+        uint64_t value = ((i / sizeof(uint64_t)) % 2 == 0) ? cycle :
+            0xFFFFF78000000000 + (rng() % 256) * 8;
+
+        memcpy(&data[i], &value, std::min(sizeof(uint64_t), size - i));
+    }
+
+    return data;
+}
+
+static size_t _bound(size_t size)
+{
+    // Large enough for incompressible data, the block table and the
+    // headers of all blocks
+    uint32_t blockCount = static_cast<uint32_t>(
+        (size + BLOCK_SIZE - 1) / BLOCK_SIZE);
+
+    return size + (size / 8) + SIMTRACE_V3_BLOCK_TABLE_SIZE(blockCount) +
+        blockCount * 1024;
+}
+
+static bool _roundTrip(WorkerPool& pool, const Codec& codec,
+                       const Buffer& data)
+{
+    Buffer compressed(_bound(data.size()));
+    size_t compressedSize = compressBlocks(pool, codec, codec.defaultLevel,
+                                           BLOCK_SIZE, data.data(),
+                                           data.size(), compressed.data(),
+                                           compressed.size());
+    if ((compressedSize == 0) || (compressedSize > compressed.size())) {
+        return false;
+    }
+
+    // The table must describe the blocks without gaps up to the end of
+    // the compressed data.
+    const AttributeBlockTable* table =
+        reinterpret_cast<const AttributeBlockTable*>(compressed.data());
+
+    uint32_t blockCount = static_cast<uint32_t>(
+        (data.size() + BLOCK_SIZE - 1) / BLOCK_SIZE);
+
+    if ((table->blockCount != blockCount) ||
+        (table->blockSize != BLOCK_SIZE) || (table->offsets[0] != 0) ||
+        (SIMTRACE_V3_BLOCK_TABLE_SIZE(blockCount) +
+            table->offsets[blockCount] != compressedSize)) {
+        return false;
+    }
+
+    // Decode into a larger buffer as the encoder does with a segment.
+    // The decoder must stop at the end of the data.
+    Buffer decompressed(data.size() + BLOCK_SIZE, 0x5A);
+    size_t size = decompressBlocks(pool, codec, compressed.data(),
+                                   compressedSize, decompressed.data(),
+                                   decompressed.size());
+
+    if (size != data.size()) {
+        return false;
+    }
+
+    for (size_t i = data.size(); i < decompressed.size(); ++i) {
+        if (decompressed[i] != 0x5A) {
+            return false;
+        }
+    }
+
+    decompressed.resize(size);
+
+    return (decompressed == data);
+}
+
+static bool _checkRoundTrips(WorkerPool& pool, const Codec& codec)
+{
+    const size_t sizes[] = {
+        1,
+        BLOCK_SIZE - 1,
+        BLOCK_SIZE,
+        BLOCK_SIZE + 1,
+        4 * BLOCK_SIZE,
+        7 * BLOCK_SIZE + 123
+    };
+
+    for (auto size : sizes) {
+        Buffer data = _trace(size, static_cast<uint32_t>(size));
+
+        if (!_roundTrip(pool, codec, data)) {
+            std::cout << "(" << size << " bytes) ";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool _expectError(WorkerPool& pool, const Codec& codec,
+                         const Buffer& source, size_t sourceSize,
+                         size_t destinationSize)
+{
+    // One spare byte, so an overrun of the destination is detected
+    Buffer destination(destinationSize + 1, 0x5A);
+
+    try {
+        decompressBlocks(pool, codec, source.data(), sourceSize,
+                         destination.data(), destinationSize);
+    } catch (const Exception&) {
+        return (destination[destinationSize] == 0x5A);
+    }
+
+    return false;
+}
+
+static bool _checkCorruptedTable(WorkerPool& pool, const Codec& codec)
+{
+    Buffer data = _trace(4 * BLOCK_SIZE + 17, 5);
+    Buffer compressed(_bound(data.size()));
+
+    size_t compressedSize = compressBlocks(pool, codec, codec.defaultLevel,
+                                           BLOCK_SIZE, data.data(),
+                                           data.size(), compressed.data(),
+                                           compressed.size());
+    compressed.resize(compressedSize);
+
+    // Truncated table and truncated blocks
+    const size_t truncated[] = {
+        0,
+        SIMTRACE_V3_BLOCK_TABLE_SIZE(0) - 1,
+        SIMTRACE_V3_BLOCK_TABLE_SIZE(5) - 1,
+        compressedSize - 1
+    };
+
+    for (auto size : truncated) {
+        if (!_expectError(pool, codec, compressed, size, data.size())) {
+            std::cout << "(truncated to " << size << " bytes) ";
+            return false;
+        }
+    }
+
+    // The destination cannot hold all blocks
+    if (!_expectError(pool, codec, compressed, compressedSize,
+                      3 * BLOCK_SIZE)) {
+        std::cout << "(small destination) ";
+        return false;
+    }
+
+    // Fields that are out of range
+    struct Corruption {
+        const char* name;
+        std::function<void(AttributeBlockTable*)> apply;
+    };
+
+    const Corruption corruptions[] = {
+        { "no blocks",       [](AttributeBlockTable* t) {
+            t->blockCount = 0; } },
+        { "many blocks",     [](AttributeBlockTable* t) {
+            t->blockCount = 0xFFFFFFFF; } },
+        { "zero block size", [](AttributeBlockTable* t) {
+            t->blockSize = 0; } },
+        { "huge block size", [](AttributeBlockTable* t) {
+            t->blockSize = 0x8000000000000000; } },
+        { "small block size", [](AttributeBlockTable* t) {
+            t->blockSize = BLOCK_SIZE / 2; } },
+        { "offset order",    [](AttributeBlockTable* t) {
+            std::swap(t->offsets[1], t->offsets[2]); } },
+        { "offset range",    [](AttributeBlockTable* t) {
+            t->offsets[t->blockCount] = 0xFFFFFFFFFFFF; } }
+    };
+
+    for (const auto& corruption : corruptions) {
+        Buffer corrupted(compressed);
+        corruption.apply(reinterpret_cast<AttributeBlockTable*>(
+            corrupted.data()));
+
+        if (!_expectError(pool, codec, corrupted, compressedSize,
+                          data.size())) {
+            std::cout << "(" << corruption.name << ") ";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, const char* argv[])
+{
+    bool ok = true;
+
+    LogCategory log("Test");
+    Environment env;
+    env.log = &log;
+    env.config = nullptr;
+
+    WorkerPool pool(4, env);
+
+    const CodecId codecs[] = { CiLz4, CiLzma, CiNone };
+
+    for (auto id : codecs) {
+        const Codec& codec = *getCodec(id);
+
+        std::cout << "[Test] " << codec.name << ": round trips...";
+        bool result = _checkRoundTrips(pool, codec);
+        std::cout << ((result) ? "ok." : "failed.") << std::endl;
+        ok = result && ok;
+
+        std::cout << "[Test] " << codec.name << ": corrupted block table...";
+        result = _checkCorruptedTable(pool, codec);
+        std::cout << ((result) ? "ok." : "failed.") << std::endl;
+        ok = result && ok;
+    }
+
+    pool.close();
+
+    return (ok) ? 0 : 1;
+}
@@ -0,0 +1,240 @@
+/*
+ * Copyright 2015 (C) Karlsruhe Institute of Technology (KIT)
+ * Marc Rittinghaus
+ *
+ * This test is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This test is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this test. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <string>
+#include <iostream>
+#include <chrono>
+#include <assert.h>
+
+#include "SimuTrace.h"
+
+using namespace SimuTrace;
+
+// Writes a stream with StReserveEntries()/StSubmitEntries() and reads it
+// back with StGetNextEntries(). The writer submits the reserved spans in
+// parts, so the test covers partial submits and segment switches. The
+// reader validates every entry and we compare the read time against a
+// loop over StGetNextEntry() once the segments are cached.
+
+class SimutraceException {};
+class TestFailException {};
+
+#define ThrowOn(expr) \
+    if (expr) { \
+        throw SimutraceException(); \
+    }
+
+#define FailOn(expr, count) \
+    if (expr) { \
+        std::cout << "failed (count " << count << ")" << std::endl; \
+        assert(false); \
+        throw TestFailException(); \
+    }
+
+// Number of entries to write. With 32 byte entries, this spans several
+// 64 MiB segments.
+#define ENTRY_COUNT 0x500000
+
+// Maximum number of entries to submit at once. Not a divisor of the
+// segment capacity, so the last submit in a segment is partial.
+#define SUBMIT_CHUNK 777
+
+static void _fill(DataRead64* entry, uint64_t i)
+{
+    entry->metadata.cycleCount = i;
+    entry->metadata.fullSize = 1;
+
+    entry->ip = 0xFFFFF78000000000 + (i % 0x10);
+    entry->address = i;
+    entry->dataFields[1] = 0x0123456789ABCDEF * i;
+}
+
+static bool _check(const DataRead64* entry, uint64_t i)
+{
+    return (entry->metadata.cycleCount == i) &&
+           (entry->metadata.fullSize == 1) &&
+           (entry->ip == 0xFFFFF78000000000 + (i % 0x10)) &&
+           (entry->address == i) &&
+           (entry->dataFields[1] == 0x0123456789ABCDEF * i);
+}
+
+static void _write(SessionId session, StreamId stream)
+{
+    StreamHandle handle = StStreamAppend(session, stream, nullptr);
+    ThrowOn(handle == nullptr);
+
+    uint64_t i = 0;
+    while (i < ENTRY_COUNT) {
+        size_t count;
+        DataRead64* span = reinterpret_cast<DataRead64*>(
+            StReserveEntries(&handle, &count));
+        ThrowOn(span == nullptr);
+        assert(count > 0);
+
+        if (count > SUBMIT_CHUNK) {
+            count = SUBMIT_CHUNK;
+        }
+
+        if (count > ENTRY_COUNT - i) {
+            count = static_cast<size_t>(ENTRY_COUNT - i);
+        }
+
+        for (size_t j = 0; j < count; ++j) {
+            _fill(&span[j], i + j);
+        }
+
+        StSubmitEntries(handle, count);
+        i += count;
+    }
+
+    ThrowOn(!StStreamClose(handle));
+}
+
+static double _readSpans(SessionId session, StreamId stream)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    StreamHandle handle = StStreamOpen(session, stream, QueryIndexType::QIndex,
+                                       0, StreamAccessFlags::SafSequentialScan,
+                                       nullptr);
+    ThrowOn(handle == nullptr);
+
+    uint64_t i = 0;
+    while (i < ENTRY_COUNT) {
+        size_t count;
+        const DataRead64* span = reinterpret_cast<const DataRead64*>(
+            StGetNextEntries(&handle, &count));
+        ThrowOn(span == nullptr);
+
+        FailOn(i + count > ENTRY_COUNT, i);
+
+        for (size_t j = 0; j < count; ++j) {
+            FailOn(!_check(&span[j], i + j), i + j);
+        }
+
+        i += count;
+    }
+
+    size_t count;
+    FailOn(StGetNextEntries(&handle, &count) != nullptr, -1);
+
+    StStreamClose(handle);
+
+    std::chrono::duration<double> t =
+        std::chrono::high_resolution_clock::now() - start;
+    return t.count();
+}
+
+static double _readEntries(SessionId session, StreamId stream)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    StreamHandle handle = StStreamOpen(session, stream, QueryIndexType::QIndex,
+                                       0, StreamAccessFlags::SafSequentialScan,
+                                       nullptr);
+    ThrowOn(handle == nullptr);
+
+    for (uint64_t i = 0; i < ENTRY_COUNT; ++i) {
+        const DataRead64* entry = reinterpret_cast<const DataRead64*>(
+            StGetNextEntry(&handle));
+        ThrowOn(entry == nullptr);
+
+        FailOn(!_check(entry, i), i);
+    }
+
+    FailOn(StGetNextEntry(&handle) != nullptr, -1);
+
+    StStreamClose(handle);
+
+    std::chrono::duration<double> t =
+        std::chrono::high_resolution_clock::now() - start;
+    return t.count();
+}
+
+int main(int argc, char *argv[])
+{
+    int code = 0;
+    SessionId session = INVALID_SESSION_ID;
+
+    std::cout << "[Test] Connecting to server..." << std::endl;
+
+    try {
+        session = StSessionCreate("local:/tmp/.simutrace");
+        ThrowOn(session == INVALID_SESSION_ID);
+
+        ThrowOn(!StSessionCreateStore(session, "simtrace:test.sim", _true));
+
+        const StreamTypeDescriptor* typeDesc;
+        typeDesc = StStreamFindMemoryType(ArchitectureSize::As64Bit,
+                                          MemoryAccessType::MatRead,
+                                          MemoryAddressType::AtPhysical,
+                                          _true);
+
+        StreamDescriptor desc;
+        ThrowOn(!StMakeStreamDescriptorFromType("memorystream", typeDesc,
+                                                &desc));
+
+        StreamId stream = StStreamRegister(session, &desc);
+        ThrowOn(stream == INVALID_STREAM_ID);
+
+        std::cout << "[Test] Writing " << ENTRY_COUNT
+                  << " entries with spans...";
+
+        _write(session, stream);
+
+        // Close and reopen the store to wait until all data is written out
+        StSessionCloseStore(session);
+        ThrowOn(!StSessionOpenStore(session, "simtrace:test.sim"));
+
+        std::cout << "ok." << std::endl;
+        std::cout << "[Test] Validating data with spans...";
+
+        double spanTime = _readSpans(session, stream);
+
+        std::cout << "ok (" << spanTime << " s)." << std::endl;
+        std::cout << "[Test] Validating data with single entries...";
+
+        double entryTime = _readEntries(session, stream);
+
+        std::cout << "ok (" << entryTime << " s)." << std::endl;
+
+        // The first read includes loading the segments from the server.
+        // Compare on the warm cache.
+        std::cout << "[Test] Validating data with spans again...";
+
+        spanTime = _readSpans(session, stream);
+
+        std::cout << "ok (" << spanTime << " s)." << std::endl;
+
+        StSessionCloseStore(session);
+
+    } catch (SimutraceException) {
+        ExceptionInformation info;
+        StGetLastError(&info);
+
+        std::cout << "Exception: '" << std::string(info.message)
+                  << "', code " << info.code << std::endl;
+
+        code = -1;
+    } catch (TestFailException) {
+        code = -1;
+    }
+
+    StSessionClose(session);
+
+    return code;
+}
@@ -0,0 +1,194 @@
+/*
+ * Copyright 2015 (C) Karlsruhe Institute of Technology (KIT)
+ * Marc Rittinghaus
+ *
+ * This test is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This test is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this test. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "SimuStor.h"
+
+using namespace SimuTrace;
+
+// Measures the throughput and the CPU time of segment transfers as done by
+// remote clients. A receiver runs in a separate thread of this process and
+// receives each message directly into a preallocated segment (like the
+// server does with its stream buffers). We transfer the segments with and
+// without zero-copy sends and report the throughput as well as the CPU time
+// of the process (sender and receiver) per GiB.
+
+static const size_t segmentSize = 64 * 1024 * 1024;
+
+struct Receiver {
+    ServerPort* binding;
+    Environment* env;
+    std::vector<char>* segment;
+};
+
+static void _segmentAllocator(Message& msg, bool free, void* args)
+{
+    // The segment is owned by the receiver. Nothing to free.
+    if (free) {
+        return;
+    }
+
+    std::vector<char>* segment = reinterpret_cast<std::vector<char>*>(args);
+    if (msg.data.payloadLength <= segment->size()) {
+        msg.data.payload = segment->data();
+    }
+}
+
+static int _receiverMain(Thread<Receiver>& thread)
+{
+    Receiver& receiver = thread.getArgument();
+
+    Environment::set(receiver.env);
+
+    try {
+        while (true) {
+            std::unique_ptr<Port> connection = receiver.binding->accept();
+            ServerPort* port = static_cast<ServerPort*>(connection.get());
+
+            try {
+                Message request = {0};
+                while (true) {
+                    request.allocator     = _segmentAllocator;
+                    request.allocatorArgs = receiver.segment;
+
+                    port->wait(request);
+
+                    // Return the first word of the segment, so the sender
+                    // can check that the data arrived.
+                    uint32_t tag = *reinterpret_cast<uint32_t*>(
+                        receiver.segment->data());
+
+                    port->ret(request, RpcApi::SC_Success, tag);
+                }
+            } catch (...) {
+                // The sender closed the connection. Wait for the next one.
+            }
+        }
+    } catch (...) {
+        // The binding has been closed. We are done.
+    }
+
+    return 0;
+}
+
+static bool _transfer(const std::string& specifier, uint32_t count,
+                      std::vector<char>& segment)
+{
+    bool ok = true;
+    ClientPort port(specifier);
+
+    uint64_t start = Clock::getTicks();
+    std::clock_t cpuStart = std::clock();
+
+    for (uint32_t i = 0; i < count; ++i) {
+        Message response = {0};
+
+        *reinterpret_cast<uint32_t*>(segment.data()) = i;
+
+        port.call(&response, RpcApi::CCV_Null, segment.data(),
+                  static_cast<uint32_t>(segment.size()));
+
+        if (response.parameter0 != i) {
+            ok = false;
+        }
+    }
+
+    double seconds = static_cast<double>(Clock::getTicks() - start) /
+        1000000000.0;
+    double cpu = static_cast<double>(std::clock() - cpuStart) /
+        CLOCKS_PER_SEC;
+    double gib = static_cast<double>(count) * segment.size() /
+        (1024.0 * 1024.0 * 1024.0);
+
+    std::cout << std::fixed << std::setprecision(2)
+              << gib / seconds << " GiB/s, "
+              << (cpu / gib) * 1000.0 << " ms CPU per GiB" << std::endl;
+
+    port.close();
+
+    return ok;
+}
+
+int main(int argc, const char* argv[])
+{
+    std::string specifier = "socket:127.0.0.1:5351";
+    uint32_t count = 32;
+
+    if (argc > 1) {
+        specifier = std::string(argv[1]);
+    }
+
+    if (argc > 2) {
+        count = static_cast<uint32_t>(atol(argv[2]));
+    }
+
+    std::cout << "[Test] Segment transfer on '" << specifier << "', "
+              << count << " segments of " << (segmentSize >> 20)
+              << " MiB." << std::endl;
+
+    LogCategory log("Test");
+    libconfig::Config config;
+    Environment env;
+    env.log = &log;
+    env.config = &config;
+    Environment::set(&env);
+
+    log.setPriorityThreshold(LogPriority::Warning);
+
+    bool ok = true;
+
+    try {
+        std::vector<char> sendSegment(segmentSize, 0x5a);
+        std::vector<char> receiveSegment(segmentSize, 0);
+
+        ServerPort binding(specifier);
+
+        Thread<Receiver> receiver(_receiverMain);
+        Receiver arg = { &binding, &env, &receiveSegment };
+        receiver.setArgument(arg);
+        receiver.start();
+
+        // Each connection reads the configuration when it is established
+        int thresholds[] = { 0, 1024 };
+        for (int threshold : thresholds) {
+            Configuration::set<int>("network.socket.zeroCopyThreshold",
+                                    threshold);
+
+            std::cout << "[Test] zero-copy "
+                      << ((threshold > 0) ? "on:  " : "off: ");
+
+            if (!_transfer(specifier, count, sendSegment)) {
+                std::cout << "[Test] Transferred data did not match."
+                          << std::endl;
+                ok = false;
+            }
+        }
+
+        binding.close();
+
+        while (receiver.isRunning()) {
+            ThreadBase::sleep(1);
+        }
+
+    } catch (const std::exception& e) {
+        std::cout << "[Test] Exception: " << e.what() << std::endl;
+        ok = false;
+    }
+
+    std::cout << "[Test] " << ((ok) ? "ok." : "failed.") << std::endl;
+
+    return (ok) ? 0 : 1;
+}
@@ -0,0 +1,271 @@
+/*
+ * Copyright 2015 (C) Karlsruhe Institute of Technology (KIT)
+ * Marc Rittinghaus
+ *
+ * This test is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This test is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this test. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "SimuStor.h"
+
+#include "Compression.h"
+
+#include <random>
+
+using namespace SimuTrace;
+using namespace SimuTrace::Compression;
+
+// Checks the compression codecs of the generic encoder. Each codec must
+// reproduce its input for inputs that are empty, shorter than the minimum
+// match length of LZ4 (MFLIMIT), incompressible or consist of long runs.
+// The decoders must reject malformed input (truncated streams, corrupted
+// bytes, wrong sizes) with an error instead of crashing or writing out of
+// bounds. Run the test with a memory checker to catch the latter.
+
+typedef std::vector<unsigned char> Buffer;
+
+// Minimum input size for which LZ4 looks for matches (MFLIMIT in lz4.c)
+#define LZ4_MF_LIMIT 12
+
+static Buffer _random(size_t size, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    Buffer data(size);
+
+    for (auto& b : data) {
+        b = static_cast<unsigned char>(rng());
+    }
+
+    return data;
+}
+
+static Buffer _run(size_t size, unsigned char value)
+{
+    return Buffer(size, value);
+}
+
+static Buffer _pattern(size_t size, size_t period)
+{
+    Buffer data(size);
+
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<unsigned char>("Simutrace"[i % period]);
+    }
+
+    return data;
+}
+
+static Buffer _trace(size_t size)
+{
+    // Resembles memory accesses: slowly increasing cycle counts and
+    // addresses with some noise
+    std::mt19937 rng(42);
+    Buffer data(size);
+
+    uint64_t cycle = 0;
+    for (size_t i = 0; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+        cycle += rng() % 16;
+        uint64_t value = ((i / sizeof(uint64_t)) % 2 == 0) ? cycle :
+            0xFFFFF78000000000 + (rng() % 256) * 8;
+
+        memcpy(&data[i], &value, sizeof(uint64_t));
+    }
+
+    return data;
+}
+
+static size_t _bound(size_t size)
+{
+    // Large enough for incompressible data and the headers of all codecs
+    return size + (size / 8) + 1024;
+}
+
+static bool _roundTrip(const Codec& codec, uint32_t level,
+                       const Buffer& data)
+{
+    Buffer compressed(_bound(data.size()));
+    size_t compressedSize = codec.compress(data.data(), data.size(),
+                                           compressed.data(),
+                                           compressed.size(), level);
+    if ((compressedSize == 0) || (compressedSize > compressed.size())) {
+        return false;
+    }
+
+    Buffer decompressed(data.size());
+    size_t size = codec.decompress(compressed.data(), compressedSize,
+                                   decompressed.data(), decompressed.size());
+
+    return (size == data.size()) && (decompressed == data);
+}
+
+static bool _checkRoundTrips(const Codec& codec)
+{
+    std::vector<Buffer> inputs;
+
+    // Inputs around the match find limit of LZ4
+    for (size_t size = 1; size <= LZ4_MF_LIMIT + 2; ++size) {
+        inputs.push_back(_random(size, static_cast<uint32_t>(size)));
+        inputs.push_back(_run(size, 0));
+    }
+
+    inputs.push_back(_random(1024 * 1024, 1));  // Incompressible
+    inputs.push_back(_run(4 * 1024 * 1024, 0)); // Long run
+    inputs.push_back(_run(65536 + 17, 0xAB));   // Run beyond max. offset
+    inputs.push_back(_pattern(100000, 1));
+    inputs.push_back(_pattern(100000, 3));      // Overlapping matches
+    inputs.push_back(_pattern(100000, 9));
+    inputs.push_back(_trace(1024 * 1024));
+
+    for (const auto& input : inputs) {
+        // Checking all levels on the large inputs takes too long for LZMA
+        std::vector<uint32_t> levels;
+        if ((codec.id == CiLzma) && (input.size() > 100000)) {
+            levels.push_back(codec.defaultLevel);
+        } else {
+            for (uint32_t level = 0; level <= codec.maxLevel; ++level) {
+                levels.push_back(level);
+            }
+        }
+
+        for (auto level : levels) {
+            if (!_roundTrip(codec, level, input)) {
+                std::cout << "(" << codec.name << ", level " << level
+                          << ", " << input.size() << " bytes) ";
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static bool _checkEmptyInput(const Codec& codec)
+{
+    // The codecs do not compress empty buffers. The encoder never asks for
+    // it.
+    Buffer compressed(_bound(0));
+
+    try {
+        byte source = 0;
+        codec.compress(&source, 0, compressed.data(), compressed.size(),
+                       codec.defaultLevel);
+        return false;
+    } catch (const ArgumentException&) {
+
+    }
+
+    return true;
+}
+
+static bool _expectDecompressError(const Codec& codec, const Buffer& source,
+                                   size_t sourceSize, size_t destinationSize)
+{
+    // One spare byte, so an overrun of the destination is detected
+    Buffer destination(destinationSize + 1, 0xCC);
+
+    try {
+        codec.decompress(source.data(), sourceSize, destination.data(),
+                         destinationSize);
+    } catch (const Exception&) {
+        return (destination[destinationSize] == 0xCC);
+    }
+
+    return false;
+}
+
+static bool _checkMalformedInput(const Codec& codec)
+{
+    Buffer data = _trace(64 * 1024);
+    Buffer compressed(_bound(data.size()));
+
+    size_t compressedSize = codec.compress(data.data(), data.size(),
+                                           compressed.data(),
+                                           compressed.size(),
+                                           codec.defaultLevel);
+    compressed.resize(compressedSize);
+
+    // Truncated streams, including truncation within the size header
+    for (size_t size = 0; size < compressedSize;
+         size += (size < 64) ? 1 : 61) {
+        if (!_expectDecompressError(codec, compressed, size, data.size())) {
+            std::cout << "(truncated to " << size << " bytes) ";
+            return false;
+        }
+    }
+
+    // The destination is smaller than announced in the header
+    if (!_expectDecompressError(codec, compressed, compressedSize,
+                                data.size() - 1)) {
+        std::cout << "(small destination) ";
+        return false;
+    }
+
+    // Corrupted streams must either fail or at least stay within the
+    // destination buffer.
+    std::mt19937 rng(3);
+    for (int i = 0; i < 1000; ++i) {
+        Buffer corrupted(compressed);
+
+        for (int j = 0; j < 4; ++j) {
+            size_t pos = sizeof(uint64_t) + (rng() %
+                (compressedSize - sizeof(uint64_t)));
+            corrupted[pos] = static_cast<unsigned char>(rng());
+        }
+
+        Buffer destination(data.size() + 1, 0xCC);
+
+        try {
+            codec.decompress(corrupted.data(), compressedSize,
+                             destination.data(), data.size());
+        } catch (const Exception&) {
+
+        }
+
+        if (destination[data.size()] != 0xCC) {
+            std::cout << "(corruption " << i << ") ";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, const char* argv[])
+{
+    bool ok = true;
+
+    const CodecId codecs[] = { CiLzma, CiLz4, CiNone };
+
+    for (auto id : codecs) {
+        const Codec& codec = *getCodec(id);
+
+        std::cout << "[Test] " << codec.name << ": round trips...";
+        bool result = _checkRoundTrips(codec);
+        std::cout << ((result) ? "ok." : "failed.") << std::endl;
+        ok = result && ok;
+
+        std::cout << "[Test] " << codec.name << ": empty input...";
+        result = _checkEmptyInput(codec);
+        std::cout << ((result) ? "ok." : "failed.") << std::endl;
+        ok = result && ok;
+
+        // Stored data has no structure that could be malformed
+        if (id != CiNone) {
+            std::cout << "[Test] " << codec.name << ": malformed input...";
+            result = _checkMalformedInput(codec);
+            std::cout << ((result) ? "ok." : "failed.") << std::endl;
+            ok = result && ok;
+        }
+    }
+
+    return (ok) ? 0 : 1;
+}
@@ -0,0 +1,286 @@
+/*
+ * Copyright 2015 (C) Karlsruhe Institute of Technology (KIT)
+ * Marc Rittinghaus
+ *
+ * This test is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This test is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this test. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <string>
+#include <iostream>
+#include <algorithm>
+#include <set>
+#include <assert.h>
+#include <string.h>
+
+#include "SimuTrace.h"
+
+using namespace SimuTrace;
+
+// Writes memory streams that span several segments, reopens the store and
+// reads the streams back. Run the server with store.simtrace.memoryShards
+// set to a value larger than 1 (e.g., --store.simtrace.memoryShards 4) to
+// cover the sharded memory encoder. Each stream ends with a short segment,
+// which uses fewer shards. The entries mix predictable and random values,
+// so that the shards store both predictor ids and raw data. Besides a full
+// sequential read, we open the streams at entries around the possible shard
+// boundaries, where a decoder that uses wrong boundaries or predictor state
+// would return wrong entries.
+
+class SimutraceException {};
+class TestFailException {};
+
+#define ThrowOn(expr) \
+    if (expr) { \
+        throw SimutraceException(); \
+    }
+
+#define FailOn(expr, count) \
+    if (expr) { \
+        std::cout << "failed (count " << count << ")" << std::endl; \
+        assert(false); \
+        throw TestFailException(); \
+    }
+
+// Size of the segments of memory streams
+#define SEGMENT_SIZE (64 * 1024 * 1024)
+
+// Maximum number of shards per segment that we probe for boundaries
+#define MAX_SHARDS 8
+
+// Alignment of shard boundaries in entries
+#define SHARD_ALIGNMENT 4096
+
+// Number of entries to compare after each open
+#define COMPARE_COUNT 256
+
+template<typename T>
+static void _makeEntry(uint64_t i, T& entry)
+{
+    const uint64_t hash = (i + 1) * 0x9E3779B97F4A7C15ULL;
+    const size_t fieldCount =
+        sizeof(entry.dataFields) / sizeof(entry.dataFields[0]);
+
+    memset(&entry, 0, sizeof(T));
+
+    // Strictly increasing cycle counts with some noise
+    entry.metadata.cycleCount = i * 4 + (hash >> 62);
+    entry.metadata.fullSize = i & 0x1;
+    entry.metadata.tag = i & 0x7FFF;
+
+    // Loops with occasional jumps and strided accesses with occasional
+    // random addresses and data. The random values are few and small to
+    // keep the compression of the trace fast.
+    entry.ip = (i % 13 == 0) ? (hash >> 40) : (0x400000 + (i % 64) * 4);
+    entry.dataFields[0] = (i % 11 == 0) ? (hash >> 40) : (0x10000 + i * 8);
+
+    if (fieldCount > 1) {
+        entry.dataFields[fieldCount - 1] = (i % 7 == 0) ? (hash >> 40) :
+            (i & 0xFF);
+    }
+}
+
+template<typename T>
+static void _write(SessionId session, StreamId stream, uint64_t count)
+{
+    StreamHandle handle = StStreamAppend(session, stream, nullptr);
+    ThrowOn(handle == nullptr);
+
+    for (uint64_t i = 0; i < count; ++i) {
+        T* entry = reinterpret_cast<T*>(StGetNextEntry(&handle));
+        ThrowOn(entry == nullptr);
+
+        _makeEntry(i, *entry);
+
+        StSubmitEntry(handle);
+    }
+
+    ThrowOn(!StStreamClose(handle));
+}
+
+template<typename T>
+static void _compare(StreamHandle* handle, uint64_t first, uint64_t count,
+                     uint64_t total)
+{
+    T expected;
+
+    for (uint64_t i = first; (i < first + count) && (i < total); ++i) {
+        const T* entry = reinterpret_cast<const T*>(StGetNextEntry(handle));
+        ThrowOn(entry == nullptr);
+
+        _makeEntry(i, expected);
+        FailOn(memcmp(entry, &expected, sizeof(T)) != 0, i);
+    }
+}
+
+template<typename T>
+static void _readSequential(SessionId session, StreamId stream,
+                            uint64_t count)
+{
+    StreamHandle handle = StStreamOpen(session, stream, QueryIndexType::QIndex,
+                                       0, StreamAccessFlags::SafSequentialScan,
+                                       nullptr);
+    ThrowOn(handle == nullptr);
+
+    _compare<T>(&handle, 0, count, count);
+
+    FailOn(StGetNextEntry(&handle) != nullptr, -1);
+
+    StStreamClose(handle);
+}
+
+template<typename T>
+static void _readAt(SessionId session, StreamId stream, QueryIndexType type,
+                    uint64_t index, uint64_t count)
+{
+    T expected;
+    _makeEntry(index, expected);
+
+    uint64_t value = (type == QueryIndexType::QCycleCount) ?
+        expected.metadata.cycleCount : index;
+
+    StreamHandle handle = StStreamOpen(session, stream, type, value,
+                                       StreamAccessFlags::SafNone, nullptr);
+    ThrowOn(handle == nullptr);
+
+    _compare<T>(&handle, index, COMPARE_COUNT, count);
+
+    StStreamClose(handle);
+}
+
+template<typename T>
+static void _readBoundaries(SessionId session, StreamId stream,
+                            uint64_t count)
+{
+    const uint64_t segmentEntries = SEGMENT_SIZE / sizeof(T);
+
+    for (uint64_t segment = 0; segment * segmentEntries < count; ++segment) {
+        const uint64_t start = segment * segmentEntries;
+        const uint64_t entries = std::min(segmentEntries, count - start);
+
+        // Collect the shard boundaries for all shard counts up to
+        // MAX_SHARDS. This mirrors the split in the memory encoder: shards
+        // are of equal size, rounded up to SHARD_ALIGNMENT entries.
+        std::set<uint64_t> splits;
+        for (uint64_t n = 2; n <= MAX_SHARDS; ++n) {
+            uint64_t size = (entries + n - 1) / n;
+            size = (size + SHARD_ALIGNMENT - 1) & ~(SHARD_ALIGNMENT - 1);
+
+            for (uint64_t split = size; split < entries; split += size) {
+                splits.insert(start + split);
+            }
+        }
+
+        // Open the stream a few entries before each boundary and compare
+        // the entries across it.
+        for (auto split : splits) {
+            _readAt<T>(session, stream, QueryIndexType::QIndex,
+                       split - COMPARE_COUNT / 2, count);
+        }
+
+        _readAt<T>(session, stream, QueryIndexType::QCycleCount,
+                   start + entries / 2 + 3, count);
+        _readAt<T>(session, stream, QueryIndexType::QIndex,
+                   start + entries - 1, count);
+    }
+}
+
+static StreamId _register(SessionId session, const char* name,
+                          ArchitectureSize size, _bool hasData)
+{
+    const StreamTypeDescriptor* typeDesc;
+    typeDesc = StStreamFindMemoryType(size, MemoryAccessType::MatWrite,
+                                      MemoryAddressType::AtVirtual, hasData);
+    ThrowOn(typeDesc == nullptr);
+
+    StreamDescriptor desc;
+    ThrowOn(!StMakeStreamDescriptorFromType(name, typeDesc, &desc));
+
+    StreamId stream = StStreamRegister(session, &desc);
+    ThrowOn(stream == INVALID_STREAM_ID);
+
+    return stream;
+}
+
+template<typename T>
+static void _check(SessionId session, const char* name, ArchitectureSize size,
+                   _bool hasData, uint64_t count)
+{
+    // Each stream gets its own store. The memory encoder keeps a segment
+    // of each of its hidden streams in memory while writing, so the
+    // streams would need a lot of server memory at the same time.
+    std::string store = std::string("simtrace:") + name + ".sim";
+
+    ThrowOn(!StSessionCreateStore(session, store.c_str(), _true));
+
+    StreamId stream = _register(session, name, size, hasData);
+
+    std::cout << "[Test] " << name << ": writing " << count << " entries...";
+
+    _write<T>(session, stream, count);
+
+    // Close and reopen the store to read the data from the file
+    StSessionCloseStore(session);
+    ThrowOn(!StSessionOpenStore(session, store.c_str()));
+
+    std::cout << "ok." << std::endl;
+    std::cout << "[Test] " << name << ": sequential read...";
+
+    _readSequential<T>(session, stream, count);
+
+    std::cout << "ok." << std::endl;
+    std::cout << "[Test] " << name << ": shard boundaries...";
+
+    _readBoundaries<T>(session, stream, count);
+
+    std::cout << "ok." << std::endl;
+
+    StSessionCloseStore(session);
+}
+
+int main(int argc, char *argv[])
+{
+    int code = 0;
+    SessionId session = INVALID_SESSION_ID;
+
+    // One and a half segments for 64 bit entries, one and a quarter for
+    // 32 bit entries.
+    const uint64_t count64 = (SEGMENT_SIZE / sizeof(DataWrite64)) * 3 / 2;
+    const uint64_t count32 = (SEGMENT_SIZE / sizeof(Write32)) * 5 / 4;
+
+    std::cout << "[Test] Connecting to server..." << std::endl;
+
+    try {
+        session = StSessionCreate("local:/tmp/.simutrace");
+        ThrowOn(session == INVALID_SESSION_ID);
+
+        _check<DataWrite64>(session, "data64", ArchitectureSize::As64Bit,
+                            _true, count64);
+        _check<Write32>(session, "write32", ArchitectureSize::As32Bit,
+                        _false, count32);
+
+    } catch (SimutraceException) {
+        ExceptionInformation info;
+        StGetLastError(&info);
+
+        std::cout << "Exception: '" << std::string(info.message)
+                  << "', code " << info.code << std::endl;
+
+        code = -1;
+    } catch (TestFailException) {
+        code = -1;
+    }
+
+    StSessionClose(session);
+
+    return code;
+}
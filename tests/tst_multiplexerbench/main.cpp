@@ -0,0 +1,230 @@
+/*
+ * Copyright 2015 (C) Karlsruhe Institute of Technology (KIT)
+ * Marc Rittinghaus
+ *
+ * This test is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This test is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this test. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <assert.h>
+
+#include "SimuTraceX.h"
+
+using namespace SimuTrace;
+
+// Measures the cycle count multiplexer with 2 to 256 input streams. The
+// inputs are dynamic streams, which generate their entries in the client, so
+// the benchmark does not depend on the server and the memory pool. Input k
+// of n delivers the cycle counts k*b, ..., k*b + b - 1, then (n + k)*b, ...
+// with a run length of b. The multiplexer must therefore output the cycle
+// counts 0, 1, 2, ... without gaps. A run length of 1 interleaves the inputs
+// entry by entry, longer runs resemble per-vCPU streams that execute for a
+// while before the next vCPU is scheduled.
+
+class SimutraceException {};
+class TestFailException {};
+
+#define ThrowOn(expr) \
+    if (expr) { \
+        throw SimutraceException(); \
+    }
+
+#define FailOn(expr, count) \
+    if (expr) { \
+        std::cout << "failed (count " << count << ")" << std::endl; \
+        assert(false); \
+        throw TestFailException(); \
+    }
+
+// Number of entries to read through the multiplexer per measurement. Must be
+// a multiple of MAX_INPUTS * MAX_RUN_LENGTH.
+#define ENTRY_COUNT 0x400000
+
+#define MAX_INPUTS 256
+#define MAX_RUN_LENGTH 64
+
+struct Generator {
+    uint32_t index;
+};
+
+struct GeneratorHandle {
+    const Generator* generator;
+    uint64_t next;
+    DataRead64 entry;
+};
+
+// Configuration of the current measurement, read by the generators when a
+// handle is opened.
+static uint32_t _inputCount;
+static uint32_t _runLength;
+
+static Generator _generators[MAX_INPUTS];
+
+static int _open(const DynamicStreamDescriptor* descriptor, StreamId id,
+                 QueryIndexType type, uint64_t value, StreamAccessFlags flags,
+                 void** userDataOut)
+{
+    GeneratorHandle* handle = new GeneratorHandle();
+
+    handle->generator = static_cast<const Generator*>(descriptor->userData);
+    handle->next = 0;
+
+    *userDataOut = handle;
+
+    return 0;
+}
+
+static void _close(StreamId id, void** userData)
+{
+    delete static_cast<GeneratorHandle*>(*userData);
+}
+
+static int _getNextEntry(void* userData, void** entryOut)
+{
+    GeneratorHandle* handle = static_cast<GeneratorHandle*>(userData);
+
+    if (handle->next >= ENTRY_COUNT / _inputCount) {
+        *entryOut = nullptr;
+        return 0;
+    }
+
+    uint64_t run = handle->next / _runLength;
+    uint64_t offset = handle->next % _runLength;
+
+    handle->entry.metadata.cycleCount =
+        (run * _inputCount + handle->generator->index) * _runLength + offset;
+    handle->entry.address = handle->generator->index;
+    handle->next++;
+
+    *entryOut = &handle->entry;
+    return 0;
+}
+
+static double _measure(SessionId session, StreamId* inputs,
+                       uint32_t inputCount, uint32_t runLength)
+{
+    _inputCount = inputCount;
+    _runLength = runLength;
+
+    std::string name = "multiplexer" + std::to_string(inputCount) + "." +
+                       std::to_string(runLength);
+
+    StreamId mux = StXMultiplexerCreate(session, name.c_str(),
+                                        MultiplexingRule::MxrCycleCount,
+                                        MultiplexerFlags::MxfNone,
+                                        inputs, inputCount);
+    ThrowOn(mux == INVALID_STREAM_ID);
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    StreamHandle handle = StStreamOpen(session, mux, QueryIndexType::QIndex,
+                                       0, StreamAccessFlags::SafSequentialScan,
+                                       nullptr);
+    ThrowOn(handle == nullptr);
+
+    for (uint64_t i = 0; i < ENTRY_COUNT; ++i) {
+        const DataRead64* entry = reinterpret_cast<const DataRead64*>(
+            StGetNextEntryFast(&handle));
+        ThrowOn(entry == nullptr);
+
+        FailOn(entry->metadata.cycleCount != i, i);
+        FailOn(entry->address != (i / runLength) % inputCount, i);
+    }
+
+    FailOn(StGetNextEntryFast(&handle) != nullptr, -1);
+
+    StStreamClose(handle);
+
+    std::chrono::duration<double> t =
+        std::chrono::high_resolution_clock::now() - start;
+
+    // Time per entry in nanoseconds
+    return (t.count() * 1e9) / ENTRY_COUNT;
+}
+
+int main(int argc, char *argv[])
+{
+    int code = 0;
+    SessionId session = INVALID_SESSION_ID;
+
+    std::cout << "[Test] Connecting to server..." << std::endl;
+
+    try {
+        session = StSessionCreate("local:/tmp/.simutrace");
+        ThrowOn(session == INVALID_SESSION_ID);
+
+        ThrowOn(!StSessionCreateStore(session, "simtrace:test.sim", _true));
+
+        const StreamTypeDescriptor* typeDesc;
+        typeDesc = StStreamFindMemoryType(ArchitectureSize::As64Bit,
+                                          MemoryAccessType::MatRead,
+                                          MemoryAddressType::AtPhysical,
+                                          _true);
+
+        DynamicStreamOperations operations = {};
+        operations.open         = _open;
+        operations.close        = _close;
+        operations.getNextEntry = _getNextEntry;
+
+        StreamId inputs[MAX_INPUTS];
+        for (uint32_t i = 0; i < MAX_INPUTS; ++i) {
+            _generators[i].index = i;
+
+            std::string name = "generator" + std::to_string(i);
+
+            DynamicStreamDescriptor desc;
+            ThrowOn(!StMakeStreamDescriptorDynamicFromType(name.c_str(),
+                        &_generators[i], typeDesc, &operations, &desc));
+
+            inputs[i] = StStreamRegisterDynamic(session, &desc);
+            ThrowOn(inputs[i] == INVALID_STREAM_ID);
+        }
+
+        std::cout << "[Test] Multiplexing " << ENTRY_COUNT
+                  << " entries (ns per entry)" << std::endl;
+        std::cout << "[Test] inputs     run 1     run 8    run 64" << std::endl;
+
+        for (uint32_t n = 2; n <= MAX_INPUTS; n *= 2) {
+            std::cout << "[Test] " << std::setw(6) << n;
+
+            for (uint32_t b = 1; b <= MAX_RUN_LENGTH; b *= 8) {
+                double t = _measure(session, inputs, n, b);
+
+                std::cout << std::setw(10) << std::fixed
+                          << std::setprecision(1) << t;
+            }
+
+            std::cout << std::endl;
+        }
+
+        StSessionCloseStore(session);
+
+    } catch (SimutraceException) {
+        ExceptionInformation info;
+        StGetLastError(&info);
+
+        std::cout << "Exception: '" << std::string(info.message)
+                  << "', code " << info.code << std::endl;
+
+        code = -1;
+    } catch (TestFailException) {
+        code = -1;
+    }
+
+    StSessionClose(session);
+
+    return code;
+}
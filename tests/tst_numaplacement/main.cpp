@@ -0,0 +1,261 @@
+/*
+ * Copyright 2015 (C) Karlsruhe Institute of Technology (KIT)
+ * Marc Rittinghaus
+ *
+ * This test is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This test is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this test. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "SimuStor.h"
+
+#include "WorkItem.h"
+#include "WorkQueue.h"
+#include "WorkerPool.h"
+
+#include <sched.h>
+
+using namespace SimuTrace;
+
+// Checks the building blocks of the NUMA placement (server.memmgmt.numa):
+// the topology reported by the system, the split of a stream buffer into
+// per-node segment ranges, the placement of memory on a node and the
+// pinning of threads and processing workers to the processors of a node.
+// The split is checked for arbitrary node counts, so it is also covered on
+// hosts with a single node.
+
+struct Pinning {
+    uint32_t node;
+    Event pinned;
+
+    volatile bool onNode;
+
+    Pinning(uint32_t node) :
+        node(node),
+        pinned(),
+        onNode(false) { }
+};
+
+static bool _isOnNode(uint32_t node)
+{
+    int cpu = ::sched_getcpu();
+    if (cpu < 0) {
+        return false;
+    }
+
+    const std::vector<uint32_t>& processors =
+        System::getNumaNodeProcessors(node);
+
+    return std::find(processors.begin(), processors.end(),
+                     static_cast<uint32_t>(cpu)) != processors.end();
+}
+
+static int _pinnedThreadMain(Thread<Pinning*>& thread)
+{
+    Pinning* pinning = thread.getArgument();
+
+    pinning->pinned.wait();
+
+    // The affinity takes effect at the next scheduling decision at the
+    // latest. Give the scheduler the chance to migrate us.
+    ThreadBase::sleep(10);
+
+    pinning->onNode = _isOnNode(pinning->node) &&
+        (System::getCurrentNumaNode() == pinning->node);
+
+    return 0;
+}
+
+static void _nodeItem(WorkItem<volatile uint32_t*>& item,
+                      volatile uint32_t*& invalid)
+{
+    if (System::getCurrentNumaNode() >= System::getNumNumaNodes()) {
+        Interlocked::interlockedAdd(invalid, 1);
+    }
+}
+
+static bool _checkTopology()
+{
+    uint32_t nodes = System::getNumNumaNodes();
+    if (nodes == 0) {
+        return false;
+    }
+
+    // Each processor must belong to exactly one node
+    std::set<uint32_t> processors;
+    for (uint32_t i = 0; i < nodes; ++i) {
+        for (auto cpu : System::getNumaNodeProcessors(i)) {
+            if (!processors.insert(cpu).second) {
+                return false;
+            }
+        }
+    }
+
+    if (processors.empty()) {
+        return false;
+    }
+
+    return (System::getCurrentNumaNode() < nodes);
+}
+
+static bool _checkSplit()
+{
+    for (uint64_t count = 1; count <= 64; ++count) {
+        for (uint32_t nodes = 1; nodes <= std::min<uint64_t>(count, 8);
+             ++nodes) {
+            std::vector<uint64_t> sizes(nodes, 0);
+            uint32_t last = 0;
+
+            for (uint64_t i = 0; i < count; ++i) {
+                uint32_t node = System::getNumaNodeOfIndex(i, count, nodes);
+
+                // The ranges must be contiguous and in order of the nodes
+                if ((node >= nodes) || (node < last) || (node > last + 1) ||
+                    ((i == 0) && (node != 0))) {
+                    return false;
+                }
+
+                sizes[node]++;
+                last = node;
+            }
+
+            // Every node gets a range and the sizes differ by one at most
+            auto minmax = std::minmax_element(sizes.begin(), sizes.end());
+            if ((*minmax.first == 0) || (*minmax.second - *minmax.first > 1)) {
+                return false;
+            }
+        }
+    }
+
+    // More nodes than elements cannot be split
+    try {
+        System::getNumaNodeOfIndex(0, 2, 3);
+        return false;
+    } catch (const ArgumentOutOfBoundsException&) {
+
+    }
+
+    return true;
+}
+
+static bool _checkMemoryBinding()
+{
+    const size_t size = 16 * System::getPageSize();
+    std::unique_ptr<byte[]> buffer(new byte[size + System::getPageSize()]);
+
+    for (uint32_t i = 0; i < System::getNumNumaNodes(); ++i) {
+        if (!System::bindMemoryToNumaNode(buffer.get(), size, i)) {
+            std::cout << "[Test] Memory placement not supported." << std::endl;
+            break;
+        }
+    }
+
+    memset(buffer.get(), 0, size);
+
+    // A range smaller than a page cannot be placed
+    if (System::bindMemoryToNumaNode(buffer.get(), 1, 0)) {
+        return false;
+    }
+
+    try {
+        System::bindMemoryToNumaNode(buffer.get(), size,
+                                     System::getNumNumaNodes());
+        return false;
+    } catch (const ArgumentOutOfBoundsException&) {
+
+    }
+
+    return true;
+}
+
+static bool _checkThreadPinning()
+{
+    for (uint32_t i = 0; i < System::getNumNumaNodes(); ++i) {
+        if (System::getNumaNodeProcessors(i).empty()) {
+            continue;
+        }
+
+        Pinning pinning(i);
+        Pinning* arg = &pinning;
+        Thread<Pinning*> thread(_pinnedThreadMain, arg);
+
+        thread.start();
+
+        bool supported = thread.setNumaNode(i);
+        pinning.pinned.signal();
+
+        thread.waitForThread();
+
+        if (supported && !pinning.onNode) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool _checkWorkerPinning()
+{
+    LogCategory log("Test");
+    Environment env;
+    env.log = &log;
+    env.config = nullptr;
+
+    WorkerPool pool(4, env);
+
+    uint32_t nodes = pool.bindToNumaNodes();
+    if ((nodes == 0) || (nodes > System::getNumNumaNodes())) {
+        return false;
+    }
+
+    volatile uint32_t invalid = 0;
+    for (uint32_t i = 0; i < 64; ++i) {
+        volatile uint32_t* arg = &invalid;
+        std::unique_ptr<WorkItemBase> item(
+            new WorkItem<volatile uint32_t*>(_nodeItem, arg));
+
+        pool.submitWork(item);
+    }
+
+    pool.close();
+
+    return (invalid == 0);
+}
+
+int main(int argc, const char* argv[])
+{
+    bool ok = true;
+
+    std::cout << "[Test] " << System::getNumNumaNodes()
+              << " NUMA node(s)." << std::endl;
+
+    std::cout << "[Test] Topology...";
+    ok = _checkTopology() && ok;
+    std::cout << ((ok) ? "ok." : "failed.") << std::endl;
+
+    std::cout << "[Test] Segment split...";
+    ok = _checkSplit() && ok;
+    std::cout << ((ok) ? "ok." : "failed.") << std::endl;
+
+    std::cout << "[Test] Memory placement...";
+    ok = _checkMemoryBinding() && ok;
+    std::cout << ((ok) ? "ok." : "failed.") << std::endl;
+
+    std::cout << "[Test] Thread pinning...";
+    ok = _checkThreadPinning() && ok;
+    std::cout << ((ok) ? "ok." : "failed.") << std::endl;
+
+    std::cout << "[Test] Worker pinning...";
+    ok = _checkWorkerPinning() && ok;
+    std::cout << ((ok) ? "ok." : "failed.") << std::endl;
+
+    return (ok) ? 0 : 1;
+}
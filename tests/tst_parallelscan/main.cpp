@@ -0,0 +1,364 @@
+/*
+ * Copyright 2015 (C) Karlsruhe Institute of Technology (KIT)
+ * Marc Rittinghaus
+ *
+ * This test is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This test is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this test. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <string>
+#include <vector>
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <assert.h>
+
+#include "SimuTrace.h"
+
+using namespace SimuTrace;
+
+// Writes a stream that spans several segments and reads it with
+// StStreamPartition()/StStreamOpenPartition() and StStreamParallelScan().
+// We check that the partitions cover the stream without gaps, that a
+// partition handle stops at the partition boundary and that the parallel
+// scan computes the same result as a single reader. We also check that the
+// error of a failed scan handler is reported to the caller and that the
+// other partitions stop early in that case.
+
+class SimutraceException {};
+class TestFailException {};
+
+#define ThrowOn(expr) \
+    if (expr) { \
+        throw SimutraceException(); \
+    }
+
+#define FailOn(expr, count) \
+    if (expr) { \
+        std::cout << "failed (count " << count << ")" << std::endl; \
+        assert(false); \
+        throw TestFailException(); \
+    }
+
+// Number of entries to write. With 32 byte entries, this spans several
+// 64 MiB segments.
+#define ENTRY_COUNT 0x800000
+
+// Maximum number of threads for the parallel scan.
+#define THREAD_COUNT 4
+
+// Error code returned by the failing scan handler.
+#define SCAN_ERROR 42
+
+struct ScanContext {
+    uint64_t sum[THREAD_COUNT];
+    uint64_t count[THREAD_COUNT];
+    uint64_t first[THREAD_COUNT];
+    bool failed;
+
+    volatile bool scanFailed;
+
+    uint64_t totalSum;
+    uint64_t totalCount;
+    uint64_t next;
+};
+
+static uint64_t _value(uint64_t i)
+{
+    return 0x0123456789ABCDEF * i;
+}
+
+static void _write(SessionId session, StreamId stream)
+{
+    StreamHandle handle = StStreamAppend(session, stream, nullptr);
+    ThrowOn(handle == nullptr);
+
+    for (uint64_t i = 0; i < ENTRY_COUNT; ++i) {
+        DataRead64* entry = reinterpret_cast<DataRead64*>(
+            StGetNextEntry(&handle));
+        ThrowOn(entry == nullptr);
+
+        entry->metadata.cycleCount = i;
+        entry->metadata.fullSize = 1;
+
+        entry->ip = 0xFFFFF78000000000 + (i % 0x10);
+        entry->address = i;
+        entry->dataFields[1] = _value(i);
+
+        StSubmitEntry(handle);
+    }
+
+    ThrowOn(!StStreamClose(handle));
+}
+
+static uint64_t _readSingle(SessionId session, StreamId stream, double& time)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    StreamHandle handle = StStreamOpen(session, stream, QueryIndexType::QIndex,
+                                       0, StreamAccessFlags::SafSequentialScan,
+                                       nullptr);
+    ThrowOn(handle == nullptr);
+
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < ENTRY_COUNT; ++i) {
+        const DataRead64* entry = reinterpret_cast<const DataRead64*>(
+            StGetNextEntry(&handle));
+        ThrowOn(entry == nullptr);
+
+        FailOn(entry->address != i, i);
+        sum += entry->dataFields[1];
+    }
+
+    FailOn(StGetNextEntry(&handle) != nullptr, -1);
+
+    StStreamClose(handle);
+
+    std::chrono::duration<double> t =
+        std::chrono::high_resolution_clock::now() - start;
+    time = t.count();
+
+    return sum;
+}
+
+static void _readPartitions(SessionId session, StreamId stream)
+{
+    StreamPartition partitions[THREAD_COUNT];
+    int n = StStreamPartition(session, stream, THREAD_COUNT, partitions);
+    ThrowOn(n < 0);
+    FailOn((n == 0) || (n > THREAD_COUNT), n);
+
+    // The partitions must cover the stream in order and without gaps.
+    FailOn(partitions[0].first != 0, 0);
+    for (int p = 0; p < n; ++p) {
+        FailOn(partitions[p].first > partitions[p].last, p);
+        FailOn((p > 0) && (partitions[p].first != partitions[p - 1].last + 1),
+               p);
+    }
+
+    // Each partition handle must stop at the end of the partition and the
+    // next partition must continue with the following entry.
+    uint64_t i = 0;
+    for (int p = 0; p < n; ++p) {
+        StreamHandle handle = StStreamOpenPartition(session, stream,
+            &partitions[p], StreamAccessFlags::SafSequentialScan);
+        ThrowOn(handle == nullptr);
+
+        const DataRead64* entry;
+        while ((entry = reinterpret_cast<const DataRead64*>(
+                    StGetNextEntry(&handle))) != nullptr) {
+            FailOn(entry->address != i, i);
+            i++;
+        }
+
+        StStreamClose(handle);
+    }
+
+    FailOn(i != ENTRY_COUNT, i);
+}
+
+static int _scan(void* userData, uint32_t partition, StreamHandle* handlePtr)
+{
+    ScanContext* ctx = static_cast<ScanContext*>(userData);
+    assert(partition < THREAD_COUNT);
+
+    const DataRead64* entry = reinterpret_cast<const DataRead64*>(
+        StGetNextEntry(handlePtr));
+    if (entry == nullptr) {
+        return 0;
+    }
+
+    uint64_t sum = 0;
+    uint64_t count = 0;
+    ctx->first[partition] = entry->address;
+
+    do {
+        if (entry->address != ctx->first[partition] + count) {
+            ctx->failed = true;
+        }
+
+        sum += entry->dataFields[1];
+        count++;
+
+        entry = reinterpret_cast<const DataRead64*>(
+            StGetNextEntry(handlePtr));
+    } while (entry != nullptr);
+
+    ctx->sum[partition] = sum;
+    ctx->count[partition] = count;
+
+    return 0;
+}
+
+static int _scanFail(void* userData, uint32_t partition,
+                     StreamHandle* handlePtr)
+{
+    ScanContext* ctx = static_cast<ScanContext*>(userData);
+
+    if (partition == 0) {
+        ctx->scanFailed = true;
+        return SCAN_ERROR;
+    }
+
+    // Wait until the first partition failed. Our handle should then stop
+    // at the end of the current segment instead of the partition.
+    while (!ctx->scanFailed) {
+        std::this_thread::yield();
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    uint64_t count = 0;
+    while (StGetNextEntry(handlePtr) != nullptr) {
+        count++;
+    }
+
+    ctx->count[partition] = count;
+
+    return 0;
+}
+
+static int _reduce(void* userData, uint32_t partition)
+{
+    ScanContext* ctx = static_cast<ScanContext*>(userData);
+
+    // The reduce handler is called in the order of the stream.
+    if ((ctx->count[partition] > 0) && (ctx->first[partition] != ctx->next)) {
+        ctx->failed = true;
+    }
+
+    ctx->next += ctx->count[partition];
+    ctx->totalSum += ctx->sum[partition];
+    ctx->totalCount += ctx->count[partition];
+
+    return 0;
+}
+
+static uint64_t _readParallel(SessionId session, StreamId stream,
+                              double& time)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    ScanContext ctx = {};
+    ThrowOn(!StStreamParallelScan(session, stream, THREAD_COUNT,
+                                  StreamAccessFlags::SafSequentialScan,
+                                  _scan, _reduce, &ctx));
+
+    FailOn(ctx.failed, -1);
+    FailOn(ctx.totalCount != ENTRY_COUNT, ctx.totalCount);
+
+    std::chrono::duration<double> t =
+        std::chrono::high_resolution_clock::now() - start;
+    time = t.count();
+
+    return ctx.totalSum;
+}
+
+static void _scanError(SessionId session, StreamId stream)
+{
+    // With two threads, each partition spans several segments
+    ScanContext ctx = {};
+    FailOn(StStreamParallelScan(session, stream, 2,
+                                StreamAccessFlags::SafSequentialScan,
+                                _scanFail, _reduce, &ctx), -1);
+
+    ExceptionInformation info;
+    StGetLastError(&info);
+
+    FailOn(info.type != ExceptionClass::EcUser, info.type);
+    FailOn(info.code != SCAN_ERROR, info.code);
+
+    // The reduce handler must not run for a failed scan.
+    FailOn(ctx.totalCount != 0, ctx.totalCount);
+
+    // The second partition must have stopped before its end.
+    FailOn(ctx.count[1] >= ENTRY_COUNT / 2, ctx.count[1]);
+}
+
+int main(int argc, char *argv[])
+{
+    int code = 0;
+    SessionId session = INVALID_SESSION_ID;
+
+    std::cout << "[Test] Connecting to server..." << std::endl;
+
+    try {
+        session = StSessionCreate("local:/tmp/.simutrace");
+        ThrowOn(session == INVALID_SESSION_ID);
+
+        ThrowOn(!StSessionCreateStore(session, "simtrace:test.sim", _true));
+
+        const StreamTypeDescriptor* typeDesc;
+        typeDesc = StStreamFindMemoryType(ArchitectureSize::As64Bit,
+                                          MemoryAccessType::MatRead,
+                                          MemoryAddressType::AtPhysical,
+                                          _true);
+
+        StreamDescriptor desc;
+        ThrowOn(!StMakeStreamDescriptorFromType("memorystream", typeDesc,
+                                                &desc));
+
+        StreamId stream = StStreamRegister(session, &desc);
+        ThrowOn(stream == INVALID_STREAM_ID);
+
+        std::cout << "[Test] Writing " << ENTRY_COUNT << " entries...";
+
+        _write(session, stream);
+
+        // Close and reopen the store to wait until all data is written out
+        StSessionCloseStore(session);
+        ThrowOn(!StSessionOpenStore(session, "simtrace:test.sim"));
+
+        std::cout << "ok." << std::endl;
+        std::cout << "[Test] Validating partitions...";
+
+        _readPartitions(session, stream);
+
+        std::cout << "ok." << std::endl;
+        std::cout << "[Test] Reading data with a single reader...";
+
+        double singleTime;
+        uint64_t singleSum = _readSingle(session, stream, singleTime);
+
+        std::cout << "ok (" << singleTime << " s)." << std::endl;
+        std::cout << "[Test] Reading data with a parallel scan...";
+
+        double parallelTime;
+        uint64_t parallelSum = _readParallel(session, stream, parallelTime);
+
+        FailOn(parallelSum != singleSum, -1);
+
+        std::cout << "ok (" << parallelTime << " s)." << std::endl;
+        std::cout << "[Test] Checking scan errors...";
+
+        _scanError(session, stream);
+
+        std::cout << "ok." << std::endl;
+
+        StSessionCloseStore(session);
+
+    } catch (SimutraceException) {
+        ExceptionInformation info;
+        StGetLastError(&info);
+
+        std::cout << "Exception: '" << std::string(info.message)
+                  << "', code " << info.code << std::endl;
+
+        code = -1;
+    } catch (TestFailException) {
+        code = -1;
+    }
+
+    StSessionClose(session);
+
+    return code;
+}
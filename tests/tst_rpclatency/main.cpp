@@ -0,0 +1,229 @@
+/*
+ * Copyright 2015 (C) Karlsruhe Institute of Technology (KIT)
+ * Marc Rittinghaus
+ *
+ * This test is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This test is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this test. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "SimuStor.h"
+
+using namespace SimuTrace;
+
+// Measures the round-trip latency of small RPCs (ping/pong). An echo
+// server runs in a separate thread of this process and returns every
+// request as it is. We issue embedded messages (header only, such as
+// StreamQuery) and data messages with small payloads (such as StreamClose
+// or StreamAppend of a remote client) and report the median and the 99th
+// percentile of the round-trip times. On local channels, we measure once
+// with the domain socket and once with a command ring in shared memory.
+
+static const uint32_t payloadSizes[] = { 0, 64, 4096 };
+
+struct Echo {
+    ServerPort* binding;
+    Environment* env;
+    uint32_t connections;
+};
+
+static void _echo(ServerPort* port)
+{
+    std::vector<char> buffer;
+    Message request = {0};
+
+    // The first message tells us whether to set up a command ring. We
+    // create it with the given capacity and return it with the response.
+    port->wait(request);
+
+    if (request.embedded.parameter1 > 0) {
+        std::unique_ptr<CommandRing> ring(new CommandRing(
+            static_cast<uint32_t>(request.embedded.parameter1)));
+        CommandRing* r = ring.get();
+
+        port->setCommandRing(ring);
+
+        std::vector<Handle> handles;
+        handles.push_back(r->getHandle());
+
+        port->ret(request, RpcApi::SC_Success, handles);
+        r->enable();
+    } else {
+        port->ret(request, RpcApi::SC_Success);
+    }
+
+    while (true) {
+        port->wait(request);
+
+        if (request.payloadType == MessagePayloadType::MptData) {
+            uint32_t length = request.data.payloadLength;
+
+            // ret() discards the request payload. Copy it first.
+            buffer.resize(std::max(length, 1U));
+            if (length > 0) {
+                memcpy(buffer.data(), request.data.payload, length);
+            }
+
+            port->ret(request, RpcApi::SC_Success, buffer.data(), length);
+        } else {
+            port->ret(request, RpcApi::SC_Success, RPC_VERSION);
+        }
+    }
+}
+
+static int _echoMain(Thread<Echo>& thread)
+{
+    Echo& echo = thread.getArgument();
+
+    Environment::set(echo.env);
+
+    try {
+        for (uint32_t i = 0; i < echo.connections; ++i) {
+            std::unique_ptr<Port> connection = echo.binding->accept();
+
+            try {
+                _echo(static_cast<ServerPort*>(connection.get()));
+            } catch (...) {
+                // The client closed the connection. Wait for the next one.
+            }
+        }
+    } catch (...) {
+        // The binding failed. We are done.
+    }
+
+    return 0;
+}
+
+static double _us(uint64_t ticks)
+{
+    return static_cast<double>(ticks) / 1000.0;
+}
+
+static bool _measure(const std::string& specifier, uint32_t rounds,
+                     uint32_t ringCapacity)
+{
+    bool ok = true;
+    ClientPort port(specifier);
+    std::vector<char> payload(4096, 0x5a);
+
+    Message setup = {0};
+    port.call(&setup, RpcApi::CCV_Null, RPC_VERSION, ringCapacity);
+
+    if (setup.payloadType == MessagePayloadType::MptHandles) {
+        std::unique_ptr<CommandRing> ring(new CommandRing(
+            setup.handles.handles->at(0), ringCapacity));
+
+        ring->enable();
+        port.setCommandRing(ring);
+    }
+
+    for (uint32_t size : payloadSizes) {
+        std::vector<uint64_t> times;
+        times.reserve(rounds);
+
+        for (uint32_t i = 0; i < rounds; ++i) {
+            Message response = {0};
+            uint64_t start = Clock::getTicks();
+
+            if (size == 0) {
+                port.call(&response, RpcApi::CCV_Null, RPC_VERSION);
+            } else {
+                port.call(&response, RpcApi::CCV_Null,
+                          payload.data(), size, RPC_VERSION);
+            }
+
+            times.push_back(Clock::getTicks() - start);
+
+            if ((response.payloadType == MessagePayloadType::MptData) &&
+                ((response.data.payloadLength != size) ||
+                 (memcmp(response.data.payload, payload.data(),
+                         size) != 0))) {
+                ok = false;
+            }
+
+            response.discard();
+        }
+
+        std::sort(times.begin(), times.end());
+
+        std::cout << std::fixed << std::setprecision(1)
+                  << "[Test] " << ((ringCapacity > 0) ? "ring " : "")
+                  << "payload " << std::setw(4) << size
+                  << " bytes: median "
+                  << _us(times[times.size() / 2]) << " us, p99 "
+                  << _us(times[(times.size() * 99) / 100])
+                  << " us" << std::endl;
+    }
+
+    port.close();
+
+    return ok;
+}
+
+int main(int argc, const char* argv[])
+{
+    std::string specifier = "socket:127.0.0.1:5350";
+    uint32_t rounds = 20000;
+
+    if (argc > 1) {
+        specifier = std::string(argv[1]);
+    }
+
+    if (argc > 2) {
+        rounds = static_cast<uint32_t>(atol(argv[2]));
+    }
+
+    std::cout << "[Test] RPC round-trip latency on '" << specifier << "', "
+              << rounds << " rounds." << std::endl;
+
+    LogCategory log("Test");
+    Environment env;
+    env.log = &log;
+    env.config = nullptr;
+    Environment::set(&env);
+
+    // Keep the RPC debug output out of the measurement
+    log.setPriorityThreshold(LogPriority::Warning);
+
+    bool ok = true;
+
+    try {
+        ServerPort binding(specifier);
+        bool useRing = IsSet(binding.getChannelCaps(), CCapCommandRing);
+
+        Thread<Echo> echo(_echoMain);
+        Echo arg = { &binding, &env, (useRing) ? 2U : 1U };
+        echo.setArgument(arg);
+        echo.start();
+
+        ok = _measure(specifier, rounds, 0);
+
+        if (useRing) {
+            ok = _measure(specifier, rounds, 64 * 1024) && ok;
+        }
+
+        while (echo.isRunning()) {
+            ThreadBase::sleep(1);
+        }
+
+    } catch (const std::exception& e) {
+        std::cout << "[Test] Exception: " << e.what() << std::endl;
+        ok = false;
+    }
+
+    if (!ok) {
+        std::cout << "[Test] Echoed payloads did not match." << std::endl;
+    }
+
+    std::cout << "[Test] " << ((ok) ? "ok." : "failed.") << std::endl;
+
+    return (ok) ? 0 : 1;
+}
@@ -0,0 +1,172 @@
+/*
+ * Copyright 2015 (C) Karlsruhe Institute of Technology (KIT)
+ * Marc Rittinghaus
+ *
+ * This test is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This test is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this test. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "SimuStor.h"
+
+#include "SegmentIndex.h"
+
+#include <random>
+
+using namespace SimuTrace;
+
+// Measures the lookup latency and memory footprint of the segment index
+// used by server streams and compares it to a tree of ranges, which the
+// stream used before. The synthetic stream consists of segments with
+// consecutive, variably sized ranges (e.g., cycle counts). Some segments
+// are added out of order to mimic segments which complete encoding out
+// of order. All lookups are verified against the tree.
+//
+// Usage: tst_segmentindex [segments] [lookups]
+
+struct RangeCompare
+{
+    bool operator() (const Range* left, const Range* right) const
+    {
+        return (left->start < right->start);
+    }
+};
+
+typedef std::set<Range*, RangeCompare> RangeTree;
+
+static StreamSegmentId _findInTree(const RangeTree& tree,
+                                   const std::vector<Range>& ranges,
+                                   uint64_t value)
+{
+    Range range;
+    range.start = range.end = value;
+
+    auto it = tree.lower_bound(&range);
+    if ((it != tree.end()) && (value == (*it)->start)) {
+        return static_cast<StreamSegmentId>(*it - ranges.data());
+    }
+
+    RangeTree::const_reverse_iterator rit(it);
+    if ((rit != tree.rend()) && (value <= (*rit)->end)) {
+        return static_cast<StreamSegmentId>(*rit - ranges.data());
+    }
+
+    return INVALID_STREAM_SEGMENT_ID;
+}
+
+static double _ns(uint64_t ticks, uint64_t count)
+{
+    // Clock ticks are in nanoseconds
+    return static_cast<double>(ticks) / count;
+}
+
+int main(int argc, const char* argv[])
+{
+    uint64_t segmentCount = 10000000;
+    uint64_t lookupCount = 10000000;
+
+    if (argc > 1) {
+        segmentCount = static_cast<uint64_t>(atoll(argv[1]));
+    }
+
+    if (argc > 2) {
+        lookupCount = static_cast<uint64_t>(atoll(argv[2]));
+    }
+
+    std::cout << "[Test] Segment index, " << segmentCount << " segments, "
+              << lookupCount << " lookups." << std::endl;
+
+    std::mt19937_64 random(42);
+
+    // Generate the ranges. Leave a gap after some segments, so lookups
+    // also miss.
+    std::vector<Range> ranges(segmentCount);
+    uint64_t next = 0;
+    for (uint64_t i = 0; i < segmentCount; ++i) {
+        uint64_t length = 1000 + random() % 1000;
+
+        ranges[i].start = next;
+        ranges[i].end   = next + length - 1;
+
+        next += length + (((random() % 16) == 0) ? 10 : 0);
+    }
+
+    // Build the order in which the segments are added. Swap neighbors
+    // every now and then.
+    std::vector<StreamSegmentId> order(segmentCount);
+    for (uint64_t i = 0; i < segmentCount; ++i) {
+        order[i] = static_cast<StreamSegmentId>(i);
+    }
+
+    for (uint64_t i = 1; i < segmentCount; i += 7) {
+        std::swap(order[i - 1], order[i]);
+    }
+
+    SegmentIndex index;
+    RangeTree tree;
+
+    uint64_t start = Clock::getTicks();
+    for (auto sqn : order) {
+        index.insert(ranges[sqn], sqn);
+    }
+    uint64_t indexInsertTicks = Clock::getTicks() - start;
+
+    start = Clock::getTicks();
+    for (auto sqn : order) {
+        tree.insert(&ranges[sqn]);
+    }
+    uint64_t treeInsertTicks = Clock::getTicks() - start;
+
+    std::vector<uint64_t> values(lookupCount);
+    for (auto& value : values) {
+        value = random() % (next + 100);
+    }
+
+    StreamSegmentId checksum = 0;
+    start = Clock::getTicks();
+    for (auto value : values) {
+        checksum += index.find(value);
+    }
+    uint64_t indexTicks = Clock::getTicks() - start;
+
+    start = Clock::getTicks();
+    for (auto value : values) {
+        checksum -= _findInTree(tree, ranges, value);
+    }
+    uint64_t treeTicks = Clock::getTicks() - start;
+
+    bool ok = (checksum == 0) && (index.getSize() == segmentCount);
+    for (uint64_t i = 0; ok && (i < std::min<uint64_t>(lookupCount, 1000000)); ++i) {
+        ok = (index.find(values[i]) == _findInTree(tree, ranges, values[i]));
+    }
+
+    // A tree node holds three pointers, the color and the value. Most
+    // allocators round this up to 48 bytes.
+    const size_t treeNodeSize = 48;
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "[Test] index: insert " << _ns(indexInsertTicks, segmentCount)
+              << " ns, lookup " << _ns(indexTicks, lookupCount) << " ns, "
+              << static_cast<double>(index.getMemoryUsage()) / segmentCount
+              << " bytes/segment" << std::endl
+              << "[Test] tree:  insert " << _ns(treeInsertTicks, segmentCount)
+              << " ns, lookup " << _ns(treeTicks, lookupCount) << " ns, "
+              << static_cast<double>(treeNodeSize) << " bytes/segment"
+              << std::endl;
+
+    if (!ok) {
+        std::cout << "[Test] Index and tree disagree." << std::endl;
+    }
+
+    std::cout << "[Test] " << ((ok) ? "ok." : "failed.") << std::endl;
+
+    return (ok) ? 0 : 1;
+}
@@ -0,0 +1,345 @@
+/*
+ * Copyright 2015 (C) Karlsruhe Institute of Technology (KIT)
+ * Marc Rittinghaus
+ *
+ * This test is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This test is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this test. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <string>
+#include <vector>
+#include <iostream>
+#include <assert.h>
+#include <string.h>
+
+#include "SimuTrace.h"
+
+using namespace SimuTrace;
+
+// Opens streams by entry index and by cycle count at arbitrary positions
+// within their segments. The server narrows these searches with the skip
+// index stored in each segment (store.simtrace.skipInterval).
+//
+// The variable-sized entries span several segments, and some of them
+// continue into the next segment. We open the stream at entries around the
+// samples of the skip index and compare the reference of the returned entry
+// with the one returned when writing the entry.
+//
+// The cycle counts of the temporal stream come in runs of equal values with
+// gaps between the runs. Opening the stream by a cycle count must return the
+// first entry with an equal or higher cycle count, also if the value lies in
+// a gap or the run crosses a sample of the skip index.
+
+class SimutraceException {};
+class TestFailException {};
+
+#define ThrowOn(expr) \
+    if (expr) { \
+        throw SimutraceException(); \
+    }
+
+#define FailOn(expr, count) \
+    if (expr) { \
+        std::cout << "failed (count " << count << ")" << std::endl; \
+        assert(false); \
+        throw TestFailException(); \
+    }
+
+// Size of the segments of the default stream buffer
+#define SEGMENT_SIZE (64 * 1024 * 1024)
+
+// Default interval of the skip index
+#define SKIP_INTERVAL 4096
+
+// Slot size of the variable-sized entries
+#define SIZE_HINT 64
+
+// Number of variable-sized entries. Most entries fit into a single slot,
+// so they span two to three segments.
+#define VARIABLE_ENTRY_COUNT (SEGMENT_SIZE / SIZE_HINT * 2)
+
+// Number of temporal entries. They span one and a half segments.
+#define TEMPORAL_ENTRY_COUNT (SEGMENT_SIZE / sizeof(TemporalEntry) * 3 / 2)
+
+// Length of the runs of equal cycle counts in the temporal stream
+#define RUN_LENGTH 5
+
+struct TemporalEntry {
+    uint64_t cycleCount;
+    uint64_t index;
+};
+
+static size_t _makeData(uint64_t i, byte* buffer)
+{
+    // Most entries fit into a single slot, some need up to 4 slots
+    size_t length = sizeof(uint64_t) + ((i % 8 == 0) ? (i % 200) : (i % 40));
+
+    memcpy(buffer, &i, sizeof(uint64_t));
+    for (size_t j = sizeof(uint64_t); j < length; ++j) {
+        buffer[j] = static_cast<byte>(i + j);
+    }
+
+    return length;
+}
+
+static CycleCount _cycleCount(uint64_t i)
+{
+    // Runs of equal cycle counts. Odd cycle counts do not exist.
+    return (i / RUN_LENGTH) * 2;
+}
+
+static uint64_t _firstEntryAtCycle(CycleCount cycle)
+{
+    return ((cycle + 1) / 2) * RUN_LENGTH;
+}
+
+static void _writeVariable(SessionId session, StreamId stream,
+                           std::vector<uint64_t>& references)
+{
+    StreamHandle handle = StStreamAppend(session, stream, nullptr);
+    ThrowOn(handle == nullptr);
+
+    byte buffer[256];
+
+    references.resize(VARIABLE_ENTRY_COUNT);
+    for (uint64_t i = 0; i < VARIABLE_ENTRY_COUNT; ++i) {
+        size_t length = _makeData(i, buffer);
+
+        ThrowOn(StWriteVariableData(&handle, buffer, length,
+                                    &references[i]) != length);
+    }
+
+    ThrowOn(!StStreamClose(handle));
+}
+
+static void _writeTemporal(SessionId session, StreamId stream)
+{
+    StreamHandle handle = StStreamAppend(session, stream, nullptr);
+    ThrowOn(handle == nullptr);
+
+    for (uint64_t i = 0; i < TEMPORAL_ENTRY_COUNT; ++i) {
+        TemporalEntry* entry = reinterpret_cast<TemporalEntry*>(
+            StGetNextEntry(&handle));
+        ThrowOn(entry == nullptr);
+
+        entry->cycleCount = _cycleCount(i);
+        entry->index = i;
+
+        StSubmitEntry(handle);
+    }
+
+    ThrowOn(!StStreamClose(handle));
+}
+
+static void _openVariable(SessionId session, StreamId stream, uint64_t index,
+                          const std::vector<uint64_t>& references)
+{
+    StreamHandle handle = StStreamOpen(session, stream, QueryIndexType::QIndex,
+                                       index, StreamAccessFlags::SafNone,
+                                       nullptr);
+    ThrowOn(handle == nullptr);
+
+    // Variable-sized entries cannot be read with StGetNextEntry(). We
+    // therefore compute the reference of the entry the handle points to.
+    const uint64_t slotsPerSegment = SEGMENT_SIZE / SIZE_HINT;
+    const uint64_t reference = handle->stat.sequenceNumber * slotsPerSegment +
+        (handle->entry - handle->segmentStart) / SIZE_HINT;
+
+    FailOn(reference != references[index], index);
+
+    // The entry must also hold the expected data
+    byte expected[256];
+    byte buffer[256];
+    size_t length = _makeData(index, expected);
+
+    FailOn(StReadVariableData(&handle, reference, buffer) != length, index);
+    FailOn(memcmp(buffer, expected, length) != 0, index);
+
+    StStreamClose(handle);
+}
+
+static void _openTemporal(SessionId session, StreamId stream,
+                          CycleCount cycle)
+{
+    StreamHandle handle = StStreamOpen(session, stream,
+                                       QueryIndexType::QCycleCount, cycle,
+                                       StreamAccessFlags::SafNone, nullptr);
+    ThrowOn(handle == nullptr);
+
+    const TemporalEntry* entry = reinterpret_cast<const TemporalEntry*>(
+        StGetNextEntry(&handle));
+    ThrowOn(entry == nullptr);
+
+    FailOn(entry->index != _firstEntryAtCycle(cycle), cycle);
+
+    StStreamClose(handle);
+}
+
+static void _checkVariable(SessionId session, StreamId stream,
+                           const std::vector<uint64_t>& references)
+{
+    const uint64_t slotsPerSegment = SEGMENT_SIZE / SIZE_HINT;
+
+    // The index of the first entry starting in each segment. The samples
+    // of a segment's skip index are relative to it.
+    std::vector<uint64_t> starts(1, 0);
+    for (uint64_t i = 1; i < references.size(); ++i) {
+        if (references[i] / slotsPerSegment !=
+            references[i - 1] / slotsPerSegment) {
+            starts.push_back(i);
+        }
+    }
+
+    std::vector<uint64_t> indices;
+    for (size_t s = 0; s < starts.size(); ++s) {
+        const uint64_t start = starts[s];
+        const uint64_t end = (s + 1 < starts.size()) ? starts[s + 1] :
+            VARIABLE_ENTRY_COUNT;
+
+        // Entries around the start of the segment. The entry before it
+        // may continue into the segment.
+        if (start >= 2) {
+            indices.push_back(start - 2);
+            indices.push_back(start - 1);
+        }
+
+        indices.push_back(start);
+        indices.push_back(start + 1);
+
+        // Entries around the samples of the skip index and in the middle
+        // of an interval
+        for (uint64_t i = start + SKIP_INTERVAL; i < end;
+             i += SKIP_INTERVAL * 61) {
+            indices.push_back(i - 1);
+            indices.push_back(i);
+            indices.push_back(i + 1);
+            indices.push_back(i + SKIP_INTERVAL / 2 + 7);
+        }
+
+        indices.push_back(end - 1);
+    }
+
+    for (auto index : indices) {
+        if (index < VARIABLE_ENTRY_COUNT) {
+            _openVariable(session, stream, index, references);
+        }
+    }
+}
+
+static void _checkTemporal(SessionId session, StreamId stream)
+{
+    const CycleCount lastCycle = _cycleCount(TEMPORAL_ENTRY_COUNT - 1);
+    const uint64_t segmentEntries = SEGMENT_SIZE / sizeof(TemporalEntry);
+
+    std::vector<CycleCount> cycles;
+
+    // Cycle counts around the samples of the skip index. The samples lie
+    // within runs, as the run length does not divide the interval.
+    for (uint64_t i = SKIP_INTERVAL; i < TEMPORAL_ENTRY_COUNT;
+         i += SKIP_INTERVAL * 37) {
+        cycles.push_back(_cycleCount(i) - 1);
+        cycles.push_back(_cycleCount(i));
+        cycles.push_back(_cycleCount(i) + 1);
+    }
+
+    // Cycle counts around the start of the second segment. The run at the
+    // boundary continues into the second segment. Both segments cover its
+    // cycle count and the stream may pick either of them, so we only probe
+    // the runs before and after it.
+    cycles.push_back(_cycleCount(segmentEntries - 1) - 2);
+    cycles.push_back(_cycleCount(segmentEntries - 1) - 1);
+    cycles.push_back(_cycleCount(segmentEntries) + 1);
+    cycles.push_back(_cycleCount(segmentEntries) + 2);
+
+    // Cycle counts in the middle of an interval and at the ends
+    for (CycleCount cycle = 1; cycle < lastCycle; cycle += 77777) {
+        cycles.push_back(cycle);
+    }
+
+    cycles.push_back(0);
+    cycles.push_back(lastCycle);
+
+    for (auto cycle : cycles) {
+        if (_firstEntryAtCycle(cycle) < TEMPORAL_ENTRY_COUNT) {
+            _openTemporal(session, stream, cycle);
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int code = 0;
+    SessionId session = INVALID_SESSION_ID;
+
+    std::cout << "[Test] Connecting to server..." << std::endl;
+
+    try {
+        session = StSessionCreate("local:/tmp/.simutrace");
+        ThrowOn(session == INVALID_SESSION_ID);
+
+        ThrowOn(!StSessionCreateStore(session, "simtrace:test.sim", _true));
+
+        StreamDescriptor desc;
+        ThrowOn(!StMakeStreamDescriptor("variable",
+                                        makeVariableEntrySize(SIZE_HINT),
+                                        StreamTypeFlags::StfNone, &desc));
+
+        StreamId variable = StStreamRegister(session, &desc);
+        ThrowOn(variable == INVALID_STREAM_ID);
+
+        ThrowOn(!StMakeStreamDescriptor("temporal", sizeof(TemporalEntry),
+                                        StreamTypeFlags::StfTemporalOrder,
+                                        &desc));
+
+        StreamId temporal = StStreamRegister(session, &desc);
+        ThrowOn(temporal == INVALID_STREAM_ID);
+
+        std::cout << "[Test] Writing entries...";
+
+        std::vector<uint64_t> references;
+        _writeVariable(session, variable, references);
+        _writeTemporal(session, temporal);
+
+        // Close and reopen the store to read the data from the file
+        StSessionCloseStore(session);
+        ThrowOn(!StSessionOpenStore(session, "simtrace:test.sim"));
+
+        std::cout << "ok." << std::endl;
+        std::cout << "[Test] Opening variable-sized entries by index...";
+
+        _checkVariable(session, variable, references);
+
+        std::cout << "ok." << std::endl;
+        std::cout << "[Test] Opening temporal entries by cycle count...";
+
+        _checkTemporal(session, temporal);
+
+        std::cout << "ok." << std::endl;
+
+        StSessionCloseStore(session);
+
+    } catch (SimutraceException) {
+        ExceptionInformation info;
+        StGetLastError(&info);
+
+        std::cout << "Exception: '" << std::string(info.message)
+                  << "', code " << info.code << std::endl;
+
+        code = -1;
+    } catch (TestFailException) {
+        code = -1;
+    }
+
+    StSessionClose(session);
+
+    return code;
+}
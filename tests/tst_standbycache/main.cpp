@@ -0,0 +1,256 @@
+/*
+ * Copyright 2015 (C) Karlsruhe Institute of Technology (KIT)
+ * Marc Rittinghaus
+ *
+ * This test is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This test is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this test. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "SimuStor.h"
+
+#include "StandbyPolicy.h"
+
+#include <random>
+
+using namespace SimuTrace;
+
+// Compares the hit ratio and the cost of the standby list policies on a
+// mixed workload. Analysis sessions repeatedly read a hot set of segments,
+// which fits into the cache. At the same time, one reader scans a large
+// stream with read ahead (low priority, prefetched segments) and another
+// reader scans without any access hints. The cache mirrors the use of the
+// policies in the ServerStreamBuffer: A segment is taken from the standby
+// list while it is open and returned on close.
+//
+// Usage: tst_standbycache [segments] [accesses]
+
+struct Cache
+{
+    enum Flags {
+        FPrefetch   = 1 << 0,
+        FReferenced = 1 << 1
+    };
+
+    StandbyPolicy& policy;
+
+    std::unordered_map<uint64_t, SegmentId> index;
+    std::vector<uint64_t> keys;
+    std::vector<int> flags;
+    std::vector<SegmentId> free;
+
+    uint64_t policyTicks;
+    uint64_t policyCount;
+
+    Cache(StandbyPolicy& policy, uint32_t capacity) :
+        policy(policy),
+        index(),
+        keys(capacity, 0),
+        flags(capacity, 0),
+        free(),
+        policyTicks(0),
+        policyCount(0)
+    {
+        for (uint32_t i = 0; i < capacity; ++i) {
+            free.push_back(static_cast<SegmentId>(capacity - i - 1));
+        }
+    }
+
+    // Opens and closes the segment with the given key. Returns true if the
+    // segment has been found in the cache.
+    bool access(uint64_t key, bool prefetch, bool lowPriority)
+    {
+        SegmentId id;
+        bool hit;
+
+        auto it = index.find(key);
+        if (it != index.end()) {
+            // A prefetch does not touch segments, which are cached already
+            if (prefetch) {
+                return true;
+            }
+
+            id = it->second;
+
+            uint64_t start = Clock::getTicks();
+            policy.remove(id);
+            policyTicks += Clock::getTicks() - start;
+            policyCount++;
+
+            if (flags[id] & FPrefetch) {
+                flags[id] &= ~FPrefetch;
+            } else {
+                flags[id] |= FReferenced;
+            }
+
+            hit = true;
+        } else {
+            if (free.empty()) {
+                uint64_t start = Clock::getTicks();
+                id = policy.evict();
+                policyTicks += Clock::getTicks() - start;
+                policyCount++;
+
+                assert(id != INVALID_SEGMENT_ID);
+                index.erase(keys[id]);
+            } else {
+                id = free.back();
+                free.pop_back();
+            }
+
+            keys[id] = key;
+            flags[id] = (prefetch) ? FPrefetch : 0;
+            index[key] = id;
+
+            hit = false;
+        }
+
+        int hints = StandbyHints::ShNone;
+        if (lowPriority) {
+            hints |= StandbyHints::ShLowPriority;
+        }
+
+        if (flags[id] & FPrefetch) {
+            hints |= StandbyHints::ShPrefetch;
+        }
+
+        if (flags[id] & FReferenced) {
+            hints |= StandbyHints::ShReferenced;
+        }
+
+        uint64_t start = Clock::getTicks();
+        policy.insert(id, key, static_cast<StandbyHints>(hints));
+        policyTicks += Clock::getTicks() - start;
+        policyCount++;
+
+        return hit;
+    }
+};
+
+struct Result
+{
+    uint64_t hotHits;
+    uint64_t hotAccesses;
+    uint64_t hits;
+    uint64_t accesses;
+    double policyNs;
+};
+
+static Result _run(const std::string& name, uint32_t capacity,
+                   uint64_t accessCount)
+{
+    static const uint64_t scanBase = 1ull << 32;
+    static const uint64_t plainBase = 2ull << 32;
+    static const uint32_t readAhead = 4;
+
+    std::unique_ptr<StandbyPolicy> policy =
+        StandbyPolicy::create(name, capacity);
+    assert(policy != nullptr);
+
+    Cache cache(*policy, capacity);
+    Result result = { 0 };
+
+    // The hot set takes 5/8 of the cache
+    const uint32_t hotSize = capacity * 5 / 8;
+    std::mt19937_64 random(42);
+
+    uint64_t scan = 0;
+    uint64_t plain = 0;
+
+    for (uint64_t i = 0; i < accessCount; ++i) {
+        bool hit;
+
+        switch (random() % 4) {
+            case 0:
+            case 1: {
+                hit = cache.access(random() % hotSize, false, false);
+
+                result.hotAccesses++;
+                result.hotHits += (hit) ? 1 : 0;
+                break;
+            }
+
+            case 2: {
+                for (uint32_t j = 1; j <= readAhead; ++j) {
+                    cache.access(scanBase + scan + j, true, true);
+                }
+
+                hit = cache.access(scanBase + scan++, false, true);
+                break;
+            }
+
+            default: {
+                hit = cache.access(plainBase + plain++, false, false);
+                break;
+            }
+        }
+
+        result.accesses++;
+        result.hits += (hit) ? 1 : 0;
+    }
+
+    result.policyNs = static_cast<double>(cache.policyTicks) /
+                      cache.policyCount;
+
+    assert(policy->getSize() == capacity);
+
+    return result;
+}
+
+static double _ratio(uint64_t hits, uint64_t count)
+{
+    return (count > 0) ? (hits * 100.0) / count : 0.0;
+}
+
+int main(int argc, const char* argv[])
+{
+    uint32_t segmentCount = 64;
+    uint64_t accessCount = 1000000;
+
+    if (argc > 1) {
+        segmentCount = static_cast<uint32_t>(atol(argv[1]));
+    }
+
+    if (argc > 2) {
+        accessCount = static_cast<uint64_t>(atoll(argv[2]));
+    }
+
+    std::cout << "[Test] Standby list policies, " << segmentCount
+              << " segments, " << accessCount << " accesses." << std::endl;
+
+    Result lru = _run("lru", segmentCount, accessCount);
+    Result twoQueue = _run("2q", segmentCount, accessCount);
+
+    const Result* results[] = { &lru, &twoQueue };
+    const char* names[] = { "lru", "2q " };
+
+    std::cout << std::fixed << std::setprecision(1);
+    for (int i = 0; i < 2; ++i) {
+        std::cout << "[Test] " << names[i] << ": hit ratio "
+                  << _ratio(results[i]->hits, results[i]->accesses)
+                  << "%, hot set "
+                  << _ratio(results[i]->hotHits, results[i]->hotAccesses)
+                  << "%, " << results[i]->policyNs << " ns/operation"
+                  << std::endl;
+    }
+
+    // The scans must not evict the hot set from a scan-resistant cache
+    bool ok = (twoQueue.hotHits > lru.hotHits) &&
+              (_ratio(twoQueue.hotHits, twoQueue.hotAccesses) > 90.0);
+
+    if (!ok) {
+        std::cout << "[Test] The scans evicted the hot set." << std::endl;
+    }
+
+    std::cout << "[Test] " << ((ok) ? "ok." : "failed.") << std::endl;
+
+    return (ok) ? 0 : 1;
+}
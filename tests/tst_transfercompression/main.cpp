@@ -0,0 +1,292 @@
+/*
+ * Copyright 2015 (C) Karlsruhe Institute of Technology (KIT)
+ * Marc Rittinghaus
+ *
+ * This test is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This test is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this test. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "SimuStor.h"
+
+#include <random>
+
+using namespace SimuTrace;
+
+// Checks the compression of data payloads on connections without shared
+// memory (server.network.codec). We check that the codec offer and the
+// selection survive the packing into parameter1 of SessionCreate and
+// SessionOpen, and transfer payloads of different sizes and content
+// through a compressed connection. The receiver echoes each payload, so
+// both directions are covered.
+
+struct Receiver {
+    ServerPort* binding;
+    Environment* env;
+    Compression::CodecId codec;
+};
+
+static int _receiverMain(Thread<Receiver>& thread)
+{
+    Receiver& receiver = thread.getArgument();
+
+    Environment::set(receiver.env);
+
+    try {
+        while (true) {
+            std::unique_ptr<Port> connection = receiver.binding->accept();
+            ServerPort* port = static_cast<ServerPort*>(connection.get());
+
+            const Compression::Codec* codec =
+                Compression::getCodec(receiver.codec);
+            port->setCompression(codec->id, codec->defaultLevel);
+
+            try {
+                Message request = {0};
+                std::vector<char> payload;
+
+                while (true) {
+                    port->wait(request);
+
+                    // The payload is released with the response
+                    const char* data = static_cast<const char*>(
+                        request.data.payload);
+                    payload.assign(data, data + request.data.payloadLength);
+
+                    port->ret(request, RpcApi::SC_Success, payload.data(),
+                              static_cast<uint32_t>(payload.size()));
+                }
+            } catch (...) {
+                // The sender closed the connection. Wait for the next one.
+            }
+        }
+    } catch (...) {
+        // The binding has been closed. We are done.
+    }
+
+    return 0;
+}
+
+static bool _checkSelection()
+{
+    // Servers prior to 3.2.2 return 0, which must not select a codec
+    if ((RpcApi::getSelectedCodec(0) != Compression::CiInvalid) ||
+        (RpcApi::makeCompressionSelection(Compression::CiInvalid, 3) != 0)) {
+        return false;
+    }
+
+    const Compression::CodecId codecs[] = {
+        Compression::CiLzma, Compression::CiLz4, Compression::CiNone };
+
+    for (auto id : codecs) {
+        const Compression::Codec* codec = Compression::getCodec(id);
+
+        for (uint32_t level = 0; level <= codec->maxLevel; ++level) {
+            uint64_t selection = RpcApi::makeCompressionSelection(id, level);
+
+            if ((RpcApi::getSelectedCodec(selection) != id) ||
+                (RpcApi::getSelectedCodecLevel(selection) != level)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static bool _checkOffer()
+{
+    // The offer shares parameter1 with the session id of SessionOpen.
+    // Neither may affect the other.
+    const uint32_t sessionIds[] = { 0, 1, 0x7fffffff, 0xffffffff };
+    const uint32_t masks[] = {
+        0,
+        1 << Compression::CiLzma,
+        1 << Compression::CiLz4,
+        (1 << Compression::CiLzma) | (1 << Compression::CiLz4)
+    };
+
+    for (auto id : sessionIds) {
+        for (auto mask : masks) {
+            uint64_t offer = RpcApi::makeCompressionOffer(mask) | id;
+
+            if ((RpcApi::getCompressionOffer(offer) != mask) ||
+                (static_cast<uint32_t>(offer) != id) ||
+                RpcApi::hasCommandRingOffer(offer)) {
+                return false;
+            }
+        }
+
+        // Clients with shared memory offer the command ring instead
+        uint64_t offer = RpcApi::makeCommandRingOffer() | id;
+
+        if ((RpcApi::getCompressionOffer(offer) != 0) ||
+            (static_cast<uint32_t>(offer) != id) ||
+            !RpcApi::hasCommandRingOffer(offer)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static std::vector<char> _compressible(size_t size)
+{
+    // Resembles a segment of memory accesses
+    std::vector<char> data(size);
+
+    for (size_t i = 0; i < size / sizeof(uint64_t); ++i) {
+        reinterpret_cast<uint64_t*>(data.data())[i] =
+            (i % 2 == 0) ? i * 3 : 0xFFFFF78000000000 + (i % 64) * 8;
+    }
+
+    return data;
+}
+
+static std::vector<char> _random(size_t size)
+{
+    std::mt19937 rng(static_cast<uint32_t>(size));
+    std::vector<char> data(size);
+
+    for (auto& b : data) {
+        b = static_cast<char>(rng());
+    }
+
+    return data;
+}
+
+static bool _transfer(ClientPort& port, const std::vector<char>& data,
+                      bool compressible)
+{
+    Message response = {0};
+
+    uint64_t sent = port.getBytesSent();
+    uint64_t received = port.getBytesReceived();
+
+    port.call(&response, RpcApi::CCV_Null, data.data(),
+              static_cast<uint32_t>(data.size()));
+
+    sent = port.getBytesSent() - sent;
+    received = port.getBytesReceived() - received;
+
+    bool ok = (response.payloadType == MessagePayloadType::MptData) &&
+        (response.data.payloadLength == data.size()) &&
+        (memcmp(response.data.payload, data.data(), data.size()) == 0);
+
+    response.discard();
+
+    // Payloads that are large enough and compress must take less space on
+    // the wire in both directions, unless they exceed the compression buffer
+    // limit. The others are sent as they are.
+    if (compressible && (data.size() >= PORT_COMPRESSION_THRESHOLD) &&
+        (data.size() <= PORT_COMPRESSION_BUFFER_LIMIT)) {
+        ok = ok && (sent < data.size()) && (received < data.size());
+    } else {
+        ok = ok && (sent >= data.size()) && (received >= data.size());
+    }
+
+    return ok;
+}
+
+static bool _checkTransfer(const std::string& specifier)
+{
+    ClientPort port(specifier);
+
+    const Compression::Codec* codec =
+        Compression::getCodec(Compression::CiLz4);
+    port.setCompression(codec->id, codec->defaultLevel);
+
+    // Sizes around the compression threshold and the compression buffer
+    // limit. The last transfers follow large ones and must reuse the grown
+    // buffer.
+    const size_t sizes[] = {
+        1024,
+        PORT_COMPRESSION_THRESHOLD - 8,
+        PORT_COMPRESSION_THRESHOLD,
+        1024 * 1024,
+        PORT_COMPRESSION_BUFFER_LIMIT,
+        PORT_COMPRESSION_BUFFER_LIMIT + 8,
+        PORT_COMPRESSION_THRESHOLD,
+        1024
+    };
+
+    bool ok = true;
+    for (auto size : sizes) {
+        if (!_transfer(port, _compressible(size), true)) {
+            std::cout << "(compressible, " << size << " bytes) ";
+            ok = false;
+        }
+
+        if (!_transfer(port, _random(size), false)) {
+            std::cout << "(random, " << size << " bytes) ";
+            ok = false;
+        }
+    }
+
+    port.close();
+
+    return ok;
+}
+
+int main(int argc, const char* argv[])
+{
+    std::string specifier = "socket:127.0.0.1:5352";
+
+    if (argc > 1) {
+        specifier = std::string(argv[1]);
+    }
+
+    LogCategory log("Test");
+    libconfig::Config config;
+    Environment env;
+    env.log = &log;
+    env.config = &config;
+    Environment::set(&env);
+
+    log.setPriorityThreshold(LogPriority::Warning);
+
+    bool ok = true;
+
+    std::cout << "[Test] Codec selection...";
+    bool result = _checkSelection();
+    std::cout << ((result) ? "ok." : "failed.") << std::endl;
+    ok = result && ok;
+
+    std::cout << "[Test] Codec offer...";
+    result = _checkOffer();
+    std::cout << ((result) ? "ok." : "failed.") << std::endl;
+    ok = result && ok;
+
+    std::cout << "[Test] Compressed transfer on '" << specifier << "'...";
+
+    try {
+        ServerPort binding(specifier);
+
+        Thread<Receiver> receiver(_receiverMain);
+        Receiver arg = { &binding, &env, Compression::CiLz4 };
+        receiver.setArgument(arg);
+        receiver.start();
+
+        result = _checkTransfer(specifier);
+
+        binding.close();
+        receiver.waitForThread();
+
+    } catch (const std::exception& e) {
+        std::cout << "exception: " << e.what() << " ";
+        result = false;
+    }
+
+    std::cout << ((result) ? "ok." : "failed.") << std::endl;
+    ok = result && ok;
+
+    return (ok) ? 0 : 1;
+}
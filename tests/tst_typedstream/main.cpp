@@ -0,0 +1,238 @@
+/*
+ * Copyright 2015 (C) Karlsruhe Institute of Technology (KIT)
+ * Marc Rittinghaus
+ *
+ * This test is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This test is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this test. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <numeric>
+#include <algorithm>
+
+#include "SimuTraceStream.h"
+
+using namespace SimuTrace;
+
+// Writes a memory stream through TypedStream and compares the time to read
+// it back with a loop over the C API (StGetNextEntry() and
+// StGetNextEntryFast()) against TypedStream::next(), nextSpan() and a
+// StreamRange with std::accumulate. Each reader sums up the addresses, so
+// the compiler cannot drop the loop. All reads run on the cached segments.
+
+class SimutraceException {};
+class TestFailException {};
+
+#define ThrowOn(expr) \
+    if (expr) { \
+        throw SimutraceException(); \
+    }
+
+// Number of entries to write. With 32 byte entries, this spans several
+// 64 MiB segments.
+#define ENTRY_COUNT 0x500000
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static const uint64_t expectedSum =
+    (static_cast<uint64_t>(ENTRY_COUNT) * (ENTRY_COUNT - 1)) / 2;
+
+static void _write(SessionId session, StreamId stream)
+{
+    TypedStream<DataWrite64> writer;
+    ThrowOn(!writer.append(session, stream));
+
+    for (uint64_t i = 0; i < ENTRY_COUNT; ++i) {
+        DataWrite64* entry = writer.next();
+        ThrowOn(entry == nullptr);
+
+        entry->metadata.cycleCount = i;
+        entry->metadata.fullSize = 1;
+
+        entry->ip = 0xFFFFF78000000000 + (i % 0x10);
+        entry->address = i;
+        entry->data.data64 = 0x0123456789ABCDEF * i;
+    }
+
+    ThrowOn(!writer.close());
+}
+
+static uint64_t _readCApi(SessionId session, StreamId stream)
+{
+    StreamHandle handle = StStreamOpen(session, stream, QIndex, 0,
+                                       SafSequentialScan, nullptr);
+    ThrowOn(handle == nullptr);
+
+    uint64_t sum = 0;
+    while (true) {
+        DataWrite64* entry =
+            reinterpret_cast<DataWrite64*>(StGetNextEntry(&handle));
+        if (entry == nullptr) {
+            break;
+        }
+
+        sum += entry->address;
+    }
+
+    StStreamClose(handle);
+    return sum;
+}
+
+static uint64_t _readCApiFast(SessionId session, StreamId stream)
+{
+    StreamHandle handle = StStreamOpen(session, stream, QIndex, 0,
+                                       SafSequentialScan, nullptr);
+    ThrowOn(handle == nullptr);
+
+    uint64_t sum = 0;
+    while (true) {
+        DataWrite64* entry =
+            reinterpret_cast<DataWrite64*>(StGetNextEntryFast(&handle));
+        if (entry == nullptr) {
+            break;
+        }
+
+        sum += entry->address;
+    }
+
+    StStreamClose(handle);
+    return sum;
+}
+
+static uint64_t _readTyped(SessionId session, StreamId stream)
+{
+    TypedStream<DataWrite64> reader;
+    ThrowOn(!reader.open(session, stream));
+
+    uint64_t sum = 0;
+    while (DataWrite64* entry = reader.next()) {
+        sum += entry->address;
+    }
+
+    return sum;
+}
+
+static uint64_t _readSpans(SessionId session, StreamId stream)
+{
+    TypedStream<DataWrite64> reader;
+    ThrowOn(!reader.open(session, stream));
+
+    uint64_t sum = 0;
+    size_t count;
+    while (DataWrite64* span = reader.nextSpan(count)) {
+        for (size_t i = 0; i < count; ++i) {
+            sum += span[i].address;
+        }
+    }
+
+    return sum;
+}
+
+static uint64_t _readRange(SessionId session, StreamId stream)
+{
+    TypedStream<DataWrite64> reader;
+    ThrowOn(!reader.open(session, stream));
+
+    StreamRange<DataWrite64> range(reader);
+
+    return std::accumulate(range.begin(), range.end(), uint64_t(0),
+        [](uint64_t sum, const DataWrite64& entry) {
+            return sum + entry.address;
+        });
+}
+
+static bool _measure(const char* name, SessionId session, StreamId stream,
+                     uint64_t (*read)(SessionId, StreamId))
+{
+    Clock::time_point start = Clock::now();
+    uint64_t sum = read(session, stream);
+    std::chrono::duration<double, std::milli> t = Clock::now() - start;
+
+    std::cout << "[Test] " << std::left << std::setw(22) << name
+              << std::right << std::fixed << std::setprecision(1)
+              << std::setw(8) << t.count() << " ms"
+              << ((sum == expectedSum) ? "" : " (wrong sum)") << std::endl;
+
+    return (sum == expectedSum);
+}
+
+int main(int argc, char *argv[])
+{
+    int code = 0;
+    SessionId session = INVALID_SESSION_ID;
+
+    std::cout << "[Test] Connecting to server..." << std::endl;
+
+    try {
+        session = StSessionCreate("local:/tmp/.simutrace");
+        ThrowOn(session == INVALID_SESSION_ID);
+
+        ThrowOn(!StSessionCreateStore(session, "simtrace:test.sim", _true));
+
+        StreamId stream = TypedStream<DataWrite64>::registerStream(session,
+            "memorystream", MatWrite, AtPhysical);
+        ThrowOn(stream == INVALID_STREAM_ID);
+
+        // Opening the stream with a wrong entry type must fail
+        TypedStream<Write64> wrong;
+        if (wrong.open(session, stream)) {
+            std::cout << "[Test] Opened stream with wrong entry type."
+                      << std::endl;
+            throw TestFailException();
+        }
+
+        std::cout << "[Test] Writing " << ENTRY_COUNT << " entries..."
+                  << std::endl;
+
+        _write(session, stream);
+
+        // Close and reopen the store to wait until all data is written out
+        StSessionCloseStore(session);
+        ThrowOn(!StSessionOpenStore(session, "simtrace:test.sim"));
+
+        // Load the segments into the cache
+        _readCApi(session, stream);
+
+        bool ok = true;
+        ok = _measure("StGetNextEntry", session, stream, _readCApi) && ok;
+        ok = _measure("StGetNextEntryFast", session, stream,
+                      _readCApiFast) && ok;
+        ok = _measure("TypedStream::next", session, stream, _readTyped) && ok;
+        ok = _measure("TypedStream::nextSpan", session, stream,
+                      _readSpans) && ok;
+        ok = _measure("StreamRange", session, stream, _readRange) && ok;
+
+        StSessionCloseStore(session);
+
+        if (!ok) {
+            throw TestFailException();
+        }
+
+    } catch (SimutraceException) {
+        ExceptionInformation info;
+        StGetLastError(&info);
+
+        std::cout << "Exception: '" << std::string(info.message)
+                  << "', code " << info.code << std::endl;
+
+        code = -1;
+    } catch (TestFailException) {
+        code = -1;
+    }
+
+    StSessionClose(session);
+
+    return code;
+}
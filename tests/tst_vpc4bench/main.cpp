@@ -0,0 +1,317 @@
+/*
+ * Copyright 2015 (C) Karlsruhe Institute of Technology (KIT)
+ * Marc Rittinghaus
+ *
+ * This test is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This test is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this test. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "SimuStor.h"
+#include "SimuTraceEntryTypes.h"
+
+#include "simtrace/VPC4/IpPredictor.h"
+#include "simtrace/VPC4/ValuePredictor.h"
+#include "simtrace/VPC4/CyclePredictor.h"
+
+#include <fstream>
+
+using namespace SimuTrace;
+
+// Measures the throughput of the VPC4 predictors in entries/s. Each entry
+// is a DataMemoryAccess64 and is encoded the same way as in the memory
+// encoder (ip, cycle count, address and data). The entries are either
+// generated synthetically or read from a file containing raw
+// DataMemoryAccess64 entries (e.g., a dump of a recorded memory stream).
+// Besides the throughput of the whole encoder, we report the time per entry
+// of each predictor on its own.
+//
+// Usage: tst_vpc4bench [entries | trace file] [rounds]
+
+struct PredictorSet {
+    IpPredictor<Address64> ip;
+    CyclePredictor<CycleCount, Address64> cycle;
+    ValuePredictor<uint64_t, Address64> value[2];
+
+    void reset(CycleCount startCycle)
+    {
+        ip.reset();
+        cycle.reset(startCycle);
+        value[0].reset();
+        value[1].reset();
+    }
+};
+
+struct Output {
+    std::vector<PredictorId> ids;
+    std::vector<uint64_t> data;
+
+    PredictorId* idPtr;
+    uint64_t* dataPtr;
+
+    Output(size_t entryCount) :
+        ids(entryCount * 4),
+        data(entryCount * 4) { rewind(); }
+
+    void rewind()
+    {
+        idPtr = ids.data();
+        dataPtr = data.data();
+    }
+};
+
+static void _generate(std::vector<DataMemoryAccess64>& entries)
+{
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    CycleCount cycle = 0;
+
+    // The synthetic trace mixes loops that walk arrays with a fixed stride,
+    // pointer chasing with recurring addresses, and random accesses. This
+    // exercises all predictors, including the not predicted path.
+    for (size_t i = 0; i < entries.size(); ++i) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+
+        DataMemoryAccess64& entry = entries[i];
+        memset(&entry, 0, sizeof(DataMemoryAccess64));
+
+        const uint32_t pattern = (i / 1024) % 3;
+        const uint32_t slot = i % 8;
+
+        entry.ip = 0xFFFFF80000100000ULL + pattern * 0x1000 + slot * 4;
+
+        switch (pattern) {
+            case 0:
+                entry.address = 0x10000000ULL + i * 8;
+                entry.data.data64 = i;
+                break;
+
+            case 1:
+                entry.address = 0x20000000ULL + ((seed >> 40) % 64) * 64;
+                entry.data.data64 = entry.address ^ 0xFF;
+                break;
+
+            default:
+                entry.address = 0x30000000ULL + ((seed >> 20) % 0x100000) * 8;
+                entry.data.data64 = seed >> 7;
+                break;
+        }
+
+        cycle += 1 + ((seed >> 62) & 1);
+        entry.metadata.cycleCount = cycle;
+    }
+}
+
+static bool _load(const char* fileName,
+                  std::vector<DataMemoryAccess64>& entries)
+{
+    std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::streamoff size = file.tellg();
+    entries.resize(static_cast<size_t>(size) / sizeof(DataMemoryAccess64));
+
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(entries.data()),
+              entries.size() * sizeof(DataMemoryAccess64));
+
+    return file.good() && !entries.empty();
+}
+
+// Predictors to run in _encode() and _decode()
+enum PredictorMask {
+    PmIp    = 0x1,
+    PmCycle = 0x2,
+    PmValue = 0x4,
+
+    PmAll   = PmIp | PmCycle | PmValue
+};
+
+static void _encode(PredictorSet& set,
+                    const std::vector<DataMemoryAccess64>& entries,
+                    Output& out, uint32_t mask)
+{
+    out.rewind();
+
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const DataMemoryAccess64& entry = entries[i];
+
+        if (mask & PmIp) {
+            set.ip.encodeIp(&out.idPtr, &out.dataPtr, entry.ip);
+        }
+
+        if (mask & PmCycle) {
+            set.cycle.encodeCycle(&out.idPtr, &out.dataPtr,
+                                  entry.metadata.cycleCount, entry.ip);
+        }
+
+        if (mask & PmValue) {
+            for (uint32_t j = 0; j < 2; ++j) {
+                set.value[j].encodeValue(&out.idPtr, &out.dataPtr,
+                                         entry.dataFields[j], entry.ip);
+            }
+        }
+    }
+}
+
+static bool _decode(PredictorSet& set,
+                    const std::vector<DataMemoryAccess64>& entries,
+                    Output& in, uint32_t mask)
+{
+    in.rewind();
+    bool valid = true;
+
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const DataMemoryAccess64& entry = entries[i];
+
+        // Without the ip predictor, we take the ip from the entry
+        Address64 ip = entry.ip;
+
+        if (mask & PmIp) {
+            set.ip.decodeIp(&in.idPtr, &in.dataPtr, ip);
+            valid = valid && (ip == entry.ip);
+        }
+
+        if (mask & PmCycle) {
+            CycleCount cycle;
+            set.cycle.decodeCycle(&in.idPtr, &in.dataPtr, ip, cycle);
+            valid = valid && (cycle == entry.metadata.cycleCount);
+        }
+
+        if (mask & PmValue) {
+            for (uint32_t j = 0; j < 2; ++j) {
+                uint64_t field;
+                set.value[j].decodeValue(&in.idPtr, &in.dataPtr, ip, field);
+                valid = valid && (field == entry.dataFields[j]);
+            }
+        }
+    }
+
+    return valid;
+}
+
+static bool _measure(PredictorSet& set,
+                     const std::vector<DataMemoryAccess64>& entries,
+                     Output& out, uint32_t mask, uint32_t rounds,
+                     uint64_t& encodeTicks, uint64_t& decodeTicks,
+                     size_t& notPredicted)
+{
+    encodeTicks = 0;
+    decodeTicks = 0;
+
+    for (uint32_t r = 0; r < rounds; ++r) {
+        set.reset(entries[0].metadata.cycleCount);
+
+        uint64_t start = Clock::getTicks();
+        _encode(set, entries, out, mask);
+        encodeTicks += Clock::getTicks() - start;
+
+        notPredicted = out.dataPtr - out.data.data();
+
+        set.reset(entries[0].metadata.cycleCount);
+
+        start = Clock::getTicks();
+        bool valid = _decode(set, entries, out, mask);
+        decodeTicks += Clock::getTicks() - start;
+
+        if (!valid) {
+            std::cout << "[Test] Decoded entries differ in round " << r
+                      << ". failed." << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static double _rate(size_t entryCount, uint64_t ticks)
+{
+    // Clock ticks are in nanoseconds
+    return (ticks == 0) ? 0.0 : entryCount * 1000000000.0 / ticks;
+}
+
+int main(int argc, const char* argv[])
+{
+    std::vector<DataMemoryAccess64> entries;
+    uint32_t rounds = 5;
+
+    if ((argc > 1) && (atol(argv[1]) == 0)) {
+        if (!_load(argv[1], entries)) {
+            std::cout << "[Test] Could not read trace file '" << argv[1]
+                      << "'. failed." << std::endl;
+            return 1;
+        }
+    } else {
+        entries.resize((argc > 1) ? static_cast<size_t>(atol(argv[1])) :
+                                    1000000);
+        _generate(entries);
+    }
+
+    if (argc > 2) {
+        rounds = std::max(1, atoi(argv[2]));
+    }
+
+    std::cout << "[Test] VPC4 predictor throughput, " << entries.size()
+              << " entries, " << rounds << " rounds." << std::endl;
+
+    std::unique_ptr<PredictorSet> set(new PredictorSet());
+    Output out(entries.size());
+
+    const size_t total = entries.size() * rounds;
+    uint64_t encodeTicks, decodeTicks;
+    size_t notPredicted;
+
+    if (!_measure(*set, entries, out, PmAll, rounds, encodeTicks,
+                  decodeTicks, notPredicted)) {
+        return 1;
+    }
+
+    std::cout << std::fixed << std::setprecision(0)
+              << "[Test] encode: " << _rate(total, encodeTicks)
+              << " entries/s" << std::endl
+              << "[Test] decode: " << _rate(total, decodeTicks)
+              << " entries/s" << std::endl
+              << std::setprecision(2)
+              << "[Test] not predicted: "
+              << (notPredicted * 100.0) / (entries.size() * 4)
+              << " % of values" << std::endl;
+
+    // The memory encoder runs the predictors interleaved. Running each
+    // predictor on its own shows where the time goes.
+    const struct {
+        uint32_t mask;
+        const char* name;
+    } predictors[] = {
+        { PmIp,    "ip" },
+        { PmCycle, "cycle" },
+        { PmValue, "value (2 fields)" }
+    };
+
+    for (const auto& predictor : predictors) {
+        size_t unused;
+        if (!_measure(*set, entries, out, predictor.mask, rounds,
+                      encodeTicks, decodeTicks, unused)) {
+            return 1;
+        }
+
+        std::cout << std::fixed << std::setprecision(2)
+                  << "[Test] " << predictor.name << ": encode "
+                  << encodeTicks / static_cast<double>(total)
+                  << " ns, decode "
+                  << decodeTicks / static_cast<double>(total)
+                  << " ns per entry" << std::endl;
+    }
+
+    std::cout << "[Test] ok." << std::endl;
+
+    return 0;
+}
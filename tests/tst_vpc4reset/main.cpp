@@ -0,0 +1,217 @@
+/*
+ * Copyright 2015 (C) Karlsruhe Institute of Technology (KIT)
+ * Marc Rittinghaus
+ *
+ * This test is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This test is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this test. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "SimuStor.h"
+
+#include "simtrace/VPC4/IpPredictor.h"
+#include "simtrace/VPC4/ValuePredictor.h"
+#include "simtrace/VPC4/CyclePredictor.h"
+
+using namespace SimuTrace;
+
+// Measures the per-segment setup cost of the VPC4 predictors used by the
+// memory encoder. The "fresh" run allocates and initializes new predictors
+// for every segment (the former behavior), the "reset" run reuses a single
+// set and resets it between segments. Both runs must produce identical
+// output, because the decoder relies on a well-defined initial state.
+
+typedef uint64_t Address;
+
+struct PredictorSet {
+    IpPredictor<Address> ip;
+    CyclePredictor<CycleCount, Address> cycle;
+    ValuePredictor<Address, Address> value;
+
+    void reset(CycleCount startCycle)
+    {
+        ip.reset();
+        cycle.reset(startCycle);
+        value.reset();
+    }
+};
+
+struct Entry {
+    Address ip;
+    Address address;
+    CycleCount cycle;
+};
+
+struct Output {
+    std::vector<PredictorId> ids;
+    std::vector<uint64_t> data;
+
+    PredictorId* idPtr;
+    uint64_t* dataPtr;
+
+    Output(size_t entryCount) :
+        ids(entryCount * 3),
+        data(entryCount * 3) { rewind(); }
+
+    void rewind()
+    {
+        idPtr = ids.data();
+        dataPtr = data.data();
+    }
+
+    bool operator ==(const Output& other) const
+    {
+        return (ids == other.ids) && (data == other.data);
+    }
+};
+
+static void _generate(std::vector<Entry>& entries, uint32_t segment)
+{
+    uint64_t seed = 0x9E3779B97F4A7C15ULL * (segment + 1);
+
+    for (size_t i = 0; i < entries.size(); ++i) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+
+        Entry& entry = entries[i];
+        entry.ip = 0xFFFFF78000000000ULL + ((seed >> 33) % 0x400) * 4;
+        entry.address = 0x10000000ULL + ((seed >> 20) % 0x10000) * 8;
+        entry.cycle = segment * entries.size() + i * 3 + ((seed >> 60) & 1);
+    }
+}
+
+static void _encode(PredictorSet& set, const std::vector<Entry>& entries,
+                    Output& out)
+{
+    out.rewind();
+
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const Entry& entry = entries[i];
+
+        set.ip.encodeIp(&out.idPtr, &out.dataPtr, entry.ip);
+        set.value.encodeValue(&out.idPtr, &out.dataPtr, entry.address,
+                              entry.ip);
+        set.cycle.encodeCycle(&out.idPtr, &out.dataPtr, entry.cycle,
+                              entry.ip);
+    }
+}
+
+static bool _decode(PredictorSet& set, const std::vector<Entry>& entries,
+                    Output& in)
+{
+    in.rewind();
+
+    for (size_t i = 0; i < entries.size(); ++i) {
+        Entry entry;
+
+        set.ip.decodeIp(&in.idPtr, &in.dataPtr, entry.ip);
+        set.value.decodeValue(&in.idPtr, &in.dataPtr, entry.ip,
+                              entry.address);
+        set.cycle.decodeCycle(&in.idPtr, &in.dataPtr, entry.ip, entry.cycle);
+
+        if ((entry.ip != entries[i].ip) ||
+            (entry.address != entries[i].address) ||
+            (entry.cycle != entries[i].cycle)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static double _ms(uint64_t ticks)
+{
+    // Clock ticks are in nanoseconds
+    return ticks / 1000000.0;
+}
+
+int main(int argc, const char* argv[])
+{
+    const uint32_t segmentCount = 32;
+    size_t entryCount = 4096;
+
+    if (argc > 1) {
+        entryCount = static_cast<size_t>(atol(argv[1]));
+    }
+
+    std::cout << "[Test] VPC4 predictor setup, " << segmentCount
+              << " segments with " << entryCount << " entries each."
+              << std::endl;
+
+    std::vector<Entry> entries(entryCount);
+    std::vector<Output> reference;
+
+    uint64_t freshSetup = 0, freshTotal = 0;
+    uint64_t resetSetup = 0, resetTotal = 0;
+
+    // Fresh predictors for every segment
+    for (uint32_t s = 0; s < segmentCount; ++s) {
+        _generate(entries, s);
+        reference.push_back(Output(entryCount));
+
+        uint64_t start = Clock::getTicks();
+        std::unique_ptr<PredictorSet> set(new PredictorSet());
+        set->cycle.setCycleCount(entries[0].cycle);
+        uint64_t setup = Clock::getTicks();
+
+        _encode(*set, entries, reference.back());
+        set.reset();
+
+        freshSetup += setup - start;
+        freshTotal += Clock::getTicks() - start;
+    }
+
+    // A single predictor set, reset between segments
+    std::unique_ptr<PredictorSet> pooled(new PredictorSet());
+    bool first = true;
+
+    for (uint32_t s = 0; s < segmentCount; ++s) {
+        _generate(entries, s);
+        Output out(entryCount);
+
+        uint64_t start = Clock::getTicks();
+        if (first) {
+            pooled->cycle.setCycleCount(entries[0].cycle);
+            first = false;
+        } else {
+            pooled->reset(entries[0].cycle);
+        }
+        uint64_t setup = Clock::getTicks();
+
+        _encode(*pooled, entries, out);
+
+        resetSetup += setup - start;
+        resetTotal += Clock::getTicks() - start;
+
+        if (!(out == reference[s])) {
+            std::cout << "[Test] Output of reset predictors differs in "
+                      << "segment " << s << ". failed." << std::endl;
+            return 1;
+        }
+
+        pooled->reset(entries[0].cycle);
+        if (!_decode(*pooled, entries, out)) {
+            std::cout << "[Test] Decoding with reset predictors failed in "
+                      << "segment " << s << ". failed." << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << std::fixed << std::setprecision(3)
+              << "[Test] fresh: setup " << _ms(freshSetup) / segmentCount
+              << " ms/segment, total " << _ms(freshTotal) / segmentCount
+              << " ms/segment" << std::endl
+              << "[Test] reset: setup " << _ms(resetSetup) / segmentCount
+              << " ms/segment, total " << _ms(resetTotal) / segmentCount
+              << " ms/segment" << std::endl
+              << "[Test] ok." << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,240 @@
+/*
+ * Copyright 2015 (C) Karlsruhe Institute of Technology (KIT)
+ * Marc Rittinghaus
+ *
+ * This test is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This test is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this test. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "SimuStor.h"
+
+#include "WorkItem.h"
+#include "WorkQueue.h"
+#include "WorkerPool.h"
+
+using namespace SimuTrace;
+
+// Measures the idle-to-busy latency of the worker pool. All workers are
+// idle when a burst of as many work items as there are workers is
+// submitted. Each item blocks its worker for a while, so the burst can
+// only start quickly if every worker has been woken up. We report the
+// time until the first and the last item of the burst started. Every
+// other burst is pinned to a single worker (same affinity key), so it can
+// only start quickly if the idle workers steal the items.
+
+static const uint32_t itemDuration = 20; // ms
+
+struct Burst {
+    uint64_t submitTime;
+    std::vector<uint64_t> startTimes;
+
+    volatile uint32_t started;
+    volatile uint32_t finished;
+
+    Burst(uint32_t size) :
+        submitTime(0),
+        startTimes(size, 0),
+        started(0),
+        finished(0) { }
+};
+
+struct Order {
+    CriticalSection lock;
+    std::vector<int> executed;
+};
+
+static void _burstItem(WorkItem<Burst*>& item, Burst*& burst)
+{
+    uint64_t now = Clock::getTicks();
+
+    uint32_t index = Interlocked::interlockedAdd(&burst->started, 1);
+    burst->startTimes[index] = now;
+
+    ThreadBase::sleep(itemDuration);
+
+    Interlocked::interlockedAdd(&burst->finished, 1);
+}
+
+static void _orderItem(WorkItem<std::pair<Order*, int>>& item,
+                       std::pair<Order*, int>& arg)
+{
+    LockScope(arg.first->lock);
+    arg.first->executed.push_back(arg.second);
+}
+
+static void _blockerItem(WorkItem<Event*>& item, Event*& event)
+{
+    event->wait();
+}
+
+static double _ms(uint64_t ticks)
+{
+    // Clock ticks are in nanoseconds
+    return ticks / 1000000.0;
+}
+
+static bool _checkPriorities(WorkerPool& pool)
+{
+    // Occupy all workers, so we can fill the queue in a defined state. The
+    // event must outlive the blockers, which we do not wait for.
+    static Event release;
+    Order order;
+
+    for (uint32_t i = 0; i < pool.getWorkerCount(); ++i) {
+        Event* arg = &release;
+        std::unique_ptr<WorkItemBase> item(
+            new WorkItem<Event*>(_blockerItem, arg));
+
+        pool.submitWork(item, WorkQueue::Priority::High);
+    }
+
+    while (pool.getQueueLength() > 0) {
+        ThreadBase::sleep(1);
+    }
+
+    const WorkQueue::Priority prios[] = {
+        WorkQueue::Priority::Low,
+        WorkQueue::Priority::Normal,
+        WorkQueue::Priority::High
+    };
+
+    for (int i = 0; i < 3; ++i) {
+        std::pair<Order*, int> arg(&order, prios[i]);
+        std::unique_ptr<WorkItemBase> item(
+            new WorkItem<std::pair<Order*, int>>(_orderItem, arg));
+
+        pool.submitWork(item, prios[i]);
+    }
+
+    // Release a single worker only. It has to process the queued items
+    // in the order of their priority.
+    release.signal();
+
+    for (int i = 0; i < 1000; ++i) {
+        Lock(order.lock); {
+            if (order.executed.size() == 3) {
+                break;
+            }
+        } Unlock();
+
+        ThreadBase::sleep(1);
+    }
+
+    for (uint32_t i = 1; i < pool.getWorkerCount(); ++i) {
+        release.signal();
+    }
+
+    LockScope(order.lock);
+    return (order.executed.size() == 3) &&
+           (order.executed[0] == WorkQueue::Priority::High) &&
+           (order.executed[1] == WorkQueue::Priority::Normal) &&
+           (order.executed[2] == WorkQueue::Priority::Low);
+}
+
+int main(int argc, const char* argv[])
+{
+    uint32_t workerCount = 8;
+    uint32_t rounds = 50;
+
+    if (argc > 1) {
+        workerCount = static_cast<uint32_t>(atol(argv[1]));
+    }
+
+    if (argc > 2) {
+        rounds = static_cast<uint32_t>(atol(argv[2]));
+    }
+
+    std::cout << "[Test] Work queue wake-up latency, " << workerCount
+              << " workers, " << rounds << " bursts." << std::endl;
+
+    LogCategory log("Test");
+    Environment env;
+    env.log = &log;
+    env.config = nullptr;
+
+    WorkerPool pool(workerCount, env);
+
+    std::vector<double> first, last;
+    bool ok = true;
+
+    for (uint32_t r = 0; r < rounds; ++r) {
+        Burst burst(workerCount);
+
+        // Give all workers the chance to fall asleep
+        ThreadBase::sleep(10);
+
+        burst.submitTime = Clock::getTicks();
+        for (uint32_t i = 0; i < workerCount; ++i) {
+            Burst* arg = &burst;
+            std::unique_ptr<WorkItemBase> item(
+                new WorkItem<Burst*>(_burstItem, arg));
+
+            if (r % 2 == 1) {
+                item->setAffinity(0);
+            }
+
+            pool.submitWork(item);
+        }
+
+        while (burst.finished < workerCount) {
+            ThreadBase::sleep(1);
+        }
+
+        std::sort(burst.startTimes.begin(), burst.startTimes.end());
+
+        first.push_back(_ms(burst.startTimes.front() - burst.submitTime));
+        last.push_back(_ms(burst.startTimes.back() - burst.submitTime));
+    }
+
+    std::sort(first.begin(), first.end());
+    std::sort(last.begin(), last.end());
+
+    double lastMedian = last[last.size() / 2];
+
+    std::cout << std::fixed << std::setprecision(3)
+              << "[Test] first item started: median " << first[first.size() / 2]
+              << " ms, max " << first.back() << " ms" << std::endl
+              << "[Test] last item started: median " << lastMedian
+              << " ms, max " << last.back() << " ms" << std::endl;
+
+    // If workers were left sleeping, the items of a burst would have to
+    // wait for each other.
+    if (lastMedian >= itemDuration) {
+        std::cout << "[Test] Workers have not been woken up for the burst."
+                  << std::endl;
+        ok = false;
+    }
+
+    uint64_t stolen = 0;
+    for (uint32_t i = 0; i < pool.getWorkerCount(); ++i) {
+        WorkQueue::LaneStatistics stats;
+        pool.getWorkerStatistics(i, stats);
+
+        stolen += stats.stolen;
+    }
+
+    if ((workerCount > 1) && (stolen == 0)) {
+        std::cout << "[Test] Idle workers did not steal work." << std::endl;
+        ok = false;
+    }
+
+    if (!_checkPriorities(pool)) {
+        std::cout << "[Test] Priorities have not been honored." << std::endl;
+        ok = false;
+    }
+
+    pool.close();
+
+    std::cout << "[Test] " << ((ok) ? "ok." : "failed.") << std::endl;
+
+    return (ok) ? 0 : 1;
+}